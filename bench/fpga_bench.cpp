@@ -0,0 +1,886 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <regex>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <emulator/hw_access_debug.h>
+#include <emulator/hw_access_null.h>
+#include <emulator/hw_access_timed.h>
+#include <emulator/hw_access_txn.h>
+
+#include "TestRun.h"
+#include "EllipseFit.h"
+#include "BlobTracker.h"
+#include "FeatureFile.h"
+#include "ResultCrc.h"
+
+// ------------------------------------------------------------
+// fpga_bench: per-layer microbenchmarks of the emulator stack
+// ------------------------------------------------------------
+//
+// Every benchmark reports ns per operation and the operation rate in
+// MHz. For the DUT-facing benchmarks one operation is one DUT clock,
+// so the MHz figure is directly comparable to the "Speed:" line of
+// fpga_app.
+//
+
+using NullBackendType = hw_access_null<>;
+using DebugBackendType = hw_access_debug;
+
+using wr_add = typename app_fields_t::wr_fields;
+using rd_add = typename app_fields_t::rd_fields;
+
+struct BenchResult {
+    std::string name;
+    std::string backend;
+    uint64_t ops;
+    double ns_per_op;
+};
+
+struct BenchOptions {
+    double min_time_ms = 200;
+    uint64_t run_clocks = 2000000;
+    std::string filter;
+};
+
+// Keeps the compiler from dropping a value or a store.
+template<typename T>
+inline void KeepAlive(T const &value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+class NullBuffer : public std::streambuf {
+protected:
+    int overflow(int c) override { return c; }
+    std::streamsize xsputn(const char *, std::streamsize n) override { return n; }
+};
+
+// Redirects std::cout and std::cerr for the lifetime of the object.
+class SilenceOutput {
+public:
+    SilenceOutput()
+        : cout_(std::cout.rdbuf(&null_)), cerr_(std::cerr.rdbuf(&null_)) {}
+    ~SilenceOutput() {
+        std::cout.rdbuf(cout_);
+        std::cerr.rdbuf(cerr_);
+    }
+private:
+    NullBuffer null_;
+    std::streambuf *cout_;
+    std::streambuf *cerr_;
+};
+
+class Bench {
+public:
+    Bench(const BenchOptions &opts) : opts_(opts) {}
+
+    bool Selected(const std::string &name, const std::string &backend) const {
+        return opts_.filter.empty() || Key(name, backend).find(opts_.filter) != std::string::npos;
+    }
+
+    // Runs body(n) with growing n until one call takes min_time/5, then
+    // takes the median of five calls. body(n) performs n operations, or,
+    // if it works in coarser steps, returns the number it performed.
+    template<typename body_t>
+    void Measure(const std::string &name, const std::string &backend, body_t &&body) {
+        if (!Selected(name, backend))
+            return;
+
+        using clock = std::chrono::steady_clock;
+        const double slice_ns = opts_.min_time_ms * 1e6 / 5;
+
+        auto run = [&](uint64_t n) -> uint64_t {
+            if constexpr (std::is_void_v<decltype(body(n))>) {
+                body(n);
+                return n;
+            } else {
+                return body(n);
+            }
+        };
+
+        uint64_t n = 1;
+        for (;;) {
+            auto t0 = clock::now();
+            const uint64_t ops = run(n);
+            double ns = std::chrono::duration<double, std::nano>(clock::now() - t0).count();
+            if (ns >= slice_ns || n >= (uint64_t(1) << 40))
+                break;
+            n = ns < slice_ns / 64 ? std::max(n, ops) * 64 : static_cast<uint64_t>(ops * slice_ns / ns) + 1;
+        }
+
+        std::array<double, 5> samples;
+        uint64_t total = 0;
+        for (auto &s : samples) {
+            auto t0 = clock::now();
+            const uint64_t ops = run(n);
+            s = std::chrono::duration<double, std::nano>(clock::now() - t0).count() / ops;
+            total += ops;
+        }
+        std::sort(samples.begin(), samples.end());
+
+        Add(BenchResult{name, backend, total, samples[samples.size() / 2]});
+    }
+
+    void Add(const BenchResult &r) {
+        results_.push_back(r);
+        std::cout << std::left << std::setw(44) << r.name << std::setw(8) << r.backend
+                  << std::right << std::fixed << std::setprecision(2)
+                  << std::setw(12) << r.ns_per_op << " ns/op"
+                  << std::setw(12) << 1e3 / r.ns_per_op << " MHz\n";
+        std::cout.unsetf(std::ios::floatfield);
+    }
+
+    const std::vector<BenchResult> &Results() const { return results_; }
+    const BenchOptions &Options() const { return opts_; }
+
+    static std::string Key(const std::string &name, const std::string &backend) {
+        return name + "@" + backend;
+    }
+
+private:
+    BenchOptions opts_;
+    std::vector<BenchResult> results_;
+};
+
+// ------------------------------------------------------------
+// bit_slicer: register file as shadow, no hw behind it
+// ------------------------------------------------------------
+struct SlicerRegs {
+    using wr_word_t = uint64_t;
+    using rd_word_t = uint64_t;
+
+    std::array<uint64_t, 8> words{};
+
+    inline void write(size_t idx, wr_word_t data, wr_word_t mask) noexcept {
+        words[idx] = (words[idx] & ~mask) | (data & mask);
+    }
+    template<size_t IDX>
+    inline void write(wr_word_t data, wr_word_t mask) noexcept {
+        words[IDX] = (words[IDX] & ~mask) | (data & mask);
+    }
+    inline rd_word_t read(size_t idx) const noexcept {
+        return words[idx];
+    }
+    template<size_t IDX>
+    inline rd_word_t read() const noexcept {
+        return words[IDX];
+    }
+};
+
+template<size_t WIDTH>
+void BenchSlicerWidth(Bench &bench) {
+    // Odd offset, so wide fields straddle word boundaries.
+    constexpr size_t OFFSET = 5;
+    using word_t = FpgaUint<WIDTH>;
+    const std::string w = "/w" + std::to_string(WIDTH);
+
+    SlicerRegs regs;
+    bit_slicer<SlicerRegs> slicer(regs);
+
+    bench.Measure("bit_slicer.write_bits" + w, "none", [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) {
+            slicer.write_bits(OFFSET, WIDTH, static_cast<word_t>(i * 0x9E3779B97F4A7C15ull));
+            KeepAlive(regs.words);
+        }
+    });
+    bench.Measure("bit_slicer.write_bits<>" + w, "none", [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) {
+            slicer.template write_bits<OFFSET, WIDTH>(static_cast<word_t>(i * 0x9E3779B97F4A7C15ull));
+            KeepAlive(regs.words);
+        }
+    });
+    bench.Measure("bit_slicer.read_bits" + w, "none", [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) {
+            KeepAlive(regs.words);
+            word_t v = slicer.template read_bits<word_t>(OFFSET, WIDTH);
+            KeepAlive(v);
+        }
+    });
+    bench.Measure("bit_slicer.read_bits<>" + w, "none", [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) {
+            KeepAlive(regs.words);
+            word_t v = slicer.template read_bits<OFFSET, WIDTH, word_t>();
+            KeepAlive(v);
+        }
+    });
+}
+
+void BenchSlicer(Bench &bench) {
+    BenchSlicerWidth<1>(bench);
+    BenchSlicerWidth<10>(bench);
+    BenchSlicerWidth<32>(bench);
+    BenchSlicerWidth<64>(bench);
+    BenchSlicerWidth<100>(bench);
+    BenchSlicerWidth<128>(bench);
+    BenchSlicerWidth<200>(bench);
+}
+
+// ------------------------------------------------------------
+// shadow::wr_flush: 16 feed words of 64 bits
+// ------------------------------------------------------------
+struct bench_wide_fields {
+    enum class wr_fields : size_t {
+        W0, W1, W2, W3, W4, W5, W6, W7, W8, W9, W10, W11, W12, W13, W14, W15,
+        END_OF_FIELDS
+    };
+    enum class rd_fields : size_t {
+        R0,
+        END_OF_FIELDS
+    };
+
+    consteval static auto get_wr_specs() {
+        std::array<FieldSpec<wr_fields>, 16> specs{};
+        for (size_t i = 0; i < specs.size(); i++)
+            specs[i] = {static_cast<wr_fields>(i), 64};
+        return specs;
+    }
+
+    consteval static auto get_rd_specs() {
+        return std::to_array<FieldSpec<rd_fields>>({{rd_fields::R0, 64}});
+    }
+};
+
+template<typename hw_t>
+void BenchFlush(Bench &bench, hw_t &hw, const std::string &backend) {
+    using shadow_t = shadow<hw_t, bench_wide_fields>;
+    constexpr size_t words = fields<bench_wide_fields>::wr_bits / (sizeof(typename hw_t::wr_word_t) * 8);
+
+    shadow_t sh(hw);
+    sh.wr_flush();
+
+    for (size_t dirty : {size_t(0), size_t(1), words / 4, words}) {
+        bench.Measure("shadow.wr_flush/dirty=" + std::to_string(dirty), backend, [&](uint64_t n) {
+            for (uint64_t i = 0; i < n; i++) {
+                for (size_t idx = 0; idx < dirty; idx++)
+                    sh.write(idx, static_cast<typename hw_t::wr_word_t>(i), ~typename hw_t::wr_word_t(0));
+                sh.wr_flush();
+            }
+        });
+    }
+}
+
+// ------------------------------------------------------------
+// emulator_fields: one pixel = field writes, flush, clock pulse
+// ------------------------------------------------------------
+template<typename hw_t>
+void BenchPixelWrites(Bench &bench, hw_t &hw, const std::string &backend) {
+    emulator_fields<hw_t, app_fields_t> emulator(hw);
+    const size_t x_size = llcca_gens.X_SIZE;
+
+    bench.Measure("emulator_fields.wr_pixel", backend, [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) {
+            Collect_t pixel{(i & 7) == 0, i % x_size, i / x_size, false, false, false};
+            WrEmulationData(emulator, pixel);
+        }
+    });
+
+    typename emulator_fields<hw_t, app_fields_t>::stimulus_t stimulus;
+    stimulus.reserve(x_size);
+    for (size_t x = 0; x < x_size; x++)
+        CompileEmulationData(stimulus, Collect_t{(x & 7) == 0, x, 0, false, false, false});
+
+    bench.Measure("emulator_fields.replay_pixel", backend, [&](uint64_t n) {
+        for (uint64_t left = n; left; )
+            left -= emulator.replay(stimulus, [&](size_t clk) { return clk + 1 < left; });
+    });
+}
+
+// ------------------------------------------------------------
+// Cost of one timed access in hw_access_timed: timestamp + bucket
+// ------------------------------------------------------------
+void BenchLatencyHistogram(Bench &bench) {
+    LatencyHistogram hist;
+    bench.Measure("CycleClock.now_histogram_add", "none", [&](uint64_t n) {
+        uint64_t t0 = CycleClock::now();
+        for (uint64_t i = 0; i < n; i++) {
+            const uint64_t t1 = CycleClock::now();
+            hist.add(t1 - t0);
+            t0 = t1;
+        }
+    });
+    KeepAlive(hist.percentile(0.99));
+}
+
+// ------------------------------------------------------------
+// TestFrame::GetPixel over the test scene
+// ------------------------------------------------------------
+void BenchGetPixel(Bench &bench) {
+    const size_t x_size = llcca_gens.X_SIZE;
+    const size_t y_size = (size_t)1 << llcca_gens.Y_BITS;
+    TestFrames test_frames(x_size, y_size, 512);
+
+    bench.Measure("TestFrame.GetPixel", "none", [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) {
+            Collect_t pixel = test_frames.GetPixel(0, i % x_size, (i / x_size) % 512);
+            KeepAlive(pixel);
+        }
+    });
+}
+
+// ------------------------------------------------------------
+// Span index on a stress scene of many objects, one op = one pixel
+// ------------------------------------------------------------
+void BenchStressScene(Bench &bench) {
+    const size_t x_size = llcca_gens.X_SIZE;
+    const size_t repeat_y = 512;
+    const size_t num_objects = 2000;
+
+    TestFrame::Objects objects;
+    uint64_t seed = 1;
+    auto next = [&](size_t range) {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        return static_cast<size_t>((seed >> 33) % range);
+    };
+    for (size_t i = 0; i < num_objects; i++) {
+        if (i & 1)
+            objects.push_back(std::make_unique<CircleData>(next(x_size), next(repeat_y), 2 + next(14)));
+        else
+            objects.push_back(std::make_unique<SquareData>(next(x_size), next(repeat_y), 2 + next(20)));
+    }
+    TestFrame frame(std::move(objects));
+    frame.Rasterize(x_size, repeat_y);
+
+    std::vector<uint8_t> labels(x_size);
+    bench.Measure("TestFrame.GetRow_stress", "none", [&](uint64_t n) {
+        uint64_t pixels = 0;
+        for (uint64_t row = 0; pixels < n; row++, pixels += x_size) {
+            frame.GetRow(row % repeat_y, labels.data());
+            KeepAlive(labels[0]);
+        }
+        return pixels;
+    });
+
+    bench.Measure("TestFrame.GetPixel_stress", "none", [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) {
+            Collect_t pixel = frame.GetPixel(i % x_size, (i / x_size) % repeat_y, repeat_y);
+            KeepAlive(pixel);
+        }
+    });
+}
+
+// ------------------------------------------------------------
+// StressScenes::render on one worker, one op = one pixel
+// ------------------------------------------------------------
+// render() works on whole frames, so each call counts the pixels of the
+// frames it rendered.
+void BenchSceneRender(Bench &bench) {
+    const size_t x_size = llcca_gens.X_SIZE;
+    StressScenes::Frame frame;
+    for (StressScenes::Profile profile : {StressScenes::Profile::UNIFORM, StressScenes::Profile::WORST}) {
+        StressScenes::Options options;
+        options.profile = profile;
+        const uint64_t frame_pixels = uint64_t(x_size) * options.rows;
+        size_t frame_idx = 0;
+        bench.Measure(std::string("StressScenes.render_") + StressScenes::profile_name(profile), "none",
+                      [&](uint64_t n) {
+            uint64_t pixels = 0;
+            for (; pixels < n; pixels += frame_pixels) {
+                StressScenes::render(options, x_size, frame_idx++, frame);
+                KeepAlive(frame.bits[0]);
+            }
+            return pixels;
+        });
+    }
+}
+
+// ------------------------------------------------------------
+// Burst policies on hw_access_txn: accesses per clock and per flush
+// ------------------------------------------------------------
+// One clock = pixel write, flush, pulse and a full feature read (VALID
+// is held at 1). fpga_tests burst_feed checks the policies agree. The
+// read cost is also given with VALID at 0, the serial path of most
+// clocks, where only VALID is read.
+template<size_t BURST>
+void BenchBurst(Bench &bench) {
+    using hw_t = hw_access_txn<uint64_t, BURST>;
+    const std::string backend = "txn/b" + std::to_string(BURST);
+    const size_t x_size = llcca_gens.X_SIZE;
+    const size_t check_clocks = 4096;
+
+    hw_t hw;
+    hw.set_rd(0, 1);
+    emulator_fields<hw_t, app_fields_t> emulator(hw);
+
+    auto clock = [&](uint64_t i) {
+        Collect_t pixel{(i & 7) == 0, i % x_size, i / x_size, false, false, false};
+        WrEmulationData(emulator, pixel);
+        Feature_t feature;
+        RdEmulationData(emulator, feature);
+        KeepAlive(feature);
+    };
+
+    for (uint64_t i = 0; i < check_clocks; i++)
+        clock(i);
+    const double wr = double(hw.count(hw_t::txn_t::WR)) / check_clocks;
+    const double rd = double(hw.count(hw_t::txn_t::RD)) / check_clocks;
+    const double rd_words = double(hw.count_words(hw_t::txn_t::RD)) / check_clocks;
+
+    hw.set_rd(0, 0);
+    hw.clear();
+    for (uint64_t i = 0; i < check_clocks; i++)
+        clock(i);
+    const double serial_rd = double(hw.count(hw_t::txn_t::RD)) / check_clocks;
+    const double serial_rd_words = double(hw.count_words(hw_t::txn_t::RD)) / check_clocks;
+    hw.set_rd(0, 1);
+
+    using wide_shadow_t = shadow<hw_t, bench_wide_fields>;
+    hw_t wide_hw;
+    wide_shadow_t wide(wide_hw);
+    wide.wr_flush();
+    wide_hw.clear();
+    for (size_t idx = 3; idx < 13; idx++)
+        wide.write(idx, idx, ~uint64_t(0));
+    wide.wr_flush();
+
+    std::cout << std::left << std::setw(44) << "accesses/clk wr, rd; 10-word flush" << std::setw(8) << backend
+              << std::right << std::fixed << std::setprecision(2)
+              << std::setw(8) << wr << std::setw(8) << rd << std::setw(8) << double(wide_hw.transactions().size()) << "\n";
+    std::cout << std::left << std::setw(44) << "rd accesses, words/clk; VALID 1, VALID 0" << std::setw(8) << backend
+              << std::right << std::setw(8) << rd << std::setw(8) << rd_words
+              << std::setw(8) << serial_rd << std::setw(8) << serial_rd_words << "\n";
+    std::cout.unsetf(std::ios::floatfield);
+
+    hw.clear();
+    bench.Measure("emulator_fields.wr_rd_pixel", backend, [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) {
+            clock(i);
+            if ((i & 1023) == 1023)
+                hw.clear();
+        }
+    });
+}
+
+void BenchBursts(Bench &bench) {
+    BenchBurst<1>(bench);
+    BenchBurst<2>(bench);
+    BenchBurst<4>(bench);
+}
+
+// ------------------------------------------------------------
+// MMIO ordering policies on hw_access_txn: barriers per clock
+// ------------------------------------------------------------
+// Same clock as BenchBurst with pairs. fpga_tests mmio_order_barriers
+// checks where the barriers are placed.
+template<mmio_order ORDER>
+void BenchOrder(Bench &bench) {
+    using hw_t = hw_access_txn<uint64_t, 2, 64, ORDER>;
+    using txn_t = typename hw_t::txn_t;
+    const std::string backend = ORDER == mmio_order::strict ? "txn/sync"
+                              : ORDER == mmio_order::relaxed ? "txn/rlx" : "txn/wc";
+    const size_t x_size = llcca_gens.X_SIZE;
+    const size_t check_clocks = 4096;
+
+    hw_t hw;
+    hw.set_rd(0, 1);
+    emulator_fields<hw_t, app_fields_t> emulator(hw);
+
+    auto clock = [&](uint64_t i) {
+        Collect_t pixel{(i & 7) == 0, i % x_size, i / x_size, false, false, false};
+        WrEmulationData(emulator, pixel);
+        Feature_t feature;
+        RdEmulationData(emulator, feature);
+        KeepAlive(feature);
+    };
+
+    for (uint64_t i = 0; i < check_clocks; i++)
+        clock(i);
+
+    const double fence_st = double(hw.count(txn_t::FENCE_ST)) / check_clocks;
+    const double fence = double(hw.count(txn_t::FENCE)) / check_clocks;
+    std::cout << std::left << std::setw(44) << "barriers/clk before pulse, before reads" << std::setw(8) << backend
+              << std::right << std::fixed << std::setprecision(2)
+              << std::setw(8) << fence_st << std::setw(8) << fence << "\n";
+    std::cout.unsetf(std::ios::floatfield);
+
+    hw.clear();
+    bench.Measure("emulator_fields.wr_rd_pixel", backend, [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) {
+            clock(i);
+            if ((i & 1023) == 1023)
+                hw.clear();
+        }
+    });
+}
+
+void BenchOrders(Bench &bench) {
+    BenchOrder<mmio_order::strict>(bench);
+    BenchOrder<mmio_order::relaxed>(bench);
+    BenchOrder<mmio_order::write_combining>(bench);
+}
+
+// ------------------------------------------------------------
+// EllipseBatch over synthetic features, one op = one feature
+// ------------------------------------------------------------
+// Features are random upright rectangles, some crossing or wrapping
+// over the seg0/seg1 boundary.
+void BenchEllipseFit(Bench &bench) {
+    const size_t num_features = 4096;
+    constexpr uint64_t y_low_size = llcca_consts::Y_LOW_SIZE;
+    constexpr uint64_t y_size = llcca_consts::Y_SIZE;
+
+    std::vector<Feature_t> features(num_features);
+    uint64_t seed = 1;
+    auto next = [&](size_t range) {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        return static_cast<size_t>((seed >> 33) % range);
+    };
+    for (auto &f : features) {
+        f = Feature_t{};
+        f.y_top_seg_0 = f.y_top_seg_1 = llcca_consts::Y_LOW_MAX;
+        const uint64_t x0 = next(llcca_gens.X_SIZE - 64), w = 1 + next(64);
+        const uint64_t y0 = next(y_size), h = 1 + next(64);
+        f.x_left = x0;
+        f.x_right = x0 + w - 1;
+        for (uint64_t y = y0; y < y0 + h; y++) {
+            const uint64_t ylow = y % y_low_size;
+            const bool seg1 = (y % y_size) >= y_low_size;
+            for (uint64_t x = x0; x < x0 + w; x++) {
+                f.x2_sum += x * x;
+                f.ylow2_sum += ylow * ylow;
+                f.xylow_sum += x * ylow;
+            }
+            const uint64_t sum_x = w * (2 * x0 + w - 1) / 2;
+            (seg1 ? f.x_seg1_sum : f.x_seg0_sum) += sum_x;
+            (seg1 ? f.ylow_seg1_sum : f.ylow_seg0_sum) += w * ylow;
+            (seg1 ? f.n_seg1_sum : f.n_seg0_sum) += w;
+            auto &top = seg1 ? f.y_top_seg_1 : f.y_top_seg_0;
+            auto &bottom = seg1 ? f.y_bottom_seg_1 : f.y_bottom_seg_0;
+            top = std::min<size_t>(top, ylow);
+            bottom = std::max<size_t>(bottom, ylow);
+        }
+        f.valid = true;
+    }
+
+    EllipseBatch batch(num_features);
+    EllipseBatch scalar(num_features);
+
+    bench.Measure("EllipseBatch.add", "none", [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) {
+            if (batch.size() == num_features)
+                batch.clear();
+            batch.add(features[i % num_features]);
+        }
+    });
+
+    bench.Measure("EllipseBatch.fit/1", "none", [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) {
+            scalar.clear();
+            scalar.add(features[i % num_features]);
+            scalar.fit();
+            KeepAlive(scalar.major(0));
+        }
+    });
+
+    batch.clear();
+    for (const auto &f : features)
+        batch.add(f);
+    bench.Measure("EllipseBatch.fit/" + std::to_string(num_features), "none", [&](uint64_t n) {
+        uint64_t fits = 0;
+        for (; fits < n; fits += num_features) {
+            batch.fit();
+            KeepAlive(batch.major(0));
+        }
+        return fits;
+    });
+    bench.Measure("EllipseBatch.fit_scalar/" + std::to_string(num_features), "none", [&](uint64_t n) {
+        uint64_t fits = 0;
+        for (; fits < n; fits += num_features) {
+            batch.fit_scalar();
+            KeepAlive(batch.major(0));
+        }
+        return fits;
+    });
+}
+
+// ------------------------------------------------------------
+// BlobTracker on a grid of moving squares, one op = one blob
+// ------------------------------------------------------------
+// Every square moves (1, 2) pixels per frame, so every blob matches
+// its track of the previous frame.
+void BenchBlobTracker(Bench &bench) {
+    const size_t spacing = 16, side = 6;
+    const size_t columns = (llcca_gens.X_SIZE - 64) / spacing;
+    const size_t rows = 4096 / columns;
+
+    auto square = [&](size_t x0, size_t y0) {
+        Feature_t f{};
+        f.valid = true;
+        f.x_left = x0;
+        f.x_right = x0 + side - 1;
+        f.y_top_seg_0 = y0;
+        f.y_bottom_seg_0 = y0 + side - 1;
+        f.y_top_seg_1 = llcca_consts::Y_LOW_MAX;
+        f.n_seg0_sum += side * side;
+        f.x_seg0_sum += side * side * (2 * x0 + side - 1) / 2;
+        f.ylow_seg0_sum += side * side * (2 * y0 + side - 1) / 2;
+        return f;
+    };
+    auto frame_features = [&](size_t frame) {
+        std::vector<Feature_t> features;
+        for (size_t r = 0; r < rows; r++)
+            for (size_t c = 0; c < columns; c++)
+                features.push_back(square(c * spacing + frame % 32, r * spacing + 2 * (frame % 32)));
+        return features;
+    };
+
+    std::vector<std::vector<Feature_t>> frames;
+    for (size_t frame = 0; frame < 8; frame++)
+        frames.push_back(frame_features(frame));
+
+    const std::string name = "BlobTracker.add/" + std::to_string(frames[0].size());
+    size_t frame = 0;
+    bench.Measure(name, "none", [&](uint64_t n) {
+        BlobTracker t;
+        for (uint64_t i = 0; i < n; frame++) {
+            t.begin_frame(frame);
+            for (const Feature_t &f : frames[frame % frames.size()]) {
+                KeepAlive(t.add(f).id);
+                if (++i == n)
+                    break;
+            }
+        }
+    });
+}
+
+// ------------------------------------------------------------
+// Feature output: text to std::cout against the columnar file sink,
+// one op = one feature, both into a null device
+// ------------------------------------------------------------
+void BenchFeatureOutput(Bench &bench) {
+    Feature_t feature{};
+    feature.valid = true;
+    feature.x_left = 8;
+    feature.x_right = 32;
+    feature.y_top_seg_0 = 520;
+    feature.y_bottom_seg_0 = 544;
+    feature.y_top_seg_1 = llcca_consts::Y_LOW_MAX;
+    feature.n_seg0_sum = 441;
+
+    bench.Measure("PrintFeature", "none", [&](uint64_t n) {
+        SilenceOutput silence;
+        for (uint64_t i = 0; i < n; i++)
+            PrintFeature(i, feature);
+    });
+
+    FeatureWriter writer("/dev/null");
+    bench.Measure("FeatureWriter.append", "none", [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++)
+            writer.append(0, i, feature);
+    });
+}
+
+// ------------------------------------------------------------
+// Result CRC fold of the reference run, one op = one folded record
+// ------------------------------------------------------------
+void BenchResultCrc(Bench &bench) {
+    CrcResultImage result{};
+    result.words.fill(0x0123456789abcdefull);
+    bench.Measure("result_crc.add", "none", [&](uint64_t n) {
+        result_crc rc;
+        for (uint64_t i = 0; i < n; i++)
+            rc.add(i, result.words.data(), result.words.size());
+        KeepAlive(rc.crc);
+    });
+}
+
+// ------------------------------------------------------------
+// End-to-end TestRun loop, one op = one DUT clock
+// ------------------------------------------------------------
+template<typename hw_t, typename run_t>
+void BenchRun(Bench &bench, const std::string &name, const std::string &backend, run_t &&run) {
+    if (!bench.Selected(name, backend))
+        return;
+
+    hw_t hw;
+    emulator_fields<hw_t, app_fields_t> emulator(hw);
+
+    uint64_t clocks;
+    auto t0 = std::chrono::steady_clock::now();
+    {
+        SilenceOutput silence;
+        clocks = run(emulator, bench.Options().run_clocks);
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+
+    bench.Add(BenchResult{name, backend, clocks, ns / clocks});
+}
+
+// hw_access_debug has no default constructor.
+struct DebugBackend : DebugBackendType {
+    DebugBackend() : DebugBackendType("debug") {}
+};
+
+template<typename hw_t>
+void BenchTestRun(Bench &bench, const std::string &backend) {
+    BenchRun<hw_t>(bench, "TestRun", backend, [](auto &iface, uint64_t clocks) {
+        return TestRun(iface, clocks);
+    });
+    BenchRun<hw_t>(bench, "TestRunPipelined", backend, [](auto &iface, uint64_t clocks) {
+        return TestRunPipelined(iface, clocks);
+    });
+    if constexpr (emulator_fields<hw_t, app_fields_t>::batch_supported) {
+        BenchRun<hw_t>(bench, "TestRunCrc", backend, [](auto &iface, uint64_t clocks) {
+            const ResultCrcFile reference;
+            return TestRun(iface, clocks, CrcCheckReport(iface, reference));
+        });
+    }
+}
+
+// ------------------------------------------------------------
+// JSON output and baseline comparison
+// ------------------------------------------------------------
+void WriteJson(std::ostream &os, const std::vector<BenchResult> &results) {
+    os << "{\n  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const auto &r = results[i];
+        os << "    {\"name\": \"" << r.name << "\", \"backend\": \"" << r.backend
+           << "\", \"ops\": " << r.ops
+           << ", \"ns_per_op\": " << std::setprecision(6) << r.ns_per_op
+           << ", \"mhz\": " << 1e3 / r.ns_per_op << "}"
+           << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    os << "  ]\n}\n";
+}
+
+// Reads the files written by WriteJson(); keyed by name@backend.
+std::map<std::string, double> ReadJson(const std::string &fname) {
+    std::ifstream in(fname);
+    if (!in)
+        throw std::runtime_error("cannot open baseline file: " + fname);
+    std::stringstream ss;
+    ss << in.rdbuf();
+    const std::string text = ss.str();
+
+    static const std::regex entry(
+        R"re("name"\s*:\s*"([^"]*)"\s*,\s*"backend"\s*:\s*"([^"]*)"[^}]*"ns_per_op"\s*:\s*([0-9.eE+-]+))re");
+
+    std::map<std::string, double> r;
+    for (auto it = std::sregex_iterator(text.begin(), text.end(), entry); it != std::sregex_iterator(); ++it)
+        r[Bench::Key((*it)[1], (*it)[2])] = std::stod((*it)[3]);
+    return r;
+}
+
+// Prints the change against the baseline; returns the number of
+// benchmarks slower than threshold_pct.
+size_t CompareBaseline(const std::vector<BenchResult> &results,
+                       const std::map<std::string, double> &baseline, double threshold_pct) {
+    size_t regressions = 0;
+    std::cout << "\nBaseline comparison (threshold " << threshold_pct << "%):\n";
+    for (const auto &r : results) {
+        const std::string key = Bench::Key(r.name, r.backend);
+        auto it = baseline.find(key);
+        std::cout << "  " << std::left << std::setw(52) << key << std::right;
+        if (it == baseline.end()) {
+            std::cout << "     (new)\n";
+            continue;
+        }
+        const double delta = (r.ns_per_op / it->second - 1.0) * 100.0;
+        const bool slower = delta > threshold_pct;
+        regressions += slower;
+        std::cout << std::showpos << std::fixed << std::setprecision(1) << std::setw(9) << delta << "%"
+                  << std::noshowpos << (slower ? "  REGRESSION" : "") << "\n";
+        std::cout.unsetf(std::ios::floatfield);
+    }
+    return regressions;
+}
+
+void PrintHelp(const char *progname) {
+    std::cerr <<
+        "Usage: " << progname << " [options]\n"
+        "\n"
+        "Options:\n"
+        "  -o <file>   Write results as JSON\n"
+        "  -b <file>   Compare against a JSON baseline written with -o\n"
+        "  -r <pct>    Regression threshold for -b in percent (default 10)\n"
+        "  -t <ms>     Minimum time per microbenchmark (default 200)\n"
+        "  -c <clocks> DUT clocks per end-to-end TestRun (default 2000000)\n"
+        "  -f <text>   Only run benchmarks whose name@backend contains <text>\n"
+        "  -h          Show this help\n"
+        "\n"
+        "Exit status is 1 if any benchmark is slower than the baseline threshold.\n";
+}
+
+int main(int argc, char *argv[]) {
+    BenchOptions opts;
+    std::string json_fname;
+    std::string baseline_fname;
+    double threshold_pct = 10;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+
+        if (arg == "-h" || arg == "--help") {
+            PrintHelp(argv[0]);
+            return 0;
+        }
+
+        if (arg != "-o" && arg != "-b" && arg != "-r" && arg != "-t" && arg != "-c" && arg != "-f") {
+            std::cerr << "Unknown option: " << arg << "\n\n";
+            PrintHelp(argv[0]);
+            return 1;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "Error: " << arg << " requires a value.\n\n";
+            PrintHelp(argv[0]);
+            return 1;
+        }
+        std::string value = argv[++i];
+
+        if (arg == "-o") json_fname = value;
+        if (arg == "-b") baseline_fname = value;
+        if (arg == "-r") threshold_pct = std::stod(value);
+        if (arg == "-t") opts.min_time_ms = std::stod(value);
+        if (arg == "-c") opts.run_clocks = std::stoull(value);
+        if (arg == "-f") opts.filter = value;
+    }
+
+    Bench bench(opts);
+
+    BenchSlicer(bench);
+    BenchGetPixel(bench);
+    BenchStressScene(bench);
+    BenchSceneRender(bench);
+    {
+        NullBackendType null_hw;
+        DebugBackend debug_hw;
+        BenchFlush(bench, null_hw, "null");
+        BenchFlush(bench, debug_hw, "debug");
+        BenchPixelWrites(bench, null_hw, "null");
+        BenchPixelWrites(bench, debug_hw, "debug");
+        hw_access_timed<NullBackendType> timed_hw(null_hw);
+        BenchPixelWrites(bench, timed_hw, "timed");
+        BenchLatencyHistogram(bench);
+    }
+    BenchBursts(bench);
+    BenchOrders(bench);
+    BenchEllipseFit(bench);
+    BenchBlobTracker(bench);
+    BenchFeatureOutput(bench);
+    BenchResultCrc(bench);
+    BenchTestRun<NullBackendType>(bench, "null");
+    BenchTestRun<DebugBackend>(bench, "debug");
+
+    if (!json_fname.empty()) {
+        std::ofstream out(json_fname);
+        WriteJson(out, bench.Results());
+    }
+
+    if (!baseline_fname.empty()) {
+        auto baseline = ReadJson(baseline_fname);
+        if (CompareBaseline(bench.Results(), baseline, threshold_pct))
+            return 1;
+    }
+
+    return 0;
+}
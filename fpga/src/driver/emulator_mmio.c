@@ -0,0 +1,170 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * emulator_mmio: maps the emulator register region to user space with a
+ * selectable memory type, for the MMIO ordering policies of
+ * hw_access_aarch64 (include/emulator/mmio_order.h).
+ *
+ * UIO maps the region Device-nGnRnE only, so every feed store waits for
+ * the write response of the AXI-Lite slave. This driver exposes the
+ * same region once per view of include/emulator/emulator_mmio.h:
+ * Device-nGnRnE, Device-nGnRE (posted stores) and Normal-NC (posted and
+ * merged stores, store only). The view is selected by the mmap offset.
+ *
+ * There is no OF match table, so the driver never races UIO for the
+ * device; fpga/src/sh/bind_emulator_mmio.sh moves the device over with
+ * driver_override. Each bound device gets /dev/emulator_mmio<N>, with
+ * the region size in /sys/class/misc/emulator_mmio<N>/size.
+ */
+
+#include <linux/device.h>
+#include <linux/fs.h>
+#include <linux/idr.h>
+#include <linux/io.h>
+#include <linux/miscdevice.h>
+#include <linux/mm.h>
+#include <linux/module.h>
+#include <linux/platform_device.h>
+#include <linux/slab.h>
+#include <linux/version.h>
+
+#include "emulator_mmio.h"
+
+#define EMULATOR_MMIO_VIEW_PAGE_SHIFT	(EMULATOR_MMIO_VIEW_SHIFT - PAGE_SHIFT)
+
+struct emulator_mmio {
+	struct miscdevice misc;
+	struct resource *res;
+	int id;
+	char name[32];
+};
+
+static DEFINE_IDA(emulator_mmio_ida);
+
+static int emulator_mmio_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	struct emulator_mmio *em = container_of(file->private_data, struct emulator_mmio, misc);
+	const unsigned long view = vma->vm_pgoff >> EMULATOR_MMIO_VIEW_PAGE_SHIFT;
+	const unsigned long pgoff = vma->vm_pgoff & ((1UL << EMULATOR_MMIO_VIEW_PAGE_SHIFT) - 1);
+	const unsigned long region_pages = PAGE_ALIGN(resource_size(em->res)) >> PAGE_SHIFT;
+	const unsigned long pages = vma_pages(vma);
+
+	if (pgoff >= region_pages || pages > region_pages - pgoff)
+		return -EINVAL;
+
+	switch (view) {
+	case EMULATOR_MMIO_VIEW_STRICT:
+		vma->vm_page_prot = pgprot_noncached(vma->vm_page_prot);
+		break;
+	case EMULATOR_MMIO_VIEW_POSTED:
+		vma->vm_page_prot = pgprot_device(vma->vm_page_prot);
+		break;
+	case EMULATOR_MMIO_VIEW_WC:
+		/*
+		 * Normal-NC may be read speculatively, and a load of the
+		 * result FIFO pops it: store only.
+		 */
+		if (vma->vm_flags & (VM_READ | VM_EXEC))
+			return -EACCES;
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 3, 0)
+		vm_flags_clear(vma, VM_MAYREAD | VM_MAYEXEC);
+#else
+		vma->vm_flags &= ~(VM_MAYREAD | VM_MAYEXEC);
+#endif
+		vma->vm_page_prot = pgprot_writecombine(vma->vm_page_prot);
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	return io_remap_pfn_range(vma, vma->vm_start, PHYS_PFN(em->res->start) + pgoff,
+				  pages << PAGE_SHIFT, vma->vm_page_prot);
+}
+
+static const struct file_operations emulator_mmio_fops = {
+	.owner = THIS_MODULE,
+	.mmap = emulator_mmio_mmap,
+};
+
+static ssize_t size_show(struct device *dev, struct device_attribute *attr, char *buf)
+{
+	struct miscdevice *misc = dev_get_drvdata(dev);
+	struct emulator_mmio *em = container_of(misc, struct emulator_mmio, misc);
+
+	return sysfs_emit(buf, "0x%llx\n", (unsigned long long)resource_size(em->res));
+}
+static DEVICE_ATTR_RO(size);
+
+static struct attribute *emulator_mmio_attrs[] = {
+	&dev_attr_size.attr,
+	NULL,
+};
+ATTRIBUTE_GROUPS(emulator_mmio);
+
+static void emulator_mmio_free_id(void *data)
+{
+	struct emulator_mmio *em = data;
+
+	ida_free(&emulator_mmio_ida, em->id);
+}
+
+static void emulator_mmio_deregister(void *data)
+{
+	struct emulator_mmio *em = data;
+
+	misc_deregister(&em->misc);
+}
+
+static int emulator_mmio_probe(struct platform_device *pdev)
+{
+	struct device *dev = &pdev->dev;
+	struct emulator_mmio *em;
+	int ret;
+
+	em = devm_kzalloc(dev, sizeof(*em), GFP_KERNEL);
+	if (!em)
+		return -ENOMEM;
+
+	em->res = platform_get_resource(pdev, IORESOURCE_MEM, 0);
+	if (!em->res)
+		return dev_err_probe(dev, -ENODEV, "no register region\n");
+	if (!PAGE_ALIGNED(em->res->start) ||
+	    resource_size(em->res) > (1ULL << EMULATOR_MMIO_VIEW_SHIFT))
+		return dev_err_probe(dev, -EINVAL, "%pR is not page aligned or larger than a view\n",
+				     em->res);
+	if (!devm_request_mem_region(dev, em->res->start, resource_size(em->res), dev_name(dev)))
+		return dev_err_probe(dev, -EBUSY, "%pR is in use\n", em->res);
+
+	em->id = ida_alloc(&emulator_mmio_ida, GFP_KERNEL);
+	if (em->id < 0)
+		return em->id;
+	ret = devm_add_action_or_reset(dev, emulator_mmio_free_id, em);
+	if (ret)
+		return ret;
+
+	snprintf(em->name, sizeof(em->name), "emulator_mmio%d", em->id);
+	em->misc.minor = MISC_DYNAMIC_MINOR;
+	em->misc.name = em->name;
+	em->misc.fops = &emulator_mmio_fops;
+	em->misc.parent = dev;
+	em->misc.groups = emulator_mmio_groups;
+	ret = misc_register(&em->misc);
+	if (ret)
+		return ret;
+	ret = devm_add_action_or_reset(dev, emulator_mmio_deregister, em);
+	if (ret)
+		return ret;
+
+	dev_info(dev, "/dev/%s: %pR\n", em->name, em->res);
+	return 0;
+}
+
+static struct platform_driver emulator_mmio_driver = {
+	.probe = emulator_mmio_probe,
+	.driver = {
+		.name = "emulator_mmio",
+	},
+};
+module_platform_driver(emulator_mmio_driver);
+
+MODULE_DESCRIPTION("Emulator register region with selectable memory type");
+MODULE_LICENSE("GPL");
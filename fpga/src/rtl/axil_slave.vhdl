@@ -9,6 +9,13 @@ entity axil_slave is
         rd_offset: natural;
         wr_dwords: natural;
         wr_offset: natural;
+        -- batch mode: stimulus FIFO write window, result FIFO read window
+        -- and 32-bit status registers at AXI words 1..status_regs
+        stim_awords: positive;
+        stim_offset: natural;
+        res_fifo_awords: positive;
+        res_fifo_offset: natural;
+        status_regs: positive;
         AXI_DATA_BITS: positive
     );
     port(
@@ -43,7 +50,29 @@ entity axil_slave is
         wr_data_out: out std_logic_vector(wr_dwords*32-1 downto 0);
 
         run_reg_out: out std_logic_vector(31 downto 0);
-        run_reg_0_pulse_out: out std_logic
+        run_reg_0_pulse_out: out std_logic;
+
+        -- written when the last AXI word of a stimulus record is written
+        stim_data_out: out std_logic_vector(stim_awords*AXI_DATA_BITS-1 downto 0);
+        stim_push_out: out std_logic;
+
+        -- head of the result FIFO, popped after its last AXI word is read
+        res_fifo_data_in: in std_logic_vector(res_fifo_awords*AXI_DATA_BITS-1 downto 0);
+        res_fifo_pop_out: out std_logic;
+
+        status_in: in std_logic_vector(status_regs*32-1 downto 0);
+
+        -- write to AXI word 1: number of DUT clocks to add to the batch
+        batch_run_out: out std_logic_vector(31 downto 0);
+        batch_run_pulse_out: out std_logic;
+
+        -- AXI word status_regs+1: result CRC register (read), any write
+        -- pulses crc_clear_out. A read of it is not accepted while
+        -- crc_busy_in = '1', i.e. before crc_in covers every DUT clock
+        -- requested so far.
+        crc_in: in std_logic_vector(63 downto 0);
+        crc_busy_in: in std_logic;
+        crc_clear_out: out std_logic
     );
 end;
 
@@ -61,6 +90,19 @@ architecture rtl of axil_slave is
     constant wr_start: natural := wr_offset;
     constant wr_end: natural := wr_start + wr_dwords - 1;
 
+    constant batch_add: natural := 1;
+
+    constant status_start: natural := 1;
+    constant status_end: natural := status_start + status_regs - 1;
+
+    constant crc_add: natural := status_end + 1;
+
+    constant stim_start: natural := stim_offset;
+    constant stim_end: natural := stim_start + stim_awords - 1;
+
+    constant res_fifo_start: natural := res_fifo_offset;
+    constant res_fifo_end: natural := res_fifo_start + res_fifo_awords - 1;
+
     signal rd_data: std_logic_vector(rd_bits-1 downto 0);
     signal wr_data: std_logic_vector(wr_bits-1 downto 0);
 
@@ -78,6 +120,13 @@ architecture rtl of axil_slave is
     signal run_reg_0_pulse: std_logic;
 
     signal free_counter: unsigned(31 downto 0);
+
+    signal stim_data: std_logic_vector(stim_awords*AXI_DATA_BITS-1 downto 0);
+    signal stim_push: std_logic;
+    signal res_fifo_pop: std_logic;
+    signal batch_run: std_logic_vector(31 downto 0);
+    signal batch_run_pulse: std_logic;
+    signal crc_clear: std_logic;
 begin
     process(clk_in)
     begin
@@ -98,6 +147,16 @@ begin
             axil_arready <= '1';
         end if;
 
+        -- give the result FIFO one cycle to present its next head
+        if res_fifo_pop = '1' then
+            axil_arready <= '0';
+        end if;
+
+        -- hold a CRC read until the last DUT clock is folded in
+        if crc_busy_in = '1' and shift_right(unsigned(axil_araddr), IGNORE_ADD_LSBS) = crc_add then
+            axil_arready <= '0';
+        end if;
+
         if sreset_in = '1' then
             axil_arready <= '0';
         end if;
@@ -108,13 +167,15 @@ begin
         variable pos: unsigned(15 downto 0);
     begin
         if rising_edge(clk_in) then
+            res_fifo_pop <= '0';
+
             if axil_arready = '1' then
                 addr := shift_right(unsigned(axil_araddr), IGNORE_ADD_LSBS);
                 ar_d1_valid <= axil_arvalid;
                 ar_d1_prot <= axil_arprot;
                 ar_d1_addr <= axil_araddr;
                 for i in 0 to AXI_DATA_BITS/32-1 loop
-                    ar_d1_data(i*32-31 downto i*32) <= X"DEAD_BEEF";
+                    ar_d1_data(i*32+31 downto i*32) <= X"DEAD_BEEF";
                 end loop;
                 if addr >= rd_start and addr <= rd_end then
                     pos := addr - rd_start;
@@ -123,6 +184,26 @@ begin
                 if addr = 0 then
                     ar_d1_data(31 downto 0) <= std_logic_vector(free_counter);
                 end if;
+                if addr >= status_start and addr <= status_end then
+                    pos := addr - status_start;
+                    ar_d1_data <= (others => '0');
+                    ar_d1_data(31 downto 0) <= status_in(to_integer(pos)*32+31 downto to_integer(pos)*32);
+                end if;
+                if addr = crc_add then
+                    ar_d1_data <= std_logic_vector(resize(unsigned(crc_in), AXI_DATA_BITS));
+                end if;
+                if addr >= res_fifo_start and addr <= res_fifo_end then
+                    pos := addr - res_fifo_start;
+                    ar_d1_data <= res_fifo_data_in(to_integer(pos)*AXI_DATA_BITS+AXI_DATA_BITS-1 downto to_integer(pos)*AXI_DATA_BITS);
+                    if addr = res_fifo_end and axil_arvalid = '1' then
+                        res_fifo_pop <= '1';
+                    end if;
+                end if;
+            end if;
+
+            if sreset_in = '1' then
+                ar_d1_valid <= '0';
+                res_fifo_pop <= '0';
             end if;
         end if;
     end process;
@@ -196,6 +277,9 @@ begin
     begin
         if rising_edge(clk_in) then
             run_reg_0_pulse <= '0';
+            stim_push <= '0';
+            batch_run_pulse <= '0';
+            crc_clear <= '0';
 
             if axil_wr = '1' then
                 addr := shift_right(unsigned(axil_awaddr), IGNORE_ADD_LSBS);
@@ -207,6 +291,23 @@ begin
                     end if;
                 end if;
 
+                if addr = batch_add then
+                    batch_run <= axil_wdata(31 downto 0);
+                    batch_run_pulse <= '1';
+                end if;
+
+                if addr = crc_add then
+                    crc_clear <= '1';
+                end if;
+
+                if addr >= stim_start and addr <= stim_end then
+                    pos := addr - stim_start;
+                    stim_data(to_integer(pos)*AXI_DATA_BITS+AXI_DATA_BITS-1 downto to_integer(pos)*AXI_DATA_BITS) <= axil_wdata;
+                    if addr = stim_end then
+                        stim_push <= '1';
+                    end if;
+                end if;
+
                 if addr >= wr_start and addr <= wr_end then
                     pos := addr - wr_start;
                     -- wr_data(to_integer(pos)*AXI_DATA_BITS+AXI_DATA_BITS-1 downto to_integer(pos)*AXI_DATA_BITS) <= axil_wdata;
@@ -225,5 +326,11 @@ begin
         wr_data_out <= wr_data;
         run_reg_out <= run_reg;
         run_reg_0_pulse_out <= run_reg_0_pulse;
+        stim_data_out <= stim_data;
+        stim_push_out <= stim_push;
+        res_fifo_pop_out <= res_fifo_pop;
+        batch_run_out <= batch_run;
+        batch_run_pulse_out <= batch_run_pulse;
+        crc_clear_out <= crc_clear;
     end process;
 end;
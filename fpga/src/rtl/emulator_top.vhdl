@@ -8,7 +8,9 @@ entity emulator_top is
     generic(
         X_SIZE: positive := x_size;
         Y_SIZE: positive := 1024;
-        AXI_DATA_BITS: positive := 64
+        AXI_DATA_BITS: positive := 64;
+        STIM_DEPTH: positive := 2048;
+        RES_DEPTH: positive := 512
     );
     port(
         clk_in: in std_logic;
@@ -148,6 +150,119 @@ architecture rtl of emulator_top is
     signal dut_clk_req: std_logic;
 
     signal dut_clk: std_logic;
+
+    -- ------------------------------------------------------------
+    -- Batch mode
+    -- ------------------------------------------------------------
+    -- Software pushes whole feed records into the stimulus FIFO (AXI
+    -- word stim_offset), then writes a clock count to AXI word 1. The
+    -- batch FSM runs one DUT clock per record, and pushes every cycle
+    -- with res_valid_out = '1' into the result FIFO as
+    --   AXI word 0:  dut_cycles after that clock (bits 31..0)
+    --   AXI word 1+: res_t, same packing as the result window
+    -- Reading the last AXI word of the head record pops it.
+    -- The FSM stalls while the stimulus FIFO is empty or the result
+    -- FIFO is full.
+    --
+    -- Status registers (read, AXI words 1..7, bits 31..0):
+    --   batch_remaining, dut_cycles, stim_count, res_count,
+    --   STIM_DEPTH, RES_DEPTH, geometry
+    -- geometry is x"47" & X_SIZE (16 bits) & y_bits (8 bits), so the
+    -- host can pick the matching field layout.
+    --
+    -- Between batch clocks the DUT sees the feed window again, so the
+    -- feed window must hold rst = '0' while a batch runs.
+    constant stim_awords: natural := (feed_bits + AXI_DATA_BITS - 1) / AXI_DATA_BITS;
+    constant stim_offset: natural := 64;
+
+    constant res_awords: natural := (res_bits + AXI_DATA_BITS - 1) / AXI_DATA_BITS;
+    constant res_fifo_awords: natural := 1 + res_awords;
+    constant res_fifo_offset: natural := 128;
+    constant res_rec_bits: natural := res_fifo_awords * AXI_DATA_BITS;
+
+    constant status_regs: natural := 7;
+
+    type stim_mem_t is array(0 to STIM_DEPTH-1) of std_logic_vector(feed_bits-1 downto 0);
+    type res_mem_t is array(0 to RES_DEPTH-1) of std_logic_vector(res_rec_bits-1 downto 0);
+
+    signal stim_mem: stim_mem_t;
+    signal stim_wr_ptr: natural range 0 to STIM_DEPTH-1;
+    signal stim_rd_ptr: natural range 0 to STIM_DEPTH-1;
+    signal stim_count: natural range 0 to STIM_DEPTH;
+    signal stim_q: std_logic_vector(feed_bits-1 downto 0);
+
+    signal res_mem: res_mem_t;
+    signal res_wr_ptr: natural range 0 to RES_DEPTH-1;
+    signal res_rd_ptr: natural range 0 to RES_DEPTH-1;
+    signal res_count: natural range 0 to RES_DEPTH;
+    signal res_q: std_logic_vector(res_rec_bits-1 downto 0);
+
+    signal stim_data: std_logic_vector(stim_awords*AXI_DATA_BITS-1 downto 0);
+    signal stim_push: std_logic;
+    signal res_fifo_pop: std_logic;
+    signal batch_run: std_logic_vector(31 downto 0);
+    signal batch_run_pulse: std_logic;
+    signal status: std_logic_vector(status_regs*32-1 downto 0);
+
+    type batch_state_t is (BATCH_IDLE, BATCH_READ, BATCH_PULSE, BATCH_CAPTURE);
+    signal batch_state: batch_state_t;
+    signal batch_remaining: unsigned(31 downto 0);
+    signal batch_feed: feed_t;
+    signal batch_clk_req: std_logic;
+
+    signal dut_feed: feed_t;
+    signal dut_cycles: unsigned(31 downto 0);
+
+    -- ------------------------------------------------------------
+    -- Result CRC
+    -- ------------------------------------------------------------
+    -- Every DUT clock with res_valid_out = '1' folds the record
+    --   AXI word 0:  crc_cycles after that clock (bits 31..0)
+    --   AXI word 1+: res_t, same packing as the result window
+    -- LSB first into a CRC-32C (reflected, poly x"82F63B78", initial
+    -- value x"FFFFFFFF", no final xor) and increments crc_count.
+    -- crc_cycles counts DUT clocks since the last clear. AXI word 8
+    -- reads crc (bits 31..0) and crc_count (bits 63..32); any write to
+    -- it clears the CRC and both counters. See result_crc.h.
+    --
+    -- res is sampled one cycle after the DUT clock request (like
+    -- BATCH_CAPTURE) and folded one cycle later, so the CRC keeps up
+    -- with a DUT clock on every cycle. It lags the request by three
+    -- cycles: crc_busy covers them, and axil_slave holds a CRC read
+    -- until crc_busy is low, so a read right after the last clock
+    -- pulse sees that clock.
+    constant CRC_POLY: std_logic_vector(31 downto 0) := x"82F63B78";
+
+    signal dut_clk_done: std_logic;
+    signal crc_cycles: unsigned(31 downto 0);
+    signal crc_rec: std_logic_vector(res_rec_bits-1 downto 0);
+    signal crc_rec_valid: std_logic;
+    signal crc: std_logic_vector(31 downto 0);
+    signal crc_count: unsigned(31 downto 0);
+    signal crc_clear: std_logic;
+    signal crc_busy: std_logic;
+
+    function crc_update(c: std_logic_vector(31 downto 0); data: std_logic_vector) return std_logic_vector is
+        variable v: std_logic_vector(31 downto 0);
+    begin
+        v := c;
+        for i in data'reverse_range loop
+            if (v(0) xor data(i)) = '1' then
+                v := ('0' & v(31 downto 1)) xor CRC_POLY;
+            else
+                v := '0' & v(31 downto 1);
+            end if;
+        end loop;
+        return v;
+    end;
+
+    function ptr_next(p: natural; depth: positive) return natural is
+    begin
+        if p = depth - 1 then
+            return 0;
+        end if;
+        return p + 1;
+    end;
 begin
     process(all)
     begin
@@ -165,6 +280,11 @@ begin
             rd_offset => 16,
             wr_dwords => feed_dwords,
             wr_offset => 16,
+            stim_awords => stim_awords,
+            stim_offset => stim_offset,
+            res_fifo_awords => res_fifo_awords,
+            res_fifo_offset => res_fifo_offset,
+            status_regs => status_regs,
             AXI_DATA_BITS => AXI_DATA_BITS
         )
         port map(
@@ -192,10 +312,176 @@ begin
             rd_data_in => res_axil,
             wr_data_out => feed_axil,
             run_reg_out => run_reg,
-            run_reg_0_pulse_out => run_reg_0_pulse
+            run_reg_0_pulse_out => run_reg_0_pulse,
+            stim_data_out => stim_data,
+            stim_push_out => stim_push,
+            res_fifo_data_in => res_q,
+            res_fifo_pop_out => res_fifo_pop,
+            status_in => status,
+            batch_run_out => batch_run,
+            batch_run_pulse_out => batch_run_pulse,
+            crc_in => std_logic_vector(crc_count) & crc,
+            crc_busy_in => crc_busy,
+            crc_clear_out => crc_clear
         );
 
-    dut_clk_req <= run_reg_0_pulse;
+    process(clk_in)
+    begin
+        if rising_edge(clk_in) then
+            if stim_push = '1' and stim_count < STIM_DEPTH then
+                stim_mem(stim_wr_ptr) <= stim_data(feed_bits-1 downto 0);
+            end if;
+            stim_q <= stim_mem(stim_rd_ptr);
+        end if;
+    end process;
+
+    process(clk_in)
+        variable rec: std_logic_vector(res_rec_bits-1 downto 0);
+        variable v_res_rd_ptr: natural range 0 to RES_DEPTH-1;
+    begin
+        if rising_edge(clk_in) then
+            if batch_state = BATCH_CAPTURE and res.res_valid_out = '1' then
+                rec := (others => '0');
+                rec(31 downto 0) := std_logic_vector(dut_cycles);
+                rec(AXI_DATA_BITS+res_bits-1 downto AXI_DATA_BITS) := res_slv;
+                res_mem(res_wr_ptr) <= rec;
+            end if;
+
+            -- read ahead on pop, so the next head is ready one cycle later
+            v_res_rd_ptr := res_rd_ptr;
+            if res_fifo_pop = '1' and res_count > 0 then
+                v_res_rd_ptr := ptr_next(res_rd_ptr, RES_DEPTH);
+            end if;
+            res_q <= res_mem(v_res_rd_ptr);
+        end if;
+    end process;
+
+    process(clk_in)
+        variable v_stim_count: natural range 0 to STIM_DEPTH;
+        variable v_res_count: natural range 0 to RES_DEPTH;
+        variable v_remaining: unsigned(31 downto 0);
+    begin
+        if rising_edge(clk_in) then
+            v_stim_count := stim_count;
+            v_res_count := res_count;
+            v_remaining := batch_remaining;
+
+            if stim_push = '1' and stim_count < STIM_DEPTH then
+                stim_wr_ptr <= ptr_next(stim_wr_ptr, STIM_DEPTH);
+                v_stim_count := v_stim_count + 1;
+            end if;
+
+            if res_fifo_pop = '1' and res_count > 0 then
+                res_rd_ptr <= ptr_next(res_rd_ptr, RES_DEPTH);
+                v_res_count := v_res_count - 1;
+            end if;
+
+            if batch_run_pulse = '1' then
+                v_remaining := v_remaining + unsigned(batch_run);
+            end if;
+
+            case batch_state is
+                when BATCH_IDLE =>
+                    if batch_remaining /= 0 and stim_count /= 0 and res_count < RES_DEPTH then
+                        batch_state <= BATCH_READ;
+                    end if;
+
+                when BATCH_READ =>
+                    batch_feed <= from_slv(stim_q);
+                    stim_rd_ptr <= ptr_next(stim_rd_ptr, STIM_DEPTH);
+                    v_stim_count := v_stim_count - 1;
+                    batch_state <= BATCH_PULSE;
+
+                when BATCH_PULSE =>
+                    batch_state <= BATCH_CAPTURE;
+
+                when BATCH_CAPTURE =>
+                    if res.res_valid_out = '1' then
+                        res_wr_ptr <= ptr_next(res_wr_ptr, RES_DEPTH);
+                        v_res_count := v_res_count + 1;
+                    end if;
+                    v_remaining := v_remaining - 1;
+                    batch_state <= BATCH_IDLE;
+            end case;
+
+            stim_count <= v_stim_count;
+            res_count <= v_res_count;
+            batch_remaining <= v_remaining;
+
+            if dut_clk_req = '1' then
+                dut_cycles <= dut_cycles + 1;
+            end if;
+
+            if sreset_in = '1' then
+                stim_wr_ptr <= 0;
+                stim_rd_ptr <= 0;
+                stim_count <= 0;
+                res_wr_ptr <= 0;
+                res_rd_ptr <= 0;
+                res_count <= 0;
+                batch_remaining <= (others => '0');
+                batch_state <= BATCH_IDLE;
+                dut_cycles <= (others => '0');
+            end if;
+        end if;
+    end process;
+
+    process(all)
+    begin
+        batch_clk_req <= '0';
+        if batch_state = BATCH_PULSE then
+            batch_clk_req <= '1';
+        end if;
+
+        dut_feed <= feed;
+        if batch_state /= BATCH_IDLE then
+            dut_feed <= batch_feed;
+        end if;
+
+        status <= (others => '0');
+        status(0*32+31 downto 0*32) <= std_logic_vector(batch_remaining);
+        status(1*32+31 downto 1*32) <= std_logic_vector(dut_cycles);
+        status(2*32+31 downto 2*32) <= std_logic_vector(to_unsigned(stim_count, 32));
+        status(3*32+31 downto 3*32) <= std_logic_vector(to_unsigned(res_count, 32));
+        status(4*32+31 downto 4*32) <= std_logic_vector(to_unsigned(STIM_DEPTH, 32));
+        status(5*32+31 downto 5*32) <= std_logic_vector(to_unsigned(RES_DEPTH, 32));
+        status(6*32+31 downto 6*32) <= x"47" & std_logic_vector(to_unsigned(X_SIZE, 16)) & std_logic_vector(to_unsigned(y_bits, 8));
+    end process;
+
+    dut_clk_req <= run_reg_0_pulse or batch_clk_req;
+
+    crc_busy <= dut_clk_req or dut_clk_done or crc_rec_valid;
+
+    process(clk_in)
+        variable rec: std_logic_vector(res_rec_bits-1 downto 0);
+    begin
+        if rising_edge(clk_in) then
+            dut_clk_done <= dut_clk_req;
+
+            if dut_clk_req = '1' then
+                crc_cycles <= crc_cycles + 1;
+            end if;
+
+            rec := (others => '0');
+            rec(31 downto 0) := std_logic_vector(crc_cycles);
+            rec(AXI_DATA_BITS+res_bits-1 downto AXI_DATA_BITS) := res_slv;
+            crc_rec <= rec;
+            crc_rec_valid <= dut_clk_done and res.res_valid_out;
+
+            if crc_rec_valid = '1' then
+                crc <= crc_update(crc, crc_rec);
+                crc_count <= crc_count + 1;
+            end if;
+
+            if sreset_in = '1' or crc_clear = '1' then
+                dut_clk_done <= '0';
+                crc_cycles <= (others => '0');
+                crc_rec_valid <= '0';
+                crc <= (others => '1');
+                crc_count <= (others => '0');
+            end if;
+        end if;
+    end process;
 
     pulsed_clock_buf_i: BUFGCE
         generic map (
@@ -214,9 +500,9 @@ begin
         )
         port map(
             clk => dut_clk,
-            rst => feed.rst,
-            datavalid => feed.datavalid,
-            pix_in => feed.pix_in,
+            rst => dut_feed.rst,
+            datavalid => dut_feed.datavalid,
+            pix_in => dut_feed.pix_in,
             res_valid_out => res.res_valid_out,
             res_data_out => res.res_data_out
         );
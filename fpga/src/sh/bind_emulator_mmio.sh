@@ -0,0 +1,39 @@
+#!/usr/bin/env bash
+set -e
+
+# ---------------------------------------------------------------------
+# Moves the emulator device from UIO to the emulator_mmio driver
+# ---------------------------------------------------------------------
+#   sudo fpga/src/sh/bind_emulator_mmio.sh uio4
+#
+# Loads fpga/src/driver/emulator_mmio.ko unless the driver is present,
+# then rebinds the platform device behind /dev/<uio> with
+# driver_override and prints the /dev/emulator_mmio<N> it gets. Run it
+# again after every fpgautil -o, which binds the device to UIO.
+# ---------------------------------------------------------------------
+
+GIT_ROOT="$(cd "$(dirname "$0")/../../.." && pwd)"
+UIO="${1:?usage: $0 <uio device, e.g. uio4>}"
+MODULE="${GIT_ROOT}/fpga/src/driver/emulator_mmio.ko"
+DRIVER_DIR="/sys/bus/platform/drivers/emulator_mmio"
+
+if [ ! -e "/sys/class/uio/${UIO}/device" ]; then
+  echo "ERROR: /sys/class/uio/${UIO} not found"
+  exit 1
+fi
+DEV_DIR="$(readlink -f "/sys/class/uio/${UIO}/device")"
+DEV="$(basename "$DEV_DIR")"
+
+if [ ! -d "$DRIVER_DIR" ]; then
+  if [ ! -f "$MODULE" ]; then
+    echo "ERROR: $MODULE not found, build it with: make -C fpga/src/driver"
+    exit 1
+  fi
+  insmod "$MODULE"
+fi
+
+echo emulator_mmio > "${DEV_DIR}/driver_override"
+echo "$DEV" > "${DEV_DIR}/driver/unbind"
+echo "$DEV" > "${DRIVER_DIR}/bind"
+
+echo "${DEV}: /dev/$(ls "${DEV_DIR}/misc")"
@@ -0,0 +1,42 @@
+#!/usr/bin/env bash
+set -e
+
+# ---------------------------------------------------------------------
+# Runs the emulator_top testbenches of fpga/src/tb in GHDL (VHDL-2008).
+# The DUT is replaced by vhdl_linkruncca_stub.vhdl and BUFGCE by a
+# behavioural model; axil_slave and emulator_top are the RTL of
+# fpga/src/rtl.
+#
+#   fpga/src/sh/run_tb.sh                  all *_tb.vhdl
+#   fpga/src/sh/run_tb.sh emulator_top_batch_tb
+# ---------------------------------------------------------------------
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+SRC_DIR="$(dirname "$SCRIPT_DIR")"
+RTL_DIR="${SRC_DIR}/rtl"
+TB_DIR="${SRC_DIR}/tb"
+WORK_DIR="${GHDL_WORK_DIR:-${TMPDIR:-/tmp}/emulator_tb}"
+GHDL="${GHDL:-ghdl}"
+GHDL_FLAGS=(--std=08 "--workdir=${WORK_DIR}")
+
+mkdir -p "$WORK_DIR"
+rm -f "$WORK_DIR"/*.cf
+
+"$GHDL" -a "${GHDL_FLAGS[@]}" \
+  "${RTL_DIR}/vhdl_linkruncca_util_pkg.vhdl" \
+  "${RTL_DIR}/vhdl_linkruncca_pkg_ellipses_linescan.vhdl" \
+  "${TB_DIR}/bufgce_sim.vhdl" \
+  "${TB_DIR}/vhdl_linkruncca_stub.vhdl" \
+  "${RTL_DIR}/axil_slave.vhdl" \
+  "${RTL_DIR}/emulator_top.vhdl" \
+  "${TB_DIR}/emulator_tb_pkg.vhdl"
+
+if [ $# -eq 0 ]; then
+  set -- $(cd "$TB_DIR" && ls *_tb.vhdl | sed 's/\.vhdl$//')
+fi
+
+for tb in "$@"; do
+  echo "=== $tb ==="
+  "$GHDL" -a "${GHDL_FLAGS[@]}" "${TB_DIR}/${tb}.vhdl"
+  "$GHDL" --elab-run "${GHDL_FLAGS[@]}" "$tb" --ieee-asserts=disable --assert-level=error
+done
@@ -0,0 +1,30 @@
+library ieee;
+use ieee.std_logic_1164.all;
+
+-- Behavioural BUFGCE for simulating emulator_top without the unisim
+-- library. CE is sampled while I is low, so O passes whole pulses of
+-- I only (CE_TYPE "SYNC"): a DUT clock request during a fabric cycle
+-- clocks the DUT on the next rising edge of I.
+entity BUFGCE is
+    generic(
+        CE_TYPE: string := "SYNC"
+    );
+    port(
+        CE: in std_logic;
+        I: in std_logic;
+        O: out std_logic
+    );
+end;
+
+architecture sim of BUFGCE is
+    signal ce_low: std_logic := '0';
+begin
+    process(I, CE)
+    begin
+        if I = '0' then
+            ce_low <= CE;
+        end if;
+    end process;
+
+    O <= I and ce_low;
+end;
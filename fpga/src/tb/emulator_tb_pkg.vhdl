@@ -0,0 +1,300 @@
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+
+use work.vhdl_linkruncca_pkg.all;
+
+-- ------------------------------------------------------------
+-- emulator_top testbench support
+-- ------------------------------------------------------------
+-- AXI-Lite master procedures, the register map of emulator_top (AXI
+-- words, see include/emulator/batch_regs.h) and the feed and result
+-- records for the stub DUT of vhdl_linkruncca_stub.vhdl.
+package emulator_tb_pkg is
+    constant AXI_DATA_BITS: positive := 64;
+    constant AXI_BYTES: positive := AXI_DATA_BITS / 8;
+
+    constant RUN_REG: natural := 0;
+    constant BATCH_RUN: natural := 1;
+    constant BATCH_REMAINING: natural := 1;
+    constant DUT_CYCLES: natural := 2;
+    constant STIM_COUNT: natural := 3;
+    constant RES_COUNT: natural := 4;
+    constant STIM_DEPTH_REG: natural := 5;
+    constant RES_DEPTH_REG: natural := 6;
+    constant GEOMETRY: natural := 7;
+    constant RES_CRC: natural := 8;
+    constant FEED_WINDOW: natural := 16;
+    constant STIM_FIFO: natural := 64;
+    constant RES_FIFO: natural := 128;
+
+    -- master side of the AXI-Lite port
+    type axil_m_t is record
+        awvalid: std_logic;
+        awaddr: std_logic_vector(15 downto 0);
+        wvalid: std_logic;
+        wstrb: std_logic_vector(AXI_BYTES-1 downto 0);
+        wdata: std_logic_vector(AXI_DATA_BITS-1 downto 0);
+        bready: std_logic;
+        arvalid: std_logic;
+        araddr: std_logic_vector(15 downto 0);
+        rready: std_logic;
+    end record;
+
+    constant axil_m_idle: axil_m_t := (
+        awvalid => '0',
+        awaddr => (others => '0'),
+        wvalid => '0',
+        wstrb => (others => '0'),
+        wdata => (others => '0'),
+        bready => '0',
+        arvalid => '0',
+        araddr => (others => '0'),
+        rready => '0'
+    );
+
+    -- slave side of the AXI-Lite port
+    type axil_s_t is record
+        awready: std_logic;
+        wready: std_logic;
+        bvalid: std_logic;
+        arready: std_logic;
+        rvalid: std_logic;
+        rdata: std_logic_vector(AXI_DATA_BITS-1 downto 0);
+    end record;
+
+    -- handshakes give up (severity failure) after this many cycles
+    constant axil_timeout: positive := 1000;
+
+    -- Writes AXI word 'word' and waits for the write response, as a
+    -- store to the Device-nGnRnE UIO mapping does.
+    procedure axil_write(
+        signal clk: in std_logic;
+        signal m: out axil_m_t;
+        signal s: in axil_s_t;
+        word: natural;
+        data: natural;
+        strb: std_logic_vector(AXI_BYTES-1 downto 0) := (others => '1'));
+
+    procedure axil_write(
+        signal clk: in std_logic;
+        signal m: out axil_m_t;
+        signal s: in axil_s_t;
+        word: natural;
+        data: std_logic_vector;
+        strb: std_logic_vector(AXI_BYTES-1 downto 0) := (others => '1'));
+
+    -- Reads AXI word 'word'. The read is issued right away, like a load
+    -- that follows a store which got its write response.
+    procedure axil_read(
+        signal clk: in std_logic;
+        signal m: out axil_m_t;
+        signal s: in axil_s_t;
+        word: natural;
+        data: out std_logic_vector(AXI_DATA_BITS-1 downto 0));
+
+    procedure wait_cycles(signal clk: in std_logic; n: natural);
+
+    -- Writes a feed record to the feed window. The window holds whole
+    -- 32-bit words only, so the upper half of a last odd word is masked.
+    procedure write_feed(
+        signal clk: in std_logic;
+        signal m: out axil_m_t;
+        signal s: in axil_s_t;
+        rec: std_logic_vector);
+
+    -- Pushes a feed record into the stimulus FIFO.
+    procedure push_stim(
+        signal clk: in std_logic;
+        signal m: out axil_m_t;
+        signal s: in axil_s_t;
+        rec: std_logic_vector);
+
+    function feed_bits return natural;
+    function res_bits return natural;
+    -- AXI words of a result FIFO record: the cycle word and the result
+    function res_rec_awords return natural;
+
+    -- Feed record of emulator_top with rst = '0': rst, datavalid, pix_in
+    -- from bit 0 up.
+    function feed_record(datavalid: std_logic; in_label: std_logic; x: natural; y: natural) return std_logic_vector;
+
+    -- Result the stub DUT gives for a pixel with datavalid and in_label
+    -- set: res_valid_out, res_data_out from bit 0 up.
+    function res_record(x: natural; y: natural) return std_logic_vector;
+
+    -- CRC-32C step of emulator_top: data folded LSB first.
+    function crc32c(c: std_logic_vector(31 downto 0); data: std_logic_vector) return std_logic_vector;
+end;
+
+package body emulator_tb_pkg is
+    procedure axil_write(
+        signal clk: in std_logic;
+        signal m: out axil_m_t;
+        signal s: in axil_s_t;
+        word: natural;
+        data: natural;
+        strb: std_logic_vector(AXI_BYTES-1 downto 0) := (others => '1')) is
+    begin
+        axil_write(clk, m, s, word, std_logic_vector(to_unsigned(data, 32)), strb);
+    end;
+
+    procedure axil_write(
+        signal clk: in std_logic;
+        signal m: out axil_m_t;
+        signal s: in axil_s_t;
+        word: natural;
+        data: std_logic_vector;
+        strb: std_logic_vector(AXI_BYTES-1 downto 0) := (others => '1')) is
+    begin
+        m.awaddr <= std_logic_vector(to_unsigned(word * AXI_BYTES, 16));
+        m.awvalid <= '1';
+        m.wdata <= std_logic_vector(resize(unsigned(data), AXI_DATA_BITS));
+        m.wstrb <= strb;
+        m.wvalid <= '1';
+        for i in 1 to axil_timeout loop
+            wait until rising_edge(clk);
+            exit when s.awready = '1' and s.wready = '1';
+            assert i < axil_timeout report "axil_write: no awready for word " & integer'image(word) severity failure;
+        end loop;
+        m.awvalid <= '0';
+        m.wvalid <= '0';
+
+        m.bready <= '1';
+        for i in 1 to axil_timeout loop
+            wait until rising_edge(clk);
+            exit when s.bvalid = '1';
+            assert i < axil_timeout report "axil_write: no bvalid for word " & integer'image(word) severity failure;
+        end loop;
+        m.bready <= '0';
+    end;
+
+    procedure axil_read(
+        signal clk: in std_logic;
+        signal m: out axil_m_t;
+        signal s: in axil_s_t;
+        word: natural;
+        data: out std_logic_vector(AXI_DATA_BITS-1 downto 0)) is
+    begin
+        m.araddr <= std_logic_vector(to_unsigned(word * AXI_BYTES, 16));
+        m.arvalid <= '1';
+        m.rready <= '1';
+        for i in 1 to axil_timeout loop
+            wait until rising_edge(clk);
+            exit when s.arready = '1';
+            assert i < axil_timeout report "axil_read: no arready for word " & integer'image(word) severity failure;
+        end loop;
+        m.arvalid <= '0';
+
+        for i in 1 to axil_timeout loop
+            wait until rising_edge(clk);
+            exit when s.rvalid = '1';
+            assert i < axil_timeout report "axil_read: no rvalid for word " & integer'image(word) severity failure;
+        end loop;
+        data := s.rdata;
+        m.rready <= '0';
+    end;
+
+    procedure wait_cycles(signal clk: in std_logic; n: natural) is
+    begin
+        for i in 1 to n loop
+            wait until rising_edge(clk);
+        end loop;
+    end;
+
+    procedure write_feed(
+        signal clk: in std_logic;
+        signal m: out axil_m_t;
+        signal s: in axil_s_t;
+        rec: std_logic_vector) is
+        constant dwords: natural := (rec'length + 31) / 32;
+        constant awords: natural := (dwords + 1) / 2;
+        variable v: std_logic_vector(awords*AXI_DATA_BITS-1 downto 0) := (others => '0');
+        variable strb: std_logic_vector(AXI_BYTES-1 downto 0);
+    begin
+        v(rec'length-1 downto 0) := rec;
+        for w in 0 to awords-1 loop
+            strb := (others => '1');
+            if 2*w + 1 = dwords then
+                strb(AXI_BYTES-1 downto AXI_BYTES/2) := (others => '0');
+            end if;
+            axil_write(clk, m, s, FEED_WINDOW + w, v(w*AXI_DATA_BITS+AXI_DATA_BITS-1 downto w*AXI_DATA_BITS), strb);
+        end loop;
+    end;
+
+    procedure push_stim(
+        signal clk: in std_logic;
+        signal m: out axil_m_t;
+        signal s: in axil_s_t;
+        rec: std_logic_vector) is
+        constant awords: natural := (rec'length + AXI_DATA_BITS - 1) / AXI_DATA_BITS;
+        variable v: std_logic_vector(awords*AXI_DATA_BITS-1 downto 0) := (others => '0');
+    begin
+        v(rec'length-1 downto 0) := rec;
+        for w in 0 to awords-1 loop
+            axil_write(clk, m, s, STIM_FIFO + w, v(w*AXI_DATA_BITS+AXI_DATA_BITS-1 downto w*AXI_DATA_BITS));
+        end loop;
+    end;
+
+    function feed_bits return natural is
+        variable pix: linkruncca_collect_t;
+        constant tmp: std_logic_vector := to_slv(pix);
+    begin
+        return 2 + tmp'length;
+    end;
+
+    function res_bits return natural is
+        constant tmp: std_logic_vector := to_slv(linkruncca_feature_empty_val);
+    begin
+        return 1 + tmp'length;
+    end;
+
+    function res_rec_awords return natural is
+    begin
+        return 1 + (res_bits + AXI_DATA_BITS - 1) / AXI_DATA_BITS;
+    end;
+
+    function pixel(in_label: std_logic; x: natural; y: natural) return linkruncca_collect_t is
+        variable pix: linkruncca_collect_t;
+    begin
+        pix.in_label := in_label;
+        pix.x := to_unsigned(x, pix.x'length);
+        pix.y := to_unsigned(y, pix.y'length);
+        pix.has_red := '0';
+        pix.has_green := '0';
+        pix.has_blue := '0';
+        return pix;
+    end;
+
+    function feed_record(datavalid: std_logic; in_label: std_logic; x: natural; y: natural) return std_logic_vector is
+        variable v: std_logic_vector(feed_bits-1 downto 0);
+    begin
+        v(0) := '0';
+        v(1) := datavalid;
+        v(feed_bits-1 downto 2) := to_slv(pixel(in_label, x, y));
+        return v;
+    end;
+
+    function res_record(x: natural; y: natural) return std_logic_vector is
+        variable v: std_logic_vector(res_bits-1 downto 0);
+    begin
+        v(0) := '1';
+        v(res_bits-1 downto 1) := to_slv(linkruncca_feature_collect(pixel('1', x, y)));
+        return v;
+    end;
+
+    function crc32c(c: std_logic_vector(31 downto 0); data: std_logic_vector) return std_logic_vector is
+        constant poly: std_logic_vector(31 downto 0) := x"82F63B78";
+        variable v: std_logic_vector(31 downto 0);
+    begin
+        v := c;
+        for i in data'reverse_range loop
+            if (v(0) xor data(i)) = '1' then
+                v := ('0' & v(31 downto 1)) xor poly;
+            else
+                v := '0' & v(31 downto 1);
+            end if;
+        end loop;
+        return v;
+    end;
+end;
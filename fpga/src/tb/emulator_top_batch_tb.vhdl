@@ -0,0 +1,183 @@
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+
+use work.emulator_tb_pkg.all;
+
+-- ------------------------------------------------------------
+-- Batch FIFOs and FSM of emulator_top
+-- ------------------------------------------------------------
+-- Small FIFOs (STIM_DEPTH 8, RES_DEPTH 4) and the stub DUT, which
+-- gives one result per pixel with in_label set. Checks over AXI-Lite,
+-- as batch_replay() sees them:
+--   - depth registers and empty FIFOs after reset
+--   - a batch stalls on a full result FIFO and resumes after pops
+--   - result records carry the DUT cycle and the stub result, in order
+--   - a batch stalls on an empty stimulus FIFO and resumes after pushes
+--   - pushes into a full stimulus FIFO are dropped
+--   - unmapped words read x"DEADBEEF"
+entity emulator_top_batch_tb is
+end;
+
+architecture sim of emulator_top_batch_tb is
+    constant STIM_DEPTH: positive := 8;
+    constant RES_DEPTH: positive := 4;
+
+    signal clk: std_logic := '0';
+    signal sreset: std_logic := '1';
+    signal m: axil_m_t := axil_m_idle;
+    signal s: axil_s_t;
+    signal done: boolean := false;
+begin
+    clk <= not clk after 5 ns when not done;
+
+    dut: entity work.emulator_top
+        generic map(
+            STIM_DEPTH => STIM_DEPTH,
+            RES_DEPTH => RES_DEPTH
+        )
+        port map(
+            clk_in => clk,
+            sreset_in => sreset,
+            axil_awready => s.awready,
+            axil_awvalid => m.awvalid,
+            axil_awprot => "000",
+            axil_awaddr => m.awaddr,
+            axil_wready => s.wready,
+            axil_wvalid => m.wvalid,
+            axil_wstrb => m.wstrb,
+            axil_wdata => m.wdata,
+            axil_bready => m.bready,
+            axil_bvalid => s.bvalid,
+            axil_bresp => open,
+            axil_arready => s.arready,
+            axil_arvalid => m.arvalid,
+            axil_arprot => "000",
+            axil_araddr => m.araddr,
+            axil_rready => m.rready,
+            axil_rvalid => s.rvalid,
+            axil_rresp => open,
+            axil_rdata => s.rdata
+        );
+
+    process
+        variable errors: natural := 0;
+        variable d: std_logic_vector(AXI_DATA_BITS-1 downto 0);
+
+        procedure check_reg(word: natural; expected: natural; what: string) is
+            variable value: natural;
+        begin
+            axil_read(clk, m, s, word, d);
+            value := to_integer(unsigned(d(31 downto 0)));
+            if value /= expected then
+                report what & " = " & integer'image(value) & ", expected " & integer'image(expected) severity error;
+                errors := errors + 1;
+            end if;
+        end;
+
+        procedure push(in_label: std_logic; x: natural) is
+        begin
+            push_stim(clk, m, s, feed_record('1', in_label, x, x));
+        end;
+
+        -- Waits for a result record, pops it and checks it.
+        procedure pop(cycle: natural; x: natural) is
+            variable rec: std_logic_vector(res_rec_awords*AXI_DATA_BITS-1 downto 0);
+        begin
+            for i in 1 to 100 loop
+                axil_read(clk, m, s, RES_COUNT, d);
+                exit when unsigned(d(31 downto 0)) /= 0;
+                assert i < 100 report "pop: result FIFO stays empty" severity failure;
+            end loop;
+            for w in 0 to res_rec_awords-1 loop
+                axil_read(clk, m, s, RES_FIFO + w, d);
+                rec(w*AXI_DATA_BITS+AXI_DATA_BITS-1 downto w*AXI_DATA_BITS) := d;
+            end loop;
+            if to_integer(unsigned(rec(31 downto 0))) /= cycle then
+                report "result cycle " & integer'image(to_integer(unsigned(rec(31 downto 0))))
+                    & ", expected " & integer'image(cycle) severity error;
+                errors := errors + 1;
+            end if;
+            if rec(AXI_DATA_BITS+res_bits-1 downto AXI_DATA_BITS) /= res_record(x, x) then
+                report "result of cycle " & integer'image(cycle) & " differs from pixel " & integer'image(x) severity error;
+                errors := errors + 1;
+            end if;
+        end;
+    begin
+        wait_cycles(clk, 4);
+        sreset <= '0';
+        wait_cycles(clk, 2);
+
+        -- rst = '0', no pixel in the feed window
+        write_feed(clk, m, s, feed_record('0', '0', 0, 0));
+
+        check_reg(STIM_DEPTH_REG, STIM_DEPTH, "STIM_DEPTH");
+        check_reg(RES_DEPTH_REG, RES_DEPTH, "RES_DEPTH");
+        check_reg(STIM_COUNT, 0, "STIM_COUNT after reset");
+        check_reg(RES_COUNT, 0, "RES_COUNT after reset");
+        check_reg(BATCH_REMAINING, 0, "BATCH_REMAINING after reset");
+
+        -- six results into a result FIFO of four: stalls after four clocks
+        for i in 0 to 5 loop
+            push('1', 10 + i);
+        end loop;
+        check_reg(STIM_COUNT, 6, "STIM_COUNT after 6 pushes");
+        axil_write(clk, m, s, BATCH_RUN, 6);
+        wait_cycles(clk, 50);
+        check_reg(RES_COUNT, RES_DEPTH, "RES_COUNT, result FIFO full");
+        check_reg(BATCH_REMAINING, 2, "BATCH_REMAINING, result FIFO full");
+        check_reg(STIM_COUNT, 2, "STIM_COUNT, result FIFO full");
+        check_reg(DUT_CYCLES, 4, "DUT_CYCLES, result FIFO full");
+
+        -- one pop lets one more clock run
+        pop(1, 10);
+        wait_cycles(clk, 20);
+        check_reg(RES_COUNT, RES_DEPTH, "RES_COUNT after one pop");
+        check_reg(BATCH_REMAINING, 1, "BATCH_REMAINING after one pop");
+        check_reg(DUT_CYCLES, 5, "DUT_CYCLES after one pop");
+
+        for i in 1 to 5 loop
+            pop(1 + i, 10 + i);
+        end loop;
+        wait_cycles(clk, 20);
+        check_reg(RES_COUNT, 0, "RES_COUNT after the batch");
+        check_reg(BATCH_REMAINING, 0, "BATCH_REMAINING after the batch");
+        check_reg(STIM_COUNT, 0, "STIM_COUNT after the batch");
+        check_reg(DUT_CYCLES, 6, "DUT_CYCLES after the batch");
+
+        -- clocks without stimulus wait for it; pixels without in_label give no result
+        axil_write(clk, m, s, BATCH_RUN, 3);
+        wait_cycles(clk, 50);
+        check_reg(BATCH_REMAINING, 3, "BATCH_REMAINING, stimulus FIFO empty");
+        check_reg(DUT_CYCLES, 6, "DUT_CYCLES, stimulus FIFO empty");
+        for i in 0 to 2 loop
+            push('0', i);
+        end loop;
+        wait_cycles(clk, 50);
+        check_reg(BATCH_REMAINING, 0, "BATCH_REMAINING after late stimulus");
+        check_reg(DUT_CYCLES, 9, "DUT_CYCLES after late stimulus");
+        check_reg(RES_COUNT, 0, "RES_COUNT without in_label");
+
+        -- a push into a full stimulus FIFO is dropped
+        for i in 0 to STIM_DEPTH loop
+            push('0', i);
+        end loop;
+        check_reg(STIM_COUNT, STIM_DEPTH, "STIM_COUNT after overfilling");
+        axil_write(clk, m, s, BATCH_RUN, STIM_DEPTH);
+        wait_cycles(clk, 100);
+        check_reg(BATCH_REMAINING, 0, "BATCH_REMAINING after a full FIFO");
+        check_reg(STIM_COUNT, 0, "STIM_COUNT after a full FIFO");
+        check_reg(DUT_CYCLES, 9 + STIM_DEPTH, "DUT_CYCLES after a full FIFO");
+
+        axil_read(clk, m, s, RES_CRC + 1, d);
+        if d /= x"DEADBEEF_DEADBEEF" then
+            report "unmapped word does not read x""DEADBEEF""" severity error;
+            errors := errors + 1;
+        end if;
+
+        assert errors = 0 report "emulator_top_batch_tb: " & integer'image(errors) & " checks failed" severity failure;
+        report "emulator_top_batch_tb: all checks passed";
+        done <= true;
+        wait;
+    end process;
+end;
@@ -0,0 +1,156 @@
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+
+use work.emulator_tb_pkg.all;
+
+-- ------------------------------------------------------------
+-- Result CRC of emulator_top
+-- ------------------------------------------------------------
+-- The CRC is folded three fabric cycles after a DUT clock request.
+-- The host reads RES_CRC right after the write response of the clock
+-- pulse, so the read must wait for the fold. Checks, against a CRC
+-- computed here for the stub DUT (see result_crc.h for the record):
+--   - clear: initial CRC, count 0
+--   - a RES_CRC read right after each single-step pulse covers it
+--   - clocks without a result advance the record cycle only
+--   - back-to-back pulses, then one read
+--   - the value is stable while no clock runs
+--   - a read during a batch completes, a read after it covers it all
+entity emulator_top_crc_tb is
+end;
+
+architecture sim of emulator_top_crc_tb is
+    signal clk: std_logic := '0';
+    signal sreset: std_logic := '1';
+    signal m: axil_m_t := axil_m_idle;
+    signal s: axil_s_t;
+    signal done: boolean := false;
+begin
+    clk <= not clk after 5 ns when not done;
+
+    dut: entity work.emulator_top
+        port map(
+            clk_in => clk,
+            sreset_in => sreset,
+            axil_awready => s.awready,
+            axil_awvalid => m.awvalid,
+            axil_awprot => "000",
+            axil_awaddr => m.awaddr,
+            axil_wready => s.wready,
+            axil_wvalid => m.wvalid,
+            axil_wstrb => m.wstrb,
+            axil_wdata => m.wdata,
+            axil_bready => m.bready,
+            axil_bvalid => s.bvalid,
+            axil_bresp => open,
+            axil_arready => s.arready,
+            axil_arvalid => m.arvalid,
+            axil_arprot => "000",
+            axil_araddr => m.araddr,
+            axil_rready => m.rready,
+            axil_rvalid => s.rvalid,
+            axil_rresp => open,
+            axil_rdata => s.rdata
+        );
+
+    process
+        variable errors: natural := 0;
+        variable d: std_logic_vector(AXI_DATA_BITS-1 downto 0);
+
+        -- expected CRC register
+        variable crc: std_logic_vector(31 downto 0);
+        variable count: natural;
+        variable cycles: natural;
+
+        procedure expect_clear is
+        begin
+            crc := x"FFFFFFFF";
+            count := 0;
+            cycles := 0;
+        end;
+
+        -- One DUT clock of pixel (x, y); in_label = '1' gives a result.
+        procedure expect_clock(in_label: std_logic; x: natural; y: natural) is
+            variable rec: std_logic_vector(res_rec_awords*AXI_DATA_BITS-1 downto 0);
+        begin
+            cycles := cycles + 1;
+            if in_label = '1' then
+                rec := (others => '0');
+                rec(31 downto 0) := std_logic_vector(to_unsigned(cycles, 32));
+                rec(AXI_DATA_BITS+res_bits-1 downto AXI_DATA_BITS) := res_record(x, y);
+                crc := crc32c(crc, rec);
+                count := count + 1;
+            end if;
+        end;
+
+        procedure check_crc(what: string) is
+        begin
+            axil_read(clk, m, s, RES_CRC, d);
+            if d(31 downto 0) /= crc or to_integer(unsigned(d(63 downto 32))) /= count then
+                report what & ": RES_CRC count " & integer'image(to_integer(unsigned(d(63 downto 32))))
+                    & ", expected " & integer'image(count) & " (crc differs: "
+                    & boolean'image(d(31 downto 0) /= crc) & ")" severity error;
+                errors := errors + 1;
+            end if;
+        end;
+
+        -- Single step: feed window, clock pulse, then the CRC read at once.
+        procedure step(in_label: std_logic; x: natural; y: natural) is
+        begin
+            write_feed(clk, m, s, feed_record('1', in_label, x, y));
+            axil_write(clk, m, s, RUN_REG, 1);
+            expect_clock(in_label, x, y);
+            check_crc("read right after pulse " & integer'image(cycles));
+        end;
+    begin
+        wait_cycles(clk, 4);
+        sreset <= '0';
+        wait_cycles(clk, 2);
+
+        axil_write(clk, m, s, RES_CRC, 0);
+        expect_clear;
+        check_crc("after clear");
+
+        for i in 1 to 12 loop
+            if i mod 3 = 0 then
+                step('0', i, i);
+            else
+                step('1', 7 * i, 100 + i);
+            end if;
+        end loop;
+
+        -- three pulses, each waiting for its write response, then one read
+        write_feed(clk, m, s, feed_record('1', '1', 5, 6));
+        for i in 1 to 3 loop
+            axil_write(clk, m, s, RUN_REG, 1);
+            expect_clock('1', 5, 6);
+        end loop;
+        check_crc("read after three pulses");
+
+        wait_cycles(clk, 20);
+        check_crc("read after idle cycles");
+
+        -- a batch: a read while it runs must complete, one after it covers it
+        write_feed(clk, m, s, feed_record('0', '0', 0, 0));
+        for i in 0 to 7 loop
+            push_stim(clk, m, s, feed_record('1', '1', 20 + i, i));
+        end loop;
+        axil_write(clk, m, s, BATCH_RUN, 8);
+        axil_read(clk, m, s, RES_CRC, d);
+        for i in 0 to 7 loop
+            expect_clock('1', 20 + i, i);
+        end loop;
+        wait_cycles(clk, 100);
+        check_crc("read after a batch");
+
+        axil_write(clk, m, s, RES_CRC, 0);
+        expect_clear;
+        check_crc("after second clear");
+
+        assert errors = 0 report "emulator_top_crc_tb: " & integer'image(errors) & " checks failed" severity failure;
+        report "emulator_top_crc_tb: all checks passed";
+        done <= true;
+        wait;
+    end process;
+end;
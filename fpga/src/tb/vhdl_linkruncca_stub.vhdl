@@ -0,0 +1,39 @@
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+
+use work.vhdl_linkruncca_pkg.all;
+
+-- Stand-in for vhdl_linkruncca in the emulator_top testbenches. Every
+-- DUT clock with datavalid and in_label set gives a result, the
+-- single-pixel feature of that pixel (linkruncca_feature_collect), so
+-- a testbench knows each record the result FIFO and the CRC must see.
+entity vhdl_linkruncca is
+    generic(
+        imwidth: integer := 130;
+        imheight: integer := 130
+    );
+    port(
+        clk: in std_logic;
+        rst: in std_logic;
+        datavalid: in std_logic;
+        pix_in: in linkruncca_collect_t;
+        res_valid_out: out std_logic;
+        res_data_out: out linkruncca_feature_t
+    );
+end;
+
+architecture stub of vhdl_linkruncca is
+begin
+    process(clk)
+    begin
+        if rising_edge(clk) then
+            res_valid_out <= datavalid and pix_in.in_label;
+            res_data_out <= linkruncca_feature_collect(pix_in);
+
+            if rst = '1' then
+                res_valid_out <= '0';
+            end if;
+        end if;
+    end process;
+end;
@@ -0,0 +1,58 @@
+# ================================================================
+#  Synthesis, implementation and timing reports
+# ================================================================
+#  vivado -mode batch -source fpga/src/tcl/run_timing.tcl
+#
+#  Creates the project with create_vivado_project.tcl unless one is
+#  open, runs implementation and writes to fpga_proj/reports:
+#    timing_summary.rpt   report_timing_summary of the routed design
+#    utilization.rpt      hierarchical utilization
+#    emulator_top.rpt     worst paths inside emulator_top
+#    crc_fold.rpt         paths into the result CRC register, which
+#                         folds a whole result record per cycle
+#  Fails if setup or hold slack is negative.
+# ================================================================
+set tcl_dir [file dirname [file normalize [info script]]]
+
+if {[catch {current_project}]} {
+    source [file join $tcl_dir create_vivado_project.tcl]
+}
+
+set proj_dir   [get_property directory [current_project]]
+set report_dir [file join $proj_dir reports]
+file mkdir $report_dir
+
+# ================================================================
+#  Run synthesis and implementation
+# ================================================================
+reset_run synth_1
+launch_runs impl_1 -jobs 4
+wait_on_run impl_1
+
+if {[get_property PROGRESS [get_runs impl_1]] != "100%"} {
+    error "Implementation failed, see [get_property DIRECTORY [get_runs impl_1]]"
+}
+
+open_run impl_1
+
+# ================================================================
+#  Reports
+# ================================================================
+report_timing_summary -max_paths 10 -report_unconstrained -file [file join $report_dir timing_summary.rpt]
+report_utilization -hierarchical -file [file join $report_dir utilization.rpt]
+
+set emulator_cells [get_cells -hierarchical -filter {NAME =~ *emulator_top_i/*}]
+report_timing -through $emulator_cells -max_paths 20 -nworst 1 -sort_by slack \
+    -file [file join $report_dir emulator_top.rpt]
+
+set crc_cells [get_cells -hierarchical -filter {NAME =~ *emulator_top_i/crc_reg*}]
+report_timing -to $crc_cells -max_paths 32 -nworst 1 -sort_by slack \
+    -file [file join $report_dir crc_fold.rpt]
+
+set wns [get_property SLACK [get_timing_paths -setup -max_paths 1 -nworst 1]]
+set whs [get_property SLACK [get_timing_paths -hold -max_paths 1 -nworst 1]]
+puts "WNS: $wns ns, WHS: $whs ns, reports in $report_dir"
+
+if {$wns < 0 || $whs < 0} {
+    error "Timing not met: WNS $wns ns, WHS $whs ns"
+}
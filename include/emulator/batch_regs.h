@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// ------------------------------------------------------------
+// BATCH MODE REGISTER MAP OF emulator_top
+// ------------------------------------------------------------
+//
+// Byte addresses, for AXI_DATA_BITS = 64. Must match emulator_top.vhdl.
+//
+//   STIM_FIFO  (W)  one feed record per push; writing the last AXI word
+//                   of the record pushes it.
+//   BATCH_RUN  (W)  adds N DUT clocks to the batch. Each clock consumes
+//                   one stimulus record.
+//   RES_FIFO   (R)  head result record: AXI word 0 is the DUT cycle
+//                   counter after that clock (bits 31..0), followed by
+//                   the result words in the same packing as the result
+//                   window. Reading the last AXI word pops the record.
+//   status     (R)  32-bit counters, see below.
+//   GEOMETRY   (R)  0x47 << 24 | X_SIZE << 8 | Y_BITS of the DUT.
+//   RES_CRC    (R)  CRC of the result stream (bits 31..0) and number of
+//                   valid results (bits 63..32), see result_crc.h.
+//                   The read response waits until the DUT clocks
+//                   pulsed before it are folded in (a few fabric
+//                   cycles); during a batch it covers the clocks run
+//                   so far.
+//              (W)  any value restarts the CRC, the count and the
+//                   cycle numbering of the records.
+//
+// Only clocks with res_valid_out = '1' produce a result record. The
+// batch stalls while the stimulus FIFO is empty or the result FIFO
+// is full.
+//
+
+struct batch_regs {
+    static constexpr size_t AXI_BYTES = 8;
+
+    static constexpr size_t BATCH_RUN       = 1 * AXI_BYTES;
+    static constexpr size_t BATCH_REMAINING = 1 * AXI_BYTES;
+    static constexpr size_t DUT_CYCLES      = 2 * AXI_BYTES;
+    static constexpr size_t STIM_COUNT      = 3 * AXI_BYTES;
+    static constexpr size_t RES_COUNT       = 4 * AXI_BYTES;
+    static constexpr size_t STIM_DEPTH      = 5 * AXI_BYTES;
+    static constexpr size_t RES_DEPTH       = 6 * AXI_BYTES;
+    static constexpr size_t GEOMETRY        = 7 * AXI_BYTES;
+    static constexpr size_t RES_CRC         = 8 * AXI_BYTES;
+
+    static constexpr size_t STIM_FIFO       = 64 * AXI_BYTES;
+    static constexpr size_t RES_FIFO        = 128 * AXI_BYTES;
+
+    // emulator_top generic defaults
+    static constexpr size_t default_stim_depth = 2048;
+    static constexpr size_t default_res_depth = 512;
+
+    // Larger STIM_DEPTH / RES_DEPTH values mean a bitstream without the
+    // batch FIFOs, whose status words read 0xDEADBEEF or stale data.
+    static constexpr size_t max_depth = 1 << 16;
+
+    // GEOMETRY register value; older bitstreams read 0xDEADBEEF there.
+    static constexpr uint32_t GEOMETRY_TAG = 0x47;
+
+    static constexpr uint32_t geometry_id(size_t x_size, size_t y_bits) noexcept {
+        return (GEOMETRY_TAG << 24) | (static_cast<uint32_t>(x_size & 0xffff) << 8) | static_cast<uint32_t>(y_bits & 0xff);
+    }
+    static constexpr bool geometry_valid(uint32_t id) noexcept { return (id >> 24) == GEOMETRY_TAG; }
+    static constexpr size_t geometry_x_size(uint32_t id) noexcept { return (id >> 8) & 0xffff; }
+    static constexpr size_t geometry_y_bits(uint32_t id) noexcept { return id & 0xff; }
+};
@@ -1,5 +1,12 @@
 #pragma once
 
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "stats.h"
+
 template <typename shadow_t>
 class bit_slicer {
 public:
@@ -16,6 +23,9 @@ public:
         auto begin_idx = bit_offset / ATOMIC_BITS;
         auto end_idx   = (bit_offset + bit_width - 1) / ATOMIC_BITS;
 
+        stats_.wr_bits_calls.add();
+        stats_.wr_words.add(end_idx - begin_idx + 1);
+
         for (auto idx = begin_idx; idx <= end_idx; ++idx) {
             size_t bit_begin = (idx == begin_idx) ? (bit_offset % ATOMIC_BITS) : 0;
             size_t bit_end   = (idx == end_idx)
@@ -39,6 +49,26 @@ public:
         }
     }
 
+    // Compile-time variant: word span, shifts and masks are constants,
+    // each touched word costs one masked write to the shadow.
+    template<size_t BIT_OFFSET, size_t BIT_WIDTH, typename word_t>
+    inline void write_bits(const word_t &data) {
+        using atomic_t = typename shadow_t::wr_word_t;
+        static constexpr size_t ATOMIC_BITS = sizeof(atomic_t) * 8;
+
+        static_assert(BIT_WIDTH > 0, "write_bits: width of zero not allowed");
+
+        constexpr size_t begin_idx = BIT_OFFSET / ATOMIC_BITS;
+        constexpr size_t end_idx   = (BIT_OFFSET + BIT_WIDTH - 1) / ATOMIC_BITS;
+
+        stats_.wr_bits_calls.add();
+        stats_.wr_words.add(end_idx - begin_idx + 1);
+
+        [&]<size_t... I>(std::index_sequence<I...>) {
+            (write_word<BIT_OFFSET, BIT_WIDTH, begin_idx + I>(data), ...);
+        }(std::make_index_sequence<end_idx - begin_idx + 1>{});
+    }
+
     inline void wr_hw(size_t word_address, typename shadow_t::wr_word_t data) {
         shadow_.wr_hw(word_address, data);
     }
@@ -59,6 +89,14 @@ public:
         auto begin_idx = bit_offset / ATOMIC_BITS;
         auto end_idx   = (bit_offset + bit_width - 1) / ATOMIC_BITS;
 
+        stats_.rd_bits_calls.add();
+        stats_.rd_words.add(end_idx - begin_idx + 1);
+
+        // A field spanning words may fetch them in bursts.
+        if constexpr (requires { shadow_.rd_fetch(begin_idx, end_idx); })
+            if (end_idx > begin_idx)
+                shadow_.rd_fetch(begin_idx, end_idx);
+
         for (auto idx = begin_idx; idx <= end_idx; ++idx) {
             atomic_t word = shadow_.read(idx);
 
@@ -83,6 +121,31 @@ public:
         return r;
     }
 
+    // Compile-time variant of read_bits().
+    template<size_t BIT_OFFSET, size_t BIT_WIDTH, typename word_t>
+    inline word_t read_bits() {
+        using atomic_t = typename shadow_t::rd_word_t;
+        static constexpr size_t ATOMIC_BITS = sizeof(atomic_t) * 8;
+
+        static_assert(BIT_WIDTH > 0, "read_bits: width of zero not allowed");
+        static_assert(BIT_WIDTH <= sizeof(word_t) * 8, "read_bits: reading field wider than word_t");
+
+        constexpr size_t begin_idx = BIT_OFFSET / ATOMIC_BITS;
+        constexpr size_t end_idx   = (BIT_OFFSET + BIT_WIDTH - 1) / ATOMIC_BITS;
+
+        stats_.rd_bits_calls.add();
+        stats_.rd_words.add(end_idx - begin_idx + 1);
+
+        if constexpr (end_idx > begin_idx && requires { shadow_.template rd_fetch<begin_idx, end_idx>(); })
+            shadow_.template rd_fetch<begin_idx, end_idx>();
+
+        word_t r = 0;
+        [&]<size_t... I>(std::index_sequence<I...>) {
+            (read_word<BIT_OFFSET, BIT_WIDTH, begin_idx + I>(r), ...);
+        }(std::make_index_sequence<end_idx - begin_idx + 1>{});
+        return r;
+    }
+
     inline typename shadow_t::rd_word_t rd_hw(size_t word_address) {
         return shadow_.rd_hw(word_address);
     }
@@ -94,6 +157,59 @@ public:
     inline void rd_flush() {
         shadow_.rd_flush();
     }
+
+    // Empty unless EMULATOR_STATS is defined (see stats.h).
+    inline const slicer_stats &stats() const noexcept {
+        return stats_;
+    }
 private:
+    template<size_t BIT_OFFSET, size_t BIT_WIDTH, size_t IDX, typename word_t>
+    inline void write_word(const word_t &data) {
+        using atomic_t = typename shadow_t::wr_word_t;
+        static constexpr size_t ATOMIC_BITS = sizeof(atomic_t) * 8;
+
+        constexpr size_t begin_idx = BIT_OFFSET / ATOMIC_BITS;
+        constexpr size_t end_idx   = (BIT_OFFSET + BIT_WIDTH - 1) / ATOMIC_BITS;
+        constexpr size_t bit_begin = (IDX == begin_idx) ? (BIT_OFFSET % ATOMIC_BITS) : 0;
+        constexpr size_t bit_end   = (IDX == end_idx)
+                                   ? ((BIT_OFFSET + BIT_WIDTH - 1) % ATOMIC_BITS)
+                                   : (ATOMIC_BITS - 1);
+        constexpr size_t wr_bits   = bit_end - bit_begin + 1;
+        constexpr size_t src_pos   = IDX * ATOMIC_BITS + bit_begin - BIT_OFFSET;
+
+        constexpr atomic_t mask = (wr_bits == ATOMIC_BITS)
+                                ? ~atomic_t(0)
+                                : ((atomic_t(1) << wr_bits) - 1);
+
+        atomic_t v = 0;
+        if constexpr (!std::is_integral_v<word_t> || src_pos < sizeof(word_t) * 8)
+            v = static_cast<atomic_t>((data >> src_pos) & mask);
+
+        shadow_.template write<IDX>(atomic_t(v << bit_begin), atomic_t(mask << bit_begin));
+    }
+
+    template<size_t BIT_OFFSET, size_t BIT_WIDTH, size_t IDX, typename word_t>
+    inline void read_word(word_t &r) {
+        using atomic_t = typename shadow_t::rd_word_t;
+        static constexpr size_t ATOMIC_BITS = sizeof(atomic_t) * 8;
+
+        constexpr size_t begin_idx = BIT_OFFSET / ATOMIC_BITS;
+        constexpr size_t end_idx   = (BIT_OFFSET + BIT_WIDTH - 1) / ATOMIC_BITS;
+        constexpr size_t bit_begin = (IDX == begin_idx) ? (BIT_OFFSET % ATOMIC_BITS) : 0;
+        constexpr size_t bit_end   = (IDX == end_idx)
+                                   ? ((BIT_OFFSET + BIT_WIDTH - 1) % ATOMIC_BITS)
+                                   : (ATOMIC_BITS - 1);
+        constexpr size_t rd_bits   = bit_end - bit_begin + 1;
+        constexpr size_t dst_pos   = IDX * ATOMIC_BITS + bit_begin - BIT_OFFSET;
+
+        constexpr atomic_t mask = (rd_bits == ATOMIC_BITS)
+                                ? ~atomic_t(0)
+                                : ((atomic_t(1) << rd_bits) - 1);
+
+        atomic_t rd_word = (shadow_.template read<IDX>() >> bit_begin) & mask;
+        r |= word_t(rd_word) << dst_pos;
+    }
+
     shadow_t &shadow_;
+    [[no_unique_address]] slicer_stats stats_;
 };
@@ -1,6 +1,21 @@
 #pragma once
 
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <format>
+#include <ostream>
+#include <stdexcept>
+
 #include "fields.h"
+#include "stimulus_image.h"
+#include "result_image.h"
+#include "batch_regs.h"
+#include "result_crc.h"
+#include "hw_burst.h"
+#include "trace_recorder.h"
+#include "stats.h"
 
 template<typename HW, typename FIELDS>
 class emulator_fields {
@@ -14,6 +29,17 @@ public:
 
     using fields_t = fields<FIELDS>;
 
+    using stimulus_t = stimulus_image<HW, FIELDS>;
+    using result_t = result_image<HW, FIELDS>;
+    using trace_t = trace_recorder<HW, FIELDS>;
+
+    // Batch mode needs hw words as wide as the AXI data bus.
+    static constexpr bool batch_supported =
+        sizeof(wr_raw_t) == batch_regs::AXI_BYTES && sizeof(rd_raw_t) == batch_regs::AXI_BYTES;
+
+    // batch_replay() gives up after this long without progress.
+    static constexpr std::chrono::milliseconds batch_stall_timeout{1000};
+
     emulator_fields(HW &hw) : 
         hw_(hw), shadow_(hw), slicer_(shadow_)
     {}
@@ -21,15 +47,45 @@ public:
     template<typename word_t>
     inline void wr_field(fields_t::wr_fields field, word_t data) {
         auto desc = fields_t::wr_desc(field);
+        wr_counts_.add(static_cast<size_t>(field));
         slicer_.write_bits(desc.bit_offset, desc.bit_width, data);
     }
 
     template<typename word_t>
     inline void rd_field(fields_t::rd_fields field, word_t &data) {
         auto desc = fields_t::rd_desc(field);
+        rd_counts_.add(static_cast<size_t>(field));
         data = slicer_.template read_bits<word_t>(desc.bit_offset, desc.bit_width);
     }
 
+    // Compile-time field: resolves to one masked write per touched word.
+    template<wr_fields FIELD, typename word_t>
+    inline void wr_field(const word_t &data) {
+        constexpr auto desc = fields_t::template wr_desc<FIELD>();
+        wr_counts_.add(static_cast<size_t>(FIELD));
+        slicer_.template write_bits<desc.bit_offset, desc.bit_width>(data);
+    }
+
+    template<rd_fields FIELD, typename word_t>
+    inline void rd_field(word_t &data) {
+        constexpr auto desc = fields_t::template rd_desc<FIELD>();
+        rd_counts_.add(static_cast<size_t>(FIELD));
+        data = slicer_.template read_bits<desc.bit_offset, desc.bit_width, word_t>();
+    }
+
+    template<rd_fields FIELD,
+             typename word_t = field_uint_t<fields_t::template rd_desc<FIELD>().bit_width>>
+    inline word_t rd_field() {
+        word_t data;
+        rd_field<FIELD>(data);
+        return data;
+    }
+
+    // Copies all result words of the current clock for later decoding.
+    inline void rd_capture(result_t &result) {
+        shadow_.rd_copy(result.words);
+    }
+
     inline void wr_flush() {
         slicer_.wr_flush();
     }
@@ -39,15 +95,250 @@ public:
     }
 
     inline void wr_raw(size_t word_address, wr_raw_t data) {
+        if (trace_ && word_address == 0 && (data & 1)) {
+            typename trace_t::wr_image_t image;
+            shadow_.wr_copy(image);
+            trace_clock(image);
+        }
         shadow_.wr_raw(word_address, data);
     }
 
+    // Records every following clock (single steps and replay) into trace.
+    inline void trace_attach(trace_t &trace) noexcept {
+        trace_ = &trace;
+    }
+
+    // Closes the last recorded clock with the reads after it.
+    inline void trace_detach() {
+        if (trace_)
+            trace_->finish([&](typename trace_t::rd_image_t &rd) { return shadow_.rd_snapshot(rd); });
+        trace_ = nullptr;
+    }
+
     inline rd_raw_t rd_raw(size_t word_address) {
         return shadow_.rd_raw(word_address);
     }
+
+    // Streams pre-packed clocks to hw: changed words, then a clock pulse.
+    // on_clock(clock_index) runs after each pulse; returning false stops
+    // the replay. Returns the number of clocks issued.
+    template<typename on_clock_t>
+    inline size_t replay(const stimulus_t &stimulus, on_clock_t &&on_clock) {
+        using mask_t = typename stimulus_t::mask_t;
+
+        typename stimulus_t::image_t image;
+        shadow_.wr_flush();
+        shadow_.wr_copy(image);
+
+        const mask_t *masks = stimulus.masks();
+        const wr_raw_t *words = stimulus.words();
+        const size_t clocks = stimulus.clocks();
+
+        size_t accesses = 0;
+        size_t clk = 0;
+        while (clk < clocks) {
+            if constexpr (hw_burst_words<HW> == 1) {
+                for (mask_t m = masks[clk]; m; m &= m - 1) {
+                    size_t idx = std::countr_zero(m);
+                    image[idx] = *words;
+                    hw_.wr(idx, *words++);
+                    accesses++;
+                }
+            } else {
+                for (mask_t m = masks[clk]; m; m &= m - 1)
+                    image[std::countr_zero(m)] = *words++;
+                accesses += hw_wr_groups(hw_, masks[clk], 0, image.data(), image.size());
+            }
+            if (trace_)
+                trace_clock(image);
+            hw_.wr_raw(0, 1);
+            if (!on_clock(clk++))
+                break;
+        }
+
+        auto &stats = shadow_.stats();
+        stats.mmio_wr.add(accesses + clk);
+        stats.clock_pulses.add(clk);
+
+        shadow_.wr_sync(image);
+        return clk;
+    }
+
+    // Runs up to max_clocks clocks of stimulus through the hw stimulus
+    // and result FIFOs, without a register write, clock pulse or VALID
+    // read per clock. on_result(cycle, result) runs for every clock with
+    // VALID set; cycle is the hw DUT cycle counter after that clock.
+    // Returns the number of clocks run.
+    //
+    // The feed register image carries over from the previous call, like
+    // consecutive replay() calls. The feed window itself is not written,
+    // it must hold RST=0 while batches run.
+    //
+    // Throws std::runtime_error if the bitstream has no batch FIFOs, or
+    // if the batch makes no progress (no record pushed or drained, no
+    // change of BATCH_REMAINING) for batch_stall_timeout.
+    template<typename on_result_t>
+    size_t batch_replay(const stimulus_t &stimulus, size_t max_clocks, on_result_t &&on_result) {
+        static_assert(batch_supported, "batch_replay() needs 64-bit hw words.");
+        using mask_t = typename stimulus_t::mask_t;
+
+        const mask_t *masks = stimulus.masks();
+        const wr_raw_t *words = stimulus.words();
+        const size_t clocks = std::min(stimulus.clocks(), max_clocks);
+        const size_t stim_depth = batch_status(batch_regs::STIM_DEPTH);
+        if (stim_depth == 0 || stim_depth > batch_regs::max_depth)
+            throw std::runtime_error(std::format(
+                "batch_replay: STIM_DEPTH reads {:#x}, the bitstream has no batch FIFOs", stim_depth));
+
+        result_t result;
+        auto drain = [&] {
+            const size_t count = batch_status(batch_regs::RES_COUNT);
+            for (size_t n = count; n; n--) {
+                const uint32_t cycle = static_cast<uint32_t>(batch_rd(batch_regs::RES_FIFO));
+                for (size_t idx = 0; idx < result_t::rd_entries; idx++)
+                    result.words[idx] = batch_rd(batch_regs::RES_FIFO + (1 + idx) * sizeof(rd_raw_t));
+                on_result(cycle, result);
+            }
+            return count;
+        };
+
+        size_t pushed = 0;
+        uint32_t remaining = 0;
+        bool stalled = false;
+        std::chrono::steady_clock::time_point stalled_since;
+        for (;;) {
+            bool progress = false;
+            if (pushed < clocks) {
+                const size_t room = stim_depth - batch_status(batch_regs::STIM_COUNT);
+                const size_t n = std::min(room, clocks - pushed);
+                for (size_t i = 0; i < n; i++, pushed++) {
+                    for (mask_t m = masks[pushed]; m; m &= m - 1)
+                        batch_image_[std::countr_zero(m)] = *words++;
+                    for (size_t idx = 0; idx < stimulus_t::wr_entries; idx++)
+                        batch_wr(batch_regs::STIM_FIFO + idx * sizeof(wr_raw_t), batch_image_[idx]);
+                }
+                if (n) {
+                    batch_wr(batch_regs::BATCH_RUN, n);
+                    shadow_.stats().clock_pulses.add(n);
+                    progress = true;
+                }
+            }
+
+            if (pushed == clocks) {
+                const uint32_t left = batch_status(batch_regs::BATCH_REMAINING);
+                if (left == 0) {
+                    drain();
+                    break;
+                }
+                progress |= left != remaining;
+                remaining = left;
+            }
+            progress |= drain() != 0;
+
+            if (progress) {
+                stalled = false;
+            } else if (!stalled) {
+                stalled = true;
+                stalled_since = std::chrono::steady_clock::now();
+            } else if (std::chrono::steady_clock::now() - stalled_since > batch_stall_timeout) {
+                throw std::runtime_error(std::format(
+                    "batch_replay: no progress for {} ms, {} of {} clocks pushed, BATCH_REMAINING {}, "
+                    "STIM_COUNT {}, RES_COUNT {}; the batch FSM is stalled",
+                    std::chrono::duration_cast<std::chrono::milliseconds>(batch_stall_timeout).count(),
+                    pushed, clocks, batch_status(batch_regs::BATCH_REMAINING),
+                    batch_status(batch_regs::STIM_COUNT), batch_status(batch_regs::RES_COUNT)));
+            }
+        }
+        return clocks;
+    }
+
+    // hw DUT cycle counter (bits 31..0), counts single steps and batches.
+    inline uint32_t batch_cycles() {
+        return batch_status(batch_regs::DUT_CYCLES);
+    }
+
+    // Restarts the hw result CRC; records count cycles from here.
+    inline void result_crc_clear() {
+        static_assert(batch_supported, "result_crc_clear() needs 64-bit hw words.");
+        batch_wr(batch_regs::RES_CRC, 0);
+    }
+
+    // CRC and number of valid results since result_crc_clear(), one
+    // register read. Compare with a result_crc built from a reference run.
+    inline result_crc read_result_crc() {
+        static_assert(batch_supported, "read_result_crc() needs 64-bit hw words.");
+        return result_crc::from_reg(batch_rd(batch_regs::RES_CRC));
+    }
+
+    // Prints the counters of stats.h. Does nothing unless EMULATOR_STATS is defined.
+    void report_stats(std::ostream &os) const {
+        if constexpr (emulator_stats_enabled) {
+            const auto &sh = shadow_.stats();
+            const auto &sl = slicer_.stats();
+            const double clocks = sh.clock_pulses.value() ? double(sh.clock_pulses.value()) : 1.0;
+            const double flushes = sh.wr_flushes.value() ? double(sh.wr_flushes.value()) : 1.0;
+            const double epochs = sh.rd_epochs.value() ? double(sh.rd_epochs.value()) : 1.0;
+
+            os << "Emulator stats:\n"
+               << "  clock pulses:           " << sh.clock_pulses.value() << "\n"
+               << "  MMIO writes:            " << sh.mmio_wr.value()
+               << " (" << sh.mmio_wr.value() / clocks << " per clock)\n"
+               << "  MMIO reads:             " << sh.mmio_rd.value()
+               << " (" << sh.mmio_rd.value() / clocks << " per clock)\n"
+               << "  wr_flush calls:         " << sh.wr_flushes.value()
+               << ", dirty words " << sh.flushed_words.value()
+               << " (avg " << sh.flushed_words.value() / flushes
+               << ", max " << sh.max_flushed_words.value() << ")\n"
+               << "  unchanged-value writes: " << sh.unchanged_writes.value() << "\n"
+               << "  rd_flush epochs:        " << sh.rd_epochs.value()
+               << ", cache hits " << sh.rd_hits.value()
+               << ", misses " << sh.rd_misses.value()
+               << " (avg " << sh.rd_misses.value() / epochs
+               << " misses/epoch, max " << sh.max_epoch_misses.value() << ")\n"
+               << "  bit_slicer:             write_bits " << sl.wr_bits_calls.value()
+               << " (" << sl.wr_words.value() << " words), read_bits " << sl.rd_bits_calls.value()
+               << " (" << sl.rd_words.value() << " words)\n";
+
+            os << "  per field:\n";
+            for (size_t f = 0; f < fields_t::num_wr_fields; f++)
+                if (wr_counts_.value(f))
+                    os << "    wr field #" << f << " " << fields_t::wr_name(f) << ": " << wr_counts_.value(f)
+                       << " writes, bits " << fields_t::wr_descs[f].bit_offset
+                       << "+" << fields_t::wr_descs[f].bit_width << "\n";
+            for (size_t f = 0; f < fields_t::num_rd_fields; f++)
+                if (rd_counts_.value(f))
+                    os << "    rd field #" << f << " " << fields_t::rd_name(f) << ": " << rd_counts_.value(f)
+                       << " reads, bits " << fields_t::rd_descs[f].bit_offset
+                       << "+" << fields_t::rd_descs[f].bit_width << "\n";
+        }
+    }
 private:
+    inline void trace_clock(const typename trace_t::wr_image_t &image) {
+        trace_->clock(image, [&](typename trace_t::rd_image_t &rd) { return shadow_.rd_snapshot(rd); });
+    }
+
+    inline void batch_wr(size_t byte_address, wr_raw_t data) {
+        shadow_.stats().mmio_wr.add();
+        hw_.wr_raw(byte_address / sizeof(wr_raw_t), data);
+    }
+
+    inline rd_raw_t batch_rd(size_t byte_address) {
+        shadow_.stats().mmio_rd.add();
+        return hw_.rd_raw(byte_address / sizeof(rd_raw_t));
+    }
+
+    inline uint32_t batch_status(size_t byte_address) {
+        return static_cast<uint32_t>(batch_rd(byte_address));
+    }
 
     HW &hw_;
     shadow_t shadow_;
     bit_slicer<shadow_t> slicer_;
+
+    typename stimulus_t::image_t batch_image_{};
+
+    trace_t *trace_ = nullptr;
+
+    [[no_unique_address]] stat_counters<fields_t::num_wr_fields> wr_counts_;
+    [[no_unique_address]] stat_counters<fields_t::num_rd_fields> rd_counts_;
 };
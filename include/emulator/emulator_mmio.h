@@ -0,0 +1,31 @@
+#ifndef EMULATOR_MMIO_H
+#define EMULATOR_MMIO_H
+
+// ------------------------------------------------------------
+// MMAP VIEWS OF THE emulator_mmio DRIVER
+// ------------------------------------------------------------
+//
+// Shared by hw_access_aarch64.h and the kernel driver in
+// fpga/src/driver, so plain C. The driver exposes the device region
+// once per view; the view is the mmap offset >> EMULATOR_MMIO_VIEW_SHIFT,
+// the offset into the region the bits below it.
+//
+//   STRICT  Device-nGnRnE, what UIO maps: each store waits for the
+//           write response of the AXI-Lite slave
+//   POSTED  Device-nGnRE: stores get an early write response, order and
+//           size of the accesses are kept
+//   WC      Normal-NC: stores may be merged and reordered until the next
+//           barrier. Must be mapped without PROT_READ, so that no load
+//           (e.g. of the result FIFO, which pops on read) goes through
+//           it.
+//
+// The size of the region is in /sys/class/misc/<device>/size.
+//
+
+#define EMULATOR_MMIO_VIEW_SHIFT    28
+
+#define EMULATOR_MMIO_VIEW_STRICT   0
+#define EMULATOR_MMIO_VIEW_POSTED   1
+#define EMULATOR_MMIO_VIEW_WC       2
+
+#endif
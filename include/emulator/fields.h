@@ -1,9 +1,17 @@
 #pragma once
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include <util/WideUint.h>
+
 template <typename T>
 struct FieldSpec {
     T field;
     size_t bit_width;
+    const char *name = nullptr;     // optional, used by traces and reports
 };
 
 struct FieldDesc {
@@ -11,6 +19,10 @@ struct FieldDesc {
     size_t bit_width;
 };
 
+// Cheapest unsigned type holding a BITS wide field.
+template <size_t BITS>
+using field_uint_t = FpgaUint<BITS>;
+
 template<typename fields_def>
 class fields {
 public:
@@ -67,4 +79,25 @@ public:
     static constexpr auto rd_desc(rd_fields f) {
         return rd_descs[static_cast<size_t>(f)];
     }
+
+    static constexpr const char *wr_name(size_t f) {
+        return wr_specs[f].name ? wr_specs[f].name : "";
+    }
+
+    static constexpr const char *rd_name(size_t f) {
+        return rd_specs[f].name ? rd_specs[f].name : "";
+    }
+
+    // Compile-time lookups, rejecting END_OF_FIELDS and out-of-range values.
+    template <wr_fields f>
+    static constexpr FieldDesc wr_desc() {
+        static_assert(static_cast<size_t>(f) < num_wr_fields, "WR field out of range.");
+        return wr_descs[static_cast<size_t>(f)];
+    }
+
+    template <rd_fields f>
+    static constexpr FieldDesc rd_desc() {
+        static_assert(static_cast<size_t>(f) < num_rd_fields, "RD field out of range.");
+        return rd_descs[static_cast<size_t>(f)];
+    }
 };
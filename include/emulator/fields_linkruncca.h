@@ -69,36 +69,36 @@ enum class wr_fields: size_t {
     auto get_wr_specs()
     {
         return std::to_array<FieldSpec<wr_fields>>({
-            { wr_fields::RST, 1 },
-            { wr_fields::DATAVALID, 1 },
-            { wr_fields::IN_LABEL, 1 },
-            { wr_fields::X, FpgaConstants::X_BITS },
-            { wr_fields::Y, FpgaConstants::Y_BITS },
-            { wr_fields::HAS_RED, 1 },
-            { wr_fields::HAS_GREEN, 1 },
-            { wr_fields::HAS_BLUE, 1 },
+            { wr_fields::RST, 1, "RST" },
+            { wr_fields::DATAVALID, 1, "DATAVALID" },
+            { wr_fields::IN_LABEL, 1, "IN_LABEL" },
+            { wr_fields::X, FpgaConstants::X_BITS, "X" },
+            { wr_fields::Y, FpgaConstants::Y_BITS, "Y" },
+            { wr_fields::HAS_RED, 1, "HAS_RED" },
+            { wr_fields::HAS_GREEN, 1, "HAS_GREEN" },
+            { wr_fields::HAS_BLUE, 1, "HAS_BLUE" },
         });
     }
 
     consteval auto static
     get_rd_specs() {
         return std::to_array<FieldSpec<rd_fields>>({
-            { rd_fields::VALID, 1 },
-            { rd_fields::X_LEFT, FpgaConstants::X_BITS },
-            { rd_fields::X_RIGHT, FpgaConstants::X_BITS },
-            { rd_fields::Y_TOP_SEG_0, FpgaConstants::Y_LOW_BITS },
-            { rd_fields::Y_TOP_SEG_1, FpgaConstants::Y_LOW_BITS },
-            { rd_fields::Y_BOTTOM_SEG_0, FpgaConstants::Y_LOW_BITS },
-            { rd_fields::Y_BOTTOM_SEG_1, FpgaConstants::Y_LOW_BITS },
-            { rd_fields::X2_SUM, FpgaConstants::X2_SUM_BITS },
-            { rd_fields::YLOW2_SUM, FpgaConstants::YLOW2_SUM_BITS },
-            { rd_fields::XYLOW_SUM, FpgaConstants::XYLOW_SUM_BITS },
-            { rd_fields::X_SEG0_SUM, FpgaConstants::X_SEG_SUM_BITS },
-            { rd_fields::X_SEG1_SUM, FpgaConstants::X_SEG_SUM_BITS },
-            { rd_fields::YLOW_SEG0_SUM, FpgaConstants::YLOW_SEG_SUM_BITS },
-            { rd_fields::YLOW_SEG1_SUM, FpgaConstants::YLOW_SEG_SUM_BITS },
-            { rd_fields::N_SEG0_SUM, FpgaConstants::N_SEG_SUM_BITS },
-            { rd_fields::N_SEG1_SUM, FpgaConstants::N_SEG_SUM_BITS },
+            { rd_fields::VALID, 1, "VALID" },
+            { rd_fields::X_LEFT, FpgaConstants::X_BITS, "X_LEFT" },
+            { rd_fields::X_RIGHT, FpgaConstants::X_BITS, "X_RIGHT" },
+            { rd_fields::Y_TOP_SEG_0, FpgaConstants::Y_LOW_BITS, "Y_TOP_SEG_0" },
+            { rd_fields::Y_TOP_SEG_1, FpgaConstants::Y_LOW_BITS, "Y_TOP_SEG_1" },
+            { rd_fields::Y_BOTTOM_SEG_0, FpgaConstants::Y_LOW_BITS, "Y_BOTTOM_SEG_0" },
+            { rd_fields::Y_BOTTOM_SEG_1, FpgaConstants::Y_LOW_BITS, "Y_BOTTOM_SEG_1" },
+            { rd_fields::X2_SUM, FpgaConstants::X2_SUM_BITS, "X2_SUM" },
+            { rd_fields::YLOW2_SUM, FpgaConstants::YLOW2_SUM_BITS, "YLOW2_SUM" },
+            { rd_fields::XYLOW_SUM, FpgaConstants::XYLOW_SUM_BITS, "XYLOW_SUM" },
+            { rd_fields::X_SEG0_SUM, FpgaConstants::X_SEG_SUM_BITS, "X_SEG0_SUM" },
+            { rd_fields::X_SEG1_SUM, FpgaConstants::X_SEG_SUM_BITS, "X_SEG1_SUM" },
+            { rd_fields::YLOW_SEG0_SUM, FpgaConstants::YLOW_SEG_SUM_BITS, "YLOW_SEG0_SUM" },
+            { rd_fields::YLOW_SEG1_SUM, FpgaConstants::YLOW_SEG_SUM_BITS, "YLOW_SEG1_SUM" },
+            { rd_fields::N_SEG0_SUM, FpgaConstants::N_SEG_SUM_BITS, "N_SEG0_SUM" },
+            { rd_fields::N_SEG1_SUM, FpgaConstants::N_SEG_SUM_BITS, "N_SEG1_SUM" },
         });
     };
 };
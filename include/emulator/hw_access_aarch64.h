@@ -1,22 +1,50 @@
 #pragma once
 
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
 #include <fcntl.h>
+#include <unistd.h>
 #include <sys/mman.h>
 
-class hw_access_aarch64 {
+#include "emulator_mmio.h"
+#include "mmio_order.h"
+
+// WORD_T is the register word (uint64_t, or __uint128_t where the AXI
+// interconnect takes 128-bit accesses). BURST is the number of words
+// moved by one wr_burst()/rd_burst() access (see hw_burst.h): 2 turns
+// pairs of 64-bit words into single stp/ldp accesses, 1 disables bursts.
+// ORDER is the MMIO ordering policy (see mmio_order.h). relaxed and
+// write_combining need the emulator_mmio driver (emulator_mmio.h):
+// relaxed maps the device Device-nGnRE, write_combining also maps the
+// feed window Normal-NC, store only. Both issue dmb oshst before a
+// control store that follows feed stores and dmb osh before the first
+// load after stores. On a UIO device (Device-nGnRnE) only strict is
+// accepted.
+template<typename WORD_T = uint64_t, size_t BURST = 2, mmio_order ORDER = mmio_order::strict>
+class hw_access_aarch64_t {
     public:
-    using wr_word_t = uint64_t;
-    using rd_word_t = uint64_t;
-    // using wr_word_t = __uint128_t;
-    // using rd_word_t = __uint128_t;
+    using wr_word_t = WORD_T;
+    using rd_word_t = WORD_T;
+
+    static constexpr size_t burst_words = BURST;
+    static constexpr mmio_order order = ORDER;
+
+    static_assert(BURST == 1 || (BURST == 2 && sizeof(WORD_T) == 8),
+                  "Bursts are stp/ldp pairs of 64-bit words.");
 
-    hw_access_aarch64(const char *uio_dev) {
-        fd_ = ::open(uio_dev, O_RDWR | O_SYNC);
+    // dev is a UIO device (/dev/uioN) or an emulator_mmio device
+    // (/dev/emulator_mmioN).
+    hw_access_aarch64_t(const char *dev) {
+        fd_ = ::open(dev, O_RDWR | O_SYNC);
         if (fd_ < 0)
             throw std::runtime_error("Failed to open UIO device");
 
-        const char* base = strrchr(uio_dev, '/');
-        const char* name = base ? base + 1 : uio_dev;
+        const char* base = strrchr(dev, '/');
+        const char* name = base ? base + 1 : dev;
 
         char path[256];
         int map_index = 0;
@@ -25,6 +53,11 @@ class hw_access_aarch64 {
             name, map_index);
 
         FILE* f = fopen(path, "r");
+        const bool uio = f != nullptr;
+        if (!uio) {
+            snprintf(path, sizeof(path), "/sys/class/misc/%s/size", name);
+            f = fopen(path, "r");
+        }
         if (!f)
             throw std::runtime_error("Cannot read UIO map size");
         if (fscanf(f, "%zx", &map_size_) != 1) {
@@ -32,19 +65,41 @@ class hw_access_aarch64 {
             throw std::runtime_error("Invalid UIO map size");
         }
         fclose(f);
-        
+
+        if (uio && ORDER != mmio_order::strict)
+            throw std::runtime_error(std::string("MMIO order ") + mmio_order_name(ORDER)
+                                     + " needs the emulator_mmio driver, UIO maps the device Device-nGnRnE");
+
+        const off_t offset = uio ? off_t(map_index) * getpagesize()
+                           : off_t(ORDER == mmio_order::strict ? EMULATOR_MMIO_VIEW_STRICT
+                                                               : EMULATOR_MMIO_VIEW_POSTED) << EMULATOR_MMIO_VIEW_SHIFT;
         mmio_ = mmap(nullptr, map_size_,
             PROT_READ | PROT_WRITE,
             MAP_SHARED,
             fd_,
-            map_index * getpagesize());
+            offset);
 
         if (mmio_ == MAP_FAILED)
             throw std::runtime_error("mmap() failed");
+
+        feed_ = static_cast<uint8_t*>(mmio_) + first_wr_byte_address;
+        if constexpr (ORDER == mmio_order::write_combining) {
+            // Store only: the driver refuses a readable Normal-NC view.
+            wc_map_ = mmap(nullptr, map_size_,
+                PROT_WRITE,
+                MAP_SHARED,
+                fd_,
+                off_t(EMULATOR_MMIO_VIEW_WC) << EMULATOR_MMIO_VIEW_SHIFT);
+            if (wc_map_ == MAP_FAILED)
+                throw std::runtime_error("mmap() of the write-combining feed view failed");
+            feed_ = static_cast<uint8_t*>(wc_map_) + first_wr_byte_address;
+        }
     }
 
-    ~hw_access_aarch64()
+    ~hw_access_aarch64_t()
     {
+        if (wc_map_ && wc_map_ != MAP_FAILED)
+            munmap(wc_map_, map_size_);
         if (mmio_ && mmio_ != MAP_FAILED)
             munmap(mmio_, map_size_);
         if (fd_ >= 0)
@@ -52,6 +107,8 @@ class hw_access_aarch64 {
     }
 
     inline void wr_raw(size_t word_address, wr_word_t data) noexcept {
+        if (fences_.control_store())
+            __asm__ volatile("dmb oshst" ::: "memory");
         auto* base = reinterpret_cast<volatile wr_word_t*>(mmio_);
 
         if constexpr (sizeof(wr_word_t)*8 == 128) {
@@ -65,10 +122,21 @@ class hw_access_aarch64 {
     }
 
     inline void wr(size_t word_offset, wr_word_t data) noexcept {
-        wr_raw(first_wr_word_address + word_offset, data);
+        fences_.feed_store();
+        auto* base = reinterpret_cast<volatile wr_word_t*>(feed_);
+
+        if constexpr (sizeof(wr_word_t)*8 == 128) {
+            const uint64_t *v = reinterpret_cast<const uint64_t *>(& data);
+            store128(base + word_offset, v[0], v[1]);
+        }
+        else {
+            base[word_offset] = data;
+        }
     }
 
     inline rd_word_t rd_raw(size_t word_address) noexcept {
+        if (fences_.load())
+            __asm__ volatile("dmb osh" ::: "memory");
         auto volatile * base = reinterpret_cast<volatile rd_word_t*>(mmio_);
 
         if constexpr (sizeof(rd_word_t)*8 == 128) {
@@ -86,6 +154,37 @@ class hw_access_aarch64 {
     inline rd_word_t rd(size_t word_offset) noexcept {
         return rd_raw(first_rd_word_address + word_offset);
     }
+
+    // n <= BURST words at an offset aligned to BURST, one access.
+    inline void wr_burst(size_t word_offset, const wr_word_t *data, size_t n) noexcept {
+        auto* base = reinterpret_cast<volatile wr_word_t*>(feed_);
+        if constexpr (BURST == 2) {
+            if (n == 2) {
+                fences_.feed_store();
+                store128(base + word_offset, data[0], data[1]);
+                return;
+            }
+        }
+        for (size_t i = 0; i < n; i++)
+            wr(word_offset + i, data[i]);
+    }
+
+    inline void rd_burst(size_t word_offset, rd_word_t *data, size_t n) noexcept {
+        auto* base = reinterpret_cast<volatile rd_word_t*>(mmio_);
+        if constexpr (BURST == 2) {
+            if (n == 2) {
+                if (fences_.load())
+                    __asm__ volatile("dmb osh" ::: "memory");
+                uint64_t lo, hi;
+                load128(base + first_rd_word_address + word_offset, lo, hi);
+                data[0] = lo;
+                data[1] = hi;
+                return;
+            }
+        }
+        for (size_t i = 0; i < n; i++)
+            data[i] = rd(word_offset + i);
+    }
 private:
     inline static void store128(volatile void *ptr, uint64_t lo, uint64_t hi)
     {
@@ -116,7 +215,16 @@ private:
     static constexpr size_t first_wr_word_address = first_wr_byte_address / wr_word_bytes;
     static constexpr size_t first_rd_word_address = first_rd_byte_address / rd_word_bytes;
 
+    static_assert(first_wr_byte_address % (BURST * wr_word_bytes) == 0 &&
+                  first_rd_byte_address % (BURST * rd_word_bytes) == 0,
+                  "Register windows must be aligned to a burst.");
+
     int     fd_ = -1;
     void*   mmio_ = nullptr;
     size_t  map_size_ = 0;
+    void*   feed_ = nullptr;
+    void*   wc_map_ = nullptr;
+    mmio_fences<ORDER> fences_;
 };
+
+using hw_access_aarch64 = hw_access_aarch64_t<>;
@@ -1,5 +1,10 @@
 #pragma once
 
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <iostream>
+
 #include <fcntl.h>
 #include <sys/mman.h>
 
@@ -40,8 +45,8 @@ class hw_access_debug {
     }
 private:
     int     fd_ = -1;
-    std::array<wr_word_t, 1024>  wr_space;
-    std::array<rd_word_t, 1024>  rd_space;
+    std::array<wr_word_t, 1024>  wr_space{};
+    std::array<rd_word_t, 1024>  rd_space{};
 
     static constexpr size_t wr_word_bytes =sizeof(wr_word_t);
     static constexpr size_t rd_word_bytes =sizeof(wr_word_t);
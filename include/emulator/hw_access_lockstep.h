@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <ostream>
+
+#include "fields.h"
+#include "hw_access_model.h"
+
+// ------------------------------------------------------------
+// LOCKSTEP BACKEND: REAL HW + C++ MODEL
+// ------------------------------------------------------------
+//
+// Wraps any hw_access backend and mirrors every write and clock
+// pulse into a hw_access_model with the same word types. Reads are
+// served from the wrapped backend and compared against the model.
+// The first differing result word is recorded with its DUT cycle.
+//
+
+template<typename hw_access_t, typename FIELDS>
+class hw_access_lockstep {
+public:
+    using wr_word_t = typename hw_access_t::wr_word_t;
+    using rd_word_t = typename hw_access_t::rd_word_t;
+
+    using model_t = hw_access_model<FIELDS, wr_word_t, rd_word_t>;
+
+    struct mismatch_t {
+        uint64_t cycle;
+        size_t word_offset;
+        rd_word_t hw_word;
+        rd_word_t model_word;
+    };
+
+    hw_access_lockstep(hw_access_t &hw) : hw_(hw) {}
+
+    inline void wr_raw(size_t word_address, wr_word_t data) {
+        hw_.wr_raw(word_address, data);
+        model_.wr_raw(word_address, data);
+    }
+
+    inline void wr(size_t word_offset, wr_word_t data) noexcept {
+        hw_.wr(word_offset, data);
+        model_.wr(word_offset, data);
+    }
+
+    // Also issued to the model, so FIFO pops stay in step.
+    inline rd_word_t rd_raw(size_t word_address) {
+        model_.rd_raw(word_address);
+        return hw_.rd_raw(word_address);
+    }
+
+    inline rd_word_t rd(size_t word_offset) noexcept {
+        rd_word_t hw_word = hw_.rd(word_offset);
+        rd_word_t model_word = model_.rd(word_offset);
+        if (hw_word != model_word && !mismatch_) {
+            mismatch_ = true;
+            first_ = mismatch_t{model_.cycles(), word_offset, hw_word, model_word};
+        }
+        return hw_word;
+    }
+
+    inline bool mismatch() const noexcept {
+        return mismatch_;
+    }
+
+    inline const mismatch_t &first_mismatch() const noexcept {
+        return first_;
+    }
+
+    inline const model_t &model() const noexcept {
+        return model_;
+    }
+
+    // Prints the first mismatch and the rd_fields (by index) whose bits differ.
+    void report(std::ostream &os) const {
+        if (!mismatch_) {
+            os << "Lockstep: no mismatch in " << model_.cycles() << " cycles\n";
+            return;
+        }
+
+        static constexpr size_t RD_BITS_PER_WORD = sizeof(rd_word_t) * 8;
+        using fields_t = fields<FIELDS>;
+
+        const rd_word_t diff = first_.hw_word ^ first_.model_word;
+        const size_t word_begin = first_.word_offset * RD_BITS_PER_WORD;
+
+        os << "Lockstep: first mismatch at cycle " << first_.cycle
+           << ", rd word " << first_.word_offset
+           << ": hw=0x" << std::hex << static_cast<uint64_t>(first_.hw_word)
+           << " model=0x" << static_cast<uint64_t>(first_.model_word) << std::dec << "\n";
+
+        for (size_t f = 0; f < fields_t::num_rd_fields; f++) {
+            const auto &desc = fields_t::rd_descs[f];
+            for (size_t i = 0; i < desc.bit_width; i++) {
+                const size_t bit = desc.bit_offset + i;
+                if (bit < word_begin || bit >= word_begin + RD_BITS_PER_WORD)
+                    continue;
+                if ((diff >> (bit - word_begin)) & 1) {
+                    os << "  differs in rd field #" << f << " " << fields_t::rd_name(f) << "\n";
+                    break;
+                }
+            }
+        }
+    }
+
+private:
+    hw_access_t &hw_;
+    model_t model_;
+
+    bool mismatch_ = false;
+    mismatch_t first_{};
+};
@@ -0,0 +1,309 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <istream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <util/CycleClock.h>
+
+#include "hw_burst.h"
+
+// ------------------------------------------------------------
+// MMIO TRANSACTION LOG OF A BACKEND
+// ------------------------------------------------------------
+//
+// Wraps any hw_access backend and appends every wr / rd / wr_raw /
+// rd_raw access (bursts as one record) to a binary file: host timestamp
+// (CycleClock ticks since construction), word address or offset, word
+// count and the data written or read. Records are gathered in a 1 MiB
+// buffer and written out when it fills, so the file write is not on
+// every access. The mmio_replay tool feeds a log through an AXI-Lite
+// latency model; mmio_log_reader decodes a log.
+//
+// Only the instantiation wrapped in hw_access_log pays for it; without
+// it, shadow calls the backend directly as before.
+//
+
+// File layout: mmio_log_header, then num_records records of LEB128
+// varints (7 bits per byte, low first, bit 7 set on all but the last):
+//
+//   address << 10 | words << 2 | kind
+//   tick delta to the previous record, zigzag encoded
+//   words x (data word XOR the last word logged at the same slot)
+//
+// address is a word offset into the feed / result window for WR / RD
+// and a word address for WR_RAW / RD_RAW. A slot is (address + i) mod
+// 256, one table for the write and one for the read kinds, all zero at
+// the start. The run loop writes the same few words over and over with
+// small changes (pixel, clock pulse, VALID), so the head and data of
+// most records take one byte each. A TestRun on the model backend logs
+// about 6 bytes per access (19 per DUT clock, TSC timestamps on x86)
+// where a fixed 16-byte header plus 64-bit data took 24.
+struct mmio_log_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t wr_word_bytes;
+    uint32_t rd_word_bytes;
+    uint32_t burst_words;
+    double ticks_hz;                // CycleClock rate of the timestamps
+    uint64_t num_records;
+    uint64_t data_bytes;            // data of all accesses, before encoding
+
+    static constexpr char MAGIC[8] = {'E', 'M', 'U', 'M', 'M', 'I', 'O', 'L'};
+    static constexpr uint32_t VERSION = 2;
+};
+
+// One decoded access; ticks are absolute (since the log was opened).
+struct mmio_log_record {
+    enum Kind : uint8_t { WR, RD, WR_RAW, RD_RAW };
+
+    uint64_t ticks;
+    uint32_t address;
+    Kind kind;
+    uint8_t words;
+
+    static constexpr size_t max_words = 255;
+    static constexpr size_t slots = 256;
+    static constexpr size_t max_varint_bytes = 10;
+
+    static constexpr bool is_write(Kind kind) noexcept {
+        return kind == WR || kind == WR_RAW;
+    }
+};
+
+// Reads the records of a log after its header. next() throws
+// std::runtime_error on a truncated or corrupt record.
+class mmio_log_reader {
+public:
+    mmio_log_reader(std::istream &in, const mmio_log_header &header)
+        : in_(in), header_(header), buffer_(size_t(1) << 20)
+    {
+        if (header.wr_word_bytes > sizeof(uint64_t) || header.rd_word_bytes > sizeof(uint64_t))
+            throw std::runtime_error("mmio_log_reader: words wider than 64 bits");
+    }
+
+    // Decodes the next record and its data words into r and data
+    // (mmio_log_record::max_words entries). False after the last one.
+    bool next(mmio_log_record &r, uint64_t *data) {
+        if (read_ == header_.num_records)
+            return false;
+
+        const uint64_t head = varint();
+        const uint64_t delta = varint();
+        r.kind = static_cast<mmio_log_record::Kind>(head & 3);
+        r.words = static_cast<uint8_t>(head >> 2);
+        if (r.words == 0 || (head >> 10) > UINT32_MAX)
+            throw std::runtime_error("mmio_log_reader: corrupt record " + std::to_string(read_));
+        r.address = static_cast<uint32_t>(head >> 10);
+        ticks_ += (delta >> 1) ^ -(delta & 1);
+        r.ticks = ticks_;
+
+        const bool write = mmio_log_record::is_write(r.kind);
+        const uint32_t word_bytes = write ? header_.wr_word_bytes : header_.rd_word_bytes;
+        const uint64_t mask = word_bytes == sizeof(uint64_t) ? ~uint64_t(0) : (uint64_t(1) << (8 * word_bytes)) - 1;
+        uint64_t *last = write ? last_wr_ : last_rd_;
+        for (size_t i = 0; i < r.words; i++) {
+            uint64_t &slot = last[(r.address + i) % mmio_log_record::slots];
+            slot = (slot ^ varint()) & mask;
+            data[i] = slot;
+        }
+        read_++;
+        return true;
+    }
+
+private:
+    uint64_t varint() {
+        uint64_t v = 0;
+        for (unsigned shift = 0; shift < 64; shift += 7) {
+            if (pos_ == end_)
+                fill();
+            const uint8_t b = buffer_[pos_++];
+            v |= uint64_t(b & 0x7f) << shift;
+            if (!(b & 0x80))
+                return v;
+        }
+        throw std::runtime_error("mmio_log_reader: corrupt record " + std::to_string(read_));
+    }
+
+    void fill() {
+        in_.read(reinterpret_cast<char *>(buffer_.data()), buffer_.size());
+        pos_ = 0;
+        end_ = static_cast<size_t>(in_.gcount());
+        if (end_ == 0)
+            throw std::runtime_error("mmio_log_reader: truncated after " + std::to_string(read_) + " records");
+    }
+
+    std::istream &in_;
+    mmio_log_header header_;
+    std::vector<uint8_t> buffer_;
+    size_t pos_ = 0;
+    size_t end_ = 0;
+    uint64_t read_ = 0;
+    uint64_t ticks_ = 0;
+    uint64_t last_wr_[mmio_log_record::slots] = {};
+    uint64_t last_rd_[mmio_log_record::slots] = {};
+};
+
+template<typename hw_access_t>
+class hw_access_log {
+public:
+    using wr_word_t = typename hw_access_t::wr_word_t;
+    using rd_word_t = typename hw_access_t::rd_word_t;
+    using record_t = mmio_log_record;
+
+    static constexpr size_t burst_words = hw_burst_words<hw_access_t>;
+    static constexpr size_t BUFFER_BYTES = size_t(1) << 20;
+
+    static_assert(sizeof(wr_word_t) <= sizeof(uint64_t) && sizeof(rd_word_t) <= sizeof(uint64_t),
+                  "hw_access_log logs words of up to 64 bits.");
+    static_assert(burst_words <= record_t::max_words, "hw_access_log: burst longer than a record.");
+
+    hw_access_log(hw_access_t &hw, const std::string &fname)
+        : hw_(hw), fname_(fname), out_(fname, std::ios::binary)
+    {
+        if (!out_)
+            throw std::runtime_error("hw_access_log: cannot open " + fname);
+        put_header();
+        buffer_.resize(BUFFER_BYTES);
+        t_start_ = CycleClock::now();
+        t_last_ = t_start_;
+    }
+
+    ~hw_access_log() {
+        try {
+            close();
+        } catch (...) {
+        }
+    }
+
+    hw_access_log(const hw_access_log &) = delete;
+    hw_access_log &operator=(const hw_access_log &) = delete;
+
+    inline void wr_raw(size_t word_address, wr_word_t data) {
+        log(record_t::WR_RAW, word_address, &data, 1);
+        hw_.wr_raw(word_address, data);
+    }
+
+    inline rd_word_t rd_raw(size_t word_address) {
+        const uint64_t t = CycleClock::now();
+        const rd_word_t data = hw_.rd_raw(word_address);
+        log(record_t::RD_RAW, word_address, &data, 1, t);
+        return data;
+    }
+
+    inline void wr(size_t word_offset, wr_word_t data) {
+        log(record_t::WR, word_offset, &data, 1);
+        hw_.wr(word_offset, data);
+    }
+
+    inline rd_word_t rd(size_t word_offset) {
+        const uint64_t t = CycleClock::now();
+        const rd_word_t data = hw_.rd(word_offset);
+        log(record_t::RD, word_offset, &data, 1, t);
+        return data;
+    }
+
+    inline void wr_burst(size_t word_offset, const wr_word_t *data, size_t n) {
+        log(record_t::WR, word_offset, data, n);
+        hw_.wr_burst(word_offset, data, n);
+    }
+
+    inline void rd_burst(size_t word_offset, rd_word_t *data, size_t n) {
+        const uint64_t t = CycleClock::now();
+        hw_.rd_burst(word_offset, data, n);
+        log(record_t::RD, word_offset, data, n, t);
+    }
+
+    inline uint64_t records() const noexcept {
+        return num_records_;
+    }
+
+    // Size of the log file, header included.
+    inline uint64_t bytes() const noexcept {
+        return sizeof(mmio_log_header) + file_bytes_ + pos_;
+    }
+
+    // Writes the buffered records and the final header.
+    void close() {
+        if (!out_.is_open())
+            return;
+        flush();
+        out_.seekp(0);
+        put_header();
+        out_.close();
+        if (!out_)
+            throw std::runtime_error("hw_access_log: write failed: " + fname_);
+    }
+
+private:
+    template<typename word_t>
+    inline void log(record_t::Kind kind, size_t address, const word_t *data, size_t n) {
+        log(kind, address, data, n, CycleClock::now());
+    }
+
+    template<typename word_t>
+    inline void log(record_t::Kind kind, size_t address, const word_t *data, size_t n, uint64_t t) {
+        if (pos_ + (n + 2) * record_t::max_varint_bytes > BUFFER_BYTES)
+            flush();
+
+        const int64_t delta = static_cast<int64_t>(t - t_last_);
+        t_last_ = t;
+        put_varint(uint64_t(address) << 10 | uint64_t(n) << 2 | kind);
+        put_varint((uint64_t(delta) << 1) ^ uint64_t(delta >> 63));
+
+        uint64_t *last = record_t::is_write(kind) ? last_wr_ : last_rd_;
+        for (size_t i = 0; i < n; i++) {
+            uint64_t &slot = last[(address + i) % record_t::slots];
+            const uint64_t word = static_cast<uint64_t>(data[i]);
+            put_varint(word ^ slot);
+            slot = word;
+        }
+        num_records_++;
+        data_bytes_ += n * sizeof(word_t);
+    }
+
+    inline void put_varint(uint64_t v) {
+        while (v >= 0x80) {
+            buffer_[pos_++] = static_cast<uint8_t>(v | 0x80);
+            v >>= 7;
+        }
+        buffer_[pos_++] = static_cast<uint8_t>(v);
+    }
+
+    void flush() {
+        out_.write(reinterpret_cast<const char *>(buffer_.data()), pos_);
+        file_bytes_ += pos_;
+        pos_ = 0;
+    }
+
+    void put_header() {
+        mmio_log_header h{};
+        std::memcpy(h.magic, mmio_log_header::MAGIC, sizeof(h.magic));
+        h.version = mmio_log_header::VERSION;
+        h.wr_word_bytes = sizeof(wr_word_t);
+        h.rd_word_bytes = sizeof(rd_word_t);
+        h.burst_words = burst_words;
+        h.ticks_hz = CycleClock::hz();
+        h.num_records = num_records_;
+        h.data_bytes = data_bytes_;
+        out_.write(reinterpret_cast<const char *>(&h), sizeof(h));
+    }
+
+    hw_access_t &hw_;
+    std::string fname_;
+    std::ofstream out_;
+    std::vector<uint8_t> buffer_;
+    size_t pos_ = 0;
+    uint64_t t_start_ = 0;
+    uint64_t t_last_ = 0;
+    uint64_t num_records_ = 0;
+    uint64_t data_bytes_ = 0;
+    uint64_t file_bytes_ = 0;
+    uint64_t last_wr_[record_t::slots] = {};
+    uint64_t last_rd_[record_t::slots] = {};
+};
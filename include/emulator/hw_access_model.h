@@ -0,0 +1,278 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <deque>
+
+#include "fields.h"
+#include "batch_regs.h"
+#include "result_crc.h"
+#include "linkruncca_model.h"
+
+// ------------------------------------------------------------
+// HOST BACKEND RUNNING THE C++ MODEL OF vhdl_linkruncca
+// ------------------------------------------------------------
+//
+// Same interface as hw_access_aarch64, but the register map of
+// emulator_top / axil_slave is backed by plain arrays:
+//
+//   - wr()/rd() access the feed and result windows (byte 0x80).
+//   - wr_raw(0, 1) advances the model by one DUT clock.
+//   - rd_raw(0) returns the number of modeled clocks (free_counter).
+//   - with 64-bit words, the batch FIFOs, status registers and result
+//     CRC of batch_regs.h work as in emulator_top.
+//
+// Word types are template parameters, so the model can shadow any
+// real backend (see hw_access_lockstep.h).
+//
+
+template<typename FIELDS, typename wr_word_type = uint64_t, typename rd_word_type = uint64_t>
+class hw_access_model {
+public:
+    using wr_word_t = wr_word_type;
+    using rd_word_t = rd_word_type;
+
+    using fields_t = fields<FIELDS>;
+    using model_t = linkruncca_model<typename FIELDS::FpgaConstants>;
+    using wr_fields = typename FIELDS::wr_fields;
+    using rd_fields = typename FIELDS::rd_fields;
+
+    hw_access_model() {
+        feed_.fill(0);
+        res_.fill(0);
+    }
+
+    hw_access_model(const char * /*uio_dev*/) : hw_access_model() {}
+
+    inline void wr_raw(size_t word_address, wr_word_t data) {
+        if (word_address == run_word_address) {
+            if (data & 1)
+                clock();
+            return;
+        }
+        if constexpr (batch_words) {
+            const size_t byte = word_address * sizeof(wr_word_t);
+            if (byte == batch_regs::BATCH_RUN) {
+                batch_remaining_ += static_cast<uint32_t>(data);
+                batch_step();
+                return;
+            }
+            if (byte == batch_regs::RES_CRC) {
+                crc_ = result_crc{};
+                crc_cycles_ = 0;
+                return;
+            }
+            if (byte >= batch_regs::STIM_FIFO && byte < batch_regs::STIM_FIFO + wr_entries * sizeof(wr_word_t)) {
+                const size_t idx = (byte - batch_regs::STIM_FIFO) / sizeof(wr_word_t);
+                stim_rec_[idx] = data;
+                if (idx == wr_entries - 1 && stim_fifo_.size() < batch_regs::default_stim_depth) {
+                    stim_fifo_.push_back(stim_rec_);
+                    batch_step();
+                }
+                return;
+            }
+        }
+        if (word_address >= first_wr_word_address &&
+            word_address < first_wr_word_address + wr_entries)
+            feed_[word_address - first_wr_word_address] = data;
+    }
+
+    inline void wr(size_t word_offset, wr_word_t data) noexcept {
+        if (word_offset < wr_entries)
+            feed_[word_offset] = data;
+    }
+
+    inline rd_word_t rd_raw(size_t word_address) {
+        if (word_address == run_word_address)
+            return static_cast<rd_word_t>(static_cast<uint32_t>(cycles_));
+        if constexpr (batch_words) {
+            const size_t byte = word_address * sizeof(rd_word_t);
+            switch (byte) {
+            case batch_regs::BATCH_REMAINING: return batch_remaining_;
+            case batch_regs::DUT_CYCLES:      return static_cast<uint32_t>(cycles_);
+            case batch_regs::STIM_COUNT:      return stim_fifo_.size();
+            case batch_regs::RES_COUNT:       return res_fifo_.size();
+            case batch_regs::STIM_DEPTH:      return batch_regs::default_stim_depth;
+            case batch_regs::RES_DEPTH:       return batch_regs::default_res_depth;
+            case batch_regs::GEOMETRY:
+                return batch_regs::geometry_id(FIELDS::FpgaConstants::X_SIZE, FIELDS::FpgaConstants::Y_BITS);
+            case batch_regs::RES_CRC:         return crc_.reg();
+            default: break;
+            }
+            if (byte >= batch_regs::RES_FIFO && byte < batch_regs::RES_FIFO + (1 + rd_entries) * sizeof(rd_word_t)) {
+                const size_t idx = (byte - batch_regs::RES_FIFO) / sizeof(rd_word_t);
+                if (res_fifo_.empty())
+                    return 0;
+                const rd_word_t word = res_fifo_.front()[idx];
+                if (idx == rd_entries) {
+                    res_fifo_.pop_front();
+                    batch_step();
+                }
+                return word;
+            }
+        }
+        if (word_address >= first_rd_word_address &&
+            word_address < first_rd_word_address + rd_entries)
+            return rd(word_address - first_rd_word_address);
+        return 0;
+    }
+
+    inline rd_word_t rd(size_t word_offset) noexcept {
+        if (word_offset >= rd_entries)
+            return 0;
+        rd_word_t word = res_[word_offset];
+        // res_valid_out has an asynchronous reset in vhdl_linkruncca.
+        if (word_offset == valid_word && feed_bit(rst_bit))
+            word &= ~(rd_word_t(1) << (valid_bit % RD_BITS_PER_WORD));
+        return word;
+    }
+
+    inline uint64_t cycles() const noexcept {
+        return cycles_;
+    }
+
+    inline const model_t &model() const noexcept {
+        return model_;
+    }
+
+private:
+    using sum_t = typename model_t::sum_t;
+    using collect_t = typename model_t::collect_t;
+    using feature_t = typename model_t::feature_t;
+
+    static constexpr size_t WR_BITS_PER_WORD = sizeof(wr_word_t) * 8;
+    static constexpr size_t RD_BITS_PER_WORD = sizeof(rd_word_t) * 8;
+
+    static constexpr size_t wr_entries = (fields_t::wr_bits + WR_BITS_PER_WORD - 1) / WR_BITS_PER_WORD;
+    static constexpr size_t rd_entries = (fields_t::rd_bits + RD_BITS_PER_WORD - 1) / RD_BITS_PER_WORD;
+
+    static constexpr size_t run_word_address = 0;
+    static constexpr size_t first_wr_word_address = 0x80 / sizeof(wr_word_t);
+    static constexpr size_t first_rd_word_address = 0x80 / sizeof(rd_word_t);
+
+    static constexpr bool batch_words =
+        sizeof(wr_word_t) == batch_regs::AXI_BYTES && sizeof(rd_word_t) == batch_regs::AXI_BYTES;
+
+    using stim_rec_t = std::array<wr_word_t, wr_entries>;
+    using res_rec_t = std::array<rd_word_t, 1 + rd_entries>;
+
+    static constexpr size_t rst_bit = fields_t::wr_desc(wr_fields::RST).bit_offset;
+    static constexpr size_t valid_bit = fields_t::rd_desc(rd_fields::VALID).bit_offset;
+    static constexpr size_t valid_word = valid_bit / RD_BITS_PER_WORD;
+
+    inline bool feed_bit(size_t bit) const noexcept {
+        return (feed_[bit / WR_BITS_PER_WORD] >> (bit % WR_BITS_PER_WORD)) & 1;
+    }
+
+    static constexpr sum_t mask(size_t bits) noexcept {
+        return bits >= 128 ? ~sum_t(0) : ((sum_t(1) << bits) - 1);
+    }
+
+    inline sum_t feed_field(wr_fields field) const noexcept {
+        const auto desc = fields_t::wr_desc(field);
+        sum_t r = 0;
+        for (size_t pos = 0; pos < desc.bit_width; ) {
+            const size_t bit = desc.bit_offset + pos;
+            const size_t shift = bit % WR_BITS_PER_WORD;
+            const size_t n = std::min(WR_BITS_PER_WORD - shift, desc.bit_width - pos);
+            r |= ((sum_t(feed_[bit / WR_BITS_PER_WORD]) >> shift) & mask(n)) << pos;
+            pos += n;
+        }
+        return r;
+    }
+
+    inline void res_field(rd_fields field, sum_t data) noexcept {
+        const auto desc = fields_t::rd_desc(field);
+        for (size_t pos = 0; pos < desc.bit_width; ) {
+            const size_t bit = desc.bit_offset + pos;
+            const size_t shift = bit % RD_BITS_PER_WORD;
+            const size_t n = std::min(RD_BITS_PER_WORD - shift, desc.bit_width - pos);
+            const rd_word_t m = static_cast<rd_word_t>(mask(n) << shift);
+            const rd_word_t v = static_cast<rd_word_t>(((data >> pos) & mask(n)) << shift);
+            auto &word = res_[bit / RD_BITS_PER_WORD];
+            word = (word & ~m) | v;
+            pos += n;
+        }
+    }
+
+    void clock() {
+        const bool rst = feed_bit(rst_bit);
+        const bool datavalid = feed_field(wr_fields::DATAVALID) != 0;
+        const collect_t pix{
+            .in_label = feed_field(wr_fields::IN_LABEL) != 0,
+            .x = static_cast<uint64_t>(feed_field(wr_fields::X)),
+            .y = static_cast<uint64_t>(feed_field(wr_fields::Y)),
+            .has_red = feed_field(wr_fields::HAS_RED) != 0,
+            .has_green = feed_field(wr_fields::HAS_GREEN) != 0,
+            .has_blue = feed_field(wr_fields::HAS_BLUE) != 0,
+        };
+
+        model_.clock(rst, datavalid, pix);
+        cycles_++;
+
+        res_field(rd_fields::VALID, model_.res_valid());
+
+        // res_data_out only changes together with res_valid_out.
+        if (model_.res_valid()) {
+            const feature_t &f = model_.res_data();
+            res_field(rd_fields::X_LEFT, f.x_left);
+            res_field(rd_fields::X_RIGHT, f.x_right);
+            res_field(rd_fields::Y_TOP_SEG_0, f.y_top_seg0);
+            res_field(rd_fields::Y_TOP_SEG_1, f.y_top_seg1);
+            res_field(rd_fields::Y_BOTTOM_SEG_0, f.y_bottom_seg0);
+            res_field(rd_fields::Y_BOTTOM_SEG_1, f.y_bottom_seg1);
+            res_field(rd_fields::X2_SUM, f.x2_sum);
+            res_field(rd_fields::YLOW2_SUM, f.ylow2_sum);
+            res_field(rd_fields::XYLOW_SUM, f.xylow_sum);
+            res_field(rd_fields::X_SEG0_SUM, f.x_seg0_sum);
+            res_field(rd_fields::X_SEG1_SUM, f.x_seg1_sum);
+            res_field(rd_fields::YLOW_SEG0_SUM, f.ylow_seg0_sum);
+            res_field(rd_fields::YLOW_SEG1_SUM, f.ylow_seg1_sum);
+            res_field(rd_fields::N_SEG0_SUM, f.n_seg0_sum);
+            res_field(rd_fields::N_SEG1_SUM, f.n_seg1_sum);
+        }
+
+        if constexpr (batch_words) {
+            crc_cycles_++;
+            if (model_.res_valid())
+                crc_.add(crc_cycles_, res_.data(), rd_entries);
+        }
+    }
+
+    // emulator_top batch FSM: one clock per stimulus record, with the
+    // record instead of the feed window as DUT input.
+    void batch_step() {
+        while (batch_remaining_ && !stim_fifo_.empty() &&
+               res_fifo_.size() < batch_regs::default_res_depth) {
+            const auto feed = feed_;
+            feed_ = stim_fifo_.front();
+            stim_fifo_.pop_front();
+            clock();
+            feed_ = feed;
+            batch_remaining_--;
+
+            if (model_.res_valid()) {
+                res_rec_t rec;
+                rec[0] = static_cast<uint32_t>(cycles_);
+                std::copy(res_.begin(), res_.end(), rec.begin() + 1);
+                res_fifo_.push_back(rec);
+            }
+        }
+    }
+
+    model_t model_;
+    uint64_t cycles_ = 0;
+
+    uint32_t batch_remaining_ = 0;
+    stim_rec_t stim_rec_{};
+    std::deque<stim_rec_t> stim_fifo_;
+    std::deque<res_rec_t> res_fifo_;
+
+    result_crc crc_;
+    uint32_t crc_cycles_ = 0;
+
+    std::array<wr_word_t, wr_entries> feed_;
+    std::array<rd_word_t, rd_entries> res_;
+};
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+
+// ------------------------------------------------------------
+// IN-MEMORY NULL BACKEND
+// ------------------------------------------------------------
+//
+// Same interface as hw_access_aarch64, backed by a small plain array.
+// Writes are stored, result reads return zero (no DUT behind it) and
+// rd_raw(0) returns the number of clock pulses. Used to measure the
+// cost of the software layers above hw_access.
+//
+
+template<typename wr_word_type = uint64_t, typename rd_word_type = uint64_t>
+class hw_access_null {
+public:
+    using wr_word_t = wr_word_type;
+    using rd_word_t = rd_word_type;
+
+    hw_access_null() {
+        wr_space_.fill(0);
+    }
+
+    hw_access_null(const char * /*uio_dev*/) : hw_access_null() {}
+
+    inline void wr_raw(size_t word_address, wr_word_t data) noexcept {
+        if (word_address == 0 && (data & 1))
+            clocks_++;
+        wr_space_[word_address & (space_words - 1)] = data;
+    }
+
+    inline void wr(size_t word_offset, wr_word_t data) noexcept {
+        wr_space_[word_offset & (space_words - 1)] = data;
+    }
+
+    inline rd_word_t rd_raw(size_t word_address) noexcept {
+        if (word_address == 0)
+            return static_cast<rd_word_t>(static_cast<uint32_t>(clocks_));
+        return 0;
+    }
+
+    inline rd_word_t rd(size_t /*word_offset*/) noexcept {
+        return 0;
+    }
+
+    inline uint64_t clocks() const noexcept {
+        return clocks_;
+    }
+
+private:
+    static constexpr size_t space_words = 64;
+
+    std::array<wr_word_t, space_words> wr_space_;
+    uint64_t clocks_ = 0;
+};
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <iomanip>
+#include <ostream>
+
+#include <util/CycleClock.h>
+#include <util/LatencyHistogram.h>
+
+#include "hw_burst.h"
+
+// ------------------------------------------------------------
+// LATENCY HISTOGRAMS OF A BACKEND
+// ------------------------------------------------------------
+//
+// Wraps any hw_access backend and timestamps each access with
+// CycleClock (CNTVCT_EL0 / rdtsc / clock_gettime):
+//
+//   wr     wr() and wr_burst() calls
+//   rd     rd() and rd_burst() calls
+//   pulse  wr_raw() of the run_reg clock pulse (word 0, bit 0)
+//   cycle  from one clock pulse to the next, i.e. one emulated cycle
+//          with all its feed writes and result reads
+//
+// Other wr_raw() / rd_raw() accesses pass through untimed. Posted
+// stores are timed until the CPU retires them, not until the device
+// sees them.
+//
+// The fabric clock counter (rd_raw(0), free_counter of axil_slave) is
+// read at construction, every 2^16 pulses (it wraps after 2^32 fabric
+// clocks) and by report(), which relates host time to fabric clocks.
+// Backends with read words narrower than 32 bits cannot return it.
+//
+
+template<typename hw_access_t>
+class hw_access_timed {
+public:
+    using wr_word_t = typename hw_access_t::wr_word_t;
+    using rd_word_t = typename hw_access_t::rd_word_t;
+
+    static constexpr size_t burst_words = hw_burst_words<hw_access_t>;
+    static constexpr bool fabric_counter = sizeof(rd_word_t) >= sizeof(uint32_t);
+
+    enum Op : uint8_t { WR, RD, PULSE, CYCLE, NUM_OPS };
+
+    hw_access_timed(hw_access_t &hw) : hw_(hw) {
+        if constexpr (fabric_counter)
+            fabric_last_ = static_cast<uint32_t>(hw_.rd_raw(0));
+        t_start_ = CycleClock::now();
+    }
+
+    inline void wr_raw(size_t word_address, wr_word_t data) {
+        if (word_address != 0 || !(data & 1)) {
+            hw_.wr_raw(word_address, data);
+            return;
+        }
+        const uint64_t t0 = CycleClock::now();
+        hw_.wr_raw(word_address, data);
+        const uint64_t t1 = CycleClock::now();
+        hist_[PULSE].add(t1 - t0);
+        if (pulses_++)
+            hist_[CYCLE].add(t0 - t_pulse_);
+        t_pulse_ = t0;
+        if ((pulses_ & 0xFFFF) == 0)
+            sample_fabric();
+    }
+
+    inline rd_word_t rd_raw(size_t word_address) {
+        return hw_.rd_raw(word_address);
+    }
+
+    inline void wr(size_t word_offset, wr_word_t data) {
+        const uint64_t t0 = CycleClock::now();
+        hw_.wr(word_offset, data);
+        hist_[WR].add(CycleClock::now() - t0);
+    }
+
+    inline rd_word_t rd(size_t word_offset) {
+        const uint64_t t0 = CycleClock::now();
+        const rd_word_t data = hw_.rd(word_offset);
+        hist_[RD].add(CycleClock::now() - t0);
+        return data;
+    }
+
+    inline void wr_burst(size_t word_offset, const wr_word_t *data, size_t n) {
+        const uint64_t t0 = CycleClock::now();
+        hw_.wr_burst(word_offset, data, n);
+        hist_[WR].add(CycleClock::now() - t0);
+    }
+
+    inline void rd_burst(size_t word_offset, rd_word_t *data, size_t n) {
+        const uint64_t t0 = CycleClock::now();
+        hw_.rd_burst(word_offset, data, n);
+        hist_[RD].add(CycleClock::now() - t0);
+    }
+
+    inline const LatencyHistogram &histogram(Op op) const noexcept {
+        return hist_[op];
+    }
+
+    static constexpr const char *op_name(Op op) noexcept {
+        constexpr const char *names[NUM_OPS] = {"wr", "rd", "pulse", "cycle"};
+        return names[op];
+    }
+
+    // Prints count, p50 / p99 / p99.9 / max in ns per operation, then
+    // the fabric clocks counted since construction.
+    void report(std::ostream &os) {
+        sample_fabric();
+        const uint64_t elapsed = CycleClock::now() - t_start_;
+
+        os << "Latency [ns], " << CycleClock::source() << " at " << std::fixed << std::setprecision(1)
+           << CycleClock::hz() / 1e6 << " MHz:\n";
+        os << std::left << std::setw(8) << "op" << std::right << std::setw(12) << "count"
+           << std::setw(10) << "p50" << std::setw(10) << "p99" << std::setw(10) << "p99.9"
+           << std::setw(12) << "max" << "\n";
+        for (size_t op = 0; op < NUM_OPS; op++) {
+            const LatencyHistogram &h = hist_[op];
+            os << std::left << std::setw(8) << op_name(static_cast<Op>(op)) << std::right
+               << std::setw(12) << h.count()
+               << std::setw(10) << CycleClock::to_ns(h.percentile(0.50))
+               << std::setw(10) << CycleClock::to_ns(h.percentile(0.99))
+               << std::setw(10) << CycleClock::to_ns(h.percentile(0.999))
+               << std::setw(12) << CycleClock::to_ns(h.max()) << "\n";
+        }
+
+        const double seconds = CycleClock::to_ns(elapsed) / 1e9;
+        if constexpr (fabric_counter) {
+            os << "Fabric: " << fabric_clocks_ << " clocks in " << std::setprecision(3) << seconds << " s";
+            if (seconds > 0)
+                os << " (" << std::setprecision(2) << double(fabric_clocks_) / seconds / 1e6 << " MHz)";
+            if (pulses_)
+                os << ", " << std::setprecision(1) << double(fabric_clocks_) / double(pulses_) << " per clock pulse";
+            os << "\n";
+        } else {
+            os << "Fabric: counter not readable with " << sizeof(rd_word_t) * 8 << "-bit reads\n";
+        }
+        os.unsetf(std::ios::floatfield);
+    }
+
+private:
+    inline void sample_fabric() {
+        if constexpr (fabric_counter) {
+            const uint32_t now = static_cast<uint32_t>(hw_.rd_raw(0));
+            fabric_clocks_ += uint32_t(now - fabric_last_);
+            fabric_last_ = now;
+        }
+    }
+
+    hw_access_t &hw_;
+    LatencyHistogram hist_[NUM_OPS];
+    uint64_t pulses_ = 0;
+    uint64_t t_pulse_ = 0;
+    uint64_t t_start_ = 0;
+    uint32_t fabric_last_ = 0;
+    uint64_t fabric_clocks_ = 0;
+};
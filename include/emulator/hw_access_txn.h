@@ -0,0 +1,151 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "mmio_order.h"
+
+// ------------------------------------------------------------
+// IN-MEMORY BACKEND RECORDING THE BUS TRANSACTIONS
+// ------------------------------------------------------------
+//
+// Same interface as hw_access_aarch64_t<WORD_T, BURST>, backed by plain
+// register arrays. Every access is appended to a transaction log and
+// checked against the burst rules of hw_burst.h: n words with
+// 1 <= n <= BURST, bursts at an offset aligned to BURST, inside the
+// window.
+// A violation throws std::logic_error.
+//
+// ORDER places barriers as hw_access_aarch64_t<WORD_T, BURST, ORDER>
+// does and logs them as FENCE_ST (dmb oshst) and FENCE (dmb osh).
+//
+// rd() returns the words set with set_rd(); the feed window holds what
+// was written, so tests can compare it with the intended register image.
+//
+
+template<typename WORD_T = uint64_t, size_t BURST = 2, size_t WINDOW_WORDS = 64,
+         mmio_order ORDER = mmio_order::strict>
+class hw_access_txn {
+public:
+    using wr_word_t = WORD_T;
+    using rd_word_t = WORD_T;
+
+    static constexpr size_t burst_words = BURST;
+    static constexpr mmio_order order = ORDER;
+
+    struct txn_t {
+        enum Kind : uint8_t { WR, RD, WR_RAW, RD_RAW, FENCE_ST, FENCE } kind;
+        uint8_t words;
+        uint32_t word_offset;
+    };
+
+    hw_access_txn() {
+        wr_space_.fill(0);
+        rd_space_.fill(0);
+    }
+
+    hw_access_txn(const char * /*uio_dev*/) : hw_access_txn() {}
+
+    inline void wr_raw(size_t word_address, wr_word_t data) {
+        if (fences_.control_store())
+            log(txn_t::FENCE_ST, 0, 0);
+        log(txn_t::WR_RAW, word_address, 1);
+        if (word_address == 0 && (data & 1))
+            clocks_++;
+    }
+
+    inline rd_word_t rd_raw(size_t word_address) {
+        if (fences_.load())
+            log(txn_t::FENCE, 0, 0);
+        log(txn_t::RD_RAW, word_address, 1);
+        return word_address == 0 ? static_cast<rd_word_t>(static_cast<uint32_t>(clocks_)) : 0;
+    }
+
+    inline void wr(size_t word_offset, wr_word_t data) {
+        check(txn_t::WR, word_offset, 1);
+        fences_.feed_store();
+        wr_space_[word_offset] = data;
+    }
+
+    inline rd_word_t rd(size_t word_offset) {
+        if (fences_.load())
+            log(txn_t::FENCE, 0, 0);
+        check(txn_t::RD, word_offset, 1);
+        return rd_space_[word_offset];
+    }
+
+    inline void wr_burst(size_t word_offset, const wr_word_t *data, size_t n) {
+        check(txn_t::WR, word_offset, n);
+        fences_.feed_store();
+        for (size_t i = 0; i < n; i++)
+            wr_space_[word_offset + i] = data[i];
+    }
+
+    inline void rd_burst(size_t word_offset, rd_word_t *data, size_t n) {
+        if (fences_.load())
+            log(txn_t::FENCE, 0, 0);
+        check(txn_t::RD, word_offset, n);
+        for (size_t i = 0; i < n; i++)
+            data[i] = rd_space_[word_offset + i];
+    }
+
+    // Result words the next reads return.
+    inline void set_rd(size_t word_offset, rd_word_t data) {
+        rd_space_.at(word_offset) = data;
+    }
+
+    inline wr_word_t feed(size_t word_offset) const {
+        return wr_space_.at(word_offset);
+    }
+
+    inline const std::vector<txn_t> &transactions() const noexcept {
+        return log_;
+    }
+
+    inline void clear() noexcept {
+        log_.clear();
+    }
+
+    inline uint64_t clocks() const noexcept {
+        return clocks_;
+    }
+
+    // Number of logged transactions of a kind.
+    inline size_t count(typename txn_t::Kind kind) const noexcept {
+        size_t n = 0;
+        for (const auto &t : log_)
+            n += t.kind == kind;
+        return n;
+    }
+
+    // Number of words moved by the logged transactions of a kind, i.e.
+    // the bus beats behind an AXI-Lite bridge.
+    inline size_t count_words(typename txn_t::Kind kind) const noexcept {
+        size_t n = 0;
+        for (const auto &t : log_)
+            n += t.kind == kind ? t.words : 0;
+        return n;
+    }
+
+private:
+    inline void check(typename txn_t::Kind kind, size_t word_offset, size_t n) {
+        if (n == 0 || n > BURST || (n > 1 && word_offset % BURST != 0) || word_offset + n > WINDOW_WORDS)
+            throw std::logic_error("hw_access_txn: bad " + std::string(kind == txn_t::WR ? "write" : "read")
+                                   + " of " + std::to_string(n) + " words at offset " + std::to_string(word_offset));
+        log(kind, word_offset, n);
+    }
+
+    inline void log(typename txn_t::Kind kind, size_t word_offset, size_t n) {
+        log_.push_back(txn_t{kind, static_cast<uint8_t>(n), static_cast<uint32_t>(word_offset)});
+    }
+
+    std::array<wr_word_t, WINDOW_WORDS> wr_space_;
+    std::array<rd_word_t, WINDOW_WORDS> rd_space_;
+    std::vector<txn_t> log_;
+    uint64_t clocks_ = 0;
+    mmio_fences<ORDER> fences_;
+};
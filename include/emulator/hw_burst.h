@@ -0,0 +1,64 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstddef>
+
+// ------------------------------------------------------------
+// MULTI-WORD (BURST) HW ACCESS
+// ------------------------------------------------------------
+//
+// A backend may declare
+//
+//   static constexpr size_t burst_words = N;    // power of two, <= 64
+//   void wr_burst(size_t word_offset, const wr_word_t *data, size_t n);
+//   void rd_burst(size_t word_offset, rd_word_t *data, size_t n);
+//
+// where word_offset is a multiple of N and 1 <= n <= N, each call being
+// one bus access (aarch64: stp / ldp of two 64-bit words). shadow and
+// emulator_fields then move whole aligned groups of N words: a flush
+// writes every group holding a changed word, and a field spanning words
+// fetches the groups inside it. A lone read miss stays one rd(), as a
+// burst read costs one bus read per word behind an AXI-Lite bridge. Backends without burst_words get 1 and
+// keep single-word wr() / rd().
+//
+
+template<typename HW>
+inline constexpr size_t hw_burst_words = 1;
+
+template<typename HW>
+    requires requires { HW::burst_words; }
+inline constexpr size_t hw_burst_words<HW> = HW::burst_words;
+
+// Mask of the burst group containing bit idx of a 64-bit word mask.
+template<size_t BURST>
+inline constexpr uint64_t burst_group_mask(size_t idx) noexcept {
+    static_assert(BURST > 0 && BURST <= 64 && std::has_single_bit(BURST),
+                  "burst_words must be a power of two up to 64.");
+    if constexpr (BURST == 64)
+        return ~uint64_t(0);
+    else
+        return ((uint64_t(1) << BURST) - 1) << (idx & ~(BURST - 1));
+}
+
+// Writes image words [base, base + 64) selected by mask, one burst per
+// aligned group with at least one bit set. Returns the number of bus
+// accesses.
+template<typename HW, typename word_t>
+inline size_t hw_wr_groups(HW &hw, uint64_t mask, size_t base, const word_t *image, size_t entries) {
+    constexpr size_t BURST = hw_burst_words<HW>;
+    size_t accesses = 0;
+    while (mask) {
+        const size_t bit = std::countr_zero(mask);
+        if constexpr (BURST == 1) {
+            hw.wr(base + bit, image[base + bit]);
+        } else {
+            const size_t idx = base + (bit & ~(BURST - 1));
+            hw.wr_burst(idx, image + idx, std::min(BURST, entries - idx));
+        }
+        mask &= ~burst_group_mask<BURST>(bit);
+        accesses++;
+    }
+    return accesses;
+}
@@ -0,0 +1,457 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+// ------------------------------------------------------------
+// CYCLE-ACCURATE C++ MODEL OF vhdl_linkruncca
+// ------------------------------------------------------------
+//
+// Register-by-register transcription of fpga/src/rtl/vhdl_linkruncca.vhdl
+// and its sub-entities (row buffers, window, holes filler, table RAMs,
+// table reader, equivalence resolver, feature accumulator).
+//
+// One clock() call equals one rising edge of the gated DUT clock in
+// emulator_top. Registers with asynchronous reset in the RTL are held
+// in reset while rst is high, synchronous ones are cleared on the edge.
+// All registers and RAMs power up as zero, like the FPGA does.
+//
+
+template<typename constants_t>
+class linkruncca_model {
+public:
+    using sum_t = unsigned __int128;
+    using addr_t = uint32_t;
+
+    static constexpr size_t X_BITS = constants_t::X_BITS;
+    static constexpr size_t Y_BITS = constants_t::Y_BITS;
+    static constexpr size_t Y_LOW_BITS = constants_t::Y_LOW_BITS;
+    static constexpr size_t MEM_ADD_BITS = constants_t::MEM_ADD_BITS;
+    static constexpr size_t MEM_SIZE = size_t(1) << MEM_ADD_BITS;
+    static constexpr size_t ROW_BUF_LENGTH = constants_t::X_SIZE - 2;
+
+    static_assert(X_BITS <= 64 && Y_BITS <= 64, "Coordinates must fit 64 bits.");
+    static_assert(MEM_ADD_BITS <= 32, "Table RAM address must fit 32 bits.");
+    static_assert(constants_t::X2_SUM_BITS <= 128 &&
+                  constants_t::YLOW2_SUM_BITS <= 128 &&
+                  constants_t::XYLOW_SUM_BITS <= 128 &&
+                  constants_t::X_SEG_SUM_BITS <= 128 &&
+                  constants_t::YLOW_SEG_SUM_BITS <= 128 &&
+                  constants_t::N_SEG_SUM_BITS <= 128,
+                  "Moment sums must fit 128 bits.");
+
+    // linkruncca_collect_t
+    struct collect_t {
+        bool in_label;
+        uint64_t x;
+        uint64_t y;
+        bool has_red;
+        bool has_green;
+        bool has_blue;
+    };
+
+    // linkruncca_feature_t
+    struct feature_t {
+        uint64_t x_left;
+        uint64_t x_right;
+        uint64_t y_top_seg0;
+        uint64_t y_top_seg1;
+        uint64_t y_bottom_seg0;
+        uint64_t y_bottom_seg1;
+        sum_t x2_sum;
+        sum_t ylow2_sum;
+        sum_t xylow_sum;
+        sum_t x_seg0_sum;
+        sum_t x_seg1_sum;
+        sum_t ylow_seg0_sum;
+        sum_t ylow_seg1_sum;
+        sum_t n_seg0_sum;
+        sum_t n_seg1_sum;
+    };
+
+    linkruncca_model() :
+        n_ram_(MEM_SIZE, 0), h_ram_(MEM_SIZE, 0), t_ram_(MEM_SIZE, 0),
+        d_ram_(MEM_SIZE, feature_t{}),
+        rbhf_(ROW_BUF_LENGTH, 0), rb_(ROW_BUF_LENGTH, 0)
+    {}
+
+    // ----------------------------------------------------
+    // One rising edge of clk.
+    // ----------------------------------------------------
+    void clock(bool rst, bool datavalid, const collect_t &pix_in) {
+        if (rst)
+            async_reset();
+
+        // ---- Combinational network, pre-edge register values ----
+
+        const addr_t n_rdata = n_ram_[n_raddr_reg_];
+        const addr_t h_rdata = h_ram_[h_raddr_reg_];
+        const addr_t t_rdata = t_ram_[t_raddr_reg_];
+
+        // vhdl_holes_filler
+        const bool hf_out = hf_x_ || (hf_top_ && (hf_left_ || hf_right_));
+
+        // vhdl_row_buf (RBHF and RB)
+        const bool hr1 = rbhf_[rbhf_head_];
+        const bool r1 = rb_[rb_head_];
+        const bool r2 = rb_[next_idx(rb_head_)];
+
+        // vhdl_feature_accumulator: d
+        feature_t dd = d_acc_;
+        if (dmg_d1_ || dac_d1_)
+            dd = feature_merge(d_acc_, d_pix_d1_);
+        if (clr_d1_ || rst)
+            dd = feature_empty_val();
+
+        // vhdl_table_reader: tp, dp
+        const bool ab = !a_ && b_;
+        const addr_t tp = ab ? t_rdata : rtp_;
+        const feature_t dp = ab ? d_ram_[d_raddr_reg_] : rdp_;
+
+        // vhdl_equivalence_resolver
+        const bool ec = c_ && !d_;
+        const bool ep = a_ && !b_;
+        const bool o = b_ && d_ && (!a_ || !c_);
+        const bool dmg = o && !(f_ && hp_ == h_);
+        const bool dac = d_;
+        const bool clr = ec;
+
+        bool h_we = false, t_we = false, n_we = false, d_we = false;
+        addr_t h_waddr = 0, t_waddr = 0, n_waddr = 0, d_waddr = 0;
+        addr_t h_wdata = 0, t_wdata = 0, n_wdata = 0;
+        feature_t d_wdata = feature_empty_val();
+        bool eoc = false;
+        bool hbf = false;
+
+        if (ec) {
+            n_we = true;
+            n_waddr = cc_;
+            n_wdata = cc_;
+
+            h_we = true;
+            h_waddr = cc_;
+            h_wdata = cc_;
+
+            d_we = true;
+            d_waddr = f_ ? h_ : cc_;
+            d_wdata = dd;
+        }
+        else if (ep) {
+            if (!fp_) {
+                d_we = true;
+                d_waddr = np_;
+                d_wdata = dp;
+                eoc = fn_;
+            }
+            else {
+                h_we = true;
+                h_waddr = np_;
+                h_wdata = hp_;
+                hbf = true;
+            }
+        }
+        else if (o) {
+            h_we = true;
+            h_waddr = np_;
+            t_we = true;
+            t_wdata = cc_;
+
+            if (!fp_) {
+                h_wdata = f_ ? h_ : cc_;
+                t_waddr = f_ ? h_ : cc_;
+            }
+            else {
+                h_wdata = hp_;
+                t_waddr = hp_;
+
+                n_we = true;
+                n_waddr = tp;
+                n_wdata = f_ ? h_ : cc_;
+            }
+        }
+
+        const bool hcn = hbf && np_ == p_;
+
+        // vhdl_table_reader: read address muxes and data bypass
+        const addr_t t_raddr = hcn ? h_wdata : h_rdata;
+        const addr_t d_raddr = t_raddr;
+        const bool dcn = d_we && d_waddr == hp_;
+
+        // vhdl_feature_accumulator: d_pix
+        feature_t d_pix = feature_empty_val();
+        if (dmg && dac)
+            d_pix = feature_merge(dp, feature_collect(pix_d3_));
+        else if (dac)
+            d_pix = feature_collect(pix_d3_);
+        else if (dmg)
+            d_pix = dp;
+
+        // ---- Rising edge ----
+
+        // vhdl_linkruncca: output register
+        res_valid_ = false;
+        if (datavalid && eoc) {
+            res_data_ = dp;
+            res_valid_ = true;
+        }
+
+        // Table RAMs, read address is registered on every edge
+        n_raddr_reg_ = pc_;
+        h_raddr_reg_ = pc_;
+        t_raddr_reg_ = t_raddr;
+        d_raddr_reg_ = d_raddr;
+        if (datavalid) {
+            if (n_we)
+                n_ram_[n_waddr] = n_wdata;
+            if (h_we)
+                h_ram_[h_waddr] = h_wdata;
+            if (t_we)
+                t_ram_[t_waddr] = t_wdata;
+            if (d_we)
+                d_ram_[d_waddr] = d_wdata;
+        }
+
+        if (datavalid) {
+            // vhdl_table_reader, second process (uses pre-edge p)
+            rtp_ = tp;
+            rdp_ = dcn ? dd : dp;
+            if (!b_ && r1) {
+                hp_ = t_raddr;
+                fp_ = t_raddr != p_;
+                np_ = n_rdata;
+                fn_ = n_rdata == p_;
+            }
+            else if (o) {
+                rtp_ = t_wdata;
+                fp_ = true;
+                hp_ = h_wdata;
+            }
+
+            // vhdl_table_reader, first process
+            p_ = pc_;
+            if (r1 && !r2)
+                pc_ = (pc_ + 1) & ADDR_MASK;
+
+            // vhdl_equivalence_resolver
+            if (ec) {
+                cc_ = (cc_ + 1) & ADDR_MASK;
+                f_ = false;
+            }
+            else if (o) {
+                h_ = h_wdata;
+                f_ = true;
+            }
+
+            // vhdl_feature_accumulator, pre_acc_sync_pr
+            dac_d1_ = dac;
+            dmg_d1_ = dmg;
+            clr_d1_ = clr;
+            d_pix_d1_ = d_pix;
+
+            // vhdl_row_buf instances shift in pre-edge C and left
+            rb_[rb_head_] = c_;
+            rb_head_ = next_idx(rb_head_);
+            rbhf_[rbhf_head_] = hf_left_;
+            rbhf_head_ = next_idx(rbhf_head_);
+
+            // vhdl_window
+            a_ = b_;
+            b_ = r1;
+            c_ = d_;
+            d_ = hf_out;
+
+            // vhdl_holes_filler
+            hf_top_ = hr1;
+            hf_left_ = hf_x_;
+            hf_x_ = hf_right_;
+            hf_right_ = pix_in.in_label;
+
+            pix_d3_ = pix_d2_;
+            pix_d2_ = pix_d1_;
+            pix_d1_ = pix_in;
+        }
+
+        // vhdl_feature_accumulator, acc_sync_pr (not gated by datavalid)
+        d_acc_ = dd;
+
+        if (rst) {
+            hf_top_ = hf_left_ = hf_x_ = hf_right_ = false;
+            a_ = b_ = c_ = d_ = false;
+            async_reset();
+        }
+    }
+
+    inline bool res_valid() const noexcept {
+        return res_valid_;
+    }
+
+    inline const feature_t &res_data() const noexcept {
+        return res_data_;
+    }
+
+    // ----------------------------------------------------
+    // vhdl_linkruncca_pkg feature functions.
+    // ----------------------------------------------------
+    static constexpr feature_t feature_empty_val() {
+        feature_t r{};
+        r.x_left = mask(X_BITS);
+        r.x_right = 0;
+        r.y_top_seg0 = mask(Y_LOW_BITS);
+        r.y_top_seg1 = mask(Y_LOW_BITS);
+        r.y_bottom_seg0 = 0;
+        r.y_bottom_seg1 = 0;
+        return r;
+    }
+
+    static constexpr feature_t feature_collect(const collect_t &a) {
+        feature_t r = feature_empty_val();
+        if (!a.in_label)
+            return r;
+
+        const bool y_msb = (a.y >> (Y_BITS - 1)) & 1;
+        const uint64_t y_low = a.y & mask(Y_LOW_BITS);
+        const sum_t x = a.x;
+        const sum_t yl = y_low;
+
+        r.x_left = a.x;
+        r.x_right = a.x;
+        if (!y_msb) {
+            r.y_top_seg0 = y_low;
+            r.y_bottom_seg0 = y_low;
+        }
+        else {
+            r.y_top_seg1 = y_low;
+            r.y_bottom_seg1 = y_low;
+        }
+
+        r.x2_sum = (x * x) & mask(constants_t::X2_SUM_BITS);
+        r.ylow2_sum = (yl * yl) & mask(constants_t::YLOW2_SUM_BITS);
+        r.xylow_sum = (x * yl) & mask(constants_t::XYLOW_SUM_BITS);
+
+        if (!y_msb) {
+            r.x_seg0_sum = x & mask(constants_t::X_SEG_SUM_BITS);
+            r.ylow_seg0_sum = yl & mask(constants_t::YLOW_SEG_SUM_BITS);
+            r.n_seg0_sum = 1;
+        }
+        else {
+            r.x_seg1_sum = x & mask(constants_t::X_SEG_SUM_BITS);
+            r.ylow_seg1_sum = yl & mask(constants_t::YLOW_SEG_SUM_BITS);
+            r.n_seg1_sum = 1;
+        }
+        return r;
+    }
+
+    static constexpr feature_t feature_merge(const feature_t &a, const feature_t &b) {
+        feature_t r = a;
+        r.x_left = std::min(a.x_left, b.x_left);
+        r.x_right = std::max(a.x_right, b.x_right);
+        r.y_top_seg0 = std::min(a.y_top_seg0, b.y_top_seg0);
+        r.y_top_seg1 = std::min(a.y_top_seg1, b.y_top_seg1);
+        r.y_bottom_seg0 = std::max(a.y_bottom_seg0, b.y_bottom_seg0);
+        r.y_bottom_seg1 = std::max(a.y_bottom_seg1, b.y_bottom_seg1);
+        r.x2_sum = (a.x2_sum + b.x2_sum) & mask(constants_t::X2_SUM_BITS);
+        r.ylow2_sum = (a.ylow2_sum + b.ylow2_sum) & mask(constants_t::YLOW2_SUM_BITS);
+        r.xylow_sum = (a.xylow_sum + b.xylow_sum) & mask(constants_t::XYLOW_SUM_BITS);
+        r.x_seg0_sum = (a.x_seg0_sum + b.x_seg0_sum) & mask(constants_t::X_SEG_SUM_BITS);
+        r.x_seg1_sum = (a.x_seg1_sum + b.x_seg1_sum) & mask(constants_t::X_SEG_SUM_BITS);
+        r.ylow_seg0_sum = (a.ylow_seg0_sum + b.ylow_seg0_sum) & mask(constants_t::YLOW_SEG_SUM_BITS);
+        r.ylow_seg1_sum = (a.ylow_seg1_sum + b.ylow_seg1_sum) & mask(constants_t::YLOW_SEG_SUM_BITS);
+        r.n_seg0_sum = (a.n_seg0_sum + b.n_seg0_sum) & mask(constants_t::N_SEG_SUM_BITS);
+        r.n_seg1_sum = (a.n_seg1_sum + b.n_seg1_sum) & mask(constants_t::N_SEG_SUM_BITS);
+        return r;
+    }
+
+private:
+    static constexpr sum_t mask(size_t bits) {
+        return bits >= 128 ? ~sum_t(0) : ((sum_t(1) << bits) - 1);
+    }
+
+    static constexpr addr_t ADDR_MASK = static_cast<addr_t>(mask(MEM_ADD_BITS));
+
+    static inline size_t next_idx(size_t idx) noexcept {
+        return (idx + 1 == ROW_BUF_LENGTH) ? 0 : idx + 1;
+    }
+
+    // Registers with asynchronous reset in the RTL.
+    void async_reset() {
+        pc_ = 0;
+        p_ = 0;
+        np_ = 0;
+        hp_ = 0;
+        fp_ = false;
+        fn_ = false;
+        rtp_ = 0;
+        rdp_ = feature_empty_val();
+
+        cc_ = 0;
+        h_ = 0;
+        f_ = false;
+
+        dac_d1_ = false;
+        dmg_d1_ = false;
+        clr_d1_ = false;
+        d_pix_d1_ = feature_empty_val();
+        d_acc_ = feature_empty_val();
+
+        res_valid_ = false;
+    }
+
+    // vhdl_linkruncca
+    collect_t pix_d1_{};
+    collect_t pix_d2_{};
+    collect_t pix_d3_{};
+    bool res_valid_ = false;
+    feature_t res_data_{};
+
+    // vhdl_table_ram_add / vhdl_table_ram_data
+    std::vector<addr_t> n_ram_;
+    std::vector<addr_t> h_ram_;
+    std::vector<addr_t> t_ram_;
+    std::vector<feature_t> d_ram_;
+    addr_t n_raddr_reg_ = 0;
+    addr_t h_raddr_reg_ = 0;
+    addr_t t_raddr_reg_ = 0;
+    addr_t d_raddr_reg_ = 0;
+
+    // vhdl_holes_filler
+    bool hf_top_ = false;
+    bool hf_left_ = false;
+    bool hf_x_ = false;
+    bool hf_right_ = false;
+
+    // vhdl_row_buf, circular: head points at the oldest entry (pix_out1)
+    std::vector<uint8_t> rbhf_;
+    std::vector<uint8_t> rb_;
+    size_t rbhf_head_ = 0;
+    size_t rb_head_ = 0;
+
+    // vhdl_window
+    bool a_ = false;
+    bool b_ = false;
+    bool c_ = false;
+    bool d_ = false;
+
+    // vhdl_table_reader
+    addr_t pc_ = 0;
+    addr_t p_ = 0;
+    addr_t np_ = 0;
+    addr_t hp_ = 0;
+    bool fp_ = false;
+    bool fn_ = false;
+    addr_t rtp_ = 0;
+    feature_t rdp_{};
+
+    // vhdl_equivalence_resolver
+    addr_t cc_ = 0;
+    addr_t h_ = 0;
+    bool f_ = false;
+
+    // vhdl_feature_accumulator
+    bool dac_d1_ = false;
+    bool dmg_d1_ = false;
+    bool clr_d1_ = false;
+    feature_t d_pix_d1_{};
+    feature_t d_acc_{};
+};
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+
+// ------------------------------------------------------------
+// MMIO ORDERING POLICIES
+// ------------------------------------------------------------
+//
+// strict           every access is a plain volatile access to the
+//                  Device-nGnRnE mapping (UIO, or the STRICT view of
+//                  emulator_mmio.h) and no barrier is issued; the device
+//                  memory type keeps all accesses in program order and
+//                  each store waits for its write response.
+// relaxed          the device is mapped Device-nGnRE (POSTED view), so
+//                  stores are posted. Ordering is restored only where the
+//                  DUT needs it: one store barrier before the next
+//                  control register store (the run_reg clock pulse), one
+//                  full barrier before the first load after any store
+//                  (the result reads).
+// write_combining  relaxed, with the feed window on the Normal-NC (WC)
+//                  view, where feed stores may also merge.
+//
+// relaxed and write_combining need the emulator_mmio driver
+// (fpga/src/driver); hw_access_aarch64 refuses them on a UIO device.
+//
+// mmio_fences tracks the pending stores and tells a backend where a
+// barrier is due. For strict it never asks for one.
+//
+
+enum class mmio_order : uint8_t {
+    strict,
+    relaxed,
+    write_combining,
+};
+
+inline constexpr const char *mmio_order_name(mmio_order order) noexcept {
+    switch (order) {
+    case mmio_order::strict:          return "strict";
+    case mmio_order::relaxed:         return "relaxed";
+    case mmio_order::write_combining: return "write_combining";
+    }
+    return "?";
+}
+
+template<mmio_order ORDER>
+class mmio_fences {
+public:
+    static constexpr bool posted = ORDER != mmio_order::strict;
+
+    // A feed store was issued.
+    inline void feed_store() noexcept {
+        if constexpr (posted)
+            feed_ = stored_ = true;
+    }
+
+    // A control register store is about to be issued. True if the feed
+    // stores before it need a store barrier first.
+    inline bool control_store() noexcept {
+        if constexpr (posted) {
+            const bool due = feed_;
+            feed_ = false;
+            stored_ = true;
+            return due;
+        }
+        return false;
+    }
+
+    // A load is about to be issued. True if a store since the last
+    // barrier must complete first.
+    inline bool load() noexcept {
+        if constexpr (posted) {
+            const bool due = stored_;
+            feed_ = stored_ = false;
+            return due;
+        }
+        return false;
+    }
+
+private:
+    bool feed_ = false;
+    bool stored_ = false;
+};
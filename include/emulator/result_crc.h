@@ -0,0 +1,76 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// ------------------------------------------------------------
+// RUNNING CRC OF THE DUT RESULT STREAM
+// ------------------------------------------------------------
+//
+// emulator_top folds every DUT clock with res_valid_out = '1' into a
+// CRC-32C (Castagnoli, reflected, initial value 0xFFFFFFFF, no final
+// xor) over the record
+//
+//   word 0:   DUT clocks since the last clear, after that clock (bits 31..0)
+//   word 1+:  the result words, same packing as the result window
+//
+// in 64-bit words, LSB first, and counts the records. CRC and count
+// are read together from batch_regs::RES_CRC. result_crc computes the
+// same value in software, so a reference run can be checked against a
+// hw run that reads no results at all: equal CRC and count mean equal
+// results in the same cycles.
+//
+
+struct result_crc {
+    static constexpr uint32_t init = 0xffffffff;
+    static constexpr uint32_t poly = 0x82f63b78;
+
+    uint32_t crc = init;
+    uint32_t count = 0;
+
+    // Folds the record of a clock with VALID set; words are the n result words.
+    template<typename word_t>
+    void add(uint64_t cycle, const word_t *words, size_t n) noexcept {
+        static_assert(sizeof(word_t) == 8, "result_crc works on 64-bit result words.");
+        crc = update(crc, static_cast<uint32_t>(cycle));
+        for (size_t i = 0; i < n; i++)
+            crc = update(crc, static_cast<uint64_t>(words[i]));
+        count++;
+    }
+
+    // RES_CRC register: crc in bits 31..0, count in bits 63..32.
+    static constexpr result_crc from_reg(uint64_t reg) noexcept {
+        return result_crc{static_cast<uint32_t>(reg), static_cast<uint32_t>(reg >> 32)};
+    }
+
+    constexpr uint64_t reg() const noexcept {
+        return uint64_t(count) << 32 | crc;
+    }
+
+    friend constexpr bool operator==(const result_crc &, const result_crc &) = default;
+
+    // Folds one 64-bit word, slicing-by-8: table[k][b] is the CRC of
+    // byte b followed by k zero bytes.
+    static constexpr uint32_t update(uint32_t crc, uint64_t word) noexcept {
+        word ^= crc;
+        uint32_t r = 0;
+        for (size_t k = 0; k < 8; k++)
+            r ^= table[7 - k][(word >> (8 * k)) & 0xff];
+        return r;
+    }
+
+    static constexpr std::array<std::array<uint32_t, 256>, 8> table = [] {
+        std::array<std::array<uint32_t, 256>, 8> t{};
+        for (uint32_t b = 0; b < 256; b++) {
+            uint32_t c = b;
+            for (size_t i = 0; i < 8; i++)
+                c = (c >> 1) ^ ((c & 1) ? poly : 0);
+            t[0][b] = c;
+        }
+        for (size_t k = 1; k < 8; k++)
+            for (size_t b = 0; b < 256; b++)
+                t[k][b] = (t[k - 1][b] >> 8) ^ t[0][t[k - 1][b] & 0xff];
+        return t;
+    }();
+};
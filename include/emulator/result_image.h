@@ -0,0 +1,84 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+#include "fields.h"
+#include "bit_slicer.h"
+
+// ------------------------------------------------------------
+// CAPTURED RESULT WORDS OF ONE DUT CLOCK
+// ------------------------------------------------------------
+//
+// A plain copy of all hw_access::rd_word_t result words, filled with
+// emulator_fields::rd_capture(). Fields are decoded later, off the MMIO
+// thread, with the same rd_field() calls as on emulator_fields.
+// wr_field() encodes fields, to rebuild the result words of decoded
+// results (see result_crc.h).
+//
+
+template<typename HW, typename FIELDS>
+class result_image {
+public:
+    using wr_word_t = typename HW::wr_word_t;
+    using rd_word_t = typename HW::rd_word_t;
+
+    using rd_fields = typename FIELDS::rd_fields;
+    using fields_t = fields<FIELDS>;
+
+    static constexpr size_t RD_BITS_PER_WORD = sizeof(rd_word_t) * 8;
+    static constexpr size_t rd_entries = (fields_t::rd_bits + RD_BITS_PER_WORD - 1) / RD_BITS_PER_WORD;
+
+    using words_t = std::array<rd_word_t, rd_entries>;
+
+    words_t words;
+
+    template<typename word_t>
+    inline void rd_field(rd_fields field, word_t &data) {
+        auto desc = fields_t::rd_desc(field);
+        bit_slicer<result_image> slicer(*this);
+        data = slicer.template read_bits<word_t>(desc.bit_offset, desc.bit_width);
+    }
+
+    template<rd_fields FIELD, typename word_t>
+    inline void rd_field(word_t &data) {
+        constexpr auto desc = fields_t::template rd_desc<FIELD>();
+        bit_slicer<result_image> slicer(*this);
+        data = slicer.template read_bits<desc.bit_offset, desc.bit_width, word_t>();
+    }
+
+    template<rd_fields FIELD, typename word_t>
+    inline void wr_field(const word_t &data) {
+        constexpr auto desc = fields_t::template rd_desc<FIELD>();
+        word_writer writer{words};
+        bit_slicer<word_writer> slicer(writer);
+        slicer.template write_bits<desc.bit_offset, desc.bit_width>(data);
+    }
+
+    // bit_slicer source interface.
+    inline rd_word_t read(size_t word_offset) const noexcept {
+        return words[word_offset];
+    }
+
+    template<size_t WORD_OFFSET>
+    inline rd_word_t read() const noexcept {
+        static_assert(WORD_OFFSET < rd_entries, "result_image::read<>() word_offset out of range");
+        return words[WORD_OFFSET];
+    }
+
+private:
+    // bit_slicer target over the result words.
+    struct word_writer {
+        using wr_word_t = result_image::rd_word_t;
+        using rd_word_t = result_image::rd_word_t;
+
+        words_t &words;
+
+        template<size_t WORD_OFFSET>
+        inline void write(rd_word_t data, rd_word_t mask) noexcept {
+            static_assert(WORD_OFFSET < rd_entries, "result_image::wr_field() word_offset out of range");
+            auto &word = words[WORD_OFFSET];
+            word = (word & ~mask) | (data & mask);
+        }
+    };
+};
@@ -1,9 +1,14 @@
 #pragma once
 
+#include <array>
+#include <bit>
+#include <cstdint>
 #include <stdexcept>
 #include <format> 
 
 #include "fields.h"
+#include "hw_burst.h"
+#include "stats.h"
 
 template<typename hw_access_t, typename fields_t>
 class shadow {
@@ -13,8 +18,11 @@ public:
 
     constexpr shadow(hw_access_t &hw) : hw_(hw) {
         wr_cache_.fill(0);
-        wr_dirty_.fill(true);
-        rd_dirty_.fill(true);
+        wr_hw_.fill(0);
+        // hw register contents are unknown until the first flush.
+        wr_dirty_ = all_wr_words();
+        wr_known_.fill(0);
+        rd_dirty_.fill(~uint64_t(0));
     }
 
     inline void write(size_t word_offset, wr_word_t data, wr_word_t mask) {
@@ -22,21 +30,92 @@ public:
             throw std::runtime_error(std::format("shadow::write() word_offset ({}) out of range", word_offset));
         }
         auto &cache = wr_cache_[word_offset];
+        const wr_word_t old = cache;
         cache = (cache & ~mask) | (data & mask);
-        wr_dirty_[word_offset] = true;
+        wr_dirty_[word_offset / 64] |= uint64_t(1) << (word_offset % 64);
+        if (cache == old)
+            stats_.unchanged_writes.add();
     }
 
+    // Compile-time word index: no range check at run time.
+    template<size_t WORD_OFFSET>
+    inline void write(wr_word_t data, wr_word_t mask) noexcept {
+        static_assert(WORD_OFFSET < wr_entries, "shadow::write<>() word_offset out of range");
+        auto &cache = wr_cache_[WORD_OFFSET];
+        const wr_word_t old = cache;
+        cache = (cache & ~mask) | (data & mask);
+        wr_dirty_[WORD_OFFSET / 64] |= uint64_t(1) << (WORD_OFFSET % 64);
+        if (cache == old)
+            stats_.unchanged_writes.add();
+    }
+
+    // Writes the dirty words whose value differs from the last value
+    // sent to hw. Words rewritten with the value hw already holds are
+    // dropped here, without an MMIO store. With a burst backend every
+    // aligned group holding such a word is written as one access.
     inline void wr_flush() {
-        for(size_t idx = 0; idx < wr_entries; idx++) {
-            if(wr_dirty_[idx]) {
-                hw_.wr(idx, wr_cache_[idx]);
-                wr_dirty_[idx] = false;
+        size_t flushed = 0;
+        size_t accesses = 0;
+        for(size_t m = 0; m < wr_mask_words; m++) {
+            const uint64_t known = wr_known_[m];
+            uint64_t send = 0;
+            for(uint64_t bits = wr_dirty_[m]; bits; bits &= bits - 1) {
+                const size_t bit = std::countr_zero(bits);
+                const size_t idx = m * 64 + bit;
+                if((known >> bit) & 1 && wr_cache_[idx] == wr_hw_[idx])
+                    continue;
+                send |= uint64_t(1) << bit;
+            }
+            if(send) {
+                flushed += std::popcount(send);
+                accesses += hw_wr_groups(hw_, send, m * 64, wr_cache_.data(), wr_entries);
+                // Whole groups went out: hw now holds the cache there.
+                uint64_t sent = send;
+                if constexpr (burst_words > 1)
+                    for(uint64_t bits = send; bits; bits &= ~burst_group_mask<burst_words>(std::countr_zero(bits)))
+                        sent |= burst_group_mask<burst_words>(std::countr_zero(bits));
+                sent &= all_wr_words()[m];
+                for(uint64_t bits = sent; bits; bits &= bits - 1) {
+                    const size_t idx = m * 64 + std::countr_zero(bits);
+                    wr_hw_[idx] = wr_cache_[idx];
+                }
+                wr_known_[m] |= sent;
             }
+            wr_known_[m] |= wr_dirty_[m];
+            wr_dirty_[m] = 0;
         }
+        stats_.wr_flushes.add();
+        stats_.flushed_words.add(flushed);
+        stats_.max_flushed_words.max(flushed);
+        stats_.mmio_wr.add(accesses);
     }
 
     inline void wr_raw(size_t word_address, wr_word_t data) {
       hw_.wr_raw(word_address, data);
+      stats_.mmio_wr.add();
+      if (word_address == 0 && (data & 1))
+          stats_.clock_pulses.add();
+    }
+
+    // Copies the current wr-cache into a register image.
+    template<typename image_t>
+    inline void wr_copy(image_t &image) const noexcept {
+        static_assert(std::tuple_size_v<image_t> == wr_entries, "Image size doesn't match.");
+        for(size_t idx = 0; idx < wr_entries; idx++)
+            image[idx] = wr_cache_[idx];
+    }
+
+    // Takes over a register image that has already been written to hw
+    // by other means (e.g. stimulus replay), and clears dirty flags.
+    template<typename image_t>
+    inline void wr_sync(const image_t &image) noexcept {
+        static_assert(std::tuple_size_v<image_t> == wr_entries, "Image size doesn't match.");
+        for(size_t idx = 0; idx < wr_entries; idx++) {
+            wr_cache_[idx] = image[idx];
+            wr_hw_[idx] = image[idx];
+        }
+        wr_dirty_.fill(0);
+        wr_known_ = all_wr_words();
     }
 
     inline rd_word_t read(size_t word_offset) {
@@ -44,22 +123,115 @@ public:
             throw std::runtime_error(std::format("shadow::read() word_offset ({}) out of range", word_offset));
         }
         auto idx = word_offset;
-        if(rd_dirty_[idx]) {
-            rd_cache_[idx] = hw_.rd(idx);
-            rd_dirty_[idx] = false;
+        const uint64_t bit = uint64_t(1) << (idx % 64);
+        if(rd_dirty_[idx / 64] & bit) {
+            rd_miss(idx);
+        } else {
+            stats_.rd_hits.add();
         }
         return rd_cache_[idx];
     }
 
+    // Compile-time word index: no range check at run time.
+    template<size_t WORD_OFFSET>
+    inline rd_word_t read() noexcept {
+        static_assert(WORD_OFFSET < rd_entries, "shadow::read<>() word_offset out of range");
+        constexpr uint64_t bit = uint64_t(1) << (WORD_OFFSET % 64);
+        if(rd_dirty_[WORD_OFFSET / 64] & bit) {
+            rd_miss(WORD_OFFSET);
+        } else {
+            stats_.rd_hits.add();
+        }
+        return rd_cache_[WORD_OFFSET];
+    }
+
+    // Copies all rd words into a result image, reading dirty ones from hw.
+    template<typename image_t>
+    inline void rd_copy(image_t &image) {
+        static_assert(std::tuple_size_v<image_t> == rd_entries, "Image size doesn't match.");
+        rd_fetch(0, rd_entries - 1);
+        for(size_t idx = 0; idx < rd_entries; idx++)
+            image[idx] = read(idx);
+    }
+
+    // Copies the rd-cache and returns a mask of the words read from hw
+    // since the last rd_flush(). Needs at most 64 rd words.
+    template<typename image_t>
+    inline uint64_t rd_snapshot(image_t &image) const noexcept {
+        static_assert(std::tuple_size_v<image_t> == rd_entries, "Image size doesn't match.");
+        static_assert(rd_entries <= 64, "rd_snapshot() supports up to 64 rd words.");
+        for(size_t idx = 0; idx < rd_entries; idx++)
+            image[idx] = rd_cache_[idx];
+        const uint64_t all = rd_entries == 64 ? ~uint64_t(0) : (uint64_t(1) << rd_entries) - 1;
+        return ~rd_dirty_[0] & all;
+    }
+
+    // Fetches the dirty words [first, last] of a field spanning words
+    // ahead of its read()s: one burst per aligned group lying inside the
+    // range with all words dirty. Words outside such groups are left to
+    // single-word misses.
+    inline void rd_fetch(size_t first, size_t last) {
+        if constexpr (burst_words > 1) {
+            if(last >= rd_entries) {
+                throw std::runtime_error(std::format("shadow::rd_fetch() last ({}) out of range", last));
+            }
+            for(size_t group = (first + burst_words - 1) & ~(burst_words - 1); group + burst_words <= last + 1;
+                group += burst_words) {
+                const uint64_t mask = burst_group_mask<burst_words>(group % 64);
+                if((rd_dirty_[group / 64] & mask) != mask)
+                    continue;
+                hw_.rd_burst(group, rd_cache_.data() + group, burst_words);
+                rd_dirty_[group / 64] &= ~mask;
+                count_rd_miss();
+            }
+        }
+    }
+
+    // Compile-time range: no range check at run time.
+    template<size_t FIRST, size_t LAST>
+    inline void rd_fetch() {
+        static_assert(FIRST <= LAST && LAST < rd_entries, "shadow::rd_fetch<>() range out of range");
+        if constexpr (burst_words > 1 && LAST + 1 - FIRST >= burst_words)
+            rd_fetch(FIRST, LAST);
+    }
+
     inline void rd_flush() noexcept {
-        rd_dirty_.fill(true);
+        rd_dirty_.fill(~uint64_t(0));
+        stats_.rd_epoch();
     }
 
     inline rd_word_t rd_raw(size_t word_address) {
+        stats_.mmio_rd.add();
         return hw_.rd_raw(word_address);
     }
+
+    // Empty unless EMULATOR_STATS is defined (see stats.h).
+    inline shadow_stats &stats() noexcept {
+        return stats_;
+    }
+
+    inline const shadow_stats &stats() const noexcept {
+        return stats_;
+    }
 private:
+    static constexpr size_t burst_words = hw_burst_words<hw_access_t>;
+
+    // Fetches word idx alone: on aarch64 an ldp of the pair costs two
+    // AXI-Lite reads, so a lone miss (mostly VALID) stays one ldr.
+    inline void rd_miss(size_t idx) {
+        rd_cache_[idx] = hw_.rd(idx);
+        rd_dirty_[idx / 64] &= ~(uint64_t(1) << (idx % 64));
+        count_rd_miss();
+    }
+
+    inline void count_rd_miss() noexcept {
+        stats_.rd_misses.add();
+        stats_.epoch_misses.add();
+        stats_.mmio_rd.add();
+    }
+
     hw_access_t &hw_;
+    [[no_unique_address]] shadow_stats stats_;
 
     static constexpr size_t wr_bits = fields<fields_t>::wr_bits;
     static constexpr size_t rd_bits = fields<fields_t>::rd_bits;
@@ -70,9 +242,24 @@ private:
     static constexpr size_t wr_entries = (wr_bits + WR_BITS_PER_WORD - 1) / WR_BITS_PER_WORD;
     static constexpr size_t rd_entries = (rd_bits + RD_BITS_PER_WORD - 1) / RD_BITS_PER_WORD;
 
+    static constexpr size_t wr_mask_words = (wr_entries + 63) / 64;
+    static constexpr size_t rd_mask_words = (rd_entries + 63) / 64;
+
+    using wr_mask_t = std::array<uint64_t, wr_mask_words>;
+
+    // Mask with one bit set per wr word.
+    static constexpr wr_mask_t all_wr_words() noexcept {
+        wr_mask_t m{};
+        for(size_t idx = 0; idx < wr_entries; idx++)
+            m[idx / 64] |= uint64_t(1) << (idx % 64);
+        return m;
+    }
+
     std::array<wr_word_t, wr_entries> wr_cache_;
+    std::array<wr_word_t, wr_entries> wr_hw_;       // last value written to hw
     std::array<rd_word_t, rd_entries> rd_cache_;
-    std::array<bool, wr_entries> wr_dirty_;
-    std::array<bool, rd_entries> rd_dirty_;
+    wr_mask_t wr_dirty_;                            // written since last flush
+    wr_mask_t wr_known_;                            // wr_hw_ is valid
+    std::array<uint64_t, rd_mask_words> rd_dirty_;
 };
 
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstddef>
+
+// ------------------------------------------------------------
+// HOT-PATH STATISTICS COUNTERS
+// ------------------------------------------------------------
+//
+// Enabled by defining EMULATOR_STATS (CMake option FPGA_STATS).
+// Otherwise every counter is an empty type kept with
+// [[no_unique_address]], and all updates are empty inline calls,
+// so shadow, bit_slicer and emulator_fields compile as before.
+//
+
+#ifdef EMULATOR_STATS
+inline constexpr bool emulator_stats_enabled = true;
+#else
+inline constexpr bool emulator_stats_enabled = false;
+#endif
+
+template<bool ENABLED = emulator_stats_enabled>
+class stat_counter {
+public:
+    inline void add(uint64_t n = 1) noexcept { value_ += n; }
+    inline void max(uint64_t n) noexcept { value_ = std::max(value_, n); }
+    inline uint64_t value() const noexcept { return value_; }
+private:
+    uint64_t value_ = 0;
+};
+
+template<>
+class stat_counter<false> {
+public:
+    inline void add(uint64_t = 1) noexcept {}
+    inline void max(uint64_t) noexcept {}
+    inline uint64_t value() const noexcept { return 0; }
+};
+
+template<size_t N, bool ENABLED = emulator_stats_enabled>
+class stat_counters {
+public:
+    inline void add(size_t idx, uint64_t n = 1) noexcept { values_[idx] += n; }
+    inline uint64_t value(size_t idx) const noexcept { return values_[idx]; }
+private:
+    std::array<uint64_t, N> values_{};
+};
+
+template<size_t N>
+class stat_counters<N, false> {
+public:
+    inline void add(size_t, uint64_t = 1) noexcept {}
+    inline uint64_t value(size_t) const noexcept { return 0; }
+};
+
+// Counted in shadow (and in emulator_fields::replay, which bypasses it).
+struct shadow_stats {
+    [[no_unique_address]] stat_counter<> mmio_wr;
+    [[no_unique_address]] stat_counter<> mmio_rd;
+    [[no_unique_address]] stat_counter<> clock_pulses;
+
+    [[no_unique_address]] stat_counter<> wr_flushes;
+    [[no_unique_address]] stat_counter<> flushed_words;
+    [[no_unique_address]] stat_counter<> max_flushed_words;
+    [[no_unique_address]] stat_counter<> unchanged_writes;
+
+    [[no_unique_address]] stat_counter<> rd_epochs;
+    [[no_unique_address]] stat_counter<> rd_hits;
+    [[no_unique_address]] stat_counter<> rd_misses;
+    [[no_unique_address]] stat_counter<> max_epoch_misses;
+    [[no_unique_address]] stat_counter<> epoch_misses;
+
+    // Closes the current rd_flush epoch.
+    inline void rd_epoch() noexcept {
+        rd_epochs.add();
+        max_epoch_misses.max(epoch_misses.value());
+        epoch_misses = {};
+    }
+};
+
+// Counted in bit_slicer: field accesses and the shadow words they touch.
+struct slicer_stats {
+    [[no_unique_address]] stat_counter<> wr_bits_calls;
+    [[no_unique_address]] stat_counter<> rd_bits_calls;
+    [[no_unique_address]] stat_counter<> wr_words;
+    [[no_unique_address]] stat_counter<> rd_words;
+};
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+#include "fields.h"
+#include "bit_slicer.h"
+
+// ------------------------------------------------------------
+// PRE-PACKED STIMULUS (REGISTER IMAGES PER DUT CLOCK)
+// ------------------------------------------------------------
+//
+// Field writes are packed into hw_access::wr_word_t register images
+// ahead of time. For every clock only the words that changed since the
+// previous clock are stored, with a per-clock bitmask of their indices.
+// emulator_fields::replay() streams the result straight to hw_access.
+//
+// The image does not touch hw_access, so it can be compiled on any
+// thread and replayed later.
+//
+
+template<typename HW, typename FIELDS>
+class stimulus_image {
+public:
+    using wr_word_t = typename HW::wr_word_t;
+    using rd_word_t = typename HW::rd_word_t;
+
+    using wr_fields = typename FIELDS::wr_fields;
+    using fields_t = fields<FIELDS>;
+
+    static constexpr size_t WR_BITS_PER_WORD = sizeof(wr_word_t) * 8;
+    static constexpr size_t wr_entries = (fields_t::wr_bits + WR_BITS_PER_WORD - 1) / WR_BITS_PER_WORD;
+
+    static_assert(wr_entries <= 64, "stimulus_image supports up to 64 feed words.");
+
+    using mask_t = std::conditional_t<(wr_entries <= 8), uint8_t,
+                   std::conditional_t<(wr_entries <= 16), uint16_t,
+                   std::conditional_t<(wr_entries <= 32), uint32_t, uint64_t>>>;
+
+    using image_t = std::array<wr_word_t, wr_entries>;
+
+    stimulus_image() : slicer_(*this) {
+        restart();
+    }
+
+    stimulus_image(const stimulus_image &) = delete;
+    stimulus_image &operator=(const stimulus_image &) = delete;
+
+    // Forget the register state: the next clock stores all words.
+    inline void restart() {
+        clear();
+        image_.fill(0);
+        last_.fill(0);
+        full_ = true;
+    }
+
+    // Drop compiled clocks, but continue from the current register state.
+    // Use after the previous contents have been replayed.
+    inline void clear() noexcept {
+        masks_.clear();
+        words_.clear();
+    }
+
+    inline void reserve(size_t clocks) {
+        masks_.reserve(clocks);
+        words_.reserve(clocks * wr_entries);
+    }
+
+    template<typename word_t>
+    inline void wr_field(wr_fields field, word_t data) {
+        auto desc = fields_t::wr_desc(field);
+        slicer_.write_bits(desc.bit_offset, desc.bit_width, data);
+    }
+
+    template<wr_fields FIELD, typename word_t>
+    inline void wr_field(const word_t &data) {
+        constexpr auto desc = fields_t::template wr_desc<FIELD>();
+        slicer_.template write_bits<desc.bit_offset, desc.bit_width>(data);
+    }
+
+    // Closes the current clock: records the changed words.
+    inline void clock() {
+        mask_t mask = 0;
+        for (size_t idx = 0; idx < wr_entries; idx++) {
+            if (full_ || image_[idx] != last_[idx]) {
+                mask |= mask_t(1) << idx;
+                words_.push_back(image_[idx]);
+            }
+        }
+        masks_.push_back(mask);
+        last_ = image_;
+        full_ = false;
+    }
+
+    inline size_t clocks() const noexcept {
+        return masks_.size();
+    }
+
+    inline const mask_t *masks() const noexcept {
+        return masks_.data();
+    }
+
+    inline const wr_word_t *words() const noexcept {
+        return words_.data();
+    }
+
+    // Register image after the last compiled clock.
+    inline const image_t &image() const noexcept {
+        return last_;
+    }
+
+    // bit_slicer target interface.
+    inline void write(size_t word_offset, wr_word_t data, wr_word_t mask) noexcept {
+        auto &word = image_[word_offset];
+        word = (word & ~mask) | (data & mask);
+    }
+
+    template<size_t WORD_OFFSET>
+    inline void write(wr_word_t data, wr_word_t mask) noexcept {
+        static_assert(WORD_OFFSET < wr_entries, "stimulus_image::write<>() word_offset out of range");
+        auto &word = image_[WORD_OFFSET];
+        word = (word & ~mask) | (data & mask);
+    }
+
+private:
+    image_t image_;
+    image_t last_;
+    bool full_ = true;
+
+    std::vector<mask_t> masks_;
+    std::vector<wr_word_t> words_;
+
+    bit_slicer<stimulus_image> slicer_;
+};
@@ -0,0 +1,234 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "fields.h"
+
+// ------------------------------------------------------------
+// PER-CYCLE WAVEFORM TRACE
+// ------------------------------------------------------------
+//
+// emulator_fields calls clock() on every DUT clock with the feed
+// register image of that clock. The record of the previous clock is
+// then closed with the result words read after it (the rd-cache) and
+// a mask of which result words were actually read. Per clock this is
+// a copy of the register images into a preallocated ring, no decoding.
+//
+// Recording can be limited to a cycle window, and can stop a given
+// number of cycles after a trigger field read non-zero (e.g. VALID);
+// the ring then holds the history before the trigger.
+//
+// save() writes the ring with the field names and layout, so the
+// trace2vcd tool can convert it without knowing the fields.
+//
+
+// File layout: trace_file_header, then per wr field and per rd field
+// { uint32 bit_offset, uint32 bit_width, uint32 name_len, name },
+// then num_records x { uint64 cycle, uint64 rd_mask, wr words, rd words }.
+struct trace_file_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t wr_word_bytes;
+    uint32_t rd_word_bytes;
+    uint32_t wr_entries;
+    uint32_t rd_entries;
+    uint32_t num_wr_fields;
+    uint32_t num_rd_fields;
+    uint32_t reserved;
+    uint64_t num_records;
+    uint64_t trigger_cycle;         // ~0 if not triggered
+
+    static constexpr char MAGIC[8] = {'E', 'M', 'U', 'T', 'R', 'A', 'C', 'E'};
+    static constexpr uint32_t VERSION = 1;
+    static constexpr uint64_t NO_CYCLE = ~uint64_t(0);
+};
+
+template<typename HW, typename FIELDS>
+class trace_recorder {
+public:
+    using wr_word_t = typename HW::wr_word_t;
+    using rd_word_t = typename HW::rd_word_t;
+
+    using fields_t = fields<FIELDS>;
+    using rd_fields = typename FIELDS::rd_fields;
+
+    static constexpr size_t WR_BITS_PER_WORD = sizeof(wr_word_t) * 8;
+    static constexpr size_t RD_BITS_PER_WORD = sizeof(rd_word_t) * 8;
+    static constexpr size_t wr_entries = (fields_t::wr_bits + WR_BITS_PER_WORD - 1) / WR_BITS_PER_WORD;
+    static constexpr size_t rd_entries = (fields_t::rd_bits + RD_BITS_PER_WORD - 1) / RD_BITS_PER_WORD;
+
+    static_assert(rd_entries <= 64, "trace_recorder supports up to 64 rd words.");
+
+    using wr_image_t = std::array<wr_word_t, wr_entries>;
+    using rd_image_t = std::array<rd_word_t, rd_entries>;
+
+    struct record_t {
+        uint64_t cycle;
+        uint64_t rd_mask;
+        wr_image_t wr;
+        rd_image_t rd;
+    };
+
+    static constexpr uint64_t NO_CYCLE = trace_file_header::NO_CYCLE;
+
+    struct config_t {
+        uint64_t begin = 0;                 // first cycle to record
+        uint64_t end = NO_CYCLE;            // one past the last cycle to record
+        bool trigger = false;               // stop post_trigger cycles after trigger_field != 0
+        rd_fields trigger_field{};
+        uint64_t post_trigger = 0;
+    };
+
+    trace_recorder(size_t capacity, const config_t &config = {})
+        : ring_(capacity), config_(config)
+    {
+        if (capacity == 0)
+            throw std::runtime_error("trace_recorder: capacity of zero");
+    }
+
+    // Starts the record of the next DUT clock. fill_rd(rd_image_t &)
+    // copies the result words read since the previous clock and returns
+    // their mask; it is only called if the previous clock is recorded.
+    template<typename fill_rd_t>
+    inline void clock(const wr_image_t &wr, fill_rd_t &&fill_rd) {
+        close(fill_rd);
+
+        const uint64_t cycle = cycle_++;
+        if (cycle < config_.begin || cycle >= config_.end || cycle > stop_)
+            return;
+
+        record_t &r = ring_[head_];
+        r.cycle = cycle;
+        r.wr = wr;
+        open_ = true;
+    }
+
+    // Closes the record of the last clock.
+    template<typename fill_rd_t>
+    inline void finish(fill_rd_t &&fill_rd) {
+        close(fill_rd);
+    }
+
+    inline size_t size() const noexcept {
+        return count_;
+    }
+
+    inline uint64_t cycles() const noexcept {
+        return cycle_;
+    }
+
+    inline uint64_t trigger_cycle() const noexcept {
+        return trigger_cycle_;
+    }
+
+    // Records in cycle order.
+    template<typename fn_t>
+    void for_each(fn_t &&fn) const {
+        const size_t first = count_ < ring_.size() ? 0 : head_;
+        for (size_t i = 0; i < count_; i++)
+            fn(ring_[(first + i) % ring_.size()]);
+    }
+
+    void save(const std::string &fname) const {
+        std::ofstream out(fname, std::ios::binary);
+        if (!out)
+            throw std::runtime_error("trace_recorder: cannot open " + fname);
+
+        trace_file_header h{};
+        std::memcpy(h.magic, trace_file_header::MAGIC, sizeof(h.magic));
+        h.version = trace_file_header::VERSION;
+        h.wr_word_bytes = sizeof(wr_word_t);
+        h.rd_word_bytes = sizeof(rd_word_t);
+        h.wr_entries = wr_entries;
+        h.rd_entries = rd_entries;
+        h.num_wr_fields = fields_t::num_wr_fields;
+        h.num_rd_fields = fields_t::num_rd_fields;
+        h.num_records = count_;
+        h.trigger_cycle = trigger_cycle_;
+        put(out, h);
+
+        auto put_field = [&](const FieldDesc &desc, const char *name) {
+            const uint32_t len = std::strlen(name);
+            put(out, uint32_t(desc.bit_offset));
+            put(out, uint32_t(desc.bit_width));
+            put(out, len);
+            out.write(name, len);
+        };
+        for (size_t f = 0; f < fields_t::num_wr_fields; f++)
+            put_field(fields_t::wr_descs[f], fields_t::wr_name(f));
+        for (size_t f = 0; f < fields_t::num_rd_fields; f++)
+            put_field(fields_t::rd_descs[f], fields_t::rd_name(f));
+
+        for_each([&](const record_t &r) {
+            put(out, r.cycle);
+            put(out, r.rd_mask);
+            out.write(reinterpret_cast<const char *>(r.wr.data()), sizeof(r.wr));
+            out.write(reinterpret_cast<const char *>(r.rd.data()), sizeof(r.rd));
+        });
+
+        if (!out)
+            throw std::runtime_error("trace_recorder: write failed: " + fname);
+    }
+
+private:
+    template<typename T>
+    static void put(std::ofstream &out, const T &v) {
+        out.write(reinterpret_cast<const char *>(&v), sizeof(v));
+    }
+
+    template<typename fill_rd_t>
+    inline void close(fill_rd_t &fill_rd) {
+        if (!open_)
+            return;
+        open_ = false;
+
+        record_t &r = ring_[head_];
+        r.rd_mask = fill_rd(r.rd);
+        if (++head_ == ring_.size())
+            head_ = 0;
+        if (count_ < ring_.size())
+            count_++;
+
+        if (config_.trigger && trigger_cycle_ == NO_CYCLE && triggered(r)) {
+            trigger_cycle_ = r.cycle;
+            stop_ = r.cycle + config_.post_trigger;
+        }
+    }
+
+    // True if all words of the trigger field were read and any bit is set.
+    inline bool triggered(const record_t &r) const noexcept {
+        const auto desc = fields_t::rd_desc(config_.trigger_field);
+        bool any = false;
+        for (size_t pos = 0; pos < desc.bit_width; ) {
+            const size_t bit = desc.bit_offset + pos;
+            const size_t idx = bit / RD_BITS_PER_WORD;
+            const size_t shift = bit % RD_BITS_PER_WORD;
+            const size_t n = std::min(RD_BITS_PER_WORD - shift, desc.bit_width - pos);
+            if (!((r.rd_mask >> idx) & 1))
+                return false;
+            const rd_word_t mask = n == RD_BITS_PER_WORD ? ~rd_word_t(0) : rd_word_t((rd_word_t(1) << n) - 1);
+            any |= ((r.rd[idx] >> shift) & mask) != 0;
+            pos += n;
+        }
+        return any;
+    }
+
+    std::vector<record_t> ring_;
+    config_t config_;
+
+    size_t head_ = 0;
+    size_t count_ = 0;
+    bool open_ = false;
+
+    uint64_t cycle_ = 0;
+    uint64_t stop_ = NO_CYCLE;
+    uint64_t trigger_cycle_ = NO_CYCLE;
+};
@@ -0,0 +1,81 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// ------------------------------------------------------------
+// CHEAP HOST TIMESTAMPS
+// ------------------------------------------------------------
+
+//
+// now() reads the ARM generic timer (CNTVCT_EL0, behind an isb so it is
+// not taken early) on aarch64, the TSC (behind an lfence) on x86, and
+// CLOCK_MONOTONIC elsewhere. hz() is the tick rate: CNTFRQ_EL0 on
+// aarch64, the TSC measured once against steady_clock on x86, 1 GHz for
+// clock_gettime.
+//
+// The generic timer usually runs at a few tens of MHz, so on aarch64
+// one tick may span several MMIO accesses.
+//
+
+class CycleClock {
+public:
+    static uint64_t now() noexcept {
+#if defined(__aarch64__)
+        uint64_t ticks;
+        __asm__ volatile("isb\n\tmrs %0, cntvct_el0" : "=r"(ticks) : : "memory");
+        return ticks;
+#elif defined(__x86_64__) || defined(__i386__)
+        _mm_lfence();
+        return __rdtsc();
+#else
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return uint64_t(ts.tv_sec) * 1000000000u + uint64_t(ts.tv_nsec);
+#endif
+    }
+
+    static double hz() noexcept {
+#if defined(__aarch64__)
+        uint64_t freq;
+        __asm__ volatile("mrs %0, cntfrq_el0" : "=r"(freq));
+        return double(freq);
+#elif defined(__x86_64__) || defined(__i386__)
+        static const double freq = calibrate();
+        return freq;
+#else
+        return 1e9;
+#endif
+    }
+
+    static const char *source() noexcept {
+#if defined(__aarch64__)
+        return "CNTVCT_EL0";
+#elif defined(__x86_64__) || defined(__i386__)
+        return "rdtsc";
+#else
+        return "clock_gettime";
+#endif
+    }
+
+    static double to_ns(uint64_t ticks) noexcept {
+        return double(ticks) * 1e9 / hz();
+    }
+
+private:
+    // TSC ticks over 20 ms of steady_clock.
+    static double calibrate() noexcept {
+        using clock = std::chrono::steady_clock;
+        const auto t0 = clock::now();
+        const uint64_t c0 = now();
+        auto t1 = t0;
+        while (t1 - t0 < std::chrono::milliseconds(20))
+            t1 = clock::now();
+        const uint64_t c1 = now();
+        return double(c1 - c0) / std::chrono::duration<double>(t1 - t0).count();
+    }
+};
@@ -0,0 +1,85 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+// ------------------------------------------------------------
+// LOG-SCALE LATENCY HISTOGRAM
+// ------------------------------------------------------------
+
+//
+// Values below 16 get a bucket each; above, every power of two is split
+// into 8 linear sub-buckets, so a percentile is off by at most 1/8 of
+// the value. Fixed size (about 4 KB), add() is a few instructions and
+// never allocates. percentile() returns the upper bound of the bucket
+// holding the requested rank, clamped to the largest value seen.
+//
+
+class LatencyHistogram {
+public:
+    static constexpr size_t SUB_BITS = 3;
+    static constexpr size_t LINEAR = size_t(2) << SUB_BITS;
+    static constexpr size_t BUCKETS = LINEAR + (64 - SUB_BITS - 1) * (size_t(1) << SUB_BITS);
+
+    void add(uint64_t value) noexcept {
+        buckets_[bucket(value)]++;
+        count_++;
+        max_ = std::max(max_, value);
+        sum_ += value;
+    }
+
+    void merge(const LatencyHistogram &other) noexcept {
+        for (size_t i = 0; i < BUCKETS; i++)
+            buckets_[i] += other.buckets_[i];
+        count_ += other.count_;
+        max_ = std::max(max_, other.max_);
+        sum_ += other.sum_;
+    }
+
+    uint64_t count() const noexcept { return count_; }
+    uint64_t max() const noexcept { return max_; }
+
+    double mean() const noexcept {
+        return count_ ? double(sum_) / double(count_) : 0.0;
+    }
+
+    // Value at quantile q (0..1), 0 for an empty histogram.
+    uint64_t percentile(double q) const noexcept {
+        if (count_ == 0)
+            return 0;
+        const uint64_t rank = std::max<uint64_t>(1, uint64_t(q * double(count_) + 0.5));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BUCKETS; i++) {
+            seen += buckets_[i];
+            if (seen >= rank)
+                return std::min(upper(i), max_);
+        }
+        return max_;
+    }
+
+    static constexpr size_t bucket(uint64_t value) noexcept {
+        if (value < LINEAR)
+            return size_t(value);
+        const size_t exp = size_t(std::bit_width(value)) - 1;
+        const size_t sub = size_t(value >> (exp - SUB_BITS)) & ((size_t(1) << SUB_BITS) - 1);
+        return LINEAR + (exp - SUB_BITS - 1) * (size_t(1) << SUB_BITS) + sub;
+    }
+
+    // Largest value falling into bucket i.
+    static constexpr uint64_t upper(size_t i) noexcept {
+        if (i < LINEAR)
+            return i;
+        const size_t exp = (i - LINEAR) / (size_t(1) << SUB_BITS) + SUB_BITS + 1;
+        const uint64_t sub = (i - LINEAR) % (size_t(1) << SUB_BITS);
+        const uint64_t step = uint64_t(1) << (exp - SUB_BITS);
+        return (uint64_t(1) << exp) + (sub + 1) * step - 1;
+    }
+
+private:
+    std::array<uint64_t, BUCKETS> buckets_{};
+    uint64_t count_ = 0;
+    uint64_t max_ = 0;
+    uint64_t sum_ = 0;
+};
@@ -0,0 +1,72 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+
+// ------------------------------------------------------------
+// LOCK-FREE SINGLE-PRODUCER / SINGLE-CONSUMER RING
+// ------------------------------------------------------------
+
+//
+// Fixed capacity (power of two), no allocation after construction.
+// try_push()/try_pop() never block. push()/pop() spin and yield the
+// CPU while the ring is full/empty, which also works on a single core.
+//
+// Each side keeps a cached copy of the other side's index, so the shared
+// cache lines are only touched when the ring looks full or empty.
+//
+
+template <typename T, size_t CAPACITY>
+class SpscRing {
+    static_assert(CAPACITY > 0 && (CAPACITY & (CAPACITY - 1)) == 0,
+                  "SpscRing capacity must be a power of two.");
+
+public:
+    bool try_push(const T &v) noexcept {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_cache_ == CAPACITY) {
+            tail_cache_ = tail_.load(std::memory_order_acquire);
+            if (head - tail_cache_ == CAPACITY)
+                return false;
+        }
+        slots_[head & MASK] = v;
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool try_pop(T &v) noexcept {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail == head_cache_) {
+            head_cache_ = head_.load(std::memory_order_acquire);
+            if (tail == head_cache_)
+                return false;
+        }
+        v = slots_[tail & MASK];
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    void push(const T &v) noexcept {
+        while (!try_push(v))
+            std::this_thread::yield();
+    }
+
+    void pop(T &v) noexcept {
+        while (!try_pop(v))
+            std::this_thread::yield();
+    }
+
+private:
+    static constexpr size_t MASK = CAPACITY - 1;
+
+    // Producer side
+    alignas(64) std::atomic<size_t> head_{0};
+    size_t tail_cache_ = 0;
+
+    // Consumer side
+    alignas(64) std::atomic<size_t> tail_{0};
+    size_t head_cache_ = 0;
+
+    alignas(64) std::array<T, CAPACITY> slots_;
+};
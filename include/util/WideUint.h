@@ -0,0 +1,236 @@
+#pragma once
+#include <array>
+#include <compare>
+#include <cstdint>
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <type_traits>
+
+// ------------------------------------------------------------
+// FIXED-WIDTH UNSIGNED INTEGERS FOR FPGA FIELDS
+// ------------------------------------------------------------
+
+//
+// WideUint<BITS> is an unsigned integer of exactly BITS bits, stored in
+// 64-bit limbs on the stack. Arithmetic wraps modulo 2^BITS like VHDL
+// unsigned. It provides the operations bit_slicer needs (shifts, bitwise
+// ops, compare, conversion to built-in types) plus add/sub for sums.
+//
+// FpgaUint<BITS> picks the cheapest type holding BITS bits:
+// uint64_t, unsigned __int128, or WideUint<BITS>.
+//
+
+template <size_t BITS>
+class WideUint {
+    static_assert(BITS > 0, "WideUint needs at least one bit.");
+
+public:
+    static constexpr size_t LIMBS = (BITS + 63) / 64;
+
+    constexpr WideUint() noexcept : limbs_{} {}
+
+    template <typename T>
+        requires (std::is_integral_v<T> || std::is_same_v<T, unsigned __int128>)
+    constexpr WideUint(T v) noexcept : limbs_{} {
+        using U = std::conditional_t<(sizeof(T) > 8), unsigned __int128, uint64_t>;
+        U u = static_cast<U>(v);
+        for (size_t i = 0; i < LIMBS && i * 64 < sizeof(U) * 8; i++)
+            limbs_[i] = static_cast<uint64_t>(u >> (i * 64));
+        trim();
+    }
+
+    template <typename T>
+        requires (std::is_integral_v<T> || std::is_same_v<T, unsigned __int128>)
+    explicit constexpr operator T() const noexcept {
+        if constexpr (std::is_same_v<T, bool>) {
+            return !is_zero();
+        }
+        else if constexpr (sizeof(T) > 8) {
+            unsigned __int128 r = limbs_[0];
+            if constexpr (LIMBS > 1)
+                r |= static_cast<unsigned __int128>(limbs_[1]) << 64;
+            return static_cast<T>(r);
+        }
+        else {
+            return static_cast<T>(limbs_[0]);
+        }
+    }
+
+    constexpr double to_double() const noexcept {
+        double r = 0.0;
+        for (size_t i = LIMBS; i-- > 0;)
+            r = r * 18446744073709551616.0 + static_cast<double>(limbs_[i]);
+        return r;
+    }
+
+    constexpr bool is_zero() const noexcept {
+        for (auto l : limbs_)
+            if (l)
+                return false;
+        return true;
+    }
+
+    constexpr uint64_t limb(size_t i) const noexcept {
+        return limbs_[i];
+    }
+
+    // ----------------------------------------------------
+    // Shifts
+    // ----------------------------------------------------
+    constexpr WideUint &operator<<=(size_t n) noexcept {
+        if (n >= BITS) {
+            limbs_ = {};
+            return *this;
+        }
+        const size_t w = n / 64, b = n % 64;
+        for (size_t i = LIMBS; i-- > 0;) {
+            uint64_t v = 0;
+            if (i >= w) {
+                v = limbs_[i - w] << b;
+                if (b && i > w)
+                    v |= limbs_[i - w - 1] >> (64 - b);
+            }
+            limbs_[i] = v;
+        }
+        trim();
+        return *this;
+    }
+
+    constexpr WideUint &operator>>=(size_t n) noexcept {
+        if (n >= BITS) {
+            limbs_ = {};
+            return *this;
+        }
+        const size_t w = n / 64, b = n % 64;
+        for (size_t i = 0; i < LIMBS; i++) {
+            uint64_t v = 0;
+            if (i + w < LIMBS) {
+                v = limbs_[i + w] >> b;
+                if (b && i + w + 1 < LIMBS)
+                    v |= limbs_[i + w + 1] << (64 - b);
+            }
+            limbs_[i] = v;
+        }
+        return *this;
+    }
+
+    friend constexpr WideUint operator<<(WideUint a, size_t n) noexcept { return a <<= n; }
+    friend constexpr WideUint operator>>(WideUint a, size_t n) noexcept { return a >>= n; }
+
+    // ----------------------------------------------------
+    // Bitwise
+    // ----------------------------------------------------
+    constexpr WideUint &operator|=(const WideUint &o) noexcept {
+        for (size_t i = 0; i < LIMBS; i++)
+            limbs_[i] |= o.limbs_[i];
+        return *this;
+    }
+
+    constexpr WideUint &operator&=(const WideUint &o) noexcept {
+        for (size_t i = 0; i < LIMBS; i++)
+            limbs_[i] &= o.limbs_[i];
+        return *this;
+    }
+
+    constexpr WideUint &operator^=(const WideUint &o) noexcept {
+        for (size_t i = 0; i < LIMBS; i++)
+            limbs_[i] ^= o.limbs_[i];
+        return *this;
+    }
+
+    constexpr WideUint operator~() const noexcept {
+        WideUint r;
+        for (size_t i = 0; i < LIMBS; i++)
+            r.limbs_[i] = ~limbs_[i];
+        r.trim();
+        return r;
+    }
+
+    friend constexpr WideUint operator|(WideUint a, const WideUint &b) noexcept { return a |= b; }
+    friend constexpr WideUint operator&(WideUint a, const WideUint &b) noexcept { return a &= b; }
+    friend constexpr WideUint operator^(WideUint a, const WideUint &b) noexcept { return a ^= b; }
+
+    // ----------------------------------------------------
+    // Arithmetic, modulo 2^BITS
+    // ----------------------------------------------------
+    constexpr WideUint &operator+=(const WideUint &o) noexcept {
+        uint64_t carry = 0;
+        for (size_t i = 0; i < LIMBS; i++) {
+            uint64_t s = limbs_[i] + carry;
+            carry = s < carry;
+            limbs_[i] = s + o.limbs_[i];
+            carry += limbs_[i] < s;
+        }
+        trim();
+        return *this;
+    }
+
+    constexpr WideUint &operator-=(const WideUint &o) noexcept {
+        uint64_t borrow = 0;
+        for (size_t i = 0; i < LIMBS; i++) {
+            uint64_t d = limbs_[i] - o.limbs_[i];
+            uint64_t b1 = limbs_[i] < o.limbs_[i];
+            limbs_[i] = d - borrow;
+            borrow = b1 | (d < borrow);
+        }
+        trim();
+        return *this;
+    }
+
+    friend constexpr WideUint operator+(WideUint a, const WideUint &b) noexcept { return a += b; }
+    friend constexpr WideUint operator-(WideUint a, const WideUint &b) noexcept { return a -= b; }
+
+    // ----------------------------------------------------
+    // Compare
+    // ----------------------------------------------------
+    friend constexpr bool operator==(const WideUint &a, const WideUint &b) noexcept {
+        return a.limbs_ == b.limbs_;
+    }
+
+    friend constexpr std::strong_ordering operator<=>(const WideUint &a, const WideUint &b) noexcept {
+        for (size_t i = LIMBS; i-- > 0;)
+            if (a.limbs_[i] != b.limbs_[i])
+                return a.limbs_[i] <=> b.limbs_[i];
+        return std::strong_ordering::equal;
+    }
+
+    // ----------------------------------------------------
+    // Decimal text, off the hot path
+    // ----------------------------------------------------
+    std::string to_string() const {
+        if (is_zero())
+            return "0";
+        std::string s;
+        auto v = limbs_;
+        bool nonzero = true;
+        while (nonzero) {
+            unsigned __int128 rem = 0;
+            nonzero = false;
+            for (size_t i = LIMBS; i-- > 0;) {
+                unsigned __int128 cur = (rem << 64) | v[i];
+                v[i] = static_cast<uint64_t>(cur / 10);
+                rem = cur % 10;
+                nonzero |= v[i] != 0;
+            }
+            s.insert(s.begin(), static_cast<char>('0' + static_cast<int>(rem)));
+        }
+        return s;
+    }
+
+    friend std::ostream &operator<<(std::ostream &os, const WideUint &v) {
+        return os << v.to_string();
+    }
+
+private:
+    constexpr void trim() noexcept {
+        if constexpr (BITS % 64)
+            limbs_[LIMBS - 1] &= (uint64_t(1) << (BITS % 64)) - 1;
+    }
+
+    std::array<uint64_t, LIMBS> limbs_;
+};
+
+template <size_t BITS>
+using FpgaUint = std::conditional_t<(BITS <= 64), uint64_t,
+                 std::conditional_t<(BITS <= 128), unsigned __int128, WideUint<BITS>>>;
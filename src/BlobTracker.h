@@ -0,0 +1,342 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include <util/CycleClock.h>
+#include <util/LatencyHistogram.h>
+
+#include "TestRun.h"
+#include "EllipseFit.h"
+
+// ------------------------------------------------------------
+// FRAME-TO-FRAME BLOB TRACKER
+// ------------------------------------------------------------
+//
+// BlobTracker associates the features of consecutive frames, as the
+// host pipeline does with the accelerator output. Every feature is
+// reduced to a blob on arrival: bounding box (x_left / x_right, y range
+// by FeatureYRange()) and centroid from the moment sums. add() matches
+// it right away against the tracks of the previous frames:
+//
+// - begin_frame() predicts every live track to the new frame (position
+//   + velocity x frames since it was last seen) and enters it into a
+//   uniform grid of `cell` pixel cells, folded into a power-of-two
+//   bucket table, in every cell its gate square touches. A blob then
+//   only looks at the bucket of its own centroid cell, so matching is
+//   O(1) per blob and linear per frame for bounded gate sizes.
+// - The gate is max_distance, widened to half the larger bbox side of
+//   the track so large blobs still match.
+// - The unclaimed candidate nearest to the centroid wins. It takes the
+//   new centroid and bbox and updates its velocity (pixels per frame,
+//   exponentially smoothed). An unmatched blob starts a new track.
+// - Tracks unmatched for more than max_missed frames end.
+//
+// Matching greedily in arrival order keeps it incremental: blobs come
+// in the order the DUT completes them, so two tracks crossing within
+// one gate may swap ids where a global assignment would not.
+//
+// The tracker's own time per frame (add() and begin_frame()) and the
+// full frame period (begin_frame() to begin_frame(), so CCA, register
+// access and reporting included) go into latency histograms.
+//
+
+inline namespace DUT_NAMESPACE {
+
+class BlobTracker {
+public:
+    struct Options {
+        double cell = 32;               // grid cell side, pixels
+        double max_distance = 24;       // gate half-width, pixels
+        double smoothing = 0.5;         // weight of a new velocity measurement
+        uint32_t max_missed = 2;        // frames a track survives unmatched
+    };
+
+    struct Blob {
+        double pixels;
+        double cx, cy;
+        int32_t x_left, x_right;
+        int32_t y_top, y_bottom;
+    };
+
+    struct Track {
+        uint64_t id;
+        Blob blob;
+        double vx, vy;                  // pixels per frame
+        size_t first_frame;
+        size_t last_frame;
+        uint64_t hits;                  // frames matched, including the first
+        // Set by begin_frame()
+        double px, py;                  // predicted centroid
+        double gate;
+        bool claimed;
+    };
+
+    BlobTracker() = default;
+    explicit BlobTracker(const Options &options) : options_(options) {}
+
+    // Ends the current frame and opens frame_idx.
+    void begin_frame(size_t frame_idx) {
+        const uint64_t t0 = CycleClock::now();
+        end_frame(t0);
+
+        frame_idx_ = frame_idx;
+        frame_open_ = true;
+        t_frame_ = t0;
+
+        // Drop tracks missed too long, predict the rest.
+        std::erase_if(tracks_, [&](const Track &t) {
+            const bool ended = frame_idx - t.last_frame > size_t(options_.max_missed) + 1;
+            ended_ += ended;
+            return ended;
+        });
+        for (Track &t : tracks_) {
+            const double frames = double(frame_idx - t.last_frame);
+            t.px = t.blob.cx + t.vx * frames;
+            t.py = t.blob.cy + t.vy * frames;
+            t.gate = std::max(options_.max_distance,
+                              0.5 * std::max(t.blob.x_right - t.blob.x_left, t.blob.y_bottom - t.blob.y_top));
+            t.claimed = false;
+        }
+        build_grid();
+
+        frame_ticks_ = CycleClock::now() - t0;
+    }
+
+    // Matches the blob of one feature; the track stays valid until the
+    // next add() or begin_frame().
+    const Track &add(const Feature_t &f) {
+        if (!frame_open_)
+            begin_frame(0);
+        const uint64_t t0 = CycleClock::now();
+
+        const Blob blob = make_blob(f);
+        blobs_++;
+
+        Track *best = nullptr;
+        if (!grid_entries_.empty()) {
+            double best_d2 = 0;
+            const size_t h = bucket(cell_of(blob.cx), cell_of(blob.cy));
+            for (uint32_t e = grid_start_[h]; e < grid_start_[h + 1]; e++) {
+                const GridEntry &g = grid_entries_[e];
+                const double dx = blob.cx - g.px, dy = blob.cy - g.py;
+                const double d2 = dx * dx + dy * dy;
+                if (d2 > g.gate2 || (best && d2 >= best_d2))
+                    continue;
+                Track &t = tracks_[g.track];
+                if (!t.claimed) {
+                    best = &t;
+                    best_d2 = d2;
+                }
+            }
+        }
+
+        if (best) {
+            const double frames = double(frame_idx_ - best->last_frame);
+            const double vx = (blob.cx - best->blob.cx) / frames;
+            const double vy = (blob.cy - best->blob.cy) / frames;
+            const double s = best->hits == 1 ? 1.0 : options_.smoothing;
+            best->vx = s * vx + (1 - s) * best->vx;
+            best->vy = s * vy + (1 - s) * best->vy;
+            best->blob = blob;
+            best->last_frame = frame_idx_;
+            best->hits++;
+            best->claimed = true;
+            matched_++;
+        } else {
+            // Not in the grid, so later blobs of this frame cannot claim it.
+            tracks_.push_back(Track{next_id_++, blob, 0, 0, frame_idx_, frame_idx_, 1,
+                                    blob.cx, blob.cy, 0, true});
+            best = &tracks_.back();
+            started_++;
+        }
+
+        frame_ticks_ += CycleClock::now() - t0;
+        return *best;
+    }
+
+    // Ends the last frame.
+    void finish() {
+        end_frame(CycleClock::now());
+    }
+
+    const std::vector<Track> &tracks() const noexcept { return tracks_; }
+    uint64_t blobs() const noexcept { return blobs_; }
+    uint64_t matched() const noexcept { return matched_; }
+
+    void report(std::ostream &os) const {
+        const auto flags = os.flags();
+        const auto precision = os.precision();
+        os << std::fixed << std::setprecision(1);
+        os << "Tracker: " << frames_ << " frames, " << blobs_ << " blobs, "
+           << (blobs_ ? 100.0 * double(matched_) / double(blobs_) : 0.0) << "% matched, " << started_
+           << " tracks started, " << ended_ << " ended, " << tracks_.size() << " live\n";
+        os << "Tracker [us per frame]:\n";
+        os << std::left << std::setw(8) << "op" << std::right << std::setw(12) << "count"
+           << std::setw(10) << "p50" << std::setw(10) << "p99" << std::setw(10) << "p99.9"
+           << std::setw(12) << "max" << "\n";
+        for (const auto &[name, h] : {std::pair{"track", &track_hist_}, std::pair{"frame", &frame_hist_}}) {
+            os << std::left << std::setw(8) << name << std::right
+               << std::setw(12) << h->count()
+               << std::setw(10) << CycleClock::to_ns(h->percentile(0.50)) / 1e3
+               << std::setw(10) << CycleClock::to_ns(h->percentile(0.99)) / 1e3
+               << std::setw(10) << CycleClock::to_ns(h->percentile(0.999)) / 1e3
+               << std::setw(12) << CycleClock::to_ns(h->max()) / 1e3 << "\n";
+        }
+        if (blobs_)
+            os << "Tracker: " << CycleClock::to_ns(track_ticks_) / double(blobs_) << " ns per blob\n";
+        os.flags(flags);
+        os.precision(precision);
+    }
+
+private:
+    static Blob make_blob(const Feature_t &f) noexcept {
+        constexpr double y_low_size = llcca_consts::Y_LOW_SIZE;
+
+        int64_t y_top, y_bottom;
+        const bool wrap = FeatureYRange(f, y_top, y_bottom);
+        const double n0 = FeatureSum(f.n_seg0_sum);
+        const double n1 = FeatureSum(f.n_seg1_sum);
+        const double n = n0 + n1;
+        const double inv = 1.0 / std::max(n, 1.0);
+        const double sx = FeatureSum(f.x_seg0_sum) + FeatureSum(f.x_seg1_sum);
+        const double sy = FeatureSum(f.ylow_seg0_sum) + FeatureSum(f.ylow_seg1_sum)
+                        + (wrap ? -y_low_size : y_low_size) * n1;
+        return Blob{n, sx * inv, sy * inv, int32_t(f.x_left), int32_t(f.x_right),
+                    int32_t(y_top), int32_t(y_bottom)};
+    }
+
+    // Gate test data of a track, stored in the grid so that scanning a
+    // bucket does not touch the tracks.
+    struct GridEntry {
+        double px, py;
+        double gate2;
+        uint32_t track;
+    };
+
+    int64_t cell_of(double v) const noexcept {
+        return int64_t(std::floor(v / options_.cell));
+    }
+
+    // Cells are laid out row by row (x from -1 to X_SIZE / cell), rows
+    // wrap around the table: blobs arrive in scan order, so consecutive
+    // lookups stay in nearby buckets.
+    size_t bucket(int64_t cx, int64_t cy) const noexcept {
+        return ((uint64_t(cy) << row_bits_) + uint64_t(cx + 1)) & grid_mask_;
+    }
+
+    // Calls fn(bucket) for every cell the gate square of t touches.
+    template<typename fn_t>
+    void for_each_cell(const Track &t, fn_t &&fn) const {
+        const int64_t x0 = cell_of(t.px - t.gate), x1 = cell_of(t.px + t.gate);
+        const int64_t y0 = cell_of(t.py - t.gate), y1 = cell_of(t.py + t.gate);
+        for (int64_t y = y0; y <= y1; y++)
+            for (int64_t x = x0; x <= x1; x++)
+                fn(bucket(x, y));
+    }
+
+    // Counting sort of (track, cell) pairs into the bucket table.
+    void build_grid() {
+        grid_entries_.clear();
+        if (tracks_.empty())
+            return;
+
+        size_t entries = 0;
+        for (const Track &t : tracks_) {
+            const double cells = std::floor(2 * t.gate / options_.cell) + 2;
+            entries += size_t(cells * cells);
+        }
+        row_bits_ = std::bit_width(size_t(double(llcca_gens.X_SIZE) / options_.cell) + 2);
+        grid_mask_ = std::bit_ceil(std::max<size_t>(size_t(1) << row_bits_, entries)) - 1;
+        grid_start_.assign(grid_mask_ + 2, 0);
+
+        for (const Track &t : tracks_)
+            for_each_cell(t, [&](size_t h) { grid_start_[h + 1]++; });
+        for (size_t h = 1; h < grid_start_.size(); h++)
+            grid_start_[h] += grid_start_[h - 1];
+        grid_entries_.resize(grid_start_.back());
+        grid_fill_.assign(grid_start_.begin(), grid_start_.end() - 1);
+        for (uint32_t i = 0; i < tracks_.size(); i++) {
+            const Track &t = tracks_[i];
+            const GridEntry entry{t.px, t.py, t.gate * t.gate, i};
+            for_each_cell(t, [&](size_t h) { grid_entries_[grid_fill_[h]++] = entry; });
+        }
+    }
+
+    void end_frame(uint64_t t) {
+        if (!frame_open_)
+            return;
+        track_hist_.add(frame_ticks_);
+        track_ticks_ += frame_ticks_;
+        frame_hist_.add(t - t_frame_);
+        frames_++;
+        frame_open_ = false;
+    }
+
+    Options options_;
+    std::vector<Track> tracks_;
+    uint64_t next_id_ = 0;
+
+    // Grid of the current frame: the entries of bucket h are
+    // grid_entries_[grid_start_[h] .. grid_start_[h + 1]).
+    size_t row_bits_ = 0;
+    size_t grid_mask_ = 0;
+    std::vector<uint32_t> grid_start_;
+    std::vector<uint32_t> grid_fill_;
+    std::vector<GridEntry> grid_entries_;
+
+    size_t frame_idx_ = 0;
+    bool frame_open_ = false;
+    uint64_t t_frame_ = 0;
+    uint64_t frame_ticks_ = 0;
+
+    uint64_t frames_ = 0;
+    uint64_t blobs_ = 0;
+    uint64_t matched_ = 0;
+    uint64_t started_ = 0;
+    uint64_t ended_ = 0;
+    uint64_t track_ticks_ = 0;
+    LatencyHistogram track_hist_;
+    LatencyHistogram frame_hist_;
+};
+
+inline void PrintTrack(const BlobTracker::Track &track) {
+    std::cout << "TRACK:";
+    std::cout << "\n  id = " << track.id << "\n  hits = " << track.hits;
+    std::cout << "\n  cx = " << track.blob.cx << "\n  cy = " << track.blob.cy;
+    std::cout << "\n  vx = " << track.vx << "\n  vy = " << track.vy;
+
+    std::cout << "\n\n";
+}
+
+// TestRun report printing each feature followed by its track; tracker
+// statistics go to stderr at the end of the run.
+struct TrackReport {
+    BlobTracker tracker;
+
+    void frame(size_t frame_idx) {
+        tracker.begin_frame(frame_idx);
+#ifdef DEBUG_PRINT
+        std::cout << "Frame " << frame_idx << ":\n";
+#endif
+    }
+    void feature(uint64_t clk_cnt, const Feature_t &feature) {
+        const BlobTracker::Track &track = tracker.add(feature);
+        PrintFeature(clk_cnt, feature);
+        PrintTrack(track);
+    }
+    void speed(uint64_t clk_cnt, std::chrono::steady_clock::time_point t0) {
+        tracker.finish();
+        PrintSpeed(clk_cnt, t0);
+        tracker.report(std::cerr);
+    }
+};
+
+} // namespace DUT_NAMESPACE
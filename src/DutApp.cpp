@@ -0,0 +1,395 @@
+#include <memory>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#define DEBUG_PRINT
+
+#include <emulator/shadow.h>
+#include <emulator/fields_linkruncca.h>
+#include <emulator/hw_access_model.h>
+#include <emulator/hw_access_lockstep.h>
+#include <emulator/hw_access_timed.h>
+#include <emulator/hw_access_log.h>
+#include <emulator/bit_slicer.h>
+#include <emulator/fields.h>
+#include <emulator/emulator_fields.h>
+
+#include "DutApp.h"
+#include "TestRun.h"
+#include "MultiRun.h"
+#include "EllipseFit.h"
+#include "BlobTracker.h"
+#include "FeatureFile.h"
+#include "ResultCrc.h"
+#include "RemoteServer.h"
+#include "RemoteClient.h"
+
+// ------------------------------------------------------------
+// fpga_app FOR ONE DUT GEOMETRY
+// ------------------------------------------------------------
+//
+// Built once per entry of FPGA_DUT_CONFIGS with DUT_X_SIZE / DUT_Y_BITS
+// set (see DutApp.h). Everything here is local to the translation
+// unit, except the DutConfig registered at static initialization.
+//
+
+namespace {
+
+using LockstepBackendType = hw_access_lockstep<BackendType, app_fields_t>;
+
+using emulator_t = emulator_fields<BackendType, app_fields_t>;
+
+// Inputs of the REPLAY, IMAGES and SCENES run modes, and the report to use.
+struct RunSources {
+    const StimulusFile *replay = nullptr;
+    ImageSequence *images = nullptr;
+    StressScenes *scenes = nullptr;
+    bool ellipses = false;              // report fitted ellipses (-e)
+    bool tracks = false;                // report blob tracks (-k)
+    FeatureWriter *features = nullptr;  // write features to a feature file (-o)
+    std::string crc_fname;              // write per-frame result CRCs (-c), empty: none
+    const ResultCrcFile *verify = nullptr;  // reference of a verification run (-v)
+};
+
+template<typename iface_t>
+bool Run(iface_t &iface, RunMode run_mode, const RunSources &sources);
+
+// Run with the per-cycle trace recorder attached, then save the trace.
+template<typename iface_t>
+bool Run(iface_t &iface, RunMode run_mode, const RunSources &sources, const TraceOptions &trace_opts) {
+    if (trace_opts.fname.empty())
+        return Run(iface, run_mode, sources);
+
+    using trace_t = typename iface_t::trace_t;
+    using fields_t = typename trace_t::fields_t;
+
+    if (run_mode == RunMode::BATCH) {
+        std::cerr << "Error: batch mode cannot be traced.\n";
+        return false;
+    }
+
+    typename trace_t::config_t config;
+    config.begin = trace_opts.begin;
+    config.end = trace_opts.end;
+    if (!trace_opts.trigger.empty()) {
+        size_t f = 0;
+        while (f < fields_t::num_rd_fields && trace_opts.trigger != fields_t::rd_name(f))
+            f++;
+        if (f == fields_t::num_rd_fields) {
+            std::cerr << "Error: unknown trigger field: " << trace_opts.trigger << "\n";
+            return false;
+        }
+        config.trigger = true;
+        config.trigger_field = static_cast<typename trace_t::rd_fields>(f);
+        config.post_trigger = trace_opts.post_trigger;
+    }
+
+    trace_t trace(trace_opts.capacity, config);
+    iface.trace_attach(trace);
+    const bool ok = Run(iface, run_mode, sources);
+    iface.trace_detach();
+
+    trace.save(trace_opts.fname);
+    std::cerr << "Trace: " << trace.size() << " of " << trace.cycles() << " cycles written to " << trace_opts.fname;
+    if (trace.trigger_cycle() != trace_t::NO_CYCLE)
+        std::cerr << ", trigger at cycle " << trace.trigger_cycle();
+    std::cerr << "\n";
+    return ok;
+}
+
+// Serial, replay, image or scene run with a report other than
+// PrintReport; option names the option that asked for it.
+template<typename iface_t, typename report_t>
+bool RunReport(iface_t &iface, RunMode run_mode, const RunSources &sources, const char *option, report_t &&report) {
+    switch (run_mode) {
+    case RunMode::REPLAY:
+        TestRunReplay(iface, *sources.replay, std::forward<report_t>(report));
+        return true;
+    case RunMode::IMAGES:
+        TestRunImages(iface, *sources.images, ~uint64_t(0), std::forward<report_t>(report));
+        return true;
+    case RunMode::SCENES:
+        TestRunScenes(iface, *sources.scenes, ~uint64_t(0), std::forward<report_t>(report));
+        return true;
+    case RunMode::SERIAL:
+        TestRun(iface, 50000000, std::forward<report_t>(report));
+        return true;
+    default:
+        std::cerr << "Error: " << option << " needs a serial, replay, image or scene run.\n";
+        return false;
+    }
+}
+
+template<typename iface_t>
+bool Run(iface_t &iface, RunMode run_mode, const RunSources &sources) {
+    if (sources.verify) {
+        if constexpr (iface_t::batch_supported) {
+            CrcCheckReport check(iface, *sources.verify);
+            return RunReport(iface, run_mode, sources, "-v", check) && check.ok();
+        } else {
+            std::cerr << "Error: -v needs a backend with 64-bit words.\n";
+            return false;
+        }
+    }
+    if (!sources.crc_fname.empty()) {
+        ResultCrcFile crcs;
+        if (!RunReport(iface, run_mode, sources, "-c", CrcReport{crcs}))
+            return false;
+        try {
+            crcs.save(sources.crc_fname);
+        } catch (const std::exception &e) {
+            std::cerr << "Error: " << e.what() << "\n";
+            return false;
+        }
+        std::cerr << "Wrote result CRCs of " << crcs.frames.size() << " frames to " << sources.crc_fname << "\n";
+        return true;
+    }
+    if (sources.features) {
+        if (!RunReport(iface, run_mode, sources, "-o", FeatureReport{*sources.features}))
+            return false;
+        sources.features->close();
+        std::cerr << "Wrote " << sources.features->records() << " features\n";
+        return true;
+    }
+    if (sources.ellipses)
+        return RunReport(iface, run_mode, sources, "-e", EllipseReport{});
+    if (sources.tracks)
+        return RunReport(iface, run_mode, sources, "-k", TrackReport{});
+
+    switch (run_mode) {
+    case RunMode::REPLAY:
+        TestRunReplay(iface, *sources.replay);
+        break;
+    case RunMode::IMAGES:
+        TestRunImages(iface, *sources.images);
+        break;
+    case RunMode::SCENES:
+        TestRunScenes(iface, *sources.scenes);
+        break;
+    case RunMode::PIPELINED:
+        TestRunPipelined(iface);
+        break;
+    case RunMode::BATCH:
+        if constexpr (iface_t::batch_supported) {
+            try {
+                TestRunBatch(iface);
+            } catch (const std::exception &e) {
+                std::cerr << "Error: " << e.what() << "\n";
+                return false;
+            }
+        } else {
+            std::cerr << "Error: batch mode needs a backend with 64-bit words.\n";
+            return false;
+        }
+        break;
+    default:
+        TestRun(iface);
+        break;
+    }
+    return true;
+}
+
+// Run with every backend access timed, then print the latency
+// histograms and the fabric clock count.
+template<typename hw_t>
+bool RunTimed(hw_t &hw, RunMode run_mode, const RunSources &sources, const TraceOptions &trace_opts) {
+    using timed_t = hw_access_timed<hw_t>;
+    timed_t timed(hw);
+    emulator_fields<timed_t, app_fields_t> emulator(timed);
+
+    const bool ok = Run(emulator, run_mode, sources, trace_opts);
+    timed.report(std::cerr);
+    return ok;
+}
+
+// Run with every backend access appended to an MMIO transaction log.
+template<typename hw_t>
+bool RunLogged(hw_t &hw, const std::string &fname, RunMode run_mode, const RunSources &sources,
+               const TraceOptions &trace_opts) {
+    using log_t = hw_access_log<hw_t>;
+    log_t log(hw, fname);
+    emulator_fields<log_t, app_fields_t> emulator(log);
+
+    const bool ok = Run(emulator, run_mode, sources, trace_opts);
+    log.close();
+    std::cerr << "MMIO log: " << log.records() << " accesses, " << log.bytes() << " bytes written to " << fname << "\n";
+    return ok;
+}
+
+// TestRun against the server at address, with the report of -e / -o.
+int RunRemoteClient(const std::string &address, const RunSources &sources) {
+    try {
+        if (sources.features) {
+            TestRunRemote(address, 50000000, FeatureReport{*sources.features});
+            sources.features->close();
+            std::cerr << "Wrote " << sources.features->records() << " features\n";
+        } else if (sources.ellipses) {
+            TestRunRemote(address, 50000000, EllipseReport{});
+        } else if (sources.tracks) {
+            TestRunRemote(address, 50000000, TrackReport{});
+        } else {
+            TestRunRemote(address);
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
+
+int RunApp(const AppOptions &options) {
+    // -------------------------------------
+    // Stimulus recording, no device needed
+    // -------------------------------------
+    if (!options.save_fname.empty()) {
+        StimulusWriter writer(options.save_fname, llcca_gens.X_SIZE, llcca_gens.Y_BITS);
+        const uint64_t clk_cnt = RecordTestRun(writer);
+        std::cerr << "Saved " << clk_cnt << " pixel clocks (" << writer.clocks()
+                  << " clocks) to " << options.save_fname << "\n";
+        return 0;
+    }
+
+    std::unique_ptr<StimulusFile> replay;
+    std::unique_ptr<ImageSequence> images;
+    std::unique_ptr<StressScenes> scenes;
+    if (options.run_mode == RunMode::REPLAY) {
+        try {
+            replay = std::make_unique<StimulusFile>(options.replay_fname);
+        } catch (const std::exception &e) {
+            std::cerr << "Error: " << e.what() << "\n";
+            return 1;
+        }
+        const StimulusFileHeader &h = replay->header();
+        if (h.x_size != llcca_gens.X_SIZE || h.y_bits != llcca_gens.Y_BITS) {
+            std::cerr << "Error: " << options.replay_fname << " is recorded for geometry " << h.x_size << "x"
+                      << h.y_bits << ", the DUT is " << llcca_gens.X_SIZE << "x" << llcca_gens.Y_BITS << ".\n";
+            return 1;
+        }
+    }
+    if (options.run_mode == RunMode::IMAGES)
+        images = std::make_unique<ImageSequence>(options.image_fnames, options.image_opts,
+                                                 llcca_gens.X_SIZE, (size_t)1 << llcca_gens.Y_BITS);
+    if (options.run_mode == RunMode::SCENES)
+        scenes = std::make_unique<StressScenes>(options.scene_opts, llcca_gens.X_SIZE, (size_t)1 << llcca_gens.Y_BITS);
+    std::unique_ptr<FeatureWriter> features;
+    if (!options.features_fname.empty())
+        features = std::make_unique<FeatureWriter>(options.features_fname);
+    ResultCrcFile verify;
+    if (!options.verify_fname.empty()) {
+        try {
+            verify = ResultCrcFile::load(options.verify_fname);
+        } catch (const std::exception &e) {
+            std::cerr << "Error: " << e.what() << "\n";
+            return 1;
+        }
+    }
+    const RunSources sources{replay.get(), images.get(), scenes.get(), options.ellipses, options.tracks, features.get(),
+                             options.crc_fname, options.verify_fname.empty() ? nullptr : &verify};
+
+    // -------------------------------------
+    // Client of a remote server, no device
+    // -------------------------------------
+    if (!options.remote_address.empty())
+        return RunRemoteClient(options.remote_address, sources);
+
+    // -------------------------------------
+    // Several instances, one thread each
+    // -------------------------------------
+    const size_t num_instances = options.mode == "model" ? options.instances : options.device_paths.size();
+    if (num_instances > 1) {
+        if (options.run_mode != RunMode::SERIAL || !options.trace_opts.fname.empty() || options.ellipses || features
+            || options.tracks || !options.crc_fname.empty() || !options.verify_fname.empty() || options.latency
+            || !options.mmio_log_fname.empty() || options.mode == "lockstep") {
+            std::cerr << "Error: several instances only run in serial hw or model mode, without trace, -e, -o, -k, -c, -v, -l or -x.\n";
+            return 1;
+        }
+        if (options.mode == "model") {
+            std::vector<std::unique_ptr<ModelBackendType>> hws;
+            std::vector<std::unique_ptr<emulator_fields<ModelBackendType, app_fields_t>>> emulators;
+            std::vector<emulator_fields<ModelBackendType, app_fields_t> *> ifaces;
+            for (size_t n = 0; n < num_instances; n++) {
+                hws.push_back(std::make_unique<ModelBackendType>());
+                emulators.push_back(std::make_unique<emulator_fields<ModelBackendType, app_fields_t>>(*hws.back()));
+                ifaces.push_back(emulators.back().get());
+            }
+            TestRunMulti(ifaces);
+            return 0;
+        }
+        std::vector<std::unique_ptr<BackendType>> hws;
+        std::vector<std::unique_ptr<emulator_t>> emulators;
+        std::vector<emulator_t *> ifaces;
+        for (const auto &path : options.device_paths) {
+            hws.push_back(std::make_unique<BackendType>(path.c_str()));
+            emulators.push_back(std::make_unique<emulator_t>(*hws.back()));
+            ifaces.push_back(emulators.back().get());
+        }
+        TestRunMulti(ifaces);
+        return 0;
+    }
+
+    // -------------------------------------
+    // C++ model backend, no device needed
+    // -------------------------------------
+    if (options.mode == "model") {
+        ModelBackendType hw;
+        if (options.latency)
+            return RunTimed(hw, options.run_mode, sources, options.trace_opts) ? 0 : 1;
+        if (!options.mmio_log_fname.empty())
+            return RunLogged(hw, options.mmio_log_fname, options.run_mode, sources, options.trace_opts) ? 0 : 1;
+        emulator_fields<ModelBackendType, app_fields_t> emulator(hw);
+        if (!options.serve_address.empty())
+            ServeRemote(emulator, options.serve_address, batch_regs::geometry_id(llcca_gens.X_SIZE, llcca_gens.Y_BITS));
+
+        if (!Run(emulator, options.run_mode, sources, options.trace_opts))
+            return 1;
+        emulator.report_stats(std::cerr);
+        return 0;
+    }
+
+    // -------------------------------------
+    // Start hardware emulator backend
+    // -------------------------------------
+    BackendType hw(options.device_paths.front().c_str());
+
+    if (options.mode == "lockstep") {
+        LockstepBackendType lockstep(hw);
+        emulator_fields<LockstepBackendType, app_fields_t> emulator(lockstep);
+
+        if (!Run(emulator, options.run_mode, sources, options.trace_opts))
+            return 1;
+        emulator.report_stats(std::cerr);
+        lockstep.report(std::cerr);
+        return lockstep.mismatch() ? 2 : 0;
+    }
+
+    if (options.latency)
+        return RunTimed(hw, options.run_mode, sources, options.trace_opts) ? 0 : 1;
+    if (!options.mmio_log_fname.empty())
+        return RunLogged(hw, options.mmio_log_fname, options.run_mode, sources, options.trace_opts) ? 0 : 1;
+
+    emulator_t emulator(hw);
+    if (!options.serve_address.empty())
+        ServeRemote(emulator, options.serve_address, batch_regs::geometry_id(llcca_gens.X_SIZE, llcca_gens.Y_BITS));
+
+    if (!Run(emulator, options.run_mode, sources, options.trace_opts))
+        return 1;
+    emulator.report_stats(std::cerr);
+    return 0;
+}
+
+class Config final : public DutConfig {
+public:
+    size_t x_size() const noexcept override { return llcca_gens.X_SIZE; }
+    size_t y_bits() const noexcept override { return llcca_gens.Y_BITS; }
+
+    int run(const AppOptions &options) const override {
+        return RunApp(options);
+    }
+};
+
+const Config config;
+const bool registered = (DutRegistry::add(config), true);
+
+} // namespace
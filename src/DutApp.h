@@ -0,0 +1,129 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <emulator/batch_regs.h>
+#include <emulator/hw_access_aarch64.h>
+#include <emulator/hw_access_debug.h>
+
+#include "ImageSequence.h"
+#include "StressScene.h"
+
+// ------------------------------------------------------------
+// DUT CONFIGURATIONS BUILT INTO fpga_app
+// ------------------------------------------------------------
+//
+// src/DutApp.cpp is compiled once per geometry of FPGA_DUT_CONFIGS
+// (CMake cache variable, "<X_SIZE>x<Y_BITS>;..."). Each build registers
+// a DutConfig, whose run() holds the complete app (backends,
+// emulator_fields, run loops) for that geometry. main() parses the
+// command line and calls run() of the selected configuration once:
+// that call is the only virtual boundary, everything below it is
+// instantiated with constexpr field descriptors.
+//
+
+// MMIO ordering policy of the device backend, set by the CMake cache
+// variable FPGA_MMIO_ORDER.
+#ifndef FPGA_MMIO_ORDER
+#define FPGA_MMIO_ORDER strict
+#endif
+
+#if defined(__aarch64__)
+using BackendType = hw_access_aarch64_t<uint64_t, 2, mmio_order::FPGA_MMIO_ORDER>;
+#else
+using BackendType = hw_access_debug;
+#endif
+
+enum class RunMode {
+    SERIAL,
+    PIPELINED,
+    BATCH,
+    REPLAY,
+    IMAGES,
+    SCENES,
+};
+
+struct TraceOptions {
+    std::string fname;                  // empty: no trace
+    size_t capacity = size_t(1) << 20;  // records kept in the ring
+    uint64_t begin = 0;
+    uint64_t end = ~uint64_t(0);
+    std::string trigger;                // rd field name, empty: no trigger
+    uint64_t post_trigger = 0;
+};
+
+// Parsed command line of fpga_app.
+struct AppOptions {
+    std::vector<std::string> device_paths;
+    size_t instances = 1;
+    std::string mode = "hw";
+    RunMode run_mode = RunMode::SERIAL;
+    TraceOptions trace_opts;
+    std::string save_fname;
+    std::string replay_fname;
+    std::vector<std::string> image_fnames;
+    ImageSequence::Options image_opts;
+    StressScenes::Options scene_opts;   // procedural stress scenes (-P)
+    bool ellipses = false;
+    std::string features_fname;
+    bool tracks = false;                // blob tracker report (-k)
+    std::string crc_fname;              // write per-frame result CRCs (-c)
+    std::string verify_fname;           // check result CRCs, no per-cycle reads (-v)
+    bool latency = false;               // latency histograms of the backend (-l)
+    std::string mmio_log_fname;         // MMIO transaction log (-x), empty: none
+    std::string serve_address;          // serve the emulator on a socket (-S)
+    std::string remote_address;         // run on a remote server (-C)
+};
+
+class DutConfig {
+public:
+    virtual ~DutConfig() = default;
+
+    virtual size_t x_size() const noexcept = 0;
+    virtual size_t y_bits() const noexcept = 0;
+
+    // Runs fpga_app for this geometry; returns the exit status.
+    virtual int run(const AppOptions &options) const = 0;
+
+    uint32_t geometry_id() const noexcept {
+        return batch_regs::geometry_id(x_size(), y_bits());
+    }
+
+    std::string name() const {
+        return std::to_string(x_size()) + "x" + std::to_string(y_bits());
+    }
+};
+
+class DutRegistry {
+public:
+    static void add(const DutConfig &config) {
+        configs().push_back(&config);
+    }
+
+    // Configuration of a geometry, nullptr if not built in.
+    static const DutConfig *find(size_t x_size, size_t y_bits) noexcept {
+        for (const DutConfig *config : configs())
+            if (config->x_size() == x_size && config->y_bits() == y_bits)
+                return config;
+        return nullptr;
+    }
+
+    static const DutConfig *find(uint32_t geometry_id) noexcept {
+        if (!batch_regs::geometry_valid(geometry_id))
+            return nullptr;
+        return find(batch_regs::geometry_x_size(geometry_id), batch_regs::geometry_y_bits(geometry_id));
+    }
+
+    static const std::vector<const DutConfig *> &all() noexcept {
+        return configs();
+    }
+
+private:
+    static std::vector<const DutConfig *> &configs() noexcept {
+        static std::vector<const DutConfig *> list;
+        return list;
+    }
+};
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <emulator/fields_linkruncca.h>
+
+// ------------------------------------------------------------
+// DUT GEOMETRY OF A TRANSLATION UNIT
+// ------------------------------------------------------------
+//
+// The app headers (TestRun.h and everything built on Feature_t) are
+// compiled for one X_SIZE / Y_BITS, given by DUT_X_SIZE and DUT_Y_BITS
+// (default 1024 x 16). fpga_app compiles src/DutApp.cpp once per entry
+// of FPGA_DUT_CONFIGS, so each geometry keeps constexpr field
+// descriptors. The app code lives in the inline namespace
+// DUT_NAMESPACE (dut_<x_size>_<y_bits>): unqualified names work as
+// before, and instances for different geometries link side by side.
+//
+
+#ifndef DUT_X_SIZE
+#define DUT_X_SIZE 1024
+#endif
+
+#ifndef DUT_Y_BITS
+#define DUT_Y_BITS 16
+#endif
+
+#define DUT_NAMESPACE_CAT(x_size, y_bits) dut_##x_size##_##y_bits
+#define DUT_NAMESPACE_NAME(x_size, y_bits) DUT_NAMESPACE_CAT(x_size, y_bits)
+#define DUT_NAMESPACE DUT_NAMESPACE_NAME(DUT_X_SIZE, DUT_Y_BITS)
+
+inline namespace DUT_NAMESPACE {
+
+constexpr FpgaGenerics_linkruncca llcca_gens{
+    .X_SIZE=DUT_X_SIZE,
+    .Y_BITS=DUT_Y_BITS,
+};
+
+} // namespace DUT_NAMESPACE
@@ -0,0 +1,312 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+#include <iostream>
+#include <numbers>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "TestRun.h"
+
+// ------------------------------------------------------------
+// ELLIPSE FIT OF FEATURE MOMENTS, IN BATCHES
+// ------------------------------------------------------------
+//
+// EllipseBatch resolves features the way resolve_ellipse() does in
+// vhdl_linkruncca_pkg_ellipses_linescan.vhdl: centroid, central
+// moments u20/u02/u11, axis lengths 2*sqrt(eigenvalue) and orientation
+// in degrees.
+//
+// add() merges the seg0/seg1 halves of one feature on the way in: the
+// sums are converted to double once, the y range is resolved by
+// FeatureYRange() as in feature2bbox(), and seg1 rows get a y offset
+// of +Y_LOW_SIZE, or -Y_LOW_SIZE when the object wraps from segment 1
+// over to segment 0.
+// Everything is stored as structure-of-arrays, so fit() runs over
+// whole columns two records at a time (NEON on aarch64, SSE2 on x86,
+// plain loop elsewhere). Only the final atan2 is scalar.
+//
+// Features without pixels resolve to all zeros.
+//
+
+inline namespace DUT_NAMESPACE {
+
+// A moment sum of Feature_t (FpgaUint or plain integer) as double.
+template<typename T>
+double FeatureSum(const T &v) noexcept {
+    if constexpr (requires { v.to_double(); })
+        return v.to_double();
+    else
+        return static_cast<double>(v);
+}
+
+// Merged y range of a feature as in feature2bbox(). True if the object
+// wraps from segment 1 over to segment 0 (its seg1 rows lie above the
+// seg0 rows, at ylow - Y_LOW_SIZE).
+inline bool FeatureYRange(const Feature_t &f, int64_t &y_top, int64_t &y_bottom) noexcept {
+    constexpr int64_t y_low_size = llcca_consts::Y_LOW_SIZE;
+    constexpr size_t y_low_max = llcca_consts::Y_LOW_MAX;
+
+    const bool seg0 = f.n_seg0_sum != 0;
+    const bool seg1 = f.n_seg1_sum != 0;
+
+    if (!seg1) {
+        y_top = f.y_top_seg_0;
+        y_bottom = f.y_bottom_seg_0;
+    } else if (!seg0) {
+        y_top = f.y_top_seg_1 + y_low_size;
+        y_bottom = f.y_bottom_seg_1 + y_low_size;
+    } else if (f.y_top_seg_0 != 0) {
+        y_top = f.y_top_seg_0;
+        y_bottom = f.y_bottom_seg_1 + y_low_size;
+    } else if (f.y_top_seg_1 != 0 || (f.y_bottom_seg_1 == y_low_max && f.y_bottom_seg_0 != y_low_max)) {
+        y_top = int64_t(f.y_top_seg_1) - y_low_size;
+        y_bottom = f.y_bottom_seg_0;
+        return true;
+    } else {
+        y_top = 0;
+        y_bottom = f.y_bottom_seg_1 + y_low_size;
+    }
+    return false;
+}
+
+class EllipseBatch {
+public:
+    explicit EllipseBatch(size_t capacity = 1024) {
+        for (auto *column : {&n_, &n1_, &sx_, &sx1_, &sxx_, &sy_, &sy1_, &syy_, &sxy_, &off_,
+                             &cx_, &cy_, &u20_, &u02_, &u11_, &major_, &minor_, &theta_})
+            column->reserve(capacity);
+        y_top_.reserve(capacity);
+        y_bottom_.reserve(capacity);
+    }
+
+    size_t size() const noexcept { return n_.size(); }
+    bool empty() const noexcept { return n_.empty(); }
+
+    void clear() noexcept {
+        for (auto *column : {&n_, &n1_, &sx_, &sx1_, &sxx_, &sy_, &sy1_, &syy_, &sxy_, &off_,
+                             &cx_, &cy_, &u20_, &u02_, &u11_, &major_, &minor_, &theta_})
+            column->clear();
+        y_top_.clear();
+        y_bottom_.clear();
+    }
+
+    // Appends one feature; its results are valid after the next fit().
+    void add(const Feature_t &f) {
+        constexpr int64_t y_low_size = llcca_consts::Y_LOW_SIZE;
+
+        int64_t y_top, y_bottom;
+        const bool wrap = FeatureYRange(f, y_top, y_bottom);
+
+        n_.push_back(FeatureSum(f.n_seg0_sum) + FeatureSum(f.n_seg1_sum));
+        n1_.push_back(FeatureSum(f.n_seg1_sum));
+        sx_.push_back(FeatureSum(f.x_seg0_sum) + FeatureSum(f.x_seg1_sum));
+        sx1_.push_back(FeatureSum(f.x_seg1_sum));
+        sxx_.push_back(FeatureSum(f.x2_sum));
+        sy_.push_back(FeatureSum(f.ylow_seg0_sum) + FeatureSum(f.ylow_seg1_sum));
+        sy1_.push_back(FeatureSum(f.ylow_seg1_sum));
+        syy_.push_back(FeatureSum(f.ylow2_sum));
+        sxy_.push_back(FeatureSum(f.xylow_sum));
+        off_.push_back(wrap ? -double(y_low_size) : double(y_low_size));
+        y_top_.push_back(static_cast<int32_t>(y_top));
+        y_bottom_.push_back(static_cast<int32_t>(y_bottom));
+    }
+
+    // Resolves all records added so far.
+    void fit() {
+        resize_results();
+        size_t i = 0;
+#if defined(__aarch64__) || defined(__SSE2__)
+        for (; i + 2 <= size(); i += 2)
+            fit_lanes<Vec2>(i);
+#endif
+        for (; i < size(); i++)
+            fit_lanes<double>(i);
+        fit_theta();
+    }
+
+    // Same results without SIMD, one record at a time.
+    void fit_scalar() {
+        resize_results();
+        for (size_t i = 0; i < size(); i++)
+            fit_lanes<double>(i);
+        fit_theta();
+    }
+
+    double pixels(size_t i) const noexcept { return n_[i]; }
+    double cx(size_t i) const noexcept { return cx_[i]; }
+    double cy(size_t i) const noexcept { return cy_[i]; }
+    double u20(size_t i) const noexcept { return u20_[i]; }
+    double u02(size_t i) const noexcept { return u02_[i]; }
+    double u11(size_t i) const noexcept { return u11_[i]; }
+    double major(size_t i) const noexcept { return major_[i]; }
+    double minor(size_t i) const noexcept { return minor_[i]; }
+    double theta(size_t i) const noexcept { return theta_[i]; }     // degrees
+    int32_t y_top(size_t i) const noexcept { return y_top_[i]; }
+    int32_t y_bottom(size_t i) const noexcept { return y_bottom_[i]; }
+
+private:
+#if defined(__aarch64__)
+    struct Vec2 {
+        float64x2_t v;
+        static Vec2 load(const double *p) noexcept { return {vld1q_f64(p)}; }
+        static Vec2 splat(double x) noexcept { return {vdupq_n_f64(x)}; }
+        void store(double *p) const noexcept { vst1q_f64(p, v); }
+        friend Vec2 operator+(Vec2 a, Vec2 b) noexcept { return {vaddq_f64(a.v, b.v)}; }
+        friend Vec2 operator-(Vec2 a, Vec2 b) noexcept { return {vsubq_f64(a.v, b.v)}; }
+        friend Vec2 operator*(Vec2 a, Vec2 b) noexcept { return {vmulq_f64(a.v, b.v)}; }
+        friend Vec2 operator/(Vec2 a, Vec2 b) noexcept { return {vdivq_f64(a.v, b.v)}; }
+        static Vec2 max(Vec2 a, Vec2 b) noexcept { return {vmaxq_f64(a.v, b.v)}; }
+        static Vec2 sqrt(Vec2 a) noexcept { return {vsqrtq_f64(a.v)}; }
+    };
+#elif defined(__SSE2__)
+    struct Vec2 {
+        __m128d v;
+        static Vec2 load(const double *p) noexcept { return {_mm_loadu_pd(p)}; }
+        static Vec2 splat(double x) noexcept { return {_mm_set1_pd(x)}; }
+        void store(double *p) const noexcept { _mm_storeu_pd(p, v); }
+        friend Vec2 operator+(Vec2 a, Vec2 b) noexcept { return {_mm_add_pd(a.v, b.v)}; }
+        friend Vec2 operator-(Vec2 a, Vec2 b) noexcept { return {_mm_sub_pd(a.v, b.v)}; }
+        friend Vec2 operator*(Vec2 a, Vec2 b) noexcept { return {_mm_mul_pd(a.v, b.v)}; }
+        friend Vec2 operator/(Vec2 a, Vec2 b) noexcept { return {_mm_div_pd(a.v, b.v)}; }
+        static Vec2 max(Vec2 a, Vec2 b) noexcept { return {_mm_max_pd(a.v, b.v)}; }
+        static Vec2 sqrt(Vec2 a) noexcept { return {_mm_sqrt_pd(a.v)}; }
+    };
+#endif
+
+    // Lane operations on double and on Vec2.
+    template<typename V>
+    static V v_load(const double *p) noexcept {
+        if constexpr (std::is_same_v<V, double>) return *p; else return V::load(p);
+    }
+    template<typename V>
+    static V v_splat(double x) noexcept {
+        if constexpr (std::is_same_v<V, double>) return x; else return V::splat(x);
+    }
+    static void v_store(double *p, double v) noexcept { *p = v; }
+    static double v_max(double a, double b) noexcept { return std::max(a, b); }
+    static double v_sqrt(double a) noexcept { return std::sqrt(a); }
+#if defined(__aarch64__) || defined(__SSE2__)
+    static void v_store(double *p, Vec2 v) noexcept { v.store(p); }
+    static Vec2 v_max(Vec2 a, Vec2 b) noexcept { return Vec2::max(a, b); }
+    static Vec2 v_sqrt(Vec2 a) noexcept { return Vec2::sqrt(a); }
+#endif
+
+    // Records [i, i + lanes of V).
+    template<typename V>
+    void fit_lanes(size_t i) noexcept {
+        const V n = v_load<V>(&n_[i]);
+        const V n1 = v_load<V>(&n1_[i]);
+        const V off = v_load<V>(&off_[i]);
+        const V inv = v_splat<V>(1.0) / v_max(n, v_splat<V>(1.0));
+        const V half = v_splat<V>(0.5);
+        const V zero = v_splat<V>(0.0);
+
+        // Merge: y = ylow + off for every seg1 pixel.
+        const V sum_x = v_load<V>(&sx_[i]);
+        const V sum_y = v_load<V>(&sy_[i]) + off * n1;
+        const V sum_yy = v_load<V>(&syy_[i]) + (off + off) * v_load<V>(&sy1_[i]) + off * off * n1;
+        const V sum_xy = v_load<V>(&sxy_[i]) + off * v_load<V>(&sx1_[i]);
+
+        const V cx = sum_x * inv;
+        const V cy = sum_y * inv;
+        const V u20 = v_load<V>(&sxx_[i]) * inv - cx * cx;
+        const V u02 = sum_yy * inv - cy * cy;
+        const V u11 = sum_xy * inv - cx * cy;
+
+        const V l_left = (u20 + u02) * half;
+        const V d = (u20 - u02) * half;
+        const V l_right = v_sqrt(d * d + u11 * u11);
+        const V two = v_splat<V>(2.0);
+
+        v_store(&cx_[i], cx);
+        v_store(&cy_[i], cy);
+        v_store(&u20_[i], u20);
+        v_store(&u02_[i], u02);
+        v_store(&u11_[i], u11);
+        v_store(&major_[i], two * v_sqrt(v_max(l_left + l_right, zero)));
+        v_store(&minor_[i], two * v_sqrt(v_max(l_left - l_right, zero)));
+    }
+
+    void fit_theta() noexcept {
+        constexpr double deg = 90.0 / std::numbers::pi;
+        for (size_t i = 0; i < size(); i++)
+            theta_[i] = deg * std::atan2(2.0 * u11_[i], u20_[i] - u02_[i]);
+    }
+
+    void resize_results() {
+        for (auto *column : {&cx_, &cy_, &u20_, &u02_, &u11_, &major_, &minor_, &theta_})
+            column->resize(size());
+    }
+
+    // Inputs, one entry per record.
+    std::vector<double> n_, n1_;        // pixels: all, in seg1
+    std::vector<double> sx_, sx1_;      // sum x: all, in seg1
+    std::vector<double> sxx_;
+    std::vector<double> sy_, sy1_;      // sum ylow: all, in seg1
+    std::vector<double> syy_;           // sum ylow^2
+    std::vector<double> sxy_;           // sum x*ylow
+    std::vector<double> off_;           // y of seg1 row ylow is ylow + off
+    std::vector<int32_t> y_top_, y_bottom_;
+
+    // Results of fit().
+    std::vector<double> cx_, cy_, u20_, u02_, u11_, major_, minor_, theta_;
+};
+
+inline void PrintEllipse(const EllipseBatch &batch, size_t i) {
+    std::cout << "ELLIPSE:";
+    std::cout << "\n  pixels = " << batch.pixels(i) << "\n  y_top = " << batch.y_top(i) << "\n  y_bottom = " << batch.y_bottom(i);
+    std::cout << "\n  cx = " << batch.cx(i) << "\n  cy = " << batch.cy(i);
+    std::cout << "\n  major = " << batch.major(i) << "\n  minor = " << batch.minor(i) << "\n  theta = " << batch.theta(i);
+
+    std::cout << "\n\n";
+}
+
+// TestRun report printing each feature followed by its ellipse.
+// Features are fitted in batches, flushed when full, at a new frame
+// and at the end of the run.
+struct EllipseReport {
+    size_t capacity = 1024;
+    EllipseBatch batch{capacity};
+    std::vector<std::pair<uint64_t, Feature_t>> pending;
+
+    void frame([[maybe_unused]] size_t frame_idx) {
+        flush();
+#ifdef DEBUG_PRINT
+        std::cout << "Frame " << frame_idx << ":\n";
+#endif
+    }
+    void feature(uint64_t clk_cnt, const Feature_t &feature) {
+        pending.emplace_back(clk_cnt, feature);
+        batch.add(feature);
+        if (batch.size() == capacity)
+            flush();
+    }
+    void speed(uint64_t clk_cnt, std::chrono::steady_clock::time_point t0) {
+        flush();
+        PrintSpeed(clk_cnt, t0);
+    }
+
+    void flush() {
+        batch.fit();
+        for (size_t i = 0; i < pending.size(); i++) {
+            PrintFeature(pending[i].first, pending[i].second);
+            PrintEllipse(batch, i);
+        }
+        pending.clear();
+        batch.clear();
+    }
+};
+
+} // namespace DUT_NAMESPACE
@@ -0,0 +1,359 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "TestRun.h"
+
+// ------------------------------------------------------------
+// FEATURE OUTPUT AS A COLUMNAR BINARY FILE
+// ------------------------------------------------------------
+//
+// FeatureWriter stores features column by column instead of as text:
+//
+//   FeatureFileHeader
+//   FeatureColumnDesc[num_columns]   name, bit width, bytes per value
+//   block 0, block 1, ...
+//
+// A block is a uint64_t record count followed by every column's values
+// for those records, back to back, each column padded to 8 bytes.
+// Values are little endian, in the smallest of 1, 2, 4, 8 or a multiple
+// of 8 bytes holding the bit width. The columns are FRAME, CLK_CNT and
+// the result fields of fields_linkruncca except VALID, with their
+// widths from get_rd_specs().
+//
+// append() only copies into the column buffers of the current block;
+// a full block (block_records records) goes out in one write() per
+// column. FeatureFile maps a written file and hands out the columns of
+// each block in place.
+//
+
+struct FeatureFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t num_columns;
+    uint32_t block_records;         // records per block, the last may hold fewer
+    uint32_t reserved;
+    uint64_t num_records;
+    uint64_t num_blocks;
+
+    static constexpr char MAGIC[8] = {'E', 'M', 'U', 'F', 'E', 'A', 'T', '\0'};
+    static constexpr uint32_t VERSION = 1;
+};
+
+struct FeatureColumnDesc {
+    char name[32];
+    uint32_t bits;
+    uint32_t bytes;
+
+    static constexpr uint32_t bytes_for(size_t bits) noexcept {
+        return bits <= 8 ? 1 : bits <= 16 ? 2 : bits <= 32 ? 4 : uint32_t((bits + 63) / 64 * 8);
+    }
+};
+
+inline namespace DUT_NAMESPACE {
+
+// Column table of the app's result fields.
+struct FeatureColumns {
+    using fields_t = fields<app_fields_t>;
+
+    static constexpr size_t FRAME = 0;
+    static constexpr size_t CLK_CNT = 1;
+    static constexpr size_t FIRST_FIELD = 2;    // rd_specs[1], X_LEFT
+    static constexpr size_t count = FIRST_FIELD + fields_t::num_rd_fields - 1;
+
+    static std::array<FeatureColumnDesc, count> descs() {
+        std::array<FeatureColumnDesc, count> d{};
+        auto set = [&](size_t i, const char *name, size_t bits) {
+            std::strncpy(d[i].name, name, sizeof(d[i].name) - 1);
+            d[i].bits = static_cast<uint32_t>(bits);
+            d[i].bytes = FeatureColumnDesc::bytes_for(bits);
+        };
+        set(FRAME, "FRAME", 32);
+        set(CLK_CNT, "CLK_CNT", 64);
+        for (size_t f = 1; f < fields_t::num_rd_fields; f++)
+            set(FIRST_FIELD + f - 1, fields_t::rd_specs[f].name, fields_t::rd_specs[f].bit_width);
+        return d;
+    }
+};
+
+class FeatureWriter {
+public:
+    FeatureWriter(const std::string &fname, uint32_t block_records = 65536)
+        : fname_(fname), block_records_(block_records), descs_(FeatureColumns::descs())
+    {
+        if (block_records_ == 0)
+            throw std::runtime_error("FeatureWriter: block of zero records");
+        fd_ = ::open(fname.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd_ < 0)
+            throw std::runtime_error("FeatureWriter: cannot open " + fname);
+        for (size_t c = 0; c < descs_.size(); c++)
+            columns_[c].resize(padded(size_t(block_records_) * descs_[c].bytes));
+        put_header();
+        put(descs_.data(), sizeof(descs_));
+    }
+
+    ~FeatureWriter() {
+        try {
+            close();
+        } catch (...) {
+        }
+    }
+
+    FeatureWriter(const FeatureWriter &) = delete;
+    FeatureWriter &operator=(const FeatureWriter &) = delete;
+
+    void append(size_t frame_idx, uint64_t clk_cnt, const Feature_t &f) {
+        static_assert(FeatureColumns::count == 17, "FeatureWriter::append() must list every result field.");
+        size_t c = 0;
+        set(c++, static_cast<uint32_t>(frame_idx));
+        set(c++, clk_cnt);
+        set(c++, f.x_left);
+        set(c++, f.x_right);
+        set(c++, f.y_top_seg_0);
+        set(c++, f.y_top_seg_1);
+        set(c++, f.y_bottom_seg_0);
+        set(c++, f.y_bottom_seg_1);
+        set(c++, f.x2_sum);
+        set(c++, f.ylow2_sum);
+        set(c++, f.xylow_sum);
+        set(c++, f.x_seg0_sum);
+        set(c++, f.x_seg1_sum);
+        set(c++, f.ylow_seg0_sum);
+        set(c++, f.ylow_seg1_sum);
+        set(c++, f.n_seg0_sum);
+        set(c++, f.n_seg1_sum);
+
+        if (++block_fill_ == block_records_)
+            put_block();
+    }
+
+    void close() {
+        if (fd_ < 0)
+            return;
+        put_block();
+        const bool ok = ::lseek(fd_, 0, SEEK_SET) == 0 && put_header();
+        ::close(fd_);
+        fd_ = -1;
+        if (!ok || failed_)
+            throw std::runtime_error("FeatureWriter: write failed: " + fname_);
+    }
+
+    uint64_t records() const noexcept {
+        return num_records_ + block_fill_;
+    }
+
+private:
+    static constexpr size_t padded(size_t bytes) noexcept {
+        return (bytes + 7) & ~size_t(7);
+    }
+
+    // Stores the low desc.bytes bytes of v at the current row of column c.
+    template<typename T>
+    void set(size_t c, const T &v) noexcept {
+        const uint32_t bytes = descs_[c].bytes;
+        uint8_t *dst = columns_[c].data() + size_t(block_fill_) * bytes;
+        if constexpr (requires { v.limb(0); }) {
+            for (size_t i = 0; i < bytes / 8; i++) {
+                const uint64_t limb = v.limb(i);
+                std::memcpy(dst + 8 * i, &limb, 8);
+            }
+        } else {
+            const auto u = static_cast<unsigned __int128>(v);
+            std::memcpy(dst, &u, std::min<size_t>(bytes, sizeof(u)));
+        }
+    }
+
+    void put_block() {
+        if (block_fill_ == 0)
+            return;
+        const uint64_t records = block_fill_;
+        put(&records, sizeof(records));
+        for (size_t c = 0; c < descs_.size(); c++)
+            put(columns_[c].data(), padded(records * descs_[c].bytes));
+        num_records_ += records;
+        num_blocks_++;
+        block_fill_ = 0;
+    }
+
+    bool put(const void *data, size_t size) noexcept {
+        const char *p = static_cast<const char *>(data);
+        while (size && !failed_) {
+            const ssize_t n = ::write(fd_, p, size);
+            if (n <= 0)
+                failed_ = true;
+            else {
+                p += n;
+                size -= n;
+            }
+        }
+        return !failed_;
+    }
+
+    bool put_header() noexcept {
+        FeatureFileHeader h{};
+        std::memcpy(h.magic, FeatureFileHeader::MAGIC, sizeof(h.magic));
+        h.version = FeatureFileHeader::VERSION;
+        h.num_columns = static_cast<uint32_t>(descs_.size());
+        h.block_records = block_records_;
+        h.num_records = num_records_;
+        h.num_blocks = num_blocks_;
+        return put(&h, sizeof(h));
+    }
+
+    std::string fname_;
+    int fd_ = -1;
+    bool failed_ = false;
+    uint32_t block_records_;
+    std::array<FeatureColumnDesc, FeatureColumns::count> descs_;
+    std::array<std::vector<uint8_t>, FeatureColumns::count> columns_;
+
+    uint32_t block_fill_ = 0;
+    uint64_t num_records_ = 0;
+    uint64_t num_blocks_ = 0;
+};
+
+} // namespace DUT_NAMESPACE
+
+// Read-only mapping of a feature file.
+class FeatureFile {
+public:
+    struct Block {
+        uint64_t records;
+        std::vector<const uint8_t *> columns;   // one per FeatureColumnDesc
+    };
+
+    FeatureFile(const std::string &fname) {
+        fd_ = ::open(fname.c_str(), O_RDONLY);
+        if (fd_ < 0)
+            throw std::runtime_error("FeatureFile: cannot open " + fname);
+
+        struct stat st;
+        if (fstat(fd_, &st) != 0 || size_t(st.st_size) < sizeof(FeatureFileHeader)) {
+            ::close(fd_);
+            throw std::runtime_error("FeatureFile: not a feature file: " + fname);
+        }
+        map_size_ = st.st_size;
+
+        map_ = mmap(nullptr, map_size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+        if (map_ == MAP_FAILED) {
+            ::close(fd_);
+            throw std::runtime_error("FeatureFile: mmap() failed");
+        }
+
+        try {
+            index(fname);
+        } catch (...) {
+            munmap(map_, map_size_);
+            ::close(fd_);
+            throw;
+        }
+    }
+
+    ~FeatureFile() {
+        munmap(map_, map_size_);
+        ::close(fd_);
+    }
+
+    FeatureFile(const FeatureFile &) = delete;
+    FeatureFile &operator=(const FeatureFile &) = delete;
+
+    const FeatureFileHeader &header() const noexcept {
+        return *static_cast<const FeatureFileHeader *>(map_);
+    }
+
+    const FeatureColumnDesc *columns() const noexcept {
+        return reinterpret_cast<const FeatureColumnDesc *>(static_cast<const char *>(map_) + sizeof(FeatureFileHeader));
+    }
+
+    // Index of the column called name, or num_columns.
+    size_t column(const std::string &name) const noexcept {
+        size_t c = 0;
+        while (c < header().num_columns && name != columns()[c].name)
+            c++;
+        return c;
+    }
+
+    const std::vector<Block> &blocks() const noexcept {
+        return blocks_;
+    }
+
+    // Value of column c, record r of a block, if it fits in 64 bits.
+    uint64_t value(const Block &block, size_t c, size_t r) const noexcept {
+        const uint32_t bytes = columns()[c].bytes;
+        uint64_t v = 0;
+        std::memcpy(&v, block.columns[c] + r * bytes, std::min<size_t>(bytes, sizeof(v)));
+        return v;
+    }
+
+private:
+    void index(const std::string &fname) {
+        const auto &h = header();
+        const char *base = static_cast<const char *>(map_);
+        size_t pos = sizeof(FeatureFileHeader) + size_t(h.num_columns) * sizeof(FeatureColumnDesc);
+        if (std::memcmp(h.magic, FeatureFileHeader::MAGIC, sizeof(h.magic)) != 0
+            || h.version != FeatureFileHeader::VERSION
+            || pos > map_size_)
+            throw std::runtime_error("FeatureFile: bad or truncated file: " + fname);
+
+        uint64_t records = 0;
+        for (uint64_t b = 0; b < h.num_blocks; b++) {
+            Block block;
+            if (map_size_ - pos < sizeof(uint64_t))
+                throw std::runtime_error("FeatureFile: truncated block in " + fname);
+            std::memcpy(&block.records, base + pos, sizeof(uint64_t));
+            pos += sizeof(uint64_t);
+            if (block.records > h.block_records)
+                throw std::runtime_error("FeatureFile: bad block in " + fname);
+            for (uint32_t c = 0; c < h.num_columns; c++) {
+                const size_t size = (block.records * columns()[c].bytes + 7) & ~size_t(7);
+                if (map_size_ - pos < size)
+                    throw std::runtime_error("FeatureFile: truncated block in " + fname);
+                block.columns.push_back(reinterpret_cast<const uint8_t *>(base + pos));
+                pos += size;
+            }
+            records += block.records;
+            blocks_.push_back(std::move(block));
+        }
+        if (records != h.num_records)
+            throw std::runtime_error("FeatureFile: record count mismatch in " + fname);
+    }
+
+    int fd_ = -1;
+    void *map_ = nullptr;
+    size_t map_size_ = 0;
+    std::vector<Block> blocks_;
+};
+
+inline namespace DUT_NAMESPACE {
+
+// TestRun report appending features to a FeatureWriter, speed to stderr.
+struct FeatureReport {
+    FeatureWriter &writer;
+    size_t frame_idx = 0;
+
+    void frame(size_t idx) {
+        frame_idx = idx;
+    }
+    void feature(uint64_t clk_cnt, const Feature_t &feature) {
+        writer.append(frame_idx, clk_cnt, feature);
+    }
+    void speed(uint64_t clk_cnt, std::chrono::steady_clock::time_point t0) {
+        PrintSpeed(clk_cnt, t0);
+    }
+};
+
+} // namespace DUT_NAMESPACE
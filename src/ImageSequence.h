@@ -0,0 +1,341 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <util/SpscRing.h>
+
+#include "StimulusFile.h"
+
+// ------------------------------------------------------------
+// IMAGE FILE INPUT: PBM / PGM / PPM AND RAW FRAME DUMPS
+// ------------------------------------------------------------
+//
+// ImageSequence reads a list of files on a read-ahead thread and hands
+// out chunks of thresholded scanlines, one attribute byte per pixel
+// (StimulusOp::IN_LABEL / HAS_RED / HAS_GREEN / HAS_BLUE). Chunks come
+// from a fixed pool, and the pages of a file are dropped from the
+// mapping once decoded, so any number of frames runs in constant memory.
+//
+// Supported inputs, each file may hold several frames back to back:
+//   P4 (PBM)  1 = in_label
+//   P5 (PGM)  sample >= threshold (scaled to 0..255) = in_label
+//   P6 (PPM)  per-channel threshold gives has_red/green/blue,
+//             luma >= threshold gives in_label
+//   raw       8-bit gray, width x height per frame, as P5
+//
+// Frames are cropped or padded with background to x_size, and cropped
+// to y_size rows.
+//
+
+class ImageSequence {
+public:
+    struct Options {
+        uint32_t threshold = 128;
+        uint32_t raw_width = 0;         // 0: files must be PBM/PGM/PPM
+        uint32_t raw_height = 0;
+    };
+
+    struct Chunk {
+        size_t frame_idx;
+        size_t y_begin;
+        size_t rows;
+        bool frame_start;
+        std::vector<uint8_t> attrs;     // rows x x_size
+    };
+
+    static constexpr size_t rows_per_chunk = 64;
+    static constexpr size_t pool_size = 4;
+
+    ImageSequence(std::vector<std::string> files, const Options &options, size_t x_size, size_t y_size)
+        : files_(std::move(files)), options_(options), x_size_(x_size), y_size_(y_size)
+    {
+        if (files_.empty())
+            throw std::runtime_error("ImageSequence: no input files");
+        for (size_t i = 0; i < pool_size; i++) {
+            pool_.push_back(std::make_unique<Chunk>());
+            pool_.back()->attrs.resize(rows_per_chunk * x_size_);
+            free_chunks_.push(pool_.back().get());
+        }
+        reader_ = std::thread([this] { read_all(); });
+    }
+
+    ~ImageSequence() {
+        stop_.store(true, std::memory_order_relaxed);
+        if (reader_.joinable())
+            reader_.join();
+    }
+
+    ImageSequence(const ImageSequence &) = delete;
+    ImageSequence &operator=(const ImageSequence &) = delete;
+
+    // Next decoded chunk, nullptr after the last one (or on error).
+    Chunk *next() noexcept {
+        Chunk *chunk;
+        filled_chunks_.pop(chunk);
+        return chunk;
+    }
+
+    // Returns a chunk from next() to the pool.
+    void release(Chunk *chunk) noexcept {
+        free_chunks_.push(chunk);
+    }
+
+    // Empty unless reading stopped on a bad file.
+    const std::string &error() const noexcept {
+        return error_;
+    }
+
+private:
+    enum class Format { PBM, PGM, PPM, RAW };
+
+    struct Frame {
+        Format format;
+        size_t width;
+        size_t height;
+        uint32_t maxval;
+        size_t row_bytes;
+        const uint8_t *data;
+    };
+
+    // Read-only mapping of one input file.
+    class Mapping {
+    public:
+        Mapping(const std::string &fname) {
+            fd_ = ::open(fname.c_str(), O_RDONLY);
+            if (fd_ < 0)
+                throw std::runtime_error("cannot open " + fname);
+            struct stat st;
+            if (fstat(fd_, &st) != 0 || st.st_size == 0) {
+                ::close(fd_);
+                throw std::runtime_error("empty file " + fname);
+            }
+            size_ = st.st_size;
+            map_ = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+            if (map_ == MAP_FAILED) {
+                ::close(fd_);
+                throw std::runtime_error("mmap() failed on " + fname);
+            }
+            madvise(map_, size_, MADV_SEQUENTIAL);
+        }
+
+        ~Mapping() {
+            munmap(map_, size_);
+            ::close(fd_);
+        }
+
+        const uint8_t *data() const noexcept { return static_cast<const uint8_t *>(map_); }
+        size_t size() const noexcept { return size_; }
+
+        // Hints the kernel about [begin, end): read it ahead, or drop it.
+        void will_need(size_t begin, size_t end) const noexcept { advise(begin, end, MADV_WILLNEED); }
+        void dont_need(size_t begin, size_t end) const noexcept { advise(begin, end, MADV_DONTNEED); }
+
+    private:
+        void advise(size_t begin, size_t end, int advice) const noexcept {
+            const size_t page = getpagesize();
+            begin = begin / page * page;
+            end = std::min(end, size_);
+            if (begin < end)
+                madvise(static_cast<uint8_t *>(map_) + begin, end - begin, advice);
+        }
+
+        int fd_ = -1;
+        void *map_ = nullptr;
+        size_t size_ = 0;
+    };
+
+    void read_all() {
+        try {
+            size_t frame_idx = 0;
+            for (const auto &fname : files_) {
+                Mapping file(fname);
+                size_t pos = 0;
+                Frame frame;
+                while (!stop_.load(std::memory_order_relaxed) && parse_frame(file, fname, pos, frame)) {
+                    if (!read_frame(file, frame, frame_idx++))
+                        break;
+                    pos = (frame.data - file.data()) + frame.height * frame.row_bytes;
+                }
+                if (stop_.load(std::memory_order_relaxed))
+                    break;
+            }
+        } catch (const std::exception &e) {
+            error_ = std::string("ImageSequence: ") + e.what();
+        }
+        filled_chunks_.push(nullptr);
+    }
+
+    // Decodes one frame into chunks. False if stopped.
+    bool read_frame(const Mapping &file, const Frame &frame, size_t frame_idx) {
+        const size_t rows = std::min(frame.height, y_size_);
+        const size_t base = frame.data - file.data();
+
+        for (size_t y = 0; y < rows; y += rows_per_chunk) {
+            Chunk *chunk;
+            while (!free_chunks_.try_pop(chunk)) {
+                if (stop_.load(std::memory_order_relaxed))
+                    return false;
+                std::this_thread::yield();
+            }
+
+            chunk->frame_idx = frame_idx;
+            chunk->y_begin = y;
+            chunk->rows = std::min(rows_per_chunk, rows - y);
+            chunk->frame_start = (y == 0);
+
+            const size_t begin = base + y * frame.row_bytes;
+            const size_t end = begin + chunk->rows * frame.row_bytes;
+            file.will_need(end, end + rows_per_chunk * frame.row_bytes);
+
+            for (size_t r = 0; r < chunk->rows; r++)
+                threshold_row(frame, frame.data + (y + r) * frame.row_bytes, &chunk->attrs[r * x_size_]);
+
+            file.dont_need(begin, end);
+            filled_chunks_.push(chunk);
+        }
+        return true;
+    }
+
+    void threshold_row(const Frame &frame, const uint8_t *src, uint8_t *dst) const noexcept {
+        const size_t width = std::min(frame.width, x_size_);
+        const uint32_t thr = options_.threshold;
+
+        switch (frame.format) {
+        case Format::PBM:
+            for (size_t x = 0; x < width; x++)
+                dst[x] = ((src[x / 8] >> (7 - x % 8)) & 1) ? StimulusOp::IN_LABEL : 0;
+            break;
+        case Format::PGM:
+        case Format::RAW:
+            for (size_t x = 0; x < width; x++)
+                dst[x] = scaled(sample(frame, src, x), frame.maxval) >= thr ? StimulusOp::IN_LABEL : 0;
+            break;
+        case Format::PPM:
+            for (size_t x = 0; x < width; x++) {
+                const uint32_t r = scaled(sample(frame, src, 3 * x), frame.maxval);
+                const uint32_t g = scaled(sample(frame, src, 3 * x + 1), frame.maxval);
+                const uint32_t b = scaled(sample(frame, src, 3 * x + 2), frame.maxval);
+                const uint32_t luma = (299 * r + 587 * g + 114 * b) / 1000;
+                dst[x] = (luma >= thr ? StimulusOp::IN_LABEL : 0)
+                       | (r >= thr ? StimulusOp::HAS_RED : 0)
+                       | (g >= thr ? StimulusOp::HAS_GREEN : 0)
+                       | (b >= thr ? StimulusOp::HAS_BLUE : 0);
+            }
+            break;
+        }
+        std::fill(dst + width, dst + x_size_, 0);
+    }
+
+    // Sample i of a PGM/PPM/raw row, 1 or 2 bytes (big endian) wide.
+    static uint32_t sample(const Frame &frame, const uint8_t *src, size_t i) noexcept {
+        if (frame.maxval < 256)
+            return src[i];
+        return (uint32_t(src[2 * i]) << 8) | src[2 * i + 1];
+    }
+
+    static uint32_t scaled(uint32_t v, uint32_t maxval) noexcept {
+        return maxval == 255 ? v : v * 255 / maxval;
+    }
+
+    // Parses the frame header at pos. False at the end of the file.
+    bool parse_frame(const Mapping &file, const std::string &fname, size_t pos, Frame &frame) const {
+        const uint8_t *p = file.data();
+        const size_t size = file.size();
+
+        if (options_.raw_width) {
+            frame.format = Format::RAW;
+            frame.width = options_.raw_width;
+            frame.height = options_.raw_height;
+            frame.maxval = 255;
+            frame.row_bytes = frame.width;
+            if (pos == size)
+                return false;
+            if (size - pos < frame.width * frame.height)
+                throw std::runtime_error("truncated raw frame in " + fname);
+            frame.data = p + pos;
+            return true;
+        }
+
+        auto skip_space = [&] {
+            while (pos < size && (std::isspace(p[pos]) || p[pos] == '#')) {
+                if (p[pos] == '#')
+                    while (pos < size && p[pos] != '\n')
+                        pos++;
+                else
+                    pos++;
+            }
+        };
+        auto number = [&] {
+            skip_space();
+            size_t v = 0;
+            const size_t start = pos;
+            while (pos < size && p[pos] >= '0' && p[pos] <= '9' && v < (size_t(1) << 32))
+                v = v * 10 + (p[pos++] - '0');
+            if (pos == start)
+                throw std::runtime_error("bad header in " + fname);
+            return v;
+        };
+
+        skip_space();
+        if (pos == size)
+            return false;
+        if (size - pos < 2 || p[pos] != 'P')
+            throw std::runtime_error("not a PBM/PGM/PPM file (use -R for raw frames): " + fname);
+
+        switch (p[pos + 1]) {
+        case '4': frame.format = Format::PBM; break;
+        case '5': frame.format = Format::PGM; break;
+        case '6': frame.format = Format::PPM; break;
+        default:
+            throw std::runtime_error("unsupported netpbm type P" + std::string(1, char(p[pos + 1])) + " in " + fname);
+        }
+        pos += 2;
+
+        frame.width = number();
+        frame.height = number();
+        frame.maxval = frame.format == Format::PBM ? 1 : number();
+        if (frame.width == 0 || frame.height == 0 || frame.maxval == 0 || frame.maxval > 65535)
+            throw std::runtime_error("bad header in " + fname);
+        pos++;      // single whitespace before the raster
+
+        const size_t bytes = frame.maxval < 256 ? 1 : 2;
+        switch (frame.format) {
+        case Format::PBM: frame.row_bytes = (frame.width + 7) / 8; break;
+        case Format::PPM: frame.row_bytes = 3 * frame.width * bytes; break;
+        default:          frame.row_bytes = frame.width * bytes; break;
+        }
+
+        if (pos > size || (size - pos) / frame.row_bytes < frame.height)
+            throw std::runtime_error("truncated raster in " + fname);
+        frame.data = p + pos;
+        return true;
+    }
+
+    std::vector<std::string> files_;
+    Options options_;
+    size_t x_size_;
+    size_t y_size_;
+
+    std::vector<std::unique_ptr<Chunk>> pool_;
+    SpscRing<Chunk *, pool_size> free_chunks_;
+    SpscRing<Chunk *, pool_size * 2> filled_chunks_;
+
+    std::atomic<bool> stop_{false};
+    std::string error_;
+    std::thread reader_;
+};
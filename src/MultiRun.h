@@ -0,0 +1,186 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstddef>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <pthread.h>
+#include <sched.h>
+
+#include "TestRun.h"
+
+// ------------------------------------------------------------
+// SEVERAL EMULATOR INSTANCES IN ONE PROCESS
+// ------------------------------------------------------------
+//
+// TestRunMulti runs TestRun on every emulator_fields instance at once,
+// each on its own thread pinned to core (index % cores). Instances
+// share nothing; each thread generates its own stimulus. Features are
+// printed while the runs go, merged in (frame, clk_cnt, instance)
+// order, so the report does not depend on thread scheduling.
+//
+// Every instance reports in (frame, clk_cnt) order, so the calling
+// thread can print the smallest head of the per-instance queues as
+// soon as every running instance has one. A queue holds at most
+// FeatureMerge::capacity features; an instance that gets that far
+// ahead waits for the others, so memory stays bounded however long
+// the run is.
+//
+
+inline namespace DUT_NAMESPACE {
+
+// Pins the calling thread to one CPU. False if the OS refused.
+inline bool PinThread(size_t cpu) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+// Bounded per-instance feature queues between the run threads and the
+// thread printing them.
+class FeatureMerge {
+public:
+    struct Entry {
+        size_t frame_idx;
+        uint64_t clk_cnt;
+        size_t instance;
+        Feature_t feature;
+    };
+
+    static constexpr size_t capacity = 4096;
+
+    explicit FeatureMerge(size_t instances) : queues_(instances), done_(instances, false) {}
+
+    // Blocks while the queue of entry.instance is full.
+    void push(const Entry &entry) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto &queue = queues_[entry.instance];
+        space_.wait(lock, [&] { return queue.size() < capacity; });
+        queue.push_back(entry);
+        data_.notify_one();
+    }
+
+    // The instance reports no more features.
+    void finish(size_t instance) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        done_[instance] = true;
+        data_.notify_one();
+    }
+
+    // Moves the entries that are next in merge order into out, waiting
+    // until there is at least one. False once every instance finished
+    // and all entries were taken.
+    bool pop(std::vector<Entry> &out) {
+        out.clear();
+        std::unique_lock<std::mutex> lock(mutex_);
+        for(;;) {
+            size_t next = queues_.size();
+            bool ready = true;
+            for(size_t i = 0; i < queues_.size() && ready; ++i) {
+                if(queues_[i].empty())
+                    ready = done_[i];
+                else if(next == queues_.size() || Before(queues_[i].front(), queues_[next].front()))
+                    next = i;
+            }
+            if(ready && next != queues_.size()) {
+                out.push_back(queues_[next].front());
+                queues_[next].pop_front();
+            } else if(ready || !out.empty()) {
+                space_.notify_all();
+                return !out.empty();
+            } else {
+                data_.wait(lock);
+            }
+        }
+    }
+
+private:
+    static bool Before(const Entry &a, const Entry &b) {
+        if(a.frame_idx != b.frame_idx)
+            return a.frame_idx < b.frame_idx;
+        if(a.clk_cnt != b.clk_cnt)
+            return a.clk_cnt < b.clk_cnt;
+        return a.instance < b.instance;
+    }
+
+    std::mutex mutex_;
+    std::condition_variable data_;      // an entry or a finish arrived
+    std::condition_variable space_;     // entries were taken
+    std::vector<std::deque<Entry>> queues_;
+    std::vector<bool> done_;
+};
+
+// TestRun report handing features to a FeatureMerge instead of printing.
+struct MergeReport {
+    FeatureMerge *merge = nullptr;
+    size_t instance = 0;
+    size_t frame_idx = 0;
+    uint64_t clk_cnt = 0;
+
+    void frame(size_t idx) {
+        frame_idx = idx;
+    }
+    void feature(uint64_t clk, const Feature_t &feature) {
+        merge->push(FeatureMerge::Entry{frame_idx, clk, instance, feature});
+    }
+    void speed(uint64_t clk, std::chrono::steady_clock::time_point) {
+        clk_cnt = clk;
+    }
+};
+
+template<typename iface_t>
+uint64_t TestRunMulti(const std::vector<iface_t *> &ifaces, uint64_t max_clk_cnt = 50000000) {
+    const size_t cores = std::max(1u, std::thread::hardware_concurrency());
+
+    auto t0 = std::chrono::steady_clock::now();
+
+    FeatureMerge merge(ifaces.size());
+    std::vector<MergeReport> reports(ifaces.size());
+    std::vector<std::thread> threads;
+    for(size_t i = 0; i < ifaces.size(); ++i) {
+        reports[i].merge = &merge;
+        reports[i].instance = i;
+        threads.emplace_back([&, i] {
+            if(!PinThread(i % cores))
+                std::cerr << "Warning: cannot pin instance " << i << " to cpu " << i % cores << "\n";
+            TestRun(*ifaces[i], max_clk_cnt, reports[i]);
+            merge.finish(i);
+        });
+    }
+
+#ifdef DEBUG_PRINT
+    size_t frame_idx = ~size_t(0);
+#endif
+    std::vector<FeatureMerge::Entry> entries;
+    while(merge.pop(entries)) {
+        for(const auto &entry : entries) {
+#ifdef DEBUG_PRINT
+            if(entry.frame_idx != frame_idx)
+                std::cout << "Frame " << entry.frame_idx << ":\n";
+            frame_idx = entry.frame_idx;
+#endif
+            std::cout << "INSTANCE: " << entry.instance << "\n";
+            PrintFeature(entry.clk_cnt, entry.feature);
+        }
+    }
+    for(auto &thread : threads)
+        thread.join();
+
+    uint64_t clk_cnt = 0;
+    for(const auto &report : reports) {
+        std::cerr << "Instance " << report.instance << ": " << report.clk_cnt << " clock cycles\n";
+        clk_cnt += report.clk_cnt;
+    }
+    PrintSpeed(clk_cnt, t0);
+    return clk_cnt;
+}
+
+} // namespace DUT_NAMESPACE
@@ -0,0 +1,300 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <emulator/batch_regs.h>
+
+#include "RemoteProtocol.h"
+#include "TestRun.h"
+
+// ------------------------------------------------------------
+// REMOTE EMULATOR CLIENT
+// ------------------------------------------------------------
+//
+// RemoteClient collects ops into a command frame and sends it when it
+// reaches frame_words or on flush(). Up to `window` frames are in
+// flight; only a full window blocks the caller. Replies are read on a
+// receiver thread, which passes every record to on_record in order.
+//
+
+class RemoteClient {
+public:
+    // (tag, mask, values): a feature record with one value per bit of
+    // mask, or a marker (mask == RemoteRecord::MARK, values nullptr).
+    using record_fn = std::function<void(uint64_t, uint64_t, const uint64_t *)>;
+
+    RemoteClient(const std::string &address, const RemoteHello &hello, record_fn on_record,
+                 size_t window = 8, size_t frame_words = 16384)
+        : socket_(RemoteSocket::connect(address)), on_record_(std::move(on_record)),
+          window_(std::max<size_t>(1, window)), frame_words_(std::max<size_t>(16, frame_words))
+    {
+        socket_.send_all(&hello, sizeof(hello));
+        RemoteHello server;
+        if (!socket_.recv_all(&server, sizeof(server)) || std::memcmp(&server, &hello, sizeof(hello)) != 0)
+            throw std::runtime_error("RemoteClient: " + address + " serves another DUT or protocol");
+        payload_.reserve(frame_words_ + 2);
+        receiver_ = std::thread([this] { receive(); });
+    }
+
+    ~RemoteClient() {
+        socket_.shutdown_both();
+        if (receiver_.joinable())
+            receiver_.join();
+    }
+
+    RemoteClient(const RemoteClient &) = delete;
+    RemoteClient &operator=(const RemoteClient &) = delete;
+
+    void wr(size_t field, uint64_t value) {
+        op(RemoteOp::make(RemoteOp::WR, field, 0), value);
+    }
+
+    // count clocks, field = start + i before clock i.
+    void ramp(size_t field, uint64_t start, uint64_t count) {
+        while (count) {
+            const uint64_t n = std::min(count, RemoteOp::MAX_COUNT);
+            op(RemoteOp::make(RemoteOp::RAMP, field, n), start);
+            start += n;
+            count -= n;
+        }
+    }
+
+    void clock(uint64_t count = 1) {
+        while (count) {
+            const uint64_t n = std::min(count, RemoteOp::MAX_COUNT);
+            op(RemoteOp::make(RemoteOp::CLOCK, 0, n));
+            count -= n;
+        }
+    }
+
+    // After every following clock: if rd field `gate` is non-zero, return
+    // the rd fields of mask.
+    void select(size_t gate, uint64_t mask) {
+        op(RemoteOp::make(RemoteOp::SELECT, gate, 0), mask);
+    }
+
+    void mark(uint64_t value) {
+        op(RemoteOp::make(RemoteOp::MARK, 0, value));
+    }
+
+    // Sends the ops collected so far as one frame.
+    void flush() {
+        if (payload_.empty())
+            return;
+        {
+            std::unique_lock lock(mutex_);
+            cv_.wait(lock, [&] { return in_flight_ < window_ || error_; });
+            if (error_)
+                std::rethrow_exception(error_);
+            in_flight_++;
+        }
+        const RemoteFrameHeader frame{RemoteFrameHeader::MAGIC, seq_++, payload_.size()};
+        socket_.send_all(&frame, sizeof(frame));
+        socket_.send_all(payload_.data(), payload_.size() * sizeof(uint64_t));
+        payload_.clear();
+    }
+
+    // Sends the last frame and waits for all replies. Returns the clocks
+    // the server ran in this session.
+    uint64_t finish() {
+        flush();
+        {
+            std::unique_lock lock(mutex_);
+            cv_.wait(lock, [&] { return in_flight_ == 0 || error_; });
+            if (error_)
+                std::rethrow_exception(error_);
+        }
+        socket_.shutdown_write();
+        receiver_.join();
+        if (error_)
+            std::rethrow_exception(error_);
+        return clocks_;
+    }
+
+private:
+    void op(uint64_t word) {
+        payload_.push_back(word);
+        if (payload_.size() >= frame_words_)
+            flush();
+    }
+
+    void op(uint64_t word, uint64_t operand) {
+        payload_.push_back(word);
+        op(operand);
+    }
+
+    void receive() {
+        try {
+            std::vector<uint64_t> records;
+            uint32_t seq = 0;
+            RemoteReplyHeader reply;
+            while (socket_.recv_all(&reply, sizeof(reply))) {
+                if (reply.magic != RemoteReplyHeader::MAGIC || reply.seq != seq++)
+                    throw std::runtime_error("RemoteClient: bad reply header");
+                records.resize(reply.words);
+                if (!socket_.recv_all(records.data(), records.size() * sizeof(uint64_t)) && !records.empty())
+                    throw std::runtime_error("RemoteClient: truncated reply");
+
+                for (size_t i = 0; i + 2 <= records.size(); ) {
+                    const uint64_t tag = records[i++];
+                    const uint64_t mask = records[i++];
+                    if (mask == RemoteRecord::MARK) {
+                        on_record_(tag, mask, nullptr);
+                        continue;
+                    }
+                    const size_t n = std::popcount(mask);
+                    if (i + n > records.size())
+                        throw std::runtime_error("RemoteClient: truncated record");
+                    on_record_(tag, mask, records.data() + i);
+                    i += n;
+                }
+                if (reply.status != RemoteReplyHeader::OK)
+                    throw std::runtime_error(std::string("RemoteClient: server: ")
+                                             + RemoteReplyHeader::status_name(reply.status));
+
+                std::lock_guard lock(mutex_);
+                clocks_ = reply.clocks;
+                in_flight_--;
+                cv_.notify_all();
+            }
+            std::lock_guard lock(mutex_);
+            if (in_flight_)
+                throw std::runtime_error("RemoteClient: connection closed with frames in flight");
+        } catch (...) {
+            std::lock_guard lock(mutex_);
+            if (!error_)
+                error_ = std::current_exception();
+            cv_.notify_all();
+        }
+    }
+
+    RemoteSocket socket_;
+    record_fn on_record_;
+    size_t window_;
+    size_t frame_words_;
+    std::vector<uint64_t> payload_;
+    uint32_t seq_ = 0;
+
+    std::thread receiver_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    size_t in_flight_ = 0;
+    uint64_t clocks_ = 0;
+    std::exception_ptr error_;
+};
+
+inline namespace DUT_NAMESPACE {
+
+// Feature values of one record, read like emulator_fields (for
+// RdFeatureFields).
+struct RemoteFeatureRecord {
+    uint64_t mask;
+    const uint64_t *values;
+
+    template<rd_add FIELD, typename word_t>
+    void rd_field(word_t &data) const {
+        const uint64_t below = mask & ((uint64_t(1) << static_cast<size_t>(FIELD)) - 1);
+        data = word_t(values[std::popcount(below)]);
+    }
+};
+
+// Same stimulus and report as TestRun, run on a remote server. Each
+// row is a few RAMP ops over the spans of the row; a frame of ops is
+// sent every rows_per_frame rows.
+template<typename report_t = PrintReport>
+uint64_t TestRunRemote(const std::string &address, uint64_t max_clk_cnt = 50000000, report_t &&report = report_t{}) {
+    using fields_t = fields<app_fields_t>;
+    const size_t frames = 1;
+    const size_t x_size = llcca_gens.X_SIZE;
+    const size_t y_size = (size_t)1 << llcca_gens.Y_BITS;
+    const size_t repeat_y_size = 512;
+    const size_t rows_per_frame = 64;
+    const uint64_t reset_clocks = 2 * x_size + 1;
+
+    auto t0 = std::chrono::steady_clock::now();
+
+    TestFrames test_frames(x_size, y_size, repeat_y_size);
+
+    RemoteHello hello{};
+    std::memcpy(hello.magic, RemoteHello::MAGIC, sizeof(hello.magic));
+    hello.version = RemoteHello::VERSION;
+    hello.geometry = batch_regs::geometry_id(llcca_gens.X_SIZE, llcca_gens.Y_BITS);
+    hello.num_wr_fields = fields_t::num_wr_fields;
+    hello.num_rd_fields = fields_t::num_rd_fields;
+
+    RemoteClient client(address, hello, [&](uint64_t tag, uint64_t mask, const uint64_t *values) {
+        if (mask == RemoteRecord::MARK) {
+            report.frame(tag);
+            return;
+        }
+        Feature_t feature;
+        feature.valid = true;
+        RemoteFeatureRecord record{mask, values};
+        RdFeatureFields(record, feature);
+        report.feature(tag - reset_clocks, feature);
+    });
+
+    auto wr = [&](wr_add field, uint64_t value) {
+        client.wr(static_cast<size_t>(field), value);
+    };
+
+    // ResetEmulation
+    wr(wr_add::RST, 1);
+    wr(wr_add::DATAVALID, 1);
+    client.clock(2 * x_size);
+    wr(wr_add::RST, 0);
+    wr(wr_add::DATAVALID, 0);
+    client.clock(1);
+
+    const uint64_t all_rd = (uint64_t(1) << fields_t::num_rd_fields) - 1;
+    client.select(static_cast<size_t>(rd_add::VALID), all_rd & ~(uint64_t(1) << static_cast<size_t>(rd_add::VALID)));
+
+    wr(wr_add::DATAVALID, 1);
+    wr(wr_add::HAS_RED, 0);
+    wr(wr_add::HAS_GREEN, 0);
+    wr(wr_add::HAS_BLUE, 0);
+
+    uint64_t clk_cnt = 0;
+    for(size_t frame_idx = 0; frame_idx < frames; ++frame_idx) {
+        client.mark(frame_idx);
+        const TestFrame &frame = test_frames.GetFrame(frame_idx);
+        for(size_t y = 0; y < y_size && clk_cnt < max_clk_cnt; ++y) {
+            wr(wr_add::Y, y);
+            size_t x = 0;
+            auto emit = [&](size_t x_end, bool in_label) {
+                const uint64_t n = std::min<uint64_t>(x_end - x, max_clk_cnt - clk_cnt);
+                if (n) {
+                    wr(wr_add::IN_LABEL, in_label ? 1 : 0);
+                    client.ramp(static_cast<size_t>(wr_add::X), x, n);
+                    clk_cnt += n;
+                }
+                x = x_end;
+            };
+            for(const TestFrame::Span &span : frame.Spans(y)) {
+                emit(span.x_begin, false);
+                emit(span.x_end, true);
+            }
+            emit(x_size, false);
+            if((y + 1) % rows_per_frame == 0)
+                client.flush();
+        }
+    }
+    client.finish();
+
+    report.speed(clk_cnt, t0);
+    return clk_cnt;
+}
+
+} // namespace DUT_NAMESPACE
@@ -0,0 +1,278 @@
+#pragma once
+
+#include <cerrno>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include <netdb.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+// ------------------------------------------------------------
+// REMOTE EMULATOR PROTOCOL
+// ------------------------------------------------------------
+//
+// fpga_app -S <address> serves emulator_fields over a socket, a client
+// (fpga_app -C <address>) drives it with batched command frames. Both
+// ends exchange a RemoteHello first; the server refuses a client built
+// for another DUT geometry.
+//
+// A command frame is a RemoteFrameHeader and a payload of 64-bit words:
+// op words (see RemoteOp), each followed by its operand word if it has
+// one. The server runs the ops in order and answers every frame with a
+// RemoteReplyHeader and the result records the frame produced, in
+// order:
+//
+//   { tag, mask, one word per bit of mask }
+//
+// For a feature record tag is the session clock it was read after and
+// mask the rd fields (bit = field index) that follow; for a marker,
+// mask is RemoteRecord::MARK and tag the MARK value.
+//
+// Clients send frames ahead without waiting for replies, so network
+// latency overlaps with emulation. Words are in host byte order; both
+// supported hosts (x86-64, aarch64) are little-endian.
+//
+// Addresses: "unix:<path>", "tcp:<host>:<port>" or "<host>:<port>";
+// a server may omit the host ("tcp:<port>") to listen on all
+// interfaces.
+//
+
+struct RemoteHello {
+    char magic[8];
+    uint32_t version;
+    uint32_t geometry;              // batch_regs::geometry_id of the DUT
+    uint32_t num_wr_fields;
+    uint32_t num_rd_fields;
+
+    static constexpr char MAGIC[8] = {'E', 'M', 'U', 'R', 'E', 'M', 'O', 'T'};
+    static constexpr uint32_t VERSION = 1;
+};
+
+struct RemoteFrameHeader {
+    uint32_t magic;
+    uint32_t seq;
+    uint64_t words;                 // payload words
+
+    static constexpr uint32_t MAGIC = 0x52464d45;   // "EMFR"
+    static constexpr uint64_t MAX_WORDS = uint64_t(1) << 24;
+};
+
+struct RemoteReplyHeader {
+    enum Status : uint32_t { OK, BAD_OP, BAD_FIELD, WIDE_FIELD, TOO_LARGE };
+
+    uint32_t magic;
+    uint32_t seq;                   // of the frame answered
+    uint32_t status;
+    uint32_t reserved;
+    uint64_t words;                 // payload words (records)
+    uint64_t clocks;                // clocks run in the session so far
+
+    static constexpr uint32_t MAGIC = 0x52504d45;   // "EMPR"
+
+    static const char *status_name(uint32_t status) noexcept {
+        switch (status) {
+        case OK:         return "ok";
+        case BAD_OP:     return "unknown op";
+        case BAD_FIELD:  return "field index out of range";
+        case WIDE_FIELD: return "selected field wider than 64 bits";
+        case TOO_LARGE:  return "frame too large";
+        }
+        return "unknown status";
+    }
+};
+
+// Op word: [63:56] kind, [55:48] field index, [47:0] count / value.
+//
+//   WR      field = operand                          (operand: value)
+//   RAMP    count clocks, field = operand + i before clock i
+//   CLOCK   count clocks with the current feed
+//   SELECT  after every following clock read rd field `field`; if it is
+//           non-zero, return the rd fields of the operand mask
+//           (operand 0: read nothing)
+//   MARK    return a marker record with value count
+struct RemoteOp {
+    enum Kind : uint8_t { WR = 1, RAMP, CLOCK, SELECT, MARK };
+
+    static constexpr uint64_t MAX_COUNT = (uint64_t(1) << 48) - 1;
+
+    static constexpr uint64_t make(Kind kind, size_t field, uint64_t count) noexcept {
+        return uint64_t(kind) << 56 | uint64_t(field & 0xff) << 48 | (count & MAX_COUNT);
+    }
+    static constexpr Kind kind(uint64_t op) noexcept { return static_cast<Kind>(op >> 56); }
+    static constexpr size_t field(uint64_t op) noexcept { return (op >> 48) & 0xff; }
+    static constexpr uint64_t count(uint64_t op) noexcept { return op & MAX_COUNT; }
+    static constexpr bool has_operand(Kind kind) noexcept {
+        return kind == WR || kind == RAMP || kind == SELECT;
+    }
+};
+
+struct RemoteRecord {
+    static constexpr uint64_t MARK = uint64_t(1) << 63;
+};
+
+// Blocking stream socket, closed on destruction. Errors throw
+// std::runtime_error.
+class RemoteSocket {
+public:
+    explicit RemoteSocket(int fd = -1) noexcept : fd_(fd) {}
+
+    ~RemoteSocket() {
+        if (fd_ >= 0)
+            ::close(fd_);
+    }
+
+    RemoteSocket(RemoteSocket &&other) noexcept : fd_(std::exchange(other.fd_, -1)) {}
+
+    RemoteSocket &operator=(RemoteSocket &&other) noexcept {
+        if (this != &other) {
+            if (fd_ >= 0)
+                ::close(fd_);
+            fd_ = std::exchange(other.fd_, -1);
+        }
+        return *this;
+    }
+
+    RemoteSocket(const RemoteSocket &) = delete;
+    RemoteSocket &operator=(const RemoteSocket &) = delete;
+
+    static RemoteSocket connect(const std::string &address) {
+        return open(address, false);
+    }
+
+    static RemoteSocket listen(const std::string &address) {
+        return open(address, true);
+    }
+
+    RemoteSocket accept() const {
+        int fd;
+        do {
+            fd = ::accept(fd_, nullptr, nullptr);
+        } while (fd < 0 && errno == EINTR);
+        if (fd < 0)
+            throw std::runtime_error(std::string("RemoteSocket: accept failed: ") + std::strerror(errno));
+        no_delay(fd);
+        return RemoteSocket(fd);
+    }
+
+    void send_all(const void *data, size_t bytes) const {
+        const char *p = static_cast<const char *>(data);
+        while (bytes) {
+            const ssize_t n = ::send(fd_, p, bytes, MSG_NOSIGNAL);
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n <= 0)
+                throw std::runtime_error(std::string("RemoteSocket: send failed: ") + std::strerror(errno));
+            p += n;
+            bytes -= size_t(n);
+        }
+    }
+
+    // False on end of stream before the first byte.
+    bool recv_all(void *data, size_t bytes) const {
+        char *p = static_cast<char *>(data);
+        const size_t total = bytes;
+        while (bytes) {
+            const ssize_t n = ::recv(fd_, p, bytes, 0);
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n < 0)
+                throw std::runtime_error(std::string("RemoteSocket: recv failed: ") + std::strerror(errno));
+            if (n == 0) {
+                if (bytes == total)
+                    return false;
+                throw std::runtime_error("RemoteSocket: connection closed mid-message");
+            }
+            p += n;
+            bytes -= size_t(n);
+        }
+        return true;
+    }
+
+    void shutdown_write() const noexcept {
+        ::shutdown(fd_, SHUT_WR);
+    }
+
+    // Wakes a thread blocked in recv_all() on this socket.
+    void shutdown_both() const noexcept {
+        ::shutdown(fd_, SHUT_RDWR);
+    }
+
+private:
+    static void no_delay(int fd) noexcept {
+        int one = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+
+    static RemoteSocket open(const std::string &address, bool server) {
+        if (address.rfind("unix:", 0) == 0) {
+            const std::string path = address.substr(5);
+            sockaddr_un sa{};
+            sa.sun_family = AF_UNIX;
+            if (path.empty() || path.size() >= sizeof(sa.sun_path))
+                throw std::runtime_error("RemoteSocket: bad unix socket path: " + path);
+            std::memcpy(sa.sun_path, path.c_str(), path.size() + 1);
+
+            RemoteSocket s(::socket(AF_UNIX, SOCK_STREAM, 0));
+            if (s.fd_ < 0)
+                throw std::runtime_error(std::string("RemoteSocket: socket failed: ") + std::strerror(errno));
+            if (server) {
+                ::unlink(path.c_str());
+                if (::bind(s.fd_, reinterpret_cast<sockaddr *>(&sa), sizeof(sa)) < 0 || ::listen(s.fd_, 4) < 0)
+                    throw std::runtime_error("RemoteSocket: cannot listen on " + address + ": " + std::strerror(errno));
+            } else if (::connect(s.fd_, reinterpret_cast<sockaddr *>(&sa), sizeof(sa)) < 0) {
+                throw std::runtime_error("RemoteSocket: cannot connect to " + address + ": " + std::strerror(errno));
+            }
+            return s;
+        }
+
+        std::string hostport = address.rfind("tcp:", 0) == 0 ? address.substr(4) : address;
+        const size_t colon = hostport.rfind(':');
+        std::string host = colon == std::string::npos ? std::string() : hostport.substr(0, colon);
+        const std::string port = colon == std::string::npos ? hostport : hostport.substr(colon + 1);
+        if (port.empty() || (host.empty() && !server))
+            throw std::runtime_error("RemoteSocket: bad address: " + address);
+
+        addrinfo hints{};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        hints.ai_flags = server ? AI_PASSIVE : 0;
+        addrinfo *list = nullptr;
+        if (const int err = ::getaddrinfo(host.empty() ? nullptr : host.c_str(), port.c_str(), &hints, &list))
+            throw std::runtime_error("RemoteSocket: cannot resolve " + address + ": " + ::gai_strerror(err));
+
+        std::string error = "no address";
+        for (addrinfo *ai = list; ai; ai = ai->ai_next) {
+            RemoteSocket s(::socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol));
+            if (s.fd_ < 0)
+                continue;
+            bool ok;
+            if (server) {
+                int one = 1;
+                ::setsockopt(s.fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+                ok = ::bind(s.fd_, ai->ai_addr, ai->ai_addrlen) == 0 && ::listen(s.fd_, 4) == 0;
+            } else {
+                ok = ::connect(s.fd_, ai->ai_addr, ai->ai_addrlen) == 0;
+                if (ok)
+                    no_delay(s.fd_);
+            }
+            if (ok) {
+                ::freeaddrinfo(list);
+                return s;
+            }
+            error = std::strerror(errno);
+        }
+        ::freeaddrinfo(list);
+        throw std::runtime_error("RemoteSocket: cannot " + std::string(server ? "listen on " : "connect to ")
+                                 + address + ": " + error);
+    }
+
+    int fd_;
+};
@@ -0,0 +1,195 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "RemoteProtocol.h"
+
+// ------------------------------------------------------------
+// REMOTE EMULATOR SERVER
+// ------------------------------------------------------------
+//
+// RemoteSession runs the command frames of one client on an
+// emulator_fields instance (any backend) and answers each with the
+// records it produced. Frames are handled one after the other on the
+// calling thread; a client that sends ahead keeps the next frames
+// queued in the socket while the current one runs. ServeRemote accepts
+// clients one at a time, forever. The DUT state carries over between
+// sessions; clients start with a reset.
+//
+
+template<typename iface_t>
+class RemoteSession {
+    using fields_t = typename iface_t::fields_t;
+    using wr_fields = typename fields_t::wr_fields;
+    using rd_fields = typename fields_t::rd_fields;
+
+public:
+    RemoteSession(iface_t &iface, RemoteSocket socket, uint32_t geometry)
+        : iface_(iface), socket_(std::move(socket)), geometry_(geometry) {}
+
+    // Runs frames until the client closes. False if the client was
+    // refused or a frame failed.
+    bool run() {
+        RemoteHello hello{};
+        std::memcpy(hello.magic, RemoteHello::MAGIC, sizeof(hello.magic));
+        hello.version = RemoteHello::VERSION;
+        hello.geometry = geometry_;
+        hello.num_wr_fields = fields_t::num_wr_fields;
+        hello.num_rd_fields = fields_t::num_rd_fields;
+
+        RemoteHello client;
+        if (!socket_.recv_all(&client, sizeof(client)))
+            return false;
+        socket_.send_all(&hello, sizeof(hello));
+        if (std::memcmp(&client, &hello, sizeof(hello)) != 0) {
+            std::cerr << "Remote: client built for another DUT or protocol, refused\n";
+            return false;
+        }
+
+        std::vector<uint64_t> payload;
+        std::vector<uint64_t> records;
+        RemoteFrameHeader frame;
+        while (socket_.recv_all(&frame, sizeof(frame))) {
+            if (frame.magic != RemoteFrameHeader::MAGIC)
+                throw std::runtime_error("RemoteSession: bad frame header");
+
+            RemoteReplyHeader reply{};
+            reply.magic = RemoteReplyHeader::MAGIC;
+            reply.seq = frame.seq;
+            records.clear();
+            if (frame.words > RemoteFrameHeader::MAX_WORDS) {
+                reply.status = RemoteReplyHeader::TOO_LARGE;
+            } else {
+                payload.resize(frame.words);
+                if (!socket_.recv_all(payload.data(), payload.size() * sizeof(uint64_t)) && !payload.empty())
+                    throw std::runtime_error("RemoteSession: truncated frame");
+                reply.status = execute(payload, records);
+            }
+            frames_++;
+
+            reply.words = records.size();
+            reply.clocks = clocks_;
+            socket_.send_all(&reply, sizeof(reply));
+            socket_.send_all(records.data(), records.size() * sizeof(uint64_t));
+            if (reply.status != RemoteReplyHeader::OK) {
+                std::cerr << "Remote: frame " << frame.seq << ": "
+                          << RemoteReplyHeader::status_name(reply.status) << "\n";
+                return false;
+            }
+        }
+        return true;
+    }
+
+    uint64_t clocks() const noexcept { return clocks_; }
+    uint64_t frames() const noexcept { return frames_; }
+
+private:
+    uint32_t execute(const std::vector<uint64_t> &payload, std::vector<uint64_t> &records) {
+        for (size_t i = 0; i < payload.size(); ) {
+            const uint64_t op = payload[i++];
+            const RemoteOp::Kind kind = RemoteOp::kind(op);
+            const size_t field = RemoteOp::field(op);
+            const uint64_t count = RemoteOp::count(op);
+            uint64_t operand = 0;
+            if (RemoteOp::has_operand(kind)) {
+                if (i == payload.size())
+                    return RemoteReplyHeader::BAD_OP;
+                operand = payload[i++];
+            }
+
+            switch (kind) {
+            case RemoteOp::WR:
+            case RemoteOp::RAMP:
+                if (field >= fields_t::num_wr_fields)
+                    return RemoteReplyHeader::BAD_FIELD;
+                if (fields_t::wr_descs[field].bit_width > 64)
+                    return RemoteReplyHeader::WIDE_FIELD;
+                if (kind == RemoteOp::WR) {
+                    iface_.wr_field(static_cast<wr_fields>(field), operand);
+                } else {
+                    for (uint64_t n = 0; n < count; n++) {
+                        iface_.wr_field(static_cast<wr_fields>(field), operand + n);
+                        clock(records);
+                    }
+                }
+                break;
+
+            case RemoteOp::CLOCK:
+                for (uint64_t n = 0; n < count; n++)
+                    clock(records);
+                break;
+
+            case RemoteOp::SELECT:
+                if (field >= fields_t::num_rd_fields || (operand & RemoteRecord::MARK)
+                    || (fields_t::num_rd_fields < 64 && (operand >> fields_t::num_rd_fields)))
+                    return RemoteReplyHeader::BAD_FIELD;
+                for (uint64_t m = operand | uint64_t(1) << field; m; m &= m - 1)
+                    if (fields_t::rd_descs[std::countr_zero(m)].bit_width > 64)
+                        return RemoteReplyHeader::WIDE_FIELD;
+                gate_ = field;
+                mask_ = operand;
+                break;
+
+            case RemoteOp::MARK:
+                records.push_back(count);
+                records.push_back(RemoteRecord::MARK);
+                break;
+
+            default:
+                return RemoteReplyHeader::BAD_OP;
+            }
+        }
+        return RemoteReplyHeader::OK;
+    }
+
+    inline void clock(std::vector<uint64_t> &records) {
+        iface_.wr_flush();
+        iface_.wr_raw(0, 1);
+        clocks_++;
+        if (!mask_)
+            return;
+
+        iface_.rd_flush();
+        uint64_t value;
+        iface_.rd_field(static_cast<rd_fields>(gate_), value);
+        if (!value)
+            return;
+        records.push_back(clocks_);
+        records.push_back(mask_);
+        for (uint64_t m = mask_; m; m &= m - 1) {
+            iface_.rd_field(static_cast<rd_fields>(std::countr_zero(m)), value);
+            records.push_back(value);
+        }
+    }
+
+    iface_t &iface_;
+    RemoteSocket socket_;
+    uint32_t geometry_;
+    uint64_t clocks_ = 0;
+    uint64_t frames_ = 0;
+    size_t gate_ = 0;
+    uint64_t mask_ = 0;
+};
+
+template<typename iface_t>
+[[noreturn]] void ServeRemote(iface_t &iface, const std::string &address, uint32_t geometry) {
+    const RemoteSocket listener = RemoteSocket::listen(address);
+    std::cerr << "Remote: serving on " << address << "\n";
+    for (;;) {
+        RemoteSession<iface_t> session(iface, listener.accept(), geometry);
+        try {
+            session.run();
+        } catch (const std::exception &e) {
+            std::cerr << "Remote: " << e.what() << "\n";
+        }
+        std::cerr << "Remote: session ended after " << session.frames() << " frames, "
+                  << session.clocks() << " clocks\n";
+    }
+}
@@ -0,0 +1,216 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <emulator/result_crc.h>
+
+#include "TestRun.h"
+
+// ------------------------------------------------------------
+// RESULT CRC REFERENCE AND VERIFICATION RUNS
+// ------------------------------------------------------------
+//
+// fpga_app -c <file> runs with per-cycle result reads as usual and
+// writes the result CRC of every frame (see result_crc.h) to a text
+// file:
+//
+//   result_crc <X_SIZE>x<Y_BITS>
+//   frame <frame_idx> <crc, 8 hex digits> <valid results>
+//   ...
+//   clocks <pixel clocks>
+//
+// fpga_app -v <file> runs the same stimulus without reading results:
+// CrcCheckReport restarts the hw CRC at the first frame and reads it
+// once at the end of every frame. CRCs are cumulative over the run,
+// record cycles count pixel clocks from the start of the first frame,
+// like clk_cnt of the reports.
+//
+
+inline namespace DUT_NAMESPACE {
+
+// Result words as the hw folds them into the CRC: 64-bit words of the
+// result window.
+using CrcResultImage = result_image<ModelBackendType, app_fields_t>;
+
+// Encodes a feature into result words, VALID set. Inverse of
+// RdFeatureFields.
+inline void WrFeatureFields(CrcResultImage &result, const Feature_t &data) {
+    result.words.fill(0);
+    result.wr_field<rd_add::VALID>(1);
+    result.wr_field<rd_add::X_LEFT>(data.x_left);
+    result.wr_field<rd_add::X_RIGHT>(data.x_right);
+    result.wr_field<rd_add::Y_TOP_SEG_0>(data.y_top_seg_0);
+    result.wr_field<rd_add::Y_TOP_SEG_1>(data.y_top_seg_1);
+    result.wr_field<rd_add::Y_BOTTOM_SEG_0>(data.y_bottom_seg_0);
+    result.wr_field<rd_add::Y_BOTTOM_SEG_1>(data.y_bottom_seg_1);
+    result.wr_field<rd_add::X2_SUM>(data.x2_sum);
+    result.wr_field<rd_add::YLOW2_SUM>(data.ylow2_sum);
+    result.wr_field<rd_add::XYLOW_SUM>(data.xylow_sum);
+    result.wr_field<rd_add::X_SEG0_SUM>(data.x_seg0_sum);
+    result.wr_field<rd_add::X_SEG1_SUM>(data.x_seg1_sum);
+    result.wr_field<rd_add::YLOW_SEG0_SUM>(data.ylow_seg0_sum);
+    result.wr_field<rd_add::YLOW_SEG1_SUM>(data.ylow_seg1_sum);
+    result.wr_field<rd_add::N_SEG0_SUM>(data.n_seg0_sum);
+    result.wr_field<rd_add::N_SEG1_SUM>(data.n_seg1_sum);
+}
+
+// Per-frame CRCs of a run. load() and save() throw std::runtime_error.
+struct ResultCrcFile {
+    struct Frame {
+        size_t frame_idx;
+        result_crc crc;
+    };
+
+    std::vector<Frame> frames;
+    uint64_t clocks = 0;
+
+    static std::string geometry() {
+        return std::to_string(llcca_gens.X_SIZE) + "x" + std::to_string(llcca_gens.Y_BITS);
+    }
+
+    static ResultCrcFile load(const std::string &fname) {
+        std::ifstream in(fname);
+        if (!in)
+            throw std::runtime_error("cannot open " + fname);
+
+        std::string tag, value;
+        if (!(in >> tag >> value) || tag != "result_crc")
+            throw std::runtime_error(fname + " is not a result CRC file");
+        if (value != geometry())
+            throw std::runtime_error(fname + " was written for geometry " + value + ", not " + geometry());
+
+        ResultCrcFile file;
+        while (in >> tag) {
+            if (tag == "clocks") {
+                if ((in >> file.clocks) && !(in >> tag))
+                    return file;
+                break;
+            }
+            Frame frame;
+            if (tag != "frame" || !(in >> frame.frame_idx >> std::hex >> frame.crc.crc >> std::dec >> frame.crc.count))
+                break;
+            file.frames.push_back(frame);
+        }
+        throw std::runtime_error(fname + ": bad or missing line after " + std::to_string(file.frames.size()) + " frames");
+    }
+
+    void save(const std::string &fname) const {
+        std::ofstream out(fname);
+        out << "result_crc " << geometry() << "\n";
+        for (const Frame &frame : frames)
+            out << "frame " << frame.frame_idx << " " << std::hex << std::setw(8) << std::setfill('0')
+                << frame.crc.crc << std::dec << " " << frame.crc.count << "\n";
+        out << "clocks " << clocks << "\n";
+        if (!out.flush())
+            throw std::runtime_error("cannot write " + fname);
+    }
+};
+
+// Reference run (-c): folds every reported feature into the CRC, as
+// the hw does, and stores the CRC at the end of every frame.
+struct CrcReport {
+    ResultCrcFile &file;
+    result_crc crc{};
+    size_t frame_idx = 0;
+    bool started = false;
+    CrcResultImage result{};
+
+    void frame(size_t idx) {
+        if (started)
+            file.frames.push_back({frame_idx, crc});
+        started = true;
+        frame_idx = idx;
+    }
+    void feature(uint64_t clk_cnt, const Feature_t &feature) {
+        WrFeatureFields(result, feature);
+        crc.add(clk_cnt, result.words.data(), result.words.size());
+    }
+    void speed(uint64_t clk_cnt, std::chrono::steady_clock::time_point t0) {
+        if (started)
+            file.frames.push_back({frame_idx, crc});
+        file.clocks = clk_cnt;
+        PrintSpeed(clk_cnt, t0);
+    }
+};
+
+// Verification run (-v): no per-cycle reads, one RES_CRC read per
+// frame, compared with the reference. Needs 64-bit hw words.
+template<typename iface_t>
+class CrcCheckReport {
+public:
+    static constexpr bool per_cycle_reads = false;
+
+    CrcCheckReport(iface_t &iface, const ResultCrcFile &reference)
+        : iface_(iface), reference_(reference)
+    {}
+
+    void frame(size_t idx) {
+        if (started_)
+            check();
+        else
+            iface_.result_crc_clear();
+        started_ = true;
+        frame_idx_ = idx;
+    }
+
+    void speed(uint64_t clk_cnt, std::chrono::steady_clock::time_point t0) {
+        if (started_)
+            check();
+        PrintSpeed(clk_cnt, t0);
+
+        if (checked_ != reference_.frames.size())
+            fail("ran " + std::to_string(checked_) + " frames, reference has "
+                 + std::to_string(reference_.frames.size()));
+        if (clk_cnt != reference_.clocks)
+            fail("ran " + std::to_string(clk_cnt) + " clocks, reference has "
+                 + std::to_string(reference_.clocks));
+        if (ok())
+            std::cerr << "Result CRC: " << checked_ << " frames match the reference\n";
+        else
+            std::cerr << "Result CRC: " << mismatches_ << " checks failed\n";
+    }
+
+    bool ok() const noexcept {
+        return mismatches_ == 0;
+    }
+
+private:
+    void check() {
+        const result_crc crc = iface_.read_result_crc();
+        const size_t n = checked_++;
+        if (n >= reference_.frames.size())
+            return;
+        const ResultCrcFile::Frame &expected = reference_.frames[n];
+        if (expected.frame_idx == frame_idx_ && expected.crc == crc)
+            return;
+
+        std::ostringstream msg;
+        msg << "frame " << frame_idx_ << ": crc " << std::hex << std::setw(8) << std::setfill('0') << crc.crc
+            << std::dec << ", " << crc.count << " results; reference frame " << expected.frame_idx << ": crc "
+            << std::hex << std::setw(8) << expected.crc.crc << std::dec << ", " << expected.crc.count << " results";
+        fail(msg.str());
+    }
+
+    void fail(const std::string &msg) {
+        if (mismatches_++ == 0)
+            std::cerr << "Result CRC mismatch, " << msg << "\n";
+    }
+
+    iface_t &iface_;
+    const ResultCrcFile &reference_;
+    size_t frame_idx_ = 0;
+    size_t checked_ = 0;
+    size_t mismatches_ = 0;
+    bool started_ = false;
+};
+
+} // namespace DUT_NAMESPACE
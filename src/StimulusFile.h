@@ -0,0 +1,303 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// ------------------------------------------------------------
+// RECORDED STIMULUS, RUN-LENGTH ENCODED
+// ------------------------------------------------------------
+//
+// A DUT input stream (reset/idle clocks and pixels) stored as a flat
+// array of 32-bit op words after a StimulusFileHeader:
+//
+//   [31:30] kind, [29:26] pixel attributes, [25:0] count
+//
+// The header records the DUT geometry (X_SIZE, Y_BITS) the stream was
+// made for; a replay needs the same geometry.
+//
+//   PIXELS   count clocks with RST=0, DATAVALID=1 and the attributes;
+//            X/Y are implicit: the pixel position advances by one per
+//            clock and wraps to the next row after x_size pixels.
+//   CONTROL  count clocks with RST = attr bit 0, DATAVALID = attr bit 1;
+//            the pixel fields keep their values.
+//   FRAME    start of frame `count`; the position returns to (0, 0).
+//   SEEK     count unused, followed by two words x and y: the next pixel
+//            is not at the implicit position.
+//
+// Background stretches of a frame are single PIXELS ops. StimulusFile
+// maps the file read-only, so a replay walks the ops in place.
+//
+
+struct StimulusFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t x_size;
+    uint32_t y_bits;
+    uint32_t reserved;
+    uint64_t num_words;         // op words following the header
+    uint64_t num_clocks;        // all clocks, CONTROL included
+    uint64_t pixel_clocks;
+
+    static constexpr char MAGIC[8] = {'E', 'M', 'U', 'S', 'T', 'I', 'M', '\0'};
+    static constexpr uint32_t VERSION = 2;
+};
+
+struct StimulusOp {
+    enum Kind : uint32_t {
+        PIXELS = 0,
+        CONTROL = 1,
+        FRAME = 2,
+        SEEK = 3,
+    };
+
+    // Pixel attribute bits.
+    static constexpr uint32_t IN_LABEL = 1u << 0;
+    static constexpr uint32_t HAS_RED = 1u << 1;
+    static constexpr uint32_t HAS_GREEN = 1u << 2;
+    static constexpr uint32_t HAS_BLUE = 1u << 3;
+
+    // CONTROL attribute bits.
+    static constexpr uint32_t RST = 1u << 0;
+    static constexpr uint32_t DATAVALID = 1u << 1;
+
+    static constexpr uint32_t COUNT_BITS = 26;
+    static constexpr uint32_t MAX_COUNT = (1u << COUNT_BITS) - 1;
+
+    static constexpr uint32_t make(Kind kind, uint32_t attrs, uint32_t count) noexcept {
+        return (uint32_t(kind) << 30) | ((attrs & 0xf) << COUNT_BITS) | count;
+    }
+    static constexpr Kind kind(uint32_t op) noexcept { return Kind(op >> 30); }
+    static constexpr uint32_t attrs(uint32_t op) noexcept { return (op >> COUNT_BITS) & 0xf; }
+    static constexpr uint32_t count(uint32_t op) noexcept { return op & MAX_COUNT; }
+};
+
+// Encodes a stream clock by clock. Header counts are written by close().
+class StimulusWriter {
+public:
+    StimulusWriter(const std::string &fname, uint32_t x_size, uint32_t y_bits)
+        : fname_(fname), out_(fname, std::ios::binary), x_size_(x_size), y_bits_(y_bits)
+    {
+        if (!out_)
+            throw std::runtime_error("StimulusWriter: cannot open " + fname);
+        if (x_size == 0 || y_bits == 0)
+            throw std::runtime_error("StimulusWriter: empty geometry");
+        put_header();
+    }
+
+    ~StimulusWriter() {
+        try {
+            close();
+        } catch (...) {
+        }
+    }
+
+    StimulusWriter(const StimulusWriter &) = delete;
+    StimulusWriter &operator=(const StimulusWriter &) = delete;
+
+    // count clocks of reset / idle, pixel fields unchanged.
+    void control(bool rst, bool datavalid, uint64_t count = 1) {
+        const uint32_t attrs = (rst ? StimulusOp::RST : 0) | (datavalid ? StimulusOp::DATAVALID : 0);
+        num_clocks_ += count;
+        extend(StimulusOp::CONTROL, attrs, count);
+    }
+
+    // Starts a frame; its first pixel is expected at (0, 0).
+    void frame(uint32_t index) {
+        end_run();
+        put(StimulusOp::make(StimulusOp::FRAME, 0, index & StimulusOp::MAX_COUNT));
+        x_ = 0;
+        y_ = 0;
+    }
+
+    // One clock of pixel data.
+    void pixel(uint32_t x, uint32_t y, uint32_t attrs) {
+        pixels(x, y, attrs, 1);
+    }
+
+    // count clocks of equal pixels from (x, y) along the row, wrapping
+    // to the next rows after x_size.
+    void pixels(uint32_t x, uint32_t y, uint32_t attrs, uint64_t count) {
+        if (!count)
+            return;
+        if (x != x_ || y != y_) {
+            end_run();
+            put(StimulusOp::make(StimulusOp::SEEK, 0, 0));
+            put(x);
+            put(y);
+        }
+        num_clocks_ += count;
+        pixel_clocks_ += count;
+        extend(StimulusOp::PIXELS, attrs, count);
+
+        const uint64_t pos = x + count;
+        x_ = pos % x_size_;
+        y_ = y + pos / x_size_;
+    }
+
+    void close() {
+        if (!out_.is_open())
+            return;
+        end_run();
+        out_.seekp(0);
+        put_header();
+        out_.close();
+        if (!out_)
+            throw std::runtime_error("StimulusWriter: write failed: " + fname_);
+    }
+
+    uint64_t clocks() const noexcept {
+        return num_clocks_;
+    }
+
+private:
+    void extend(StimulusOp::Kind kind, uint32_t attrs, uint64_t count) {
+        if (run_count_ && (kind != run_kind_ || attrs != run_attrs_))
+            end_run();
+        run_kind_ = kind;
+        run_attrs_ = attrs;
+        while (count) {
+            const uint64_t n = std::min<uint64_t>(count, StimulusOp::MAX_COUNT - run_count_);
+            run_count_ += n;
+            count -= n;
+            if (run_count_ == StimulusOp::MAX_COUNT)
+                end_run();
+        }
+    }
+
+    void end_run() {
+        if (run_count_)
+            put(StimulusOp::make(run_kind_, run_attrs_, run_count_));
+        run_count_ = 0;
+    }
+
+    void put(uint32_t word) {
+        out_.write(reinterpret_cast<const char *>(&word), sizeof(word));
+        num_words_++;
+    }
+
+    void put_header() {
+        StimulusFileHeader h{};
+        std::memcpy(h.magic, StimulusFileHeader::MAGIC, sizeof(h.magic));
+        h.version = StimulusFileHeader::VERSION;
+        h.x_size = x_size_;
+        h.y_bits = y_bits_;
+        h.num_words = num_words_;
+        h.num_clocks = num_clocks_;
+        h.pixel_clocks = pixel_clocks_;
+        out_.write(reinterpret_cast<const char *>(&h), sizeof(h));
+    }
+
+    std::string fname_;
+    std::ofstream out_;
+    uint32_t x_size_;
+    uint32_t y_bits_;
+
+    uint32_t x_ = 0;
+    uint32_t y_ = 0;
+
+    StimulusOp::Kind run_kind_ = StimulusOp::PIXELS;
+    uint32_t run_attrs_ = 0;
+    uint32_t run_count_ = 0;
+
+    uint64_t num_words_ = 0;
+    uint64_t num_clocks_ = 0;
+    uint64_t pixel_clocks_ = 0;
+};
+
+// Read-only mapping of a stimulus file.
+class StimulusFile {
+public:
+    StimulusFile(const std::string &fname) {
+        fd_ = ::open(fname.c_str(), O_RDONLY);
+        if (fd_ < 0)
+            throw std::runtime_error("StimulusFile: cannot open " + fname);
+
+        struct stat st;
+        if (fstat(fd_, &st) != 0 || size_t(st.st_size) < sizeof(StimulusFileHeader)) {
+            ::close(fd_);
+            throw std::runtime_error("StimulusFile: not a stimulus file: " + fname);
+        }
+        map_size_ = st.st_size;
+
+        map_ = mmap(nullptr, map_size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+        if (map_ == MAP_FAILED) {
+            ::close(fd_);
+            throw std::runtime_error("StimulusFile: mmap() failed");
+        }
+        madvise(map_, map_size_, MADV_SEQUENTIAL);
+        madvise(map_, map_size_, MADV_WILLNEED);
+
+        const auto &h = header();
+        try {
+            check_header(h, fname);
+        } catch (...) {
+            munmap(map_, map_size_);
+            ::close(fd_);
+            throw;
+        }
+        if (h.num_words > (map_size_ - sizeof(StimulusFileHeader)) / sizeof(uint32_t)) {
+            munmap(map_, map_size_);
+            ::close(fd_);
+            throw std::runtime_error("StimulusFile: truncated file: " + fname);
+        }
+    }
+
+    // Header of a stimulus file, without mapping it; for picking the
+    // DUT geometry before a replay.
+    static StimulusFileHeader read_header(const std::string &fname) {
+        std::ifstream in(fname, std::ios::binary);
+        if (!in)
+            throw std::runtime_error("StimulusFile: cannot open " + fname);
+        StimulusFileHeader h{};
+        if (!in.read(reinterpret_cast<char *>(&h), sizeof(h)))
+            throw std::runtime_error("StimulusFile: not a stimulus file: " + fname);
+        check_header(h, fname);
+        return h;
+    }
+
+    ~StimulusFile() {
+        munmap(map_, map_size_);
+        ::close(fd_);
+    }
+
+    StimulusFile(const StimulusFile &) = delete;
+    StimulusFile &operator=(const StimulusFile &) = delete;
+
+    const StimulusFileHeader &header() const noexcept {
+        return *static_cast<const StimulusFileHeader *>(map_);
+    }
+
+    const uint32_t *begin() const noexcept {
+        return reinterpret_cast<const uint32_t *>(static_cast<const char *>(map_) + sizeof(StimulusFileHeader));
+    }
+
+    const uint32_t *end() const noexcept {
+        return begin() + header().num_words;
+    }
+
+private:
+    static void check_header(const StimulusFileHeader &h, const std::string &fname) {
+        if (std::memcmp(h.magic, StimulusFileHeader::MAGIC, sizeof(h.magic)) != 0)
+            throw std::runtime_error("StimulusFile: not a stimulus file: " + fname);
+        if (h.version != StimulusFileHeader::VERSION)
+            throw std::runtime_error("StimulusFile: " + fname + " has format version " + std::to_string(h.version)
+                                     + ", expected " + std::to_string(StimulusFileHeader::VERSION)
+                                     + "; record it again with -s");
+        if (h.x_size == 0 || h.y_bits == 0)
+            throw std::runtime_error("StimulusFile: bad file: " + fname);
+    }
+
+    int fd_ = -1;
+    void *map_ = nullptr;
+    size_t map_size_ = 0;
+};
@@ -0,0 +1,452 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+#include <iomanip>
+#include <memory>
+#include <numbers>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// ------------------------------------------------------------
+// SEEDED PROCEDURAL STRESS SCENES
+// ------------------------------------------------------------
+//
+// StressScenes renders a long sequence of varied frames for throughput
+// and RTL table stress runs: rotated ellipses, rings, concave shapes
+// (crescents, and combs whose teeth start separate labels that all
+// merge at the spine), chains of touching blobs and speckle noise. How
+// many shapes land on a row follows a density profile:
+//
+//   uniform   same density on every row
+//   ramp      empty at the top, densest at the bottom
+//   bands     eight alternating dense and near-empty bands
+//   worst     uniform with dense speckle, plus a full-width comb of
+//             1-pixel teeth every 64 rows (x_size / 2 labels on one
+//             row, merged in one row) drawn over everything else
+//
+// Frame n depends only on (seed, profile, n, geometry), so runs are
+// reproducible whatever the number of workers. Workers render frames
+// into a bounded ring of packed bitmaps (one bit per pixel, rows of
+// 64-bit words) ahead of the driver: frame n goes to slot n % ring
+// size, and next() hands the frames out in order. Waiting on either
+// side blocks on the slot (std::atomic::wait), so idle workers do not
+// take CPU time from the driver.
+//
+
+class StressScenes {
+public:
+    enum class Profile { UNIFORM, RAMP, BANDS, WORST };
+
+    struct Options {
+        uint64_t seed = 1;
+        Profile profile = Profile::UNIFORM;
+        size_t frames = 16;             // 0: endless
+        size_t rows = 512;              // rows per frame, clipped to y_size
+        size_t workers = 0;             // 0: one per core but one, at least 1
+        size_t ring_frames = 0;         // 0: 2 x workers
+    };
+
+    struct Frame {
+        size_t frame_idx = 0;
+        size_t x_size = 0;
+        size_t rows = 0;
+        size_t words_per_row = 0;
+        size_t shapes = 0;
+        size_t max_runs = 0;            // most in_label runs on one row
+        std::vector<uint64_t> bits;     // pixel (x, y): bit x % 64 of row(y)[x / 64]
+
+        const uint64_t *row(size_t y) const noexcept {
+            return bits.data() + y * words_per_row;
+        }
+
+        // Calls fn(x_begin, x_end) for every in_label run of row y, left
+        // to right.
+        template<typename fn_t>
+        void runs(size_t y, fn_t &&fn) const {
+            const uint64_t *w = row(y);
+            size_t x = find(w, 0, true);
+            while (x < x_size) {
+                const size_t x_end = find(w, x, false);
+                fn(x, x_end);
+                x = find(w, x_end, true);
+            }
+        }
+
+    private:
+        // First pixel at or after x that is set (or clear), x_size if none.
+        size_t find(const uint64_t *w, size_t x, bool set) const noexcept {
+            size_t i = x / 64;
+            if (i >= words_per_row)
+                return x_size;
+            uint64_t word = (set ? w[i] : ~w[i]) & (~uint64_t(0) << (x % 64));
+            while (!word) {
+                if (++i == words_per_row)
+                    return x_size;
+                word = set ? w[i] : ~w[i];
+            }
+            return std::min(i * 64 + std::countr_zero(word), x_size);
+        }
+    };
+
+    StressScenes(const Options &options, size_t x_size, size_t y_size)
+        : options_(options), x_size_(x_size)
+    {
+        options_.rows = std::clamp<size_t>(options_.rows, 1, y_size);
+        if (!options_.workers)
+            options_.workers = std::max(2u, std::thread::hardware_concurrency()) - 1;
+        if (!options_.ring_frames)
+            options_.ring_frames = 2 * options_.workers;
+
+        ring_size_ = options_.ring_frames;
+        slots_ = std::make_unique<Slot[]>(ring_size_);
+        for (size_t s = 0; s < ring_size_; s++)
+            slots_[s].free.store(s, std::memory_order_relaxed);
+        for (size_t w = 0; w < options_.workers; w++)
+            workers_.emplace_back([this] { work(); });
+    }
+
+    ~StressScenes() {
+        for (size_t s = 0; s < ring_size_; s++) {
+            slots_[s].free.store(STOP, std::memory_order_release);
+            slots_[s].free.notify_all();
+        }
+        for (auto &worker : workers_)
+            worker.join();
+    }
+
+    StressScenes(const StressScenes &) = delete;
+    StressScenes &operator=(const StressScenes &) = delete;
+
+    // Next frame in order, nullptr after the last one. Hand it back with
+    // release() before the next call.
+    const Frame *next() {
+        if (options_.frames && consumed_ == options_.frames)
+            return nullptr;
+        Slot &slot = slots_[consumed_ % ring_size_];
+        const uint64_t ready = consumed_ + 1;
+        uint64_t v = slot.ready.load(std::memory_order_acquire);
+        if (v != ready) {
+            const auto t0 = std::chrono::steady_clock::now();
+            while (v != ready) {
+                slot.ready.wait(v, std::memory_order_acquire);
+                v = slot.ready.load(std::memory_order_acquire);
+            }
+            wait_ns_ += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+            waits_++;
+        }
+        max_runs_ = std::max(max_runs_, slot.frame.max_runs);
+        return &slot.frame;
+    }
+
+    void release(const Frame *frame) {
+        Slot &slot = slots_[frame->frame_idx % ring_size_];
+        slot.free.store(frame->frame_idx + ring_size_, std::memory_order_release);
+        slot.free.notify_all();
+        consumed_++;
+    }
+
+    const Options &options() const noexcept {
+        return options_;
+    }
+
+    // Render and ring statistics of the frames handed out so far.
+    void report(std::ostream &os) const {
+        const double render_ms = render_ns_.load(std::memory_order_relaxed) / 1e6;
+        const uint64_t rendered = rendered_.load(std::memory_order_relaxed);
+        const auto flags = os.flags();
+        const auto precision = os.precision();
+        os << std::fixed << std::setprecision(2);
+        os << "Scenes: seed " << options_.seed << ", " << profile_name(options_.profile) << ", " << consumed_
+           << " frames of " << x_size_ << " x " << options_.rows << ", max " << max_runs_ << " runs on a row\n";
+        os << "Scenes: " << options_.workers << " workers, ring of " << ring_size_ << ", "
+           << (rendered ? render_ms / rendered : 0.0) << " ms render per frame, driver waited "
+           << waits_ << " times, " << wait_ns_ / 1e6 << " ms\n";
+        os.flags(flags);
+        os.precision(precision);
+    }
+
+    static const char *profile_name(Profile profile) noexcept {
+        switch (profile) {
+        case Profile::UNIFORM: return "uniform";
+        case Profile::RAMP:    return "ramp";
+        case Profile::BANDS:   return "bands";
+        case Profile::WORST:   return "worst";
+        }
+        return "unknown";
+    }
+
+    // False if name is not a profile.
+    static bool parse_profile(const std::string &name, Profile &profile) noexcept {
+        for (Profile p : {Profile::UNIFORM, Profile::RAMP, Profile::BANDS, Profile::WORST}) {
+            if (name == profile_name(p)) {
+                profile = p;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Renders frame frame_idx of the scene sequence into frame.
+    static void render(const Options &options, size_t x_size, size_t frame_idx, Frame &frame) {
+        frame.frame_idx = frame_idx;
+        frame.x_size = x_size;
+        frame.rows = options.rows;
+        frame.words_per_row = (x_size + 63) / 64;
+        frame.shapes = 0;
+        frame.bits.assign(frame.rows * frame.words_per_row, 0);
+
+        Rng rng(options.seed ^ (frame_idx + 1) * 0x9e3779b97f4a7c15ull);
+        const size_t rows = frame.rows;
+        auto density = [&](size_t y) { return row_density(options.profile, double(y) / rows); };
+
+        // One shape per ~2500 pixels at full density.
+        const size_t candidates = x_size * rows / 2500 + 1;
+        for (size_t i = 0; i < candidates; i++) {
+            const double cx = rng.range(0, x_size);
+            const double cy = rng.range(0, rows);
+            if (rng.uniform() >= density(size_t(cy)))
+                continue;
+            frame.shapes++;
+
+            const double pick = rng.uniform();
+            if (pick < 0.30) {
+                const Ellipse e(cx, cy, rng.range(3, 40), rng.range(3, 40), rng.range(0, std::numbers::pi));
+                draw(frame, e, nullptr);
+            } else if (pick < 0.45) {
+                // Ring: the same ellipse scaled down cut out of the middle.
+                const double a = rng.range(8, 48), b = rng.range(8, 48), t = rng.range(0, std::numbers::pi);
+                const double k = rng.range(0.4, 0.8);
+                const Ellipse outer(cx, cy, a, b, t), inner(cx, cy, a * k, b * k, t);
+                draw(frame, outer, &inner);
+            } else if (pick < 0.60) {
+                // Crescent: an ellipse minus a shifted copy.
+                const double r = rng.range(8, 40), t = rng.range(0, 2 * std::numbers::pi);
+                const double shift = r * rng.range(0.3, 0.7);
+                const Ellipse outer(cx, cy, r, r * rng.range(0.7, 1.0), 0);
+                const Ellipse inner(cx + shift * std::cos(t), cy + shift * std::sin(t), r, r, 0);
+                draw(frame, outer, &inner);
+            } else if (pick < 0.75) {
+                const size_t teeth = 2 + rng.below(12);
+                const size_t width = 1 + rng.below(4);
+                draw_comb(frame, rng, size_t(cx), size_t(cy), teeth, width, 1 + rng.below(4),
+                          4 + rng.below(40), 1 + rng.below(3));
+            } else {
+                // Chain of blobs, each touching the previous one.
+                double x = cx, y = cy, r = rng.range(3, 15);
+                double heading = rng.range(0, 2 * std::numbers::pi);
+                for (size_t n = 2 + rng.below(7); n--; ) {
+                    draw(frame, Ellipse(x, y, r, r, 0), nullptr);
+                    const double r_next = rng.range(3, 15);
+                    heading += rng.range(-0.8, 0.8);
+                    x += (r + r_next) * std::cos(heading);
+                    y += (r + r_next) * std::sin(heading);
+                    r = r_next;
+                }
+            }
+        }
+
+        // Speckle: single pixels, now and then a pair.
+        const size_t speckle = x_size * rows / (options.profile == Profile::WORST ? 32 : 256);
+        for (size_t i = 0; i < speckle; i++) {
+            const size_t y = rng.below(rows);
+            if (rng.uniform() >= density(y))
+                continue;
+            const size_t x = rng.below(x_size);
+            fill(frame, y, x, x + 1 + (rng.below(4) == 0));
+        }
+
+        if (options.profile == Profile::WORST) {
+            // 1-pixel teeth and gaps over the full width, spine below,
+            // drawn last on cleared rows: nothing fills the gaps, and the
+            // blank row above keeps the teeth separate labels.
+            for (size_t y = 0; y + 24 < rows; y += 64) {
+                clear(frame, long(y) - 1, long(y + 17));
+                draw_comb(frame, rng, 0, y, x_size / 2, 1, 1, 16, 1, false);
+            }
+        }
+
+        frame.max_runs = 0;
+        for (size_t y = 0; y < rows; y++) {
+            const uint64_t *w = frame.row(y);
+            size_t runs = 0;
+            uint64_t carry = 0;
+            for (size_t i = 0; i < frame.words_per_row; i++) {
+                runs += std::popcount(w[i] & ~(w[i] << 1 | carry));
+                carry = w[i] >> 63;
+            }
+            frame.max_runs = std::max(frame.max_runs, runs);
+        }
+    }
+
+private:
+    static constexpr uint64_t STOP = ~uint64_t(0);
+
+    struct Slot {
+        Frame frame;
+        std::atomic<uint64_t> free{0};      // frame index the slot takes next
+        std::atomic<uint64_t> ready{0};     // frame index + 1 once rendered
+    };
+
+    // splitmix64
+    struct Rng {
+        uint64_t state;
+
+        explicit Rng(uint64_t seed) : state(seed) {}
+
+        uint64_t next() noexcept {
+            uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+            return z ^ (z >> 31);
+        }
+        double uniform() noexcept { return (next() >> 11) * 0x1.0p-53; }
+        double range(double lo, double hi) noexcept { return lo + (hi - lo) * uniform(); }
+        size_t below(size_t n) noexcept { return n ? next() % n : 0; }
+    };
+
+    // Rotated ellipse: pixel (x, y) is inside if
+    // A dx^2 + B dx dy + C dy^2 <= 1, with dx = x - cx, dy = y - cy.
+    struct Ellipse {
+        double cx, cy;
+        double A, B, C;
+        double half_height;
+
+        Ellipse(double cx_, double cy_, double a, double b, double t) : cx(cx_), cy(cy_) {
+            const double c = std::cos(t), s = std::sin(t);
+            A = c * c / (a * a) + s * s / (b * b);
+            B = 2 * c * s * (1 / (a * a) - 1 / (b * b));
+            C = s * s / (a * a) + c * c / (b * b);
+            half_height = std::sqrt(A / (A * C - B * B / 4));
+        }
+
+        // Pixels [x_begin, x_end) of row y inside; false if none.
+        bool span(double y, long &x_begin, long &x_end) const noexcept {
+            const double dy = y - cy;
+            const double disc = B * B * dy * dy - 4 * A * (C * dy * dy - 1);
+            if (disc < 0)
+                return false;
+            const double root = std::sqrt(disc);
+            x_begin = long(std::ceil(cx + (-B * dy - root) / (2 * A)));
+            x_end = long(std::floor(cx + (-B * dy + root) / (2 * A))) + 1;
+            return x_begin < x_end;
+        }
+    };
+
+    static double row_density(Profile profile, double y) noexcept {
+        switch (profile) {
+        case Profile::RAMP:  return y;
+        case Profile::BANDS: return (size_t(y * 8) & 1) ? 0.05 : 1.0;
+        default:             return 1.0;
+        }
+    }
+
+    // Sets pixels [x_begin, x_end) of row y, clipped to the frame.
+    static void fill(Frame &frame, long y, long x_begin, long x_end) noexcept {
+        if (y < 0 || size_t(y) >= frame.rows)
+            return;
+        const size_t x0 = size_t(std::max(x_begin, 0L));
+        const size_t x1 = std::min(size_t(std::max(x_end, 0L)), frame.x_size);
+        if (x0 >= x1)
+            return;
+        uint64_t *w = frame.bits.data() + y * frame.words_per_row;
+        const size_t i0 = x0 / 64, i1 = (x1 - 1) / 64;
+        const uint64_t first = ~uint64_t(0) << (x0 % 64);
+        const uint64_t last = ~uint64_t(0) >> (63 - (x1 - 1) % 64);
+        if (i0 == i1) {
+            w[i0] |= first & last;
+            return;
+        }
+        w[i0] |= first;
+        for (size_t i = i0 + 1; i < i1; i++)
+            w[i] = ~uint64_t(0);
+        w[i1] |= last;
+    }
+
+    // Clears rows [y_begin, y_end), clipped to the frame.
+    static void clear(Frame &frame, long y_begin, long y_end) noexcept {
+        const size_t y0 = size_t(std::max(y_begin, 0L));
+        const size_t y1 = std::min(size_t(std::max(y_end, 0L)), frame.rows);
+        if (y0 < y1)
+            std::fill(frame.bits.begin() + y0 * frame.words_per_row, frame.bits.begin() + y1 * frame.words_per_row, 0);
+    }
+
+    // outer, minus inner if given.
+    static void draw(Frame &frame, const Ellipse &outer, const Ellipse *inner) noexcept {
+        const long y0 = long(std::ceil(outer.cy - outer.half_height));
+        const long y1 = long(std::floor(outer.cy + outer.half_height));
+        for (long y = std::max(y0, 0L); y <= y1 && size_t(y) < frame.rows; y++) {
+            long o0, o1, i0, i1;
+            if (!outer.span(y, o0, o1))
+                continue;
+            if (inner && inner->span(y, i0, i1) && i0 < o1 && i1 > o0) {
+                fill(frame, y, o0, i0);
+                fill(frame, y, i1, o1);
+            } else {
+                fill(frame, y, o0, o1);
+            }
+        }
+    }
+
+    // Teeth hanging from a spine below them (a staircase of tooth
+    // heights unless even): every tooth opens a label, the spine merges
+    // them all.
+    static void draw_comb(Frame &frame, Rng &rng, size_t x, size_t y, size_t teeth, size_t width, size_t gap,
+                          size_t height, size_t spine, bool uneven = true) noexcept {
+        const size_t pitch = width + gap;
+        for (size_t t = 0; t < teeth; t++) {
+            const size_t top = uneven ? rng.below(height / 2 + 1) : 0;
+            for (size_t r = top; r < height; r++)
+                fill(frame, long(y + r), long(x + t * pitch), long(x + t * pitch + width));
+        }
+        for (size_t r = 0; r < spine; r++)
+            fill(frame, long(y + height + r), long(x), long(x + teeth * pitch - gap));
+    }
+
+    void work() {
+        for (;;) {
+            const size_t n = next_frame_.fetch_add(1, std::memory_order_relaxed);
+            if (options_.frames && n >= options_.frames)
+                return;
+            Slot &slot = slots_[n % ring_size_];
+            for (uint64_t v = slot.free.load(std::memory_order_acquire); v != n;
+                 v = slot.free.load(std::memory_order_acquire)) {
+                if (v == STOP)
+                    return;
+                slot.free.wait(v, std::memory_order_acquire);
+            }
+
+            const auto t0 = std::chrono::steady_clock::now();
+            render(options_, x_size_, n, slot.frame);
+            render_ns_.fetch_add(uint64_t(std::chrono::duration<double, std::nano>(
+                std::chrono::steady_clock::now() - t0).count()), std::memory_order_relaxed);
+            rendered_.fetch_add(1, std::memory_order_relaxed);
+
+            slot.ready.store(n + 1, std::memory_order_release);
+            slot.ready.notify_one();
+        }
+    }
+
+    Options options_;
+    size_t x_size_;
+    size_t ring_size_ = 0;
+    std::unique_ptr<Slot[]> slots_;
+    std::vector<std::thread> workers_;
+
+    std::atomic<size_t> next_frame_{0};
+    std::atomic<uint64_t> render_ns_{0};
+    std::atomic<uint64_t> rendered_{0};
+
+    // Driver side
+    size_t consumed_ = 0;
+    size_t max_runs_ = 0;
+    uint64_t waits_ = 0;
+    double wait_ns_ = 0;
+};
@@ -0,0 +1,856 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <iostream>
+#include <chrono>
+#include <atomic>
+#include <thread>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <span>
+#include <type_traits>
+
+#include <util/WideUint.h>
+#include <util/SpscRing.h>
+
+#include <emulator/shadow.h>
+#include <emulator/fields_linkruncca.h>
+#include <emulator/hw_access_model.h>
+#include <emulator/bit_slicer.h>
+#include <emulator/fields.h>
+#include <emulator/emulator_fields.h>
+
+#include "StimulusFile.h"
+#include "ImageSequence.h"
+#include "StressScene.h"
+#include "DutGeometry.h"
+
+// ------------------------------------------------------------
+// TEST SCENE AND RUN LOOPS OF fpga_app
+// ------------------------------------------------------------
+//
+// Shared by fpga_app (src/DutApp.cpp) and fpga_bench (bench/).
+// Define DEBUG_PRINT before including to print frame headers. The DUT
+// geometry llcca_gens comes from DutGeometry.h.
+//
+
+inline namespace DUT_NAMESPACE {
+
+using app_fields_t = fields_linkruncca<llcca_gens>;
+
+using ModelBackendType = hw_access_model<app_fields_t>;
+
+using wr_add = typename app_fields_t::wr_fields;
+using rd_add = typename app_fields_t::rd_fields;
+
+enum ObjectType {
+    CIRCLE,
+    SQUARE,
+};
+
+struct ObjectBase {
+    virtual ~ObjectBase() = default;
+    virtual bool pixel(size_t x, size_t y) const = 0;
+    // Rows [y_begin(), y_end()) bound the object.
+    virtual size_t y_begin() const = 0;
+    virtual size_t y_end() const = 0;
+    // Pixels [x_begin, x_end) of row y that pixel() accepts; false if none.
+    virtual bool span(size_t y, size_t &x_begin, size_t &x_end) const = 0;
+};
+
+struct CircleData: ObjectBase {
+    size_t x;
+    size_t y;
+    size_t radius;
+    CircleData(size_t x_, size_t y_, size_t radius_) : x(x_), y(y_), radius(radius_) {}
+    bool pixel(size_t x, size_t y) const override {
+        long dx = static_cast<long>(x) - static_cast<long>(this->x);
+        long dy = static_cast<long>(y) - static_cast<long>(this->y);
+        long r = static_cast<long>(radius);
+        return (dx*dx + dy*dy) <= (r * r);
+    }
+    size_t y_begin() const override {
+        return y > radius ? y - radius : 0;
+    }
+    size_t y_end() const override {
+        return y + radius + 1;
+    }
+    bool span(size_t y, size_t &x_begin, size_t &x_end) const override {
+        long dy = static_cast<long>(y) - static_cast<long>(this->y);
+        long r = static_cast<long>(radius);
+        long h = r*r - dy*dy;
+        if (h < 0)
+            return false;
+        long dx = static_cast<long>(std::sqrt(static_cast<double>(h)));
+        while (dx*dx > h)
+            dx--;
+        while ((dx+1)*(dx+1) <= h)
+            dx++;
+        long cx = static_cast<long>(this->x);
+        x_begin = static_cast<size_t>(std::max(cx - dx, 0L));
+        x_end = static_cast<size_t>(cx + dx + 1);
+        return true;
+    }
+};
+
+struct SquareData: ObjectBase {
+    size_t x;
+    size_t y;
+    size_t side_length;
+    SquareData(size_t x_, size_t y_, size_t side_length_) : x(x_), y(y_), side_length(side_length_) {}
+    bool pixel(size_t x, size_t y) const override {
+        return (x >= this->x && x < this->x + side_length &&
+                y >= this->y && y < this->y + side_length);
+    }
+    size_t y_begin() const override {
+        return y;
+    }
+    size_t y_end() const override {
+        return y + side_length;
+    }
+    bool span(size_t y, size_t &x_begin, size_t &x_end) const override {
+        if (y < this->y || y >= this->y + side_length || side_length == 0)
+            return false;
+        x_begin = x;
+        x_end = x + side_length;
+        return true;
+    }
+};
+
+struct Collect_t {
+    bool in_label;
+    size_t x;
+    size_t y;
+    bool has_red;
+    bool has_green;
+    bool has_blue;
+};
+
+using llcca_consts = app_fields_t::FpgaConstants;
+
+struct Feature_t {
+    bool valid;
+    size_t x_left;
+    size_t x_right;
+    size_t y_top_seg_0;
+    size_t y_top_seg_1;
+    size_t y_bottom_seg_0;
+    size_t y_bottom_seg_1;
+    FpgaUint<llcca_consts::X2_SUM_BITS> x2_sum;
+    FpgaUint<llcca_consts::YLOW2_SUM_BITS> ylow2_sum;
+    FpgaUint<llcca_consts::XYLOW_SUM_BITS> xylow_sum;
+    FpgaUint<llcca_consts::X_SEG_SUM_BITS> x_seg0_sum;
+    FpgaUint<llcca_consts::X_SEG_SUM_BITS> x_seg1_sum;
+    FpgaUint<llcca_consts::YLOW_SEG_SUM_BITS> ylow_seg0_sum;
+    FpgaUint<llcca_consts::YLOW_SEG_SUM_BITS> ylow_seg1_sum;
+    FpgaUint<llcca_consts::N_SEG_SUM_BITS> n_seg0_sum;
+    FpgaUint<llcca_consts::N_SEG_SUM_BITS> n_seg1_sum;
+};
+
+// A frame of objects. Rasterize() converts it once into sorted, merged
+// in_label spans per row (rows repeat every repeat_y), so a scanline
+// costs its number of spans instead of pixels x objects virtual calls.
+class TestFrame {
+public:
+    using Objects = std::vector<std::unique_ptr<ObjectBase>>;
+
+    struct Span {
+        uint32_t x_begin;
+        uint32_t x_end;
+    };
+
+private:
+    Objects objects_;
+
+    size_t x_size_ = 0;
+    size_t repeat_y_ = 0;
+    std::vector<uint32_t> row_offsets_;     // spans of row y: [row_offsets_[y], row_offsets_[y+1])
+    std::vector<Span> spans_;
+
+public:
+    TestFrame(Objects objects)
+        : objects_(std::move(objects))
+    {}
+
+    // Builds the span index for rows [0, repeat_y) clipped to [0, x_size).
+    // Objects are bucketed by the rows of their bounding box, so only the
+    // objects crossing a row are asked for its span.
+    void Rasterize(size_t x_size, size_t repeat_y) {
+        x_size_ = x_size;
+        repeat_y_ = repeat_y;
+
+        std::vector<std::vector<Span>> rows(repeat_y);
+        for(const auto& obj : objects_) {
+            const size_t y_end = std::min(obj->y_end(), repeat_y);
+            for(size_t y = obj->y_begin(); y < y_end; ++y) {
+                size_t x_begin, x_end;
+                if(!obj->span(y, x_begin, x_end))
+                    continue;
+                x_end = std::min(x_end, x_size);
+                if(x_begin < x_end)
+                    rows[y].push_back(Span{static_cast<uint32_t>(x_begin), static_cast<uint32_t>(x_end)});
+            }
+        }
+
+        row_offsets_.assign(1, 0);
+        spans_.clear();
+        for(auto& row : rows) {
+            std::sort(row.begin(), row.end(), [](const Span& a, const Span& b) { return a.x_begin < b.x_begin; });
+            for(const Span& span : row) {
+                if(spans_.size() > row_offsets_.back() && span.x_begin <= spans_.back().x_end)
+                    spans_.back().x_end = std::max(spans_.back().x_end, span.x_end);
+                else
+                    spans_.push_back(span);
+            }
+            row_offsets_.push_back(static_cast<uint32_t>(spans_.size()));
+        }
+    }
+
+    bool Rasterized(size_t x_size, size_t repeat_y) const {
+        return repeat_y_ == repeat_y && x_size_ == x_size;
+    }
+
+    // in_label spans of row y, after Rasterize().
+    std::span<const Span> Spans(size_t y) const {
+        y %= repeat_y_;
+        return std::span<const Span>(spans_.data() + row_offsets_[y], spans_.data() + row_offsets_[y+1]);
+    }
+
+    // Expands row y into one in_label byte per pixel, after Rasterize().
+    void GetRow(size_t y, uint8_t *labels) const {
+        std::memset(labels, 0, x_size_);
+        for(const Span& span : Spans(y))
+            std::memset(labels + span.x_begin, 1, span.x_end - span.x_begin);
+    }
+
+    Collect_t GetPixel(size_t x, size_t y, size_t repeat_y) const {
+        if(x < x_size_ && repeat_y == repeat_y_) {
+            auto spans = Spans(y);
+            auto it = std::upper_bound(spans.begin(), spans.end(), x,
+                                       [](size_t x, const Span& span) { return x < span.x_end; });
+            const bool in_label = it != spans.end() && x >= it->x_begin;
+            return Collect_t{in_label, x, y, false, false, false};
+        }
+        for(const auto& obj : objects_) {
+            if(obj->pixel(x, y % repeat_y)) {
+                return Collect_t{true, x, y, false, false, false};
+            }
+        }
+        return Collect_t{false, x, y, false, false, false};
+    }
+};
+
+class TestFrames {
+private:
+    std::vector<TestFrame> frames_;
+public:
+    TestFrames(size_t x_size, size_t y_size, size_t repeat_y_size)
+        : x_size(x_size), y_size(y_size), repeat_y(repeat_y_size)
+    {
+        // Create some test frames with objects
+        for(size_t f = 0; f < 10; ++f) {
+            TestFrame::Objects objects;
+            objects.push_back(std::make_unique<CircleData>(20 + f*40, 20 + f*3, 12));
+            objects.push_back(std::make_unique<SquareData>(30 + f*30,  30 + f*2, 10));
+            frames_.emplace_back(std::move(objects));
+            frames_.back().Rasterize(x_size, repeat_y);
+        }
+    }
+
+    TestFrame& GetFrame(size_t index) {
+        return frames_[index % frames_.size()];
+    }
+
+    const TestFrame& GetFrame(size_t index) const {
+        return frames_[index % frames_.size()];
+    }
+
+    Collect_t GetPixel(size_t frame_index, size_t x, size_t y) const {
+        return frames_[frame_index % frames_.size()].GetPixel(x, y, repeat_y);
+    }
+
+    const size_t x_size;
+    const size_t y_size;
+    const size_t repeat_y;
+};
+
+template<typename iface_t>
+void WrEmulationData(iface_t &iface, Collect_t &data) {
+    iface.template wr_field<wr_add::RST>(0);
+    iface.template wr_field<wr_add::DATAVALID>(1);
+    iface.template wr_field<wr_add::IN_LABEL>(data.in_label ? 1 : 0);
+    iface.template wr_field<wr_add::X>(data.x);
+    iface.template wr_field<wr_add::Y>(data.y);
+    iface.template wr_field<wr_add::HAS_RED>(data.has_red ? 1 : 0);
+    iface.template wr_field<wr_add::HAS_GREEN>(data.has_green ? 1 : 0);
+    iface.template wr_field<wr_add::HAS_BLUE>(data.has_blue ? 1 : 0);
+
+    iface.wr_flush();
+    iface.wr_raw(0, (uint32_t)1);
+}
+
+template<typename stimulus_t>
+void CompileEmulationData(stimulus_t &stimulus, const Collect_t &data) {
+    stimulus.template wr_field<wr_add::RST>(0);
+    stimulus.template wr_field<wr_add::DATAVALID>(1);
+    stimulus.template wr_field<wr_add::IN_LABEL>(data.in_label ? 1 : 0);
+    stimulus.template wr_field<wr_add::X>(data.x);
+    stimulus.template wr_field<wr_add::Y>(data.y);
+    stimulus.template wr_field<wr_add::HAS_RED>(data.has_red ? 1 : 0);
+    stimulus.template wr_field<wr_add::HAS_GREEN>(data.has_green ? 1 : 0);
+    stimulus.template wr_field<wr_add::HAS_BLUE>(data.has_blue ? 1 : 0);
+
+    stimulus.clock();
+}
+
+// Packs rows [y_begin, y_end) of a frame into register images, one clock per pixel.
+// Each row is emitted as background and in_label runs from the span index.
+template<typename stimulus_t>
+void CompileFrame(stimulus_t &stimulus, const TestFrames &test_frames, size_t frame_idx, size_t y_begin, size_t y_end) {
+    const TestFrame &frame = test_frames.GetFrame(frame_idx);
+    for(size_t y = y_begin; y < y_end; ++y) {
+        size_t x = 0;
+        auto emit = [&](size_t x_end, bool in_label) {
+            for(; x < x_end; ++x)
+                CompileEmulationData(stimulus, Collect_t{in_label, x, y, false, false, false});
+        };
+        for(const TestFrame::Span &span : frame.Spans(y)) {
+            emit(span.x_begin, false);
+            emit(span.x_end, true);
+        }
+        emit(test_frames.x_size, false);
+    }
+}
+
+// Reads all feature fields except VALID. Works on emulator_fields and on result_image.
+template<typename src_t>
+void RdFeatureFields(src_t &src, Feature_t &data) {
+    src.template rd_field<rd_add::X_LEFT>(data.x_left);
+    src.template rd_field<rd_add::X_RIGHT>(data.x_right);
+    src.template rd_field<rd_add::Y_TOP_SEG_0>(data.y_top_seg_0);
+    src.template rd_field<rd_add::Y_TOP_SEG_1>(data.y_top_seg_1);
+    src.template rd_field<rd_add::Y_BOTTOM_SEG_0>(data.y_bottom_seg_0);
+    src.template rd_field<rd_add::Y_BOTTOM_SEG_1>(data.y_bottom_seg_1);
+    src.template rd_field<rd_add::X2_SUM>(data.x2_sum);
+    src.template rd_field<rd_add::YLOW2_SUM>(data.ylow2_sum);
+    src.template rd_field<rd_add::XYLOW_SUM>(data.xylow_sum);
+    src.template rd_field<rd_add::X_SEG0_SUM>(data.x_seg0_sum);
+    src.template rd_field<rd_add::X_SEG1_SUM>(data.x_seg1_sum);
+    src.template rd_field<rd_add::YLOW_SEG0_SUM>(data.ylow_seg0_sum);
+    src.template rd_field<rd_add::YLOW_SEG1_SUM>(data.ylow_seg1_sum);
+    src.template rd_field<rd_add::N_SEG0_SUM>(data.n_seg0_sum);
+    src.template rd_field<rd_add::N_SEG1_SUM>(data.n_seg1_sum);
+}
+
+template<typename iface_t>
+bool RdEmulationData(iface_t &iface, Feature_t &data) {
+    iface.rd_flush();
+    iface.template rd_field<rd_add::VALID>(data.valid);
+    if(data.valid)
+        RdFeatureFields(iface, data);
+    return data.valid;
+}
+
+inline void PrintFeature(uint64_t clk_cnt, const Feature_t &feature) {
+    std::cout << "FEATURE:";
+    std::cout << "\n  clk_cnt = " << clk_cnt << "\n  X_LEFT: " << feature.x_left << "\n  X_RIGHT: " << feature.x_right;
+    std::cout << "\n  y_top_seg_0 = " << feature.y_top_seg_0 << "\n  y_bottom_seg_0 = " << feature.y_bottom_seg_0;
+    std::cout << "\n  y_top_seg_1 = " << feature.y_top_seg_1 << "\n  y_bottom_seg_1 = " << feature.y_bottom_seg_1;
+
+    std::cout << "\n\n";
+}
+
+template<typename iface_t>
+void ResetEmulation(iface_t &iface, size_t x_size) {
+    iface.template wr_field<wr_add::RST>(1);
+    iface.template wr_field<wr_add::DATAVALID>(1);
+    iface.wr_flush();
+    for(size_t i=0; i < 2*x_size; i++)
+        iface.wr_raw(0, (uint32_t)1);
+    iface.template wr_field<wr_add::RST>(0);
+    iface.template wr_field<wr_add::DATAVALID>(0);
+    iface.wr_flush();
+    iface.wr_raw(0, (uint32_t)1);
+}
+
+inline void PrintSpeed(uint64_t clk_cnt, std::chrono::steady_clock::time_point t0) {
+    auto t1 = std::chrono::steady_clock::now();
+    double usec = std::chrono::duration<double, std::micro>(t1 - t0).count();
+    double mhz  = clk_cnt / usec;
+
+    std::cerr << "Emulation ended\n";
+    std::cerr << "Processed " << clk_cnt << " clock cycles\n";
+    std::cerr << "Elapsed time: " << usec << " us\n";
+    std::cerr << "Speed: " << mhz << " MHz\n";
+}
+
+// Default report of TestRun: frame headers and features to stdout,
+// speed to stderr.
+struct PrintReport {
+    void frame([[maybe_unused]] size_t frame_idx) {
+#ifdef DEBUG_PRINT
+        std::cout << "Frame " << frame_idx << ":\n";
+#endif
+    }
+    void feature(uint64_t clk_cnt, const Feature_t &feature) {
+        PrintFeature(clk_cnt, feature);
+    }
+    void speed(uint64_t clk_cnt, std::chrono::steady_clock::time_point t0) {
+        PrintSpeed(clk_cnt, t0);
+    }
+};
+
+// A report with `static constexpr bool per_cycle_reads = false` (see
+// ResultCrc.h) only gets frame() and speed() calls: the run loops then
+// pulse clocks without reading VALID after each one.
+template<typename report_t>
+constexpr bool PerCycleReads() {
+    if constexpr (requires { std::remove_cvref_t<report_t>::per_cycle_reads; })
+        return std::remove_cvref_t<report_t>::per_cycle_reads;
+    else
+        return true;
+}
+
+// Reads the result of the last clock and reports it if VALID is set.
+template<typename iface_t, typename report_t>
+inline void RdReport(iface_t &iface, uint64_t clk_cnt, report_t &report) {
+    if constexpr (PerCycleReads<report_t>()) {
+        Feature_t feature;
+        if(RdEmulationData(iface, feature))
+            report.feature(clk_cnt, feature);
+    }
+}
+
+template<typename iface_t, typename report_t = PrintReport>
+uint64_t TestRun(iface_t &iface, uint64_t max_clk_cnt = 50000000, report_t &&report = report_t{}) {
+    const size_t frames = 1;
+    const size_t x_size = llcca_gens.X_SIZE;
+    const size_t y_bits = llcca_gens.Y_BITS;
+    const size_t y_size = (size_t)1 << y_bits;
+    const size_t repeat_y_size = 512;
+
+    using clock = std::chrono::steady_clock;
+
+    auto t0 = clock::now();    
+
+    TestFrames test_frames(x_size, y_size, repeat_y_size);
+
+    ResetEmulation(iface, x_size);
+
+    // Stimulus is compiled and replayed in chunks of rows to bound memory.
+    const size_t rows_per_chunk = 64;
+    typename iface_t::stimulus_t stimulus;
+    stimulus.reserve(rows_per_chunk * x_size);
+
+    uint64_t clk_cnt = 0;
+    for(size_t frame_idx = 0; frame_idx < frames; ++frame_idx) {
+        report.frame(frame_idx);
+        for(size_t y = 0; y < y_size && clk_cnt < max_clk_cnt; y += rows_per_chunk) {
+            stimulus.clear();
+            CompileFrame(stimulus, test_frames, frame_idx, y, std::min(y + rows_per_chunk, y_size));
+
+            iface.replay(stimulus, [&](size_t) {
+                clk_cnt++;
+                RdReport(iface, clk_cnt, report);
+                return clk_cnt < max_clk_cnt;
+            });
+        }
+    }
+
+    report.speed(clk_cnt, t0);
+    return clk_cnt;
+}
+
+// Same run as TestRun, split over three threads connected by SPSC rings:
+//   generator - compiles stimulus chunks into a fixed pool of stimulus_images,
+//   driver    - only replays stimulus, polls VALID and captures result words,
+//   consumer  - decodes captured results and prints features.
+// The driver thread does no allocation and no I/O.
+template<typename iface_t>
+uint64_t TestRunPipelined(iface_t &iface, uint64_t max_clk_cnt = 50000000) {
+    const size_t frames = 1;
+    const size_t x_size = llcca_gens.X_SIZE;
+    const size_t y_bits = llcca_gens.Y_BITS;
+    const size_t y_size = (size_t)1 << y_bits;
+    const size_t repeat_y_size = 512;
+    const size_t rows_per_chunk = 64;
+
+    using stimulus_t = typename iface_t::stimulus_t;
+    using result_t = typename iface_t::result_t;
+
+    struct StimulusChunk {
+        stimulus_t stimulus;
+        size_t frame_idx;
+        bool frame_start;
+    };
+
+    struct ResultRecord {
+        enum Kind { FRAME, FEATURE, END } kind;
+        size_t frame_idx;
+        uint64_t clk_cnt;
+        result_t result;
+    };
+
+    static constexpr size_t pool_size = 4;
+
+    auto t0 = std::chrono::steady_clock::now();
+
+    TestFrames test_frames(x_size, y_size, repeat_y_size);
+
+    std::vector<std::unique_ptr<StimulusChunk>> pool;
+    SpscRing<StimulusChunk *, pool_size> free_chunks;
+    SpscRing<StimulusChunk *, pool_size * 2> filled_chunks;
+    auto results = std::make_unique<SpscRing<ResultRecord, 4096>>();
+    std::atomic<bool> stop{false};
+
+    for(size_t i = 0; i < pool_size; i++) {
+        pool.push_back(std::make_unique<StimulusChunk>());
+        pool.back()->stimulus.reserve(rows_per_chunk * x_size);
+        free_chunks.push(pool.back().get());
+    }
+
+    ResetEmulation(iface, x_size);
+
+    std::thread generator([&] {
+        for(size_t frame_idx = 0; frame_idx < frames; ++frame_idx) {
+            for(size_t y = 0; y < y_size; y += rows_per_chunk) {
+                StimulusChunk *chunk;
+                while(!free_chunks.try_pop(chunk)) {
+                    if(stop.load(std::memory_order_relaxed))
+                        return;
+                    std::this_thread::yield();
+                }
+                chunk->frame_idx = frame_idx;
+                chunk->frame_start = (y == 0);
+                chunk->stimulus.clear();
+                CompileFrame(chunk->stimulus, test_frames, frame_idx, y, std::min(y + rows_per_chunk, y_size));
+                filled_chunks.push(chunk);
+            }
+        }
+        filled_chunks.push(nullptr);
+    });
+
+    uint64_t clk_cnt = 0;
+    std::thread driver([&] {
+        ResultRecord record;
+        StimulusChunk *chunk;
+        for(;;) {
+            filled_chunks.pop(chunk);
+            if(!chunk)
+                break;
+
+            if(chunk->frame_start) {
+                record.kind = ResultRecord::FRAME;
+                record.frame_idx = chunk->frame_idx;
+                results->push(record);
+            }
+
+            iface.replay(chunk->stimulus, [&](size_t) {
+                clk_cnt++;
+                iface.rd_flush();
+                if(iface.template rd_field<rd_add::VALID>()) {
+                    record.kind = ResultRecord::FEATURE;
+                    record.clk_cnt = clk_cnt;
+                    iface.rd_capture(record.result);
+                    results->push(record);
+                }
+                return clk_cnt < max_clk_cnt;
+            });
+
+            free_chunks.push(chunk);
+            if(clk_cnt >= max_clk_cnt)
+                break;
+        }
+        stop.store(true, std::memory_order_relaxed);
+        record.kind = ResultRecord::END;
+        results->push(record);
+    });
+
+    std::thread consumer([&] {
+        ResultRecord record;
+        for(;;) {
+            results->pop(record);
+            if(record.kind == ResultRecord::END)
+                break;
+            if(record.kind == ResultRecord::FRAME) {
+#ifdef DEBUG_PRINT
+                std::cout << "Frame " << record.frame_idx << ":\n";
+#endif
+                continue;
+            }
+            Feature_t feature;
+            feature.valid = true;
+            RdFeatureFields(record.result, feature);
+            PrintFeature(record.clk_cnt, feature);
+        }
+    });
+
+    driver.join();
+    generator.join();
+    consumer.join();
+
+    PrintSpeed(clk_cnt, t0);
+    return clk_cnt;
+}
+
+// Same run as TestRun, but through the emulator_top batch FIFOs: stimulus
+// records are queued in hw and only cycles with VALID set come back,
+// tagged with the hw DUT cycle counter.
+template<typename iface_t>
+uint64_t TestRunBatch(iface_t &iface, uint64_t max_clk_cnt = 50000000) {
+    const size_t frames = 1;
+    const size_t x_size = llcca_gens.X_SIZE;
+    const size_t y_bits = llcca_gens.Y_BITS;
+    const size_t y_size = (size_t)1 << y_bits;
+    const size_t repeat_y_size = 512;
+    const size_t rows_per_chunk = 64;
+
+    auto t0 = std::chrono::steady_clock::now();
+
+    TestFrames test_frames(x_size, y_size, repeat_y_size);
+
+    ResetEmulation(iface, x_size);
+    const uint32_t cycle0 = iface.batch_cycles();
+
+    typename iface_t::stimulus_t stimulus;
+    stimulus.reserve(rows_per_chunk * x_size);
+
+    uint64_t clk_cnt = 0;
+    for(size_t frame_idx = 0; frame_idx < frames; ++frame_idx) {
+#ifdef DEBUG_PRINT
+        std::cout << "Frame " << frame_idx << ":\n";
+#endif
+        for(size_t y = 0; y < y_size && clk_cnt < max_clk_cnt; y += rows_per_chunk) {
+            stimulus.clear();
+            CompileFrame(stimulus, test_frames, frame_idx, y, std::min(y + rows_per_chunk, y_size));
+
+            clk_cnt += iface.batch_replay(stimulus, max_clk_cnt - clk_cnt,
+                [&](uint32_t cycle, typename iface_t::result_t &result) {
+                    Feature_t feature;
+                    feature.valid = true;
+                    RdFeatureFields(result, feature);
+                    PrintFeature(static_cast<uint32_t>(cycle - cycle0), feature);
+                });
+        }
+    }
+
+    PrintSpeed(clk_cnt, t0);
+    return clk_cnt;
+}
+
+// Writes the stimulus of TestRun (reset, then frames up to max_clk_cnt
+// pixels) to a stimulus file, without driving a DUT.
+inline uint64_t RecordTestRun(StimulusWriter &writer, uint64_t max_clk_cnt = 50000000) {
+    const size_t frames = 1;
+    const size_t x_size = llcca_gens.X_SIZE;
+    const size_t y_bits = llcca_gens.Y_BITS;
+    const size_t y_size = (size_t)1 << y_bits;
+    const size_t repeat_y_size = 512;
+
+    TestFrames test_frames(x_size, y_size, repeat_y_size);
+
+    // Same clocks as ResetEmulation.
+    writer.control(true, true, 2*x_size);
+    writer.control(false, false);
+
+    uint64_t clk_cnt = 0;
+    for(size_t frame_idx = 0; frame_idx < frames; ++frame_idx) {
+        writer.frame(frame_idx);
+        for(size_t y = 0; y < y_size && clk_cnt < max_clk_cnt; ++y) {
+            size_t x = 0;
+            auto emit = [&](size_t x_end, uint32_t attrs) {
+                const size_t n = std::min<uint64_t>(x_end - x, max_clk_cnt - clk_cnt);
+                writer.pixels(x, y, attrs, n);
+                x += n;
+                clk_cnt += n;
+            };
+            for(const TestFrame::Span &span : test_frames.GetFrame(frame_idx).Spans(y)) {
+                emit(span.x_begin, 0);
+                emit(span.x_end, StimulusOp::IN_LABEL);
+            }
+            emit(x_size, 0);
+        }
+    }
+    writer.close();
+    return clk_cnt;
+}
+
+// Drives a recorded stimulus file straight from its mapping. Per pixel
+// clock only X (and Y on a new row) is written; the attributes are
+// written once per run. Throws std::runtime_error if the file was
+// recorded for another geometry. Results are read and reported as in TestRun.
+template<typename iface_t, typename report_t = PrintReport>
+uint64_t TestRunReplay(iface_t &iface, const StimulusFile &file, report_t &&report = report_t{}) {
+    const uint32_t x_size = file.header().x_size;
+    if (x_size != llcca_gens.X_SIZE || file.header().y_bits != llcca_gens.Y_BITS)
+        throw std::runtime_error("TestRunReplay: stimulus recorded for geometry " + std::to_string(x_size) + "x"
+                                 + std::to_string(file.header().y_bits) + ", DUT is "
+                                 + std::to_string(llcca_gens.X_SIZE) + "x" + std::to_string(llcca_gens.Y_BITS));
+
+    auto t0 = std::chrono::steady_clock::now();
+
+    uint32_t x = 0;
+    uint32_t y = 0;
+    uint64_t clk_cnt = 0;
+    for(const uint32_t *op = file.begin(); op != file.end(); ) {
+        const uint32_t word = *op++;
+        const uint32_t attrs = StimulusOp::attrs(word);
+        const uint32_t count = StimulusOp::count(word);
+
+        switch(StimulusOp::kind(word)) {
+        case StimulusOp::CONTROL:
+            iface.template wr_field<wr_add::RST>((attrs & StimulusOp::RST) ? 1 : 0);
+            iface.template wr_field<wr_add::DATAVALID>((attrs & StimulusOp::DATAVALID) ? 1 : 0);
+            iface.wr_flush();
+            for(uint32_t i = 0; i < count; i++)
+                iface.wr_raw(0, (uint32_t)1);
+            break;
+
+        case StimulusOp::FRAME:
+            report.frame(count);
+            x = 0;
+            y = 0;
+            break;
+
+        case StimulusOp::SEEK:
+            if(file.end() - op < 2)
+                throw std::runtime_error("TestRunReplay: truncated SEEK");
+            x = op[0];
+            y = op[1];
+            op += 2;
+            break;
+
+        case StimulusOp::PIXELS:
+            iface.template wr_field<wr_add::RST>(0);
+            iface.template wr_field<wr_add::DATAVALID>(1);
+            iface.template wr_field<wr_add::IN_LABEL>((attrs & StimulusOp::IN_LABEL) ? 1 : 0);
+            iface.template wr_field<wr_add::HAS_RED>((attrs & StimulusOp::HAS_RED) ? 1 : 0);
+            iface.template wr_field<wr_add::HAS_GREEN>((attrs & StimulusOp::HAS_GREEN) ? 1 : 0);
+            iface.template wr_field<wr_add::HAS_BLUE>((attrs & StimulusOp::HAS_BLUE) ? 1 : 0);
+            iface.template wr_field<wr_add::Y>(y);
+            for(uint32_t i = 0; i < count; i++) {
+                iface.template wr_field<wr_add::X>(x);
+                iface.wr_flush();
+                iface.wr_raw(0, (uint32_t)1);
+
+                clk_cnt++;
+                RdReport(iface, clk_cnt, report);
+
+                if(++x == x_size) {
+                    x = 0;
+                    iface.template wr_field<wr_add::Y>(++y);
+                }
+            }
+            break;
+        }
+    }
+
+    report.speed(clk_cnt, t0);
+    return clk_cnt;
+}
+
+// Same run as TestRun, on frames read from image files. Scanlines are
+// decoded ahead on the ImageSequence reader thread; this loop only
+// packs and replays them.
+template<typename iface_t, typename report_t = PrintReport>
+uint64_t TestRunImages(iface_t &iface, ImageSequence &images, uint64_t max_clk_cnt = ~uint64_t(0),
+                       report_t &&report = report_t{}) {
+    const size_t x_size = llcca_gens.X_SIZE;
+
+    auto t0 = std::chrono::steady_clock::now();
+
+    ResetEmulation(iface, x_size);
+
+    typename iface_t::stimulus_t stimulus;
+    stimulus.reserve(ImageSequence::rows_per_chunk * x_size);
+
+    uint64_t clk_cnt = 0;
+    while(ImageSequence::Chunk *chunk = images.next()) {
+        if(clk_cnt >= max_clk_cnt) {
+            images.release(chunk);
+            continue;
+        }
+        if(chunk->frame_start)
+            report.frame(chunk->frame_idx);
+        stimulus.clear();
+        const uint8_t *attrs = chunk->attrs.data();
+        for(size_t y = chunk->y_begin; y < chunk->y_begin + chunk->rows; ++y) {
+            for(size_t x = 0; x < x_size; ++x) {
+                const uint8_t a = *attrs++;
+                CompileEmulationData(stimulus, Collect_t{
+                    (a & StimulusOp::IN_LABEL) != 0, x, y,
+                    (a & StimulusOp::HAS_RED) != 0,
+                    (a & StimulusOp::HAS_GREEN) != 0,
+                    (a & StimulusOp::HAS_BLUE) != 0});
+            }
+        }
+        images.release(chunk);
+
+        iface.replay(stimulus, [&](size_t) {
+            clk_cnt++;
+            RdReport(iface, clk_cnt, report);
+            return clk_cnt < max_clk_cnt;
+        });
+    }
+
+    if(!images.error().empty())
+        throw std::runtime_error(images.error());
+
+    report.speed(clk_cnt, t0);
+    return clk_cnt;
+}
+
+// Same run as TestRun, on procedural stress scenes. Frames are rendered
+// ahead on the StressScenes workers; this loop only packs the in_label
+// runs of their bitmaps and replays them.
+template<typename iface_t, typename report_t = PrintReport>
+uint64_t TestRunScenes(iface_t &iface, StressScenes &scenes, uint64_t max_clk_cnt = ~uint64_t(0),
+                       report_t &&report = report_t{}) {
+    const size_t x_size = llcca_gens.X_SIZE;
+    const size_t rows_per_chunk = 64;
+
+    auto t0 = std::chrono::steady_clock::now();
+
+    ResetEmulation(iface, x_size);
+
+    typename iface_t::stimulus_t stimulus;
+    stimulus.reserve(rows_per_chunk * x_size);
+
+    uint64_t clk_cnt = 0;
+    while(clk_cnt < max_clk_cnt) {
+        const StressScenes::Frame *frame = scenes.next();
+        if(!frame)
+            break;
+        report.frame(frame->frame_idx);
+        for(size_t y = 0; y < frame->rows && clk_cnt < max_clk_cnt; y += rows_per_chunk) {
+            stimulus.clear();
+            for(size_t row = y; row < std::min(y + rows_per_chunk, frame->rows); ++row) {
+                size_t x = 0;
+                auto emit = [&](size_t x_end, bool in_label) {
+                    for(; x < x_end; ++x)
+                        CompileEmulationData(stimulus, Collect_t{in_label, x, row, false, false, false});
+                };
+                frame->runs(row, [&](size_t x_begin, size_t x_end) {
+                    emit(x_begin, false);
+                    emit(x_end, true);
+                });
+                emit(x_size, false);
+            }
+
+            iface.replay(stimulus, [&](size_t) {
+                clk_cnt++;
+                RdReport(iface, clk_cnt, report);
+                return clk_cnt < max_clk_cnt;
+            });
+        }
+        scenes.release(frame);
+    }
+
+    report.speed(clk_cnt, t0);
+    scenes.report(std::cerr);
+    return clk_cnt;
+}
+
+} // namespace DUT_NAMESPACE
@@ -1,271 +1,101 @@
 #include <vector>
-#include <variant>
-#include <memory>
 #include <iostream>
-#include <chrono>
+#include <stdexcept>
+#include <string>
 
 #include "emulator/FpgaGenerics.h"
 
-#include <boost/multiprecision/cpp_int.hpp>
-using boost::multiprecision::cpp_int;
-
 constexpr FpgaGenerics generics(65535, 16);
 
-#define DEBUG_PRINT
-
-#include <emulator/shadow.h>
-#include <emulator/fields_linkruncca.h>
-#include <emulator/hw_access_aarch64.h>
-#include <emulator/hw_access_debug.h>
-#include <emulator/bit_slicer.h>
-#include <emulator/fields.h>
-#include <emulator/emulator_fields.h>
-
-#if defined(__aarch64__)
-using BackendType = hw_access_aarch64;
-#else
-using BackendType = hw_access_debug;
-#endif
-
-constexpr FpgaGenerics_linkruncca llcca_gens{
-    .X_SIZE=1024,
-    .Y_BITS=16,
-};
-
-using app_fields_t = fields_linkruncca<llcca_gens>;
-
-using emulator_t = emulator_fields<BackendType, app_fields_t>;
-
-using wr_add = typename emulator_t::wr_fields;
-using rd_add = typename emulator_t::rd_fields;
+#include "DutApp.h"
+#include "StimulusFile.h"
 
 const char* dev_fname = "/dev/uio4";
-enum ObjectType {
-    CIRCLE,
-    SQUARE,
-};
-
-struct ObjectBase {
-    virtual ~ObjectBase() = default;
-    virtual bool pixel(size_t x, size_t y) const = 0;
-};
-
-struct CircleData: ObjectBase {
-    size_t x;
-    size_t y;
-    size_t radius;
-    CircleData(size_t x_, size_t y_, size_t radius_) : x(x_), y(y_), radius(radius_) {}
-    bool pixel(size_t x, size_t y) const override {
-        long dx = static_cast<long>(x) - static_cast<long>(this->x);
-        long dy = static_cast<long>(y) - static_cast<long>(this->y);
-        long r = static_cast<long>(radius);
-        return (dx*dx + dy*dy) <= (r * r);
-    }
-};
-
-struct SquareData: ObjectBase {
-    size_t x;
-    size_t y;
-    size_t side_length;
-    SquareData(size_t x_, size_t y_, size_t side_length_) : x(x_), y(y_), side_length(side_length_) {}
-    bool pixel(size_t x, size_t y) const override {
-        return (x >= this->x && x < this->x + side_length &&
-                y >= this->y && y < this->y + side_length);
-    }
-};
-
-struct Collect_t {
-    bool in_label;
-    size_t x;
-    size_t y;
-    bool has_red;
-    bool has_green;
-    bool has_blue;
-};
-
-struct Feature_t {
-    bool valid;
-    size_t x_left;
-    size_t x_right;
-    size_t y_top_seg_0;
-    size_t y_top_seg_1;
-    size_t y_bottom_seg_0;
-    size_t y_bottom_seg_1;
-    cpp_int x2_sum;
-    cpp_int ylow2_sum;
-    cpp_int xylow_sum;
-    cpp_int x_seg0_sum;
-    cpp_int x_seg1_sum;
-    cpp_int ylow_seg0_sum;
-    cpp_int ylow_seg1_sum;
-    cpp_int n_seg0_sum;
-    cpp_int n_seg1_sum;
-};
-
-class TestFrame {
-public:
-    using Objects = std::vector<std::unique_ptr<ObjectBase>>;
-private:
-    Objects objects_;
-
-public:
-    TestFrame(Objects objects)
-        : objects_(std::move(objects))
-    {}
-
-    Collect_t GetPixel(size_t x, size_t y, size_t repeat_y) const {
-        for(const auto& obj : objects_) {
-            if(obj->pixel(x, y % repeat_y)) {
-                return Collect_t{true, x, y, false, false, false};
-            }
-        }
-        return Collect_t{false, x, y, false, false, false};
-    }
-};
-
-class TestFrames {
-private:
-    std::vector<TestFrame> frames_;
-public:
-    TestFrames(size_t x_size, size_t y_size, size_t repeat_y_size)
-        : x_size(x_size), y_size(y_size), repeat_y(repeat_y_size)
-    {
-        // Create some test frames with objects
-        for(size_t f = 0; f < 10; ++f) {
-            TestFrame::Objects objects;
-            objects.push_back(std::make_unique<CircleData>(20 + f*40, 20 + f*3, 12));
-            objects.push_back(std::make_unique<SquareData>(30 + f*30,  30 + f*2, 10));
-            frames_.emplace_back(std::move(objects));
-        }
-    }
-
-    TestFrame& GetFrame(size_t index) {
-        return frames_[index % frames_.size()];
-    }
-
-    Collect_t GetPixel(size_t frame_index, size_t x, size_t y) const {
-        return frames_[frame_index % frames_.size()].GetPixel(x, y, repeat_y);
-    }
-
-    const size_t x_size;
-    const size_t y_size;
-    const size_t repeat_y;
-};
-
-void WrEmulationData(emulator_t &iface, Collect_t &data) {
-    iface.wr_field(wr_add::RST, 0);
-    iface.wr_field(wr_add::DATAVALID, 1);
-    iface.wr_field(wr_add::IN_LABEL, data.in_label ? 1 : 0);
-    iface.wr_field(wr_add::X, data.x);
-    iface.wr_field(wr_add::Y, data.y);
-    iface.wr_field(wr_add::HAS_RED, data.has_red ? 1 : 0);
-    iface.wr_field(wr_add::HAS_GREEN, data.has_green ? 1 : 0);
-    iface.wr_field(wr_add::HAS_BLUE, data.has_blue ? 1 : 0);
-
-    iface.wr_flush();
-    iface.wr_raw(0, (uint32_t)1);
-}
-
-bool RdEmulationData(emulator_t &iface, Feature_t &data) {
-    iface.rd_flush();
-    iface.rd_field(rd_add::VALID, data.valid);
-    if(data.valid) {
-        iface.rd_field(rd_add::X_LEFT, data.x_left);
-        iface.rd_field(rd_add::X_RIGHT, data.x_right);
-        iface.rd_field(rd_add::Y_TOP_SEG_0, data.y_top_seg_0);
-        iface.rd_field(rd_add::Y_TOP_SEG_1, data.y_top_seg_1);
-        iface.rd_field(rd_add::Y_BOTTOM_SEG_0, data.y_bottom_seg_0);
-        iface.rd_field(rd_add::Y_BOTTOM_SEG_1, data.y_bottom_seg_1);
-        iface.rd_field(rd_add::X2_SUM, data.x2_sum);
-        iface.rd_field(rd_add::YLOW2_SUM, data.ylow2_sum);
-        iface.rd_field(rd_add::XYLOW_SUM, data.xylow_sum);
-        iface.rd_field(rd_add::X_SEG0_SUM, data.x_seg0_sum);
-        iface.rd_field(rd_add::X_SEG1_SUM, data.x_seg1_sum);
-        iface.rd_field(rd_add::YLOW_SEG0_SUM, data.ylow_seg0_sum);
-        iface.rd_field(rd_add::YLOW_SEG1_SUM, data.ylow_seg1_sum);
-        iface.rd_field(rd_add::N_SEG0_SUM, data.n_seg0_sum);
-        iface.rd_field(rd_add::N_SEG1_SUM, data.n_seg1_sum);
-    }
-    return data.valid;
-}
-
-void TestRun(emulator_t &iface) {
-    const size_t frames = 1;
-    const size_t x_size = llcca_gens.X_SIZE;
-    const size_t y_bits = llcca_gens.Y_BITS;
-    const size_t y_size = (size_t)1 << y_bits;
-    const size_t repeat_y_size = 512;
-    const size_t max_clk_cnt = 50000000;
-
-    using clock = std::chrono::steady_clock;
-
-    auto t0 = clock::now();    
-
-    TestFrames test_frames(x_size, y_size, repeat_y_size);
-
-    iface.wr_field(wr_add::RST, 1);
-    iface.wr_field(wr_add::DATAVALID, 1);
-    iface.wr_flush();
-    for(int i=0; i < 2*x_size; i++)
-        iface.wr_raw(0, (uint32_t)1);
-    iface.wr_field(wr_add::RST, 0);
-    iface.wr_field(wr_add::DATAVALID, 0);
-    iface.wr_flush();
-    iface.wr_raw(0, (uint32_t)1);
-
-    uint64_t clk_cnt = 0;
-    for(size_t frame_idx = 0; frame_idx < frames; ++frame_idx) {
-#ifdef DEBUG_PRINT
-        std::cout << "Frame " << frame_idx << ":\n";
-#endif
-        for(auto y = 0; y < y_size; ++y) {
-            for(size_t x = 0; x < x_size; ++x) {
-                Collect_t pixel = test_frames.GetPixel(frame_idx, x, y);
-                Feature_t feature;
-                WrEmulationData(iface, pixel);
-                clk_cnt++;
-                if(RdEmulationData(iface, feature)) {
-                    std::cout << "FEATURE:";
-                    std::cout << "\n  clk_cnt = " << clk_cnt << "\n  X_LEFT: " << feature.x_left << "\n  X_RIGHT: " << feature.x_right;
-                    std::cout << "\n  y_top_seg_0 = " << feature.y_top_seg_0 << "\n  y_bottom_seg_0 = " << feature.y_bottom_seg_0;
-                    std::cout << "\n  y_top_seg_1 = " << feature.y_top_seg_1 << "\n  y_bottom_seg_1 = " << feature.y_bottom_seg_1;
-
-                    std::cout << "\n\n";
-                }
-                if(clk_cnt >= max_clk_cnt)
-                    break;
-            }
-            if(clk_cnt >= max_clk_cnt)
-                break;
-        }
-    }
-
-    auto t1 = clock::now();
-    double usec = std::chrono::duration<double, std::micro>(t1 - t0).count();
-    double mhz  = clk_cnt / usec;
-
-    std::cerr << "Emulation ended\n";
-    std::cerr << "Processed " << clk_cnt << " clock cycles\n";
-    std::cerr << "Elapsed time: " << usec << " us\n";
-    std::cerr << "Speed: " << mhz << " MHz\n";
-}
-
-#include <iostream>
-#include <string>
 
 void PrintHelp(const char* progname)
 {
     std::cerr <<
-        "Usage: " << progname << " -d <uio_device>\n"
+        "Usage: " << progname << " -d <uio_device>... [-m <mode>] [-n <count>] [-p | -b | -r <file> | -i <file>... | -P <seed>[:<profile>]] [-s <file>] [-e | -o <file> | -k | -c <file> | -v <file>] [-G <x>x<y>] [-t <file> [-w <b>:<e>] [-g <field>[:<n>]]]\n"
         "\n"
         "Options:\n"
-        "  -d <path>   UIO device file, e.g. /dev/uio4\n"
+        "  -d <path>   UIO device file, e.g. /dev/uio4, or /dev/emulator_mmio<N>\n"
+        "              (needed by FPGA_MMIO_ORDER relaxed / write_combining);\n"
+        "              repeat for several emulator instances, each run on its\n"
+        "              own pinned thread\n"
+        "  -n <count>  Number of model instances with -m model (default 1)\n"
+        "  -m <mode>   Backend mode:\n"
+        "                hw       - hardware backend (default)\n"
+        "                model    - C++ model of vhdl_linkruncca, no device needed\n"
+        "                lockstep - hardware and model together, reports first mismatch\n"
+        "  -p          Pipelined run: stimulus generation, register access and\n"
+        "              result printing on separate threads\n"
+        "  -b          Batch run: stimulus and results go through the hw FIFOs,\n"
+        "              no per-clock register access (64-bit backends only)\n"
+        "  -s <file>   Save the TestRun stimulus to a stimulus file and exit\n"
+        "              (no device needed)\n"
+        "  -r <file>   Replay a stimulus file saved with -s instead of\n"
+        "              generating the test frames; the file sets the\n"
+        "              geometry, which must match -G and the device\n"
+        "  -i <file>   Run on frames from a PBM/PGM/PPM file (repeatable; a file\n"
+        "              may hold several frames), read ahead on a separate thread\n"
+        "  -T <n>      Threshold 0..255 for -i, default 128\n"
+        "  -R <w>x<h>  -i files are raw 8-bit gray frames of w x h pixels\n"
+        "  -P <seed>[:<profile>]\n"
+        "              Run on seeded procedural stress scenes, rendered ahead on\n"
+        "              worker threads; profile uniform (default), ramp, bands\n"
+        "              or worst\n"
+        "  -F <n>[x<rows>] Scene frames (0: endless) and rows per frame,\n"
+        "              default 16x512\n"
+        "  -l          Time every register access and clock pulse, print\n"
+        "              p50/p99/p99.9/max latency histograms at the end (hw, model)\n"
+        "  -S <addr>   Serve the emulator (hw or model backend) to remote\n"
+        "              clients on unix:<path> or tcp:[<host>:]<port>\n"
+        "  -C <addr>   Run the serial test on a remote server (-S), no device\n"
+        "              needed; tcp:<host>:<port> or unix:<path>\n"
+        "  -x <file>   Log every register access to an MMIO log file, predict\n"
+        "              its clock rate with mmio_replay (hw, model)\n"
+        "  -e          Print the fitted ellipse (centroid, axes, orientation)\n"
+        "              after each feature; serial, -r, -i and -P runs\n"
+        "  -o <file>   Write features to a columnar binary feature file instead\n"
+        "              of printing them; serial, -r, -i and -P runs\n"
+        "  -k          Track blobs from frame to frame, print the track after\n"
+        "              each feature and the tracker cost per frame at the end;\n"
+        "              serial, -r, -i and -P runs\n"
+        "  -c <file>   Write the result CRC of every frame to file, as reference\n"
+        "              for -v; serial, -i and -P runs\n"
+        "  -v <file>   Verification run: no per-cycle result reads, compare the\n"
+        "              hw result CRC with the -c reference once per frame;\n"
+        "              exit status 1 on a mismatch (64-bit backends only)\n"
+        "  -t <file>   Record a per-cycle trace (last 2^20 cycles) to file,\n"
+        "              convert with trace2vcd (not in batch mode)\n"
+        "  -w <b>:<e>  Trace only cycles b to e-1\n"
+        "  -g <f>[:<n>] Stop the trace n cycles after result field f reads\n"
+        "              non-zero, e.g. -g VALID:100\n"
+        "  -G <x>x<y>  DUT geometry X_SIZE x Y_BITS; default: read from the\n"
+        "              device, else from the -r file, else the first\n"
+        "              built-in geometry\n"
         "  -h          Show this help\n"
-        "\n";
+        "\n"
+        "Built-in geometries:";
+    for (const DutConfig *config : DutRegistry::all())
+        std::cerr << " " << config->name();
+    std::cerr << "\n\n";
+}
+
+// GEOMETRY register of the device, or 0 if the backend cannot read the
+// batch status registers.
+uint32_t ProbeGeometry(const std::string &device_path) {
+    if constexpr (sizeof(BackendType::rd_word_t) == batch_regs::AXI_BYTES) {
+        BackendType hw(device_path.c_str());
+        return static_cast<uint32_t>(hw.rd_raw(batch_regs::GEOMETRY / batch_regs::AXI_BYTES));
+    } else {
+        return 0;
+    }
 }
 
 int main(int argc, char* argv[]) {
-    std::string device_path;
+    AppOptions options;
+    std::string geometry;
 
     // -------------------------------
     // Parse command line arguments
@@ -284,7 +114,225 @@ int main(int argc, char* argv[]) {
                 PrintHelp(argv[0]);
                 return 1;
             }
-            device_path = argv[++i];
+            options.device_paths.push_back(argv[++i]);
+            continue;
+        }
+
+        if (arg == "-n") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: -n requires a count.\n\n";
+                PrintHelp(argv[0]);
+                return 1;
+            }
+            const std::string value = argv[++i];
+            try {
+                options.instances = std::stoul(value);
+            } catch (const std::exception &) {
+                options.instances = 0;
+            }
+            if (options.instances == 0) {
+                std::cerr << "Error: bad argument for -n: " << value << "\n\n";
+                PrintHelp(argv[0]);
+                return 1;
+            }
+            continue;
+        }
+
+        if (arg == "-p") {
+            options.run_mode = RunMode::PIPELINED;
+            continue;
+        }
+
+        if (arg == "-b") {
+            options.run_mode = RunMode::BATCH;
+            continue;
+        }
+
+        if (arg == "-S" || arg == "-C") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: " << arg << " requires an address.\n\n";
+                PrintHelp(argv[0]);
+                return 1;
+            }
+            (arg == "-S" ? options.serve_address : options.remote_address) = argv[++i];
+            continue;
+        }
+
+        if (arg == "-x") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: -x requires a file name.\n\n";
+                PrintHelp(argv[0]);
+                return 1;
+            }
+            options.mmio_log_fname = argv[++i];
+            continue;
+        }
+
+        if (arg == "-l") {
+            options.latency = true;
+            continue;
+        }
+
+        if (arg == "-e") {
+            options.ellipses = true;
+            continue;
+        }
+
+        if (arg == "-k") {
+            options.tracks = true;
+            continue;
+        }
+
+        if (arg == "-G") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: -G requires a geometry.\n\n";
+                PrintHelp(argv[0]);
+                return 1;
+            }
+            geometry = argv[++i];
+            continue;
+        }
+
+        if (arg == "-o") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: -o requires a feature file.\n\n";
+                PrintHelp(argv[0]);
+                return 1;
+            }
+            options.features_fname = argv[++i];
+            continue;
+        }
+
+        if (arg == "-c" || arg == "-v") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: " << arg << " requires a CRC file.\n\n";
+                PrintHelp(argv[0]);
+                return 1;
+            }
+            (arg == "-c" ? options.crc_fname : options.verify_fname) = argv[++i];
+            continue;
+        }
+
+        if (arg == "-s" || arg == "-r") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: " << arg << " requires a stimulus file.\n\n";
+                PrintHelp(argv[0]);
+                return 1;
+            }
+            if (arg == "-s") {
+                options.save_fname = argv[++i];
+            } else {
+                options.replay_fname = argv[++i];
+                options.run_mode = RunMode::REPLAY;
+            }
+            continue;
+        }
+
+        if (arg == "-i" || arg == "-T" || arg == "-R") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: " << arg << " requires an argument.\n\n";
+                PrintHelp(argv[0]);
+                return 1;
+            }
+            const std::string value = argv[++i];
+            try {
+                if (arg == "-i") {
+                    options.image_fnames.push_back(value);
+                    options.run_mode = RunMode::IMAGES;
+                } else if (arg == "-T") {
+                    options.image_opts.threshold = std::stoul(value);
+                    if (options.image_opts.threshold > 255)
+                        throw std::out_of_range(value);
+                } else {
+                    const size_t sep = value.find('x');
+                    if (sep == std::string::npos)
+                        throw std::invalid_argument(value);
+                    options.image_opts.raw_width = std::stoul(value.substr(0, sep));
+                    options.image_opts.raw_height = std::stoul(value.substr(sep + 1));
+                    if (!options.image_opts.raw_width || !options.image_opts.raw_height)
+                        throw std::invalid_argument(value);
+                }
+            } catch (const std::exception &) {
+                std::cerr << "Error: bad argument for " << arg << ": " << value << "\n\n";
+                PrintHelp(argv[0]);
+                return 1;
+            }
+            continue;
+        }
+
+        if (arg == "-P" || arg == "-F") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: " << arg << " requires an argument.\n\n";
+                PrintHelp(argv[0]);
+                return 1;
+            }
+            const std::string value = argv[++i];
+            try {
+                if (arg == "-P") {
+                    const size_t colon = value.find(':');
+                    options.scene_opts.seed = std::stoull(value.substr(0, colon));
+                    if (colon != std::string::npos
+                        && !StressScenes::parse_profile(value.substr(colon + 1), options.scene_opts.profile))
+                        throw std::invalid_argument(value);
+                    options.run_mode = RunMode::SCENES;
+                } else {
+                    const size_t sep = value.find('x');
+                    options.scene_opts.frames = std::stoul(value.substr(0, sep));
+                    if (sep != std::string::npos) {
+                        options.scene_opts.rows = std::stoul(value.substr(sep + 1));
+                        if (!options.scene_opts.rows)
+                            throw std::invalid_argument(value);
+                    }
+                }
+            } catch (const std::exception &) {
+                std::cerr << "Error: bad argument for " << arg << ": " << value << "\n\n";
+                PrintHelp(argv[0]);
+                return 1;
+            }
+            continue;
+        }
+
+        if (arg == "-t" || arg == "-w" || arg == "-g") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: " << arg << " requires an argument.\n\n";
+                PrintHelp(argv[0]);
+                return 1;
+            }
+            const std::string value = argv[++i];
+            const size_t colon = value.find(':');
+            try {
+                if (arg == "-t") {
+                    options.trace_opts.fname = value;
+                } else if (arg == "-w") {
+                    if (colon == std::string::npos)
+                        throw std::invalid_argument(value);
+                    options.trace_opts.begin = std::stoull(value.substr(0, colon));
+                    options.trace_opts.end = std::stoull(value.substr(colon + 1));
+                } else {
+                    options.trace_opts.trigger = value.substr(0, colon);
+                    if (colon != std::string::npos)
+                        options.trace_opts.post_trigger = std::stoull(value.substr(colon + 1));
+                }
+            } catch (const std::exception &) {
+                std::cerr << "Error: bad argument for " << arg << ": " << value << "\n\n";
+                PrintHelp(argv[0]);
+                return 1;
+            }
+            continue;
+        }
+
+        if (arg == "-m") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: -m requires a mode.\n\n";
+                PrintHelp(argv[0]);
+                return 1;
+            }
+            options.mode = argv[++i];
+            if (options.mode != "hw" && options.mode != "model" && options.mode != "lockstep") {
+                std::cerr << "Error: unknown mode: " << options.mode << "\n\n";
+                PrintHelp(argv[0]);
+                return 1;
+            }
             continue;
         }
 
@@ -296,18 +344,113 @@ int main(int argc, char* argv[]) {
     // -------------------------------------
     // Require a device file unless disabled
     // -------------------------------------
-    if (device_path.empty()) {
+    if (options.save_fname.empty() && options.remote_address.empty() && options.mode != "model"
+        && options.device_paths.empty()) {
         std::cerr << "Error: No UIO device specified.\n\n";
         PrintHelp(argv[0]);
         return 1;
     }
 
+    if (options.ellipses + !options.features_fname.empty() + options.tracks
+        + !options.crc_fname.empty() + !options.verify_fname.empty() > 1) {
+        std::cerr << "Error: -e, -o, -k, -c and -v cannot be combined.\n";
+        return 1;
+    }
+
+    if ((!options.crc_fname.empty() || !options.verify_fname.empty()) && options.run_mode == RunMode::REPLAY) {
+        std::cerr << "Error: -c and -v need a serial, -i or -P run.\n";
+        return 1;
+    }
+
+    if ((options.latency || !options.mmio_log_fname.empty()) && options.mode == "lockstep") {
+        std::cerr << "Error: -l and -x need hw or model mode.\n";
+        return 1;
+    }
+
+    if (options.latency && !options.mmio_log_fname.empty()) {
+        std::cerr << "Error: -l and -x cannot be combined.\n";
+        return 1;
+    }
+
+    if (!options.serve_address.empty() || !options.remote_address.empty()) {
+        if (!options.serve_address.empty() && !options.remote_address.empty()) {
+            std::cerr << "Error: -S and -C cannot be combined.\n";
+            return 1;
+        }
+        if (options.run_mode != RunMode::SERIAL || !options.trace_opts.fname.empty() || options.latency
+            || !options.mmio_log_fname.empty() || !options.save_fname.empty() || options.instances > 1
+            || options.device_paths.size() > 1 || options.mode == "lockstep") {
+            std::cerr << "Error: -S and -C take a single hw or model instance, without -p, -b, -r, -i, -P, -s, -t, -l or -x.\n";
+            return 1;
+        }
+        if (!options.crc_fname.empty() || !options.verify_fname.empty()) {
+            std::cerr << "Error: -c and -v cannot be combined with -S or -C.\n";
+            return 1;
+        }
+        if (!options.serve_address.empty() && (options.ellipses || !options.features_fname.empty() || options.tracks)) {
+            std::cerr << "Error: -e, -o and -k belong to the client (-C).\n";
+            return 1;
+        }
+    }
+
+    // -------------------------------------
+    // A replay needs the geometry the
+    // stimulus file was recorded for
+    // -------------------------------------
+    const DutConfig *replay_config = nullptr;
+    if (options.run_mode == RunMode::REPLAY) {
+        StimulusFileHeader h;
+        try {
+            h = StimulusFile::read_header(options.replay_fname);
+        } catch (const std::exception &e) {
+            std::cerr << "Error: " << e.what() << "\n";
+            return 1;
+        }
+        replay_config = DutRegistry::find(h.x_size, h.y_bits);
+        if (!replay_config) {
+            std::cerr << "Error: " << options.replay_fname << " is recorded for geometry " << h.x_size << "x"
+                      << h.y_bits << ", which is not built in.\n";
+            return 1;
+        }
+    }
+
     // -------------------------------------
-    // Start hardware emulator backend
+    // Select the DUT geometry: -G, else the
+    // GEOMETRY register, else the replayed
+    // file, else the default
     // -------------------------------------
-    BackendType hw(device_path.c_str());
-    emulator_t emulator(hw);
+    const DutConfig *config = nullptr;
+    if (!geometry.empty()) {
+        for (const DutConfig *c : DutRegistry::all())
+            if (c->name() == geometry)
+                config = c;
+        if (!config) {
+            std::cerr << "Error: geometry " << geometry << " is not built in.\n\n";
+            PrintHelp(argv[0]);
+            return 1;
+        }
+    } else if (options.mode != "model" && options.save_fname.empty() && options.remote_address.empty()) {
+        const uint32_t id = ProbeGeometry(options.device_paths.front());
+        config = DutRegistry::find(id);
+        if (!config && batch_regs::geometry_valid(id)) {
+            std::cerr << "Error: device reports geometry " << batch_regs::geometry_x_size(id) << "x"
+                      << batch_regs::geometry_y_bits(id) << ", which is not built in.\n";
+            return 1;
+        }
+    }
+    if (!config)
+        config = replay_config;
+    if (!config)
+        config = DutRegistry::find(FPGA_DUT_DEFAULT_X_SIZE, FPGA_DUT_DEFAULT_Y_BITS);
+    if (!config) {
+        std::cerr << "Error: no DUT geometry built in.\n";
+        return 1;
+    }
+    if (replay_config && config != replay_config) {
+        std::cerr << "Error: " << options.replay_fname << " is recorded for geometry " << replay_config->name()
+                  << ", the DUT is " << config->name() << ".\n";
+        return 1;
+    }
 
-    TestRun(emulator);
-    return 0;
+    return config->run(options);
 }
@@ -0,0 +1,284 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <emulator/hw_access_log.h>
+
+// ------------------------------------------------------------
+// mmio_replay: predict the clock rate of an MMIO transaction log
+// ------------------------------------------------------------
+//
+// Feeds a log written by fpga_app -x through a timing model of a CPU
+// driving an AXI-Lite slave:
+//
+// - Every access costs the CPU a fixed time, plus the logged gap to the
+//   previous access times a scale factor (0 by default: logs taken on a
+//   workstation say nothing about target CPU time).
+// - An access of n words is split into beats of the AXI data width;
+//   AXI-Lite has no bursts, so each beat is one transaction. Beats on
+//   the same channel (read or write) are issued at most one per
+//   'issue' AXI clocks.
+// - Writes are posted: the CPU only stalls when the number of writes
+//   waiting for their response reaches the write buffer depth.
+// - Reads block the CPU until the data returns. With device ordering
+//   (the default), a read is issued only after all earlier writes got
+//   their response.
+//
+// One DUT clock is a wr_raw of bit 0 to word 0, so the predicted rate
+// is clock pulses over modeled time.
+//
+
+struct TimingModel {
+    double axi_mhz = 100.0;         // AXI-Lite clock
+    uint32_t axi_bytes = 8;         // data width
+    double read_clocks = 24;        // address to data, including the interconnect
+    double write_clocks = 12;       // address / data to response
+    double issue_clocks = 2;        // between beats on one channel
+    double cpu_ns = 5;              // CPU time per access
+    double gap_scale = 0;           // share of the logged gaps added as CPU time
+    size_t write_depth = 8;         // posted writes in flight
+    bool ordered = true;            // reads wait for earlier write responses
+};
+
+struct Prediction {
+    uint64_t records = 0;
+    uint64_t counts[4] = {};
+    uint64_t pulses = 0;
+    uint64_t wr_beats = 0;
+    uint64_t rd_beats = 0;
+    double read_stall_ns = 0;       // CPU waiting for read data
+    double write_stall_ns = 0;      // CPU waiting for the write buffer
+    double order_stall_ns = 0;      // reads waiting for write responses
+    double total_ns = 0;
+    uint64_t first_tick = 0;
+    uint64_t last_tick = 0;
+};
+
+class AxiLiteModel {
+public:
+    explicit AxiLiteModel(const TimingModel &model) : m_(model), clk_ns_(1e3 / model.axi_mhz) {}
+
+    void access(const mmio_log_record &r, uint32_t word_bytes, double gap_ns, Prediction &p) {
+        cpu_ += m_.cpu_ns + gap_ns * m_.gap_scale;
+        const uint64_t beats = std::max<uint64_t>(1, (uint64_t(r.words) * word_bytes + m_.axi_bytes - 1) / m_.axi_bytes);
+        if (mmio_log_record::is_write(r.kind)) {
+            p.wr_beats += beats;
+            for (uint64_t b = 0; b < beats; b++)
+                write_beat(p);
+        } else {
+            p.rd_beats += beats;
+            read(beats, p);
+        }
+    }
+
+    double finish() {
+        while (!writes_.empty()) {
+            cpu_ = std::max(cpu_, writes_.front());
+            writes_.pop_front();
+        }
+        return cpu_;
+    }
+
+private:
+    void retire() {
+        while (!writes_.empty() && writes_.front() <= cpu_)
+            writes_.pop_front();
+    }
+
+    void write_beat(Prediction &p) {
+        retire();
+        if (writes_.size() >= m_.write_depth) {
+            p.write_stall_ns += writes_.front() - cpu_;
+            cpu_ = writes_.front();
+            writes_.pop_front();
+        }
+        const double start = std::max(cpu_, w_free_);
+        w_free_ = start + m_.issue_clocks * clk_ns_;
+        writes_.push_back(start + m_.write_clocks * clk_ns_);
+    }
+
+    void read(uint64_t beats, Prediction &p) {
+        double t = cpu_;
+        if (m_.ordered && !writes_.empty()) {
+            t = std::max(t, writes_.back());
+            p.order_stall_ns += t - cpu_;
+            writes_.clear();
+        }
+        const double issue = t;
+        double done = t;
+        for (uint64_t b = 0; b < beats; b++) {
+            const double start = std::max(t, r_free_);
+            r_free_ = start + m_.issue_clocks * clk_ns_;
+            done = start + m_.read_clocks * clk_ns_;
+            t = start;
+        }
+        p.read_stall_ns += done - issue;
+        cpu_ = done;
+        retire();
+    }
+
+    TimingModel m_;
+    double clk_ns_;
+    double cpu_ = 0;                // CPU time of the next access
+    double w_free_ = 0;             // write channel free for the next beat
+    double r_free_ = 0;             // read channel free for the next beat
+    std::deque<double> writes_;     // response times of posted writes, ascending
+};
+
+void PrintHelp(const char* progname)
+{
+    std::cerr <<
+        "Usage: " << progname << " [options] <mmio_log>\n"
+        "\n"
+        "Predicts the DUT clock rate of an MMIO log written by fpga_app -x\n"
+        "with an AXI-Lite latency model.\n"
+        "\n"
+        "Options:\n"
+        "  -f <MHz>    AXI-Lite clock (default 100)\n"
+        "  -a <bytes>  AXI data width in bytes (default 8)\n"
+        "  -r <clk>    Read latency, address to data, in AXI clocks (default 24)\n"
+        "  -w <clk>    Write latency, to the response, in AXI clocks (default 12)\n"
+        "  -i <clk>    AXI clocks between beats on one channel (default 2)\n"
+        "  -c <ns>     CPU time per access (default 5)\n"
+        "  -g <scale>  Add the logged gaps between accesses times scale as CPU\n"
+        "              time (default 0; 1 for logs taken on the target)\n"
+        "  -q <n>      Posted writes in flight (default 8)\n"
+        "  -u          Unordered: reads do not wait for earlier writes\n"
+        "  -h          Show this help\n"
+        "\n";
+}
+
+int main(int argc, char* argv[]) {
+    TimingModel model;
+    std::string fname;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "-h" || arg == "--help") {
+            PrintHelp(argv[0]);
+            return 0;
+        }
+        if (arg == "-u") {
+            model.ordered = false;
+            continue;
+        }
+        if (arg.size() == 2 && arg[0] == '-' && std::strchr("farwicgq", arg[1])) {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: " << arg << " requires a value.\n\n";
+                PrintHelp(argv[0]);
+                return 1;
+            }
+            const std::string value = argv[++i];
+            try {
+                switch (arg[1]) {
+                case 'f': model.axi_mhz = std::stod(value); break;
+                case 'a': model.axi_bytes = std::stoul(value); break;
+                case 'r': model.read_clocks = std::stod(value); break;
+                case 'w': model.write_clocks = std::stod(value); break;
+                case 'i': model.issue_clocks = std::stod(value); break;
+                case 'c': model.cpu_ns = std::stod(value); break;
+                case 'g': model.gap_scale = std::stod(value); break;
+                case 'q': model.write_depth = std::stoul(value); break;
+                }
+            } catch (const std::exception &) {
+                std::cerr << "Error: bad value for " << arg << ": " << value << "\n";
+                return 1;
+            }
+            if (model.axi_mhz <= 0 || model.axi_bytes == 0 || model.write_depth == 0) {
+                std::cerr << "Error: " << arg << " must be positive.\n";
+                return 1;
+            }
+            continue;
+        }
+        if (!fname.empty() || arg[0] == '-') {
+            std::cerr << "Error: unknown argument " << arg << "\n\n";
+            PrintHelp(argv[0]);
+            return 1;
+        }
+        fname = arg;
+    }
+    if (fname.empty()) {
+        PrintHelp(argv[0]);
+        return 1;
+    }
+
+    std::ifstream in(fname, std::ios::binary);
+    if (!in) {
+        std::cerr << "Error: cannot open " << fname << "\n";
+        return 1;
+    }
+
+    mmio_log_header h;
+    if (!in.read(reinterpret_cast<char *>(&h), sizeof(h))
+        || std::memcmp(h.magic, mmio_log_header::MAGIC, sizeof(h.magic)) != 0) {
+        std::cerr << "Error: " << fname << " is not an MMIO log.\n";
+        return 1;
+    }
+    if (h.version != mmio_log_header::VERSION) {
+        std::cerr << "Error: unsupported MMIO log version " << h.version << ".\n";
+        return 1;
+    }
+
+    std::vector<uint64_t> data(mmio_log_record::max_words);
+    const double tick_ns = 1e9 / h.ticks_hz;
+
+    AxiLiteModel axi(model);
+    Prediction p;
+    uint64_t prev_tick = 0;
+    try {
+        mmio_log_reader reader(in, h);
+        mmio_log_record r;
+        for (uint64_t n = 0; reader.next(r, data.data()); n++) {
+            const uint32_t word_bytes = mmio_log_record::is_write(r.kind) ? h.wr_word_bytes : h.rd_word_bytes;
+
+            if (r.kind == mmio_log_record::WR_RAW && r.address == 0 && (data[0] & 1))
+                p.pulses++;
+            p.counts[r.kind]++;
+            if (n == 0)
+                p.first_tick = r.ticks;
+            p.last_tick = r.ticks;
+
+            axi.access(r, word_bytes, n ? double(r.ticks - prev_tick) * tick_ns : 0.0, p);
+            prev_tick = r.ticks;
+            p.records++;
+        }
+    } catch (const std::runtime_error &e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+    p.total_ns = axi.finish();
+
+    const double logged_s = double(p.last_tick - p.first_tick) * tick_ns / 1e9;
+    const double model_s = p.total_ns / 1e9;
+    const double clocks = double(std::max<uint64_t>(1, p.pulses));
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Log: " << p.records << " records (wr " << p.counts[mmio_log_record::WR]
+              << ", rd " << p.counts[mmio_log_record::RD] << ", wr_raw " << p.counts[mmio_log_record::WR_RAW]
+              << ", rd_raw " << p.counts[mmio_log_record::RD_RAW] << "), " << p.pulses << " clock pulses, "
+              << h.wr_word_bytes * 8 << "/" << h.rd_word_bytes * 8 << "-bit words, burst " << h.burst_words << "\n";
+    std::cout << "Logged: " << std::setprecision(3) << logged_s << " s";
+    if (logged_s > 0)
+        std::cout << ", " << std::setprecision(2) << p.pulses / logged_s / 1e6 << " MHz";
+    std::cout << "\n";
+    std::cout << "Model: AXI-Lite " << model.axi_mhz << " MHz, " << model.axi_bytes << "-byte beats, read "
+              << model.read_clocks << " / write " << model.write_clocks << " / issue " << model.issue_clocks
+              << " clk, cpu " << model.cpu_ns << " ns + " << model.gap_scale << " x gap, "
+              << model.write_depth << " writes in flight, " << (model.ordered ? "ordered" : "unordered") << "\n";
+    std::cout << "Per clock: " << p.wr_beats / clocks << " wr beats, " << p.rd_beats / clocks << " rd beats, "
+              << p.read_stall_ns / clocks << " ns read stall, " << p.order_stall_ns / clocks << " ns order stall, "
+              << p.write_stall_ns / clocks << " ns write buffer stall\n";
+    std::cout << "Predicted: " << std::setprecision(3) << model_s << " s";
+    if (model_s > 0)
+        std::cout << ", " << std::setprecision(2) << p.pulses / model_s / 1e6 << " MHz";
+    std::cout << "\n";
+    return 0;
+}
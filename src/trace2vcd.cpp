@@ -0,0 +1,191 @@
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <emulator/trace_recorder.h>
+
+// ------------------------------------------------------------
+// trace2vcd: convert a trace_recorder file to VCD
+// ------------------------------------------------------------
+//
+// The trace file carries the field names and bit layout, so this tool
+// needs no knowledge of the DUT fields. Feed fields go into scope
+// "feed", result fields into scope "result". One VCD time unit is one
+// DUT clock. Result fields whose words were not read in a cycle are
+// dumped as 'x'.
+//
+
+struct TraceField {
+    uint32_t bit_offset;
+    uint32_t bit_width;
+    std::string name;
+    std::string id;
+    std::string last;
+};
+
+template<typename T>
+static bool Get(std::istream &in, T &v)
+{
+    return bool(in.read(reinterpret_cast<char *>(&v), sizeof(v)));
+}
+
+static bool ReadFields(std::istream &in, uint32_t count, std::vector<TraceField> &fields)
+{
+    for (uint32_t f = 0; f < count; f++) {
+        TraceField field;
+        uint32_t len;
+        if (!Get(in, field.bit_offset) || !Get(in, field.bit_width) || !Get(in, len))
+            return false;
+        field.name.resize(len);
+        if (!in.read(field.name.data(), len))
+            return false;
+        if (field.name.empty())
+            field.name = "field" + std::to_string(fields.size());
+        fields.push_back(std::move(field));
+    }
+    return true;
+}
+
+// Short printable VCD identifier: base 94 starting at '!'.
+static std::string VcdId(size_t n)
+{
+    std::string id;
+    do {
+        id += char('!' + n % 94);
+        n /= 94;
+    } while (n);
+    return id;
+}
+
+// Field value as a binary string, MSB first. Words are little endian.
+static std::string FieldBits(const TraceField &field, const uint8_t *image)
+{
+    std::string s(field.bit_width, '0');
+    for (uint32_t i = 0; i < field.bit_width; i++) {
+        const size_t bit = size_t(field.bit_offset) + i;
+        if ((image[bit / 8] >> (bit % 8)) & 1)
+            s[field.bit_width - 1 - i] = '1';
+    }
+    return s;
+}
+
+// True if all rd words covering the field were read in this cycle.
+static bool FieldRead(const TraceField &field, uint64_t rd_mask, uint32_t rd_word_bits)
+{
+    const size_t first = field.bit_offset / rd_word_bits;
+    const size_t last = (size_t(field.bit_offset) + field.bit_width - 1) / rd_word_bits;
+    for (size_t idx = first; idx <= last; idx++)
+        if (!((rd_mask >> idx) & 1))
+            return false;
+    return true;
+}
+
+static void PutValue(std::ostream &out, TraceField &field, std::string value)
+{
+    if (value == field.last)
+        return;
+    if (field.bit_width == 1)
+        out << value << field.id << '\n';
+    else
+        out << 'b' << value << ' ' << field.id << '\n';
+    field.last = std::move(value);
+}
+
+static void DeclareScope(std::ostream &out, const char *scope, const std::vector<TraceField> &fields)
+{
+    out << "$scope module " << scope << " $end\n";
+    for (const auto &field : fields)
+        out << "$var wire " << field.bit_width << ' ' << field.id << ' ' << field.name << " $end\n";
+    out << "$upscope $end\n";
+}
+
+void PrintHelp(const char* progname)
+{
+    std::cerr <<
+        "Usage: " << progname << " <trace_file> <vcd_file>\n"
+        "\n"
+        "Converts a trace written by fpga_app -t to a VCD waveform.\n"
+        "\n";
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 3) {
+        PrintHelp(argv[0]);
+        return 1;
+    }
+
+    std::ifstream in(argv[1], std::ios::binary);
+    if (!in) {
+        std::cerr << "Error: cannot open " << argv[1] << "\n";
+        return 1;
+    }
+
+    trace_file_header h;
+    if (!Get(in, h) || std::memcmp(h.magic, trace_file_header::MAGIC, sizeof(h.magic)) != 0) {
+        std::cerr << "Error: " << argv[1] << " is not a trace file.\n";
+        return 1;
+    }
+    if (h.version != trace_file_header::VERSION) {
+        std::cerr << "Error: unsupported trace version " << h.version << ".\n";
+        return 1;
+    }
+
+    std::vector<TraceField> wr_fields, rd_fields;
+    if (!ReadFields(in, h.num_wr_fields, wr_fields) || !ReadFields(in, h.num_rd_fields, rd_fields)) {
+        std::cerr << "Error: truncated field table.\n";
+        return 1;
+    }
+
+    size_t next_id = 0;
+    for (auto &field : wr_fields)
+        field.id = VcdId(next_id++);
+    for (auto &field : rd_fields)
+        field.id = VcdId(next_id++);
+
+    std::ofstream out(argv[2]);
+    if (!out) {
+        std::cerr << "Error: cannot open " << argv[2] << "\n";
+        return 1;
+    }
+
+    out << "$comment emulator trace, " << h.num_records << " cycles";
+    if (h.trigger_cycle != trace_file_header::NO_CYCLE)
+        out << ", trigger at cycle " << h.trigger_cycle;
+    out << " $end\n";
+    out << "$timescale 1 ns $end\n";
+    DeclareScope(out, "feed", wr_fields);
+    DeclareScope(out, "result", rd_fields);
+    out << "$enddefinitions $end\n";
+
+    const uint32_t rd_word_bits = h.rd_word_bytes * 8;
+    std::vector<uint8_t> wr(size_t(h.wr_entries) * h.wr_word_bytes);
+    std::vector<uint8_t> rd(size_t(h.rd_entries) * h.rd_word_bytes);
+
+    for (uint64_t n = 0; n < h.num_records; n++) {
+        uint64_t cycle, rd_mask;
+        if (!Get(in, cycle) || !Get(in, rd_mask)
+            || !in.read(reinterpret_cast<char *>(wr.data()), wr.size())
+            || !in.read(reinterpret_cast<char *>(rd.data()), rd.size())) {
+            std::cerr << "Error: truncated after " << n << " records.\n";
+            return 1;
+        }
+
+        out << '#' << cycle << '\n';
+        for (auto &field : wr_fields)
+            PutValue(out, field, FieldBits(field, wr.data()));
+        for (auto &field : rd_fields)
+            PutValue(out, field, FieldRead(field, rd_mask, rd_word_bits)
+                                 ? FieldBits(field, rd.data())
+                                 : std::string(field.bit_width, 'x'));
+    }
+
+    if (!out) {
+        std::cerr << "Error: write failed: " << argv[2] << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,26 @@
+# ------------------------------------------------------------
+# Writes one add_test() per name of "fpga_tests -l" to TEST_LIST.
+# Run after every build of fpga_tests, so ctest always sees the
+# tests the binary holds.
+#
+#   -D TEST_EXECUTABLE=<fpga_tests> -D TEST_LIST=<file>
+#   [-D TEST_LAUNCHER=<emulator>]
+# ------------------------------------------------------------
+
+execute_process(
+    COMMAND ${TEST_LAUNCHER} ${TEST_EXECUTABLE} -l
+    OUTPUT_VARIABLE names
+    RESULT_VARIABLE result
+)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "${TEST_EXECUTABLE} -l failed: ${result}")
+endif()
+
+string(REPLACE "\n" ";" names "${names}")
+set(content "")
+foreach(name IN LISTS names)
+    if(name)
+        string(APPEND content "add_test([=[${name}]=] ${TEST_LAUNCHER} [=[${TEST_EXECUTABLE}]=] [=[${name}]=])\n")
+    endif()
+endforeach()
+file(WRITE ${TEST_LIST} "${content}")
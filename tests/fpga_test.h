@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+// ------------------------------------------------------------
+// fpga_tests: test registry and shared helpers
+// ------------------------------------------------------------
+//
+// FPGA_TEST(name) defines a test and registers it under name; the
+// test returns false after printing "Error: ..." to std::cerr. Each
+// tests/test_*.cpp holds the tests of one part of the stack, and
+// fpga_tests -l lists them all, which is where CMake takes the ctest
+// tests from.
+//
+
+struct TestCase {
+    const char *name;
+    bool (*run)();
+};
+
+inline std::vector<TestCase> &TestRegistry() {
+    static std::vector<TestCase> tests;
+    return tests;
+}
+
+struct TestRegistration {
+    TestRegistration(const char *name, bool (*run)()) {
+        TestRegistry().push_back(TestCase{name, run});
+    }
+};
+
+#define FPGA_TEST(name)                                                     \
+    static bool name##_test();                                              \
+    static const TestRegistration name##_registration(#name, name##_test);  \
+    static bool name##_test()
+
+class NullBuffer : public std::streambuf {
+protected:
+    int overflow(int c) override { return c; }
+    std::streamsize xsputn(const char *, std::streamsize n) override { return n; }
+};
+
+// Redirects std::cout and std::cerr for the lifetime of the object.
+class SilenceOutput {
+public:
+    SilenceOutput()
+        : cout_(std::cout.rdbuf(&null_)), cerr_(std::cerr.rdbuf(&null_)) {}
+    ~SilenceOutput() {
+        std::cout.rdbuf(cout_);
+        std::cerr.rdbuf(cerr_);
+    }
+private:
+    NullBuffer null_;
+    std::streambuf *cout_;
+    std::streambuf *cerr_;
+};
+
+// Same generator as the benchmarks, so failures are reproducible.
+class TestRandom {
+public:
+    size_t operator()(size_t range) {
+        seed_ = seed_ * 6364136223846793005ull + 1442695040888963407ull;
+        return static_cast<size_t>((seed_ >> 33) % range);
+    }
+private:
+    uint64_t seed_ = 1;
+};
+
+// A file name in the temp directory, unique to this process.
+inline std::string TempPath(const std::string &suffix) {
+    return (std::filesystem::temp_directory_path()
+            / ("fpga_tests_" + std::to_string(::getpid()) + suffix)).string();
+}
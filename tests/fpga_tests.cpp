@@ -0,0 +1,65 @@
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "fpga_test.h"
+
+// ------------------------------------------------------------
+// fpga_tests: correctness checks of the emulator stack
+// ------------------------------------------------------------
+//
+// One test per behavior, no device needed. "fpga_tests <name>..." runs
+// the named tests, "fpga_tests" runs all of them and "fpga_tests -l"
+// lists them; CMake registers every listed name with ctest after each
+// build (tests/discover_tests.cmake). The tests are in tests/test_*.cpp
+// and register themselves with FPGA_TEST (fpga_test.h).
+//
+
+// ------------------------------------------------------------
+// Driver
+// ------------------------------------------------------------
+bool RunTest(const TestCase &test) {
+    bool ok;
+    try {
+        ok = test.run();
+    } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        ok = false;
+    }
+    std::cout << (ok ? "PASS " : "FAIL ") << test.name << "\n";
+    return ok;
+}
+
+int main(int argc, char *argv[]) {
+    std::vector<std::string> names(argv + 1, argv + argc);
+
+    // Registration order depends on the link order; list and run by name.
+    auto &tests = TestRegistry();
+    std::sort(tests.begin(), tests.end(),
+              [](const TestCase &a, const TestCase &b) { return std::strcmp(a.name, b.name) < 0; });
+
+    if (names.size() == 1 && names[0] == "-l") {
+        for (const auto &test : tests)
+            std::cout << test.name << "\n";
+        return 0;
+    }
+
+    size_t failed = 0;
+    if (names.empty()) {
+        for (const auto &test : tests)
+            failed += !RunTest(test);
+    }
+    for (const auto &name : names) {
+        auto it = std::find_if(tests.begin(), tests.end(), [&](const TestCase &t) { return name == t.name; });
+        if (it == tests.end()) {
+            std::cerr << "Error: unknown test " << name << " (fpga_tests -l lists them).\n";
+            failed++;
+        } else {
+            failed += !RunTest(*it);
+        }
+    }
+    return failed ? 1 : 0;
+}
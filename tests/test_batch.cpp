@@ -0,0 +1,58 @@
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+
+#include <emulator/batch_regs.h>
+#include <emulator/hw_access_null.h>
+
+#include "TestRun.h"
+
+#include "fpga_test.h"
+
+// ------------------------------------------------------------
+// batch_replay() against a bitstream without, or with a stuck, batch FSM
+// ------------------------------------------------------------
+// hw_access_null reads 0 everywhere: no stimulus FIFO.
+FPGA_TEST(batch_no_fifo) {
+    hw_access_null<> hw;
+    emulator_fields<hw_access_null<>, app_fields_t> emulator(hw);
+    emulator_fields<hw_access_null<>, app_fields_t>::stimulus_t stimulus;
+    try {
+        emulator.batch_replay(stimulus, 10, [](uint32_t, auto &) {});
+    } catch (const std::runtime_error &) {
+        return true;
+    }
+    std::cerr << "Error: batch_replay() ran without a stimulus FIFO.\n";
+    return false;
+}
+
+// A FIFO of 8 records whose FSM never takes one: BATCH_REMAINING stays.
+struct StalledBatchBackend : hw_access_null<> {
+    uint64_t rd_raw(size_t word_offset) {
+        switch (word_offset * sizeof(uint64_t)) {
+        case batch_regs::STIM_DEPTH: return 8;
+        case batch_regs::BATCH_REMAINING: return 5;
+        default: return 0;
+        }
+    }
+};
+
+FPGA_TEST(batch_stall) {
+    using iface_t = emulator_fields<StalledBatchBackend, app_fields_t>;
+    StalledBatchBackend hw;
+    iface_t emulator(hw);
+    iface_t::stimulus_t stimulus;
+
+    const auto t0 = std::chrono::steady_clock::now();
+    try {
+        emulator.batch_replay(stimulus, 10, [](uint32_t, auto &) {});
+    } catch (const std::runtime_error &) {
+        if (std::chrono::steady_clock::now() - t0 >= iface_t::batch_stall_timeout)
+            return true;
+        std::cerr << "Error: batch_replay() gave up before batch_stall_timeout.\n";
+        return false;
+    }
+    std::cerr << "Error: batch_replay() returned on a stalled batch FSM.\n";
+    return false;
+}
@@ -0,0 +1,47 @@
+#include <cstdint>
+#include <iostream>
+
+#include "BlobTracker.h"
+
+#include "fpga_test.h"
+
+// ------------------------------------------------------------
+// BlobTracker on a grid of moving squares
+// ------------------------------------------------------------
+// Every square moves (1, 2) pixels per frame; after the first frame all
+// blobs must keep their track and the velocity must be exact.
+FPGA_TEST(blob_tracker) {
+    const size_t spacing = 16, side = 6;
+    const size_t columns = (llcca_gens.X_SIZE - 64) / spacing;
+    const size_t rows = 4096 / columns;
+
+    auto square = [&](size_t x0, size_t y0) {
+        Feature_t f{};
+        f.valid = true;
+        f.x_left = x0;
+        f.x_right = x0 + side - 1;
+        f.y_top_seg_0 = y0;
+        f.y_bottom_seg_0 = y0 + side - 1;
+        f.y_top_seg_1 = llcca_consts::Y_LOW_MAX;
+        f.n_seg0_sum += side * side;
+        f.x_seg0_sum += side * side * (2 * x0 + side - 1) / 2;
+        f.ylow_seg0_sum += side * side * (2 * y0 + side - 1) / 2;
+        return f;
+    };
+
+    BlobTracker tracker;
+    for (size_t frame = 0; frame < 8; frame++) {
+        tracker.begin_frame(frame);
+        size_t i = 0;
+        for (size_t r = 0; r < rows; r++) {
+            for (size_t c = 0; c < columns; c++, i++) {
+                const BlobTracker::Track &t = tracker.add(square(c * spacing + frame, r * spacing + 2 * frame));
+                if (t.id != i || (frame > 0 && (t.vx != 1.0 || t.vy != 2.0))) {
+                    std::cerr << "Error: BlobTracker lost blob " << i << " in frame " << frame << ".\n";
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
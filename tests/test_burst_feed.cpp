@@ -0,0 +1,165 @@
+#include <array>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include <emulator/bit_slicer.h>
+#include <emulator/hw_access_txn.h>
+#include <util/WideUint.h>
+
+#include "TestRun.h"
+
+#include "fpga_test.h"
+
+// ------------------------------------------------------------
+// Burst policies of hw_access_txn
+// ------------------------------------------------------------
+// 16 words of 64 bits, flushed as one 10-word dirty range.
+struct wide_test_fields {
+    enum class wr_fields : size_t {
+        W0, W1, W2, W3, W4, W5, W6, W7, W8, W9, W10, W11, W12, W13, W14, W15,
+        END_OF_FIELDS
+    };
+    enum class rd_fields : size_t {
+        R0,
+        END_OF_FIELDS
+    };
+
+    consteval static auto get_wr_specs() {
+        std::array<FieldSpec<wr_fields>, 16> specs{};
+        for (size_t i = 0; i < specs.size(); i++)
+            specs[i] = {static_cast<wr_fields>(i), 64};
+        return specs;
+    }
+
+    consteval static auto get_rd_specs() {
+        return std::to_array<FieldSpec<rd_fields>>({{rd_fields::R0, 64}});
+    }
+};
+
+// Feed window after 4096 pixel clocks (pixel write, flush, pulse, full
+// feature read with VALID held at 1) and after a 10-word flush. The
+// backend throws on any access breaking the burst rules.
+template<size_t BURST>
+std::vector<uint64_t> BurstFeed() {
+    using hw_t = hw_access_txn<uint64_t, BURST>;
+    const size_t x_size = llcca_gens.X_SIZE;
+
+    hw_t hw;
+    hw.set_rd(0, 1);
+    emulator_fields<hw_t, app_fields_t> emulator(hw);
+    for (uint64_t i = 0; i < 4096; i++) {
+        Collect_t pixel{(i & 7) == 0, i % x_size, i / x_size, false, false, false};
+        WrEmulationData(emulator, pixel);
+        Feature_t feature;
+        RdEmulationData(emulator, feature);
+    }
+
+    hw_t wide_hw;
+    shadow<hw_t, wide_test_fields> wide(wide_hw);
+    wide.wr_flush();
+    for (size_t idx = 3; idx < 13; idx++)
+        wide.write(idx, idx, ~uint64_t(0));
+    wide.wr_flush();
+
+    std::vector<uint64_t> feed;
+    for (size_t idx = 0; idx < 16; idx++)
+        feed.push_back(hw.feed(idx));
+    for (size_t idx = 0; idx < 16; idx++)
+        feed.push_back(wide_hw.feed(idx));
+    return feed;
+}
+
+FPGA_TEST(burst_feed) {
+    const auto single = BurstFeed<1>();
+    if (single != BurstFeed<2>() || single != BurstFeed<4>()) {
+        std::cerr << "Error: burst policies left different feed registers.\n";
+        return false;
+    }
+    return true;
+}
+
+// ------------------------------------------------------------
+// Read misses on a burst backend
+// ------------------------------------------------------------
+// Six rd words: VALID alone in word 0, A spanning the aligned pair of
+// words 0-1, B in word 2 and C spanning words 3-5.
+struct read_test_fields {
+    enum class wr_fields : size_t {
+        W0,
+        END_OF_FIELDS
+    };
+    enum class rd_fields : size_t {
+        VALID, A, B, C,
+        END_OF_FIELDS
+    };
+
+    consteval static auto get_wr_specs() {
+        return std::to_array<FieldSpec<wr_fields>>({{wr_fields::W0, 64}});
+    }
+
+    consteval static auto get_rd_specs() {
+        return std::to_array<FieldSpec<rd_fields>>({
+            {rd_fields::VALID, 1}, {rd_fields::A, 127}, {rd_fields::B, 64}, {rd_fields::C, 192},
+        });
+    }
+};
+
+// A lone miss is one single-word read; a field spanning words reads
+// each aligned pair inside it with one burst and the rest word by word.
+FPGA_TEST(burst_read) {
+    using hw_t = hw_access_txn<uint64_t, 2>;
+    using txn_t = hw_t::txn_t;
+    using shadow_t = shadow<hw_t, read_test_fields>;
+    using W = WideUint<192>;
+
+    hw_t hw;
+    for (size_t idx = 0; idx < 6; idx++)
+        hw.set_rd(idx, 0x0101010101010101ull * (idx + 1));
+    shadow_t sh(hw);
+    bit_slicer<shadow_t> slicer(sh);
+
+    W word[6];
+    for (size_t idx = 0; idx < 6; idx++)
+        word[idx] = W(0x0101010101010101ull * (idx + 1));
+    const W a = (word[0] >> 1 | word[1] << 63) & ((W(1) << 127) - W(1));
+    const W c = word[3] | word[4] << 64 | word[5] << 128;
+
+    struct Expect {
+        const char *what;
+        std::vector<txn_t> txns;
+    };
+    auto check = [&](const Expect &e, bool ok) {
+        std::vector<txn_t> txns = hw.transactions();
+        hw.clear();
+        sh.rd_flush();
+        bool same = ok && txns.size() == e.txns.size();
+        for (size_t i = 0; same && i < txns.size(); i++)
+            same = txns[i].kind == e.txns[i].kind && txns[i].words == e.txns[i].words
+                && txns[i].word_offset == e.txns[i].word_offset;
+        if (!same) {
+            size_t words = 0;
+            for (const auto &t : txns)
+                words += t.words;
+            std::cerr << "Error: reading " << e.what << " gave " << txns.size() << " reads of " << words
+                      << " words" << (ok ? "" : " and a wrong value") << ".\n";
+        }
+        return same;
+    };
+
+    for (bool compile_time : {false, true}) {
+        const bool valid = compile_time ? slicer.read_bits<0, 1, uint64_t>() : slicer.read_bits<uint64_t>(0, 1);
+        if (!check({"VALID", {{txn_t::RD, 1, 0}}}, valid == 1))
+            return false;
+        const W ra = compile_time ? slicer.read_bits<1, 127, W>() : slicer.read_bits<W>(1, 127);
+        if (!check({"A", {{txn_t::RD, 2, 0}}}, ra == a))
+            return false;
+        const W rb = compile_time ? slicer.read_bits<128, 64, W>() : slicer.read_bits<W>(128, 64);
+        if (!check({"B", {{txn_t::RD, 1, 2}}}, rb == word[2]))
+            return false;
+        const W rc = compile_time ? slicer.read_bits<192, 192, W>() : slicer.read_bits<W>(192, 192);
+        if (!check({"C", {{txn_t::RD, 2, 4}, {txn_t::RD, 1, 3}}}, rc == c))
+            return false;
+    }
+    return true;
+}
@@ -0,0 +1,133 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include "EllipseFit.h"
+
+#include "fpga_test.h"
+
+// ------------------------------------------------------------
+// EllipseBatch on upright rectangles
+// ------------------------------------------------------------
+// A w x h rectangle at (x0, y0) has its centroid in the middle, central
+// moments u20 = (w^2 - 1) / 12, u02 = (h^2 - 1) / 12, u11 = 0, and axes
+// 2 * sqrt of the larger and smaller of u20, u02. Rows run modulo
+// Y_SIZE: a rectangle crossing Y_LOW_SIZE spans both segments, one
+// crossing Y_SIZE wraps from segment 1 over to segment 0 and resolves
+// at y0 - Y_SIZE.
+namespace {
+
+struct Rectangle {
+    uint64_t x0, w, y0, h;
+};
+
+Feature_t RectangleFeature(const Rectangle &r) {
+    constexpr uint64_t y_low_size = llcca_consts::Y_LOW_SIZE;
+    constexpr uint64_t y_size = llcca_consts::Y_SIZE;
+
+    Feature_t f{};
+    f.y_top_seg_0 = f.y_top_seg_1 = llcca_consts::Y_LOW_MAX;
+    f.x_left = r.x0;
+    f.x_right = r.x0 + r.w - 1;
+    for (uint64_t y = r.y0; y < r.y0 + r.h; y++) {
+        const uint64_t ylow = y % y_low_size;
+        const bool seg1 = (y % y_size) >= y_low_size;
+        for (uint64_t x = r.x0; x < r.x0 + r.w; x++) {
+            f.x2_sum += x * x;
+            f.ylow2_sum += ylow * ylow;
+            f.xylow_sum += x * ylow;
+        }
+        const uint64_t sum_x = r.w * (2 * r.x0 + r.w - 1) / 2;
+        (seg1 ? f.x_seg1_sum : f.x_seg0_sum) += sum_x;
+        (seg1 ? f.ylow_seg1_sum : f.ylow_seg0_sum) += r.w * ylow;
+        (seg1 ? f.n_seg1_sum : f.n_seg0_sum) += r.w;
+        auto &top = seg1 ? f.y_top_seg_1 : f.y_top_seg_0;
+        auto &bottom = seg1 ? f.y_bottom_seg_1 : f.y_bottom_seg_0;
+        top = std::min<size_t>(top, ylow);
+        bottom = std::max<size_t>(bottom, ylow);
+    }
+    f.valid = true;
+    return f;
+}
+
+bool Near(double value, double expected, double tolerance) {
+    return std::abs(value - expected) <= tolerance;
+}
+
+// The central moments come from raw sums (sum y^2 / n - cy^2), so their
+// error scales with x^2 + y^2, not with the moment itself; the axes are
+// checked squared for the same reason.
+bool CheckRectangle(const EllipseBatch &batch, size_t i, const Rectangle &r) {
+    constexpr int64_t y_size = llcca_consts::Y_SIZE;
+
+    const int64_t y_top = int64_t(r.y0) - (r.y0 + r.h > uint64_t(y_size) ? y_size : 0);
+    const double cx = r.x0 + (r.w - 1) / 2.0;
+    const double cy = y_top + (r.h - 1) / 2.0;
+    const double u20 = (double(r.w) * r.w - 1) / 12;
+    const double u02 = (double(r.h) * r.h - 1) / 12;
+    const double tolerance = 1e-14 * (1 + cx * cx + cy * cy);
+    const double major = batch.major(i) / 2, minor = batch.minor(i) / 2;
+    if (batch.y_top(i) != y_top || batch.y_bottom(i) != y_top + int64_t(r.h) - 1
+        || batch.pixels(i) != double(r.w * r.h)
+        || !Near(batch.cx(i), cx, 1e-9) || !Near(batch.cy(i), cy, 1e-9)
+        || !Near(batch.u20(i), u20, tolerance) || !Near(batch.u02(i), u02, tolerance)
+        || !Near(batch.u11(i), 0, tolerance)
+        || !Near(major * major, std::max(u20, u02), 2 * tolerance)
+        || !Near(minor * minor, std::min(u20, u02), 2 * tolerance)) {
+        std::cerr << "Error: rectangle " << r.w << "x" << r.h << " at (" << r.x0 << ", " << r.y0
+                  << ") resolves to y " << batch.y_top(i) << ".." << batch.y_bottom(i)
+                  << ", c (" << batch.cx(i) << ", " << batch.cy(i) << "), u20 " << batch.u20(i)
+                  << ", u02 " << batch.u02(i) << ", u11 " << batch.u11(i)
+                  << ", axes " << batch.major(i) << "/" << batch.minor(i) << ".\n";
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+// Fixed rectangles inside segment 0, inside segment 1, across the
+// segment boundary and across the frame wrap, then random ones; the
+// SIMD fit and fit_scalar() must both match the closed form, and
+// agree with each other exactly.
+FPGA_TEST(ellipse_fit) {
+    constexpr uint64_t y_low_size = llcca_consts::Y_LOW_SIZE;
+    constexpr uint64_t y_size = llcca_consts::Y_SIZE;
+    const size_t num_random = 4096;
+
+    std::vector<Rectangle> rects = {
+        {0, 1, 0, 1},
+        {10, 20, 5, 3},
+        {100, 3, y_low_size + 7, 40},
+        {200, 17, y_low_size - 8, 16},
+        {300, 5, y_low_size - 1, 2},
+        {400, 9, y_size - 10, 30},
+        {500, 31, y_size - 1, 2},
+        {600, 8, y_size - 4, 8},
+    };
+    TestRandom next;
+    for (size_t i = 0; i < num_random; i++)
+        rects.push_back({next(llcca_gens.X_SIZE - 64), 1 + next(64), next(y_size), 1 + next(64)});
+
+    EllipseBatch batch(rects.size());
+    EllipseBatch scalar(rects.size());
+    for (const auto &r : rects) {
+        batch.add(RectangleFeature(r));
+        scalar.add(RectangleFeature(r));
+    }
+
+    batch.fit();
+    scalar.fit_scalar();
+    for (size_t i = 0; i < rects.size(); i++) {
+        if (!CheckRectangle(batch, i, rects[i]) || !CheckRectangle(scalar, i, rects[i]))
+            return false;
+        if (batch.cx(i) != scalar.cx(i) || batch.cy(i) != scalar.cy(i) || batch.major(i) != scalar.major(i)
+            || batch.minor(i) != scalar.minor(i) || batch.theta(i) != scalar.theta(i)) {
+            std::cerr << "Error: EllipseBatch::fit() differs from fit_scalar() at feature " << i << ".\n";
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,105 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "TestRun.h"
+#include "FeatureFile.h"
+
+#include "fpga_test.h"
+
+// ------------------------------------------------------------
+// Feature file: a model run read back through FeatureFile
+// ------------------------------------------------------------
+// Blocks of three records, so the features of the first 1M clocks span
+// full blocks and a partial last one.
+FPGA_TEST(feature_file) {
+    struct Record {
+        size_t frame_idx;
+        uint64_t clk_cnt;
+        Feature_t feature;
+    };
+
+    struct RecordReport {
+        FeatureReport file;
+        std::vector<Record> records;
+
+        void frame(size_t idx) {
+            file.frame(idx);
+        }
+        void feature(uint64_t clk_cnt, const Feature_t &feature) {
+            file.feature(clk_cnt, feature);
+            records.push_back({file.frame_idx, clk_cnt, feature});
+        }
+        void speed(uint64_t, std::chrono::steady_clock::time_point) {}
+    };
+
+    const std::string fname = TempPath(".feat");
+    const uint32_t block_records = 3;
+
+    std::vector<Record> records;
+    {
+        FeatureWriter writer(fname, block_records);
+        RecordReport report{FeatureReport{writer}, {}};
+        ModelBackendType hw;
+        emulator_fields<ModelBackendType, app_fields_t> emulator(hw);
+        TestRun(emulator, 1000000, report);
+        writer.close();
+        records = std::move(report.records);
+    }
+
+    auto fail = [&](const std::string &what) {
+        std::cerr << "Error: feature file " << what << ".\n";
+        std::filesystem::remove(fname);
+        return false;
+    };
+
+    // Low 64 bits of every column, in FeatureColumns order.
+    auto expected = [](const Record &rec) {
+        const Feature_t &f = rec.feature;
+        return std::array<uint64_t, FeatureColumns::count>{
+            rec.frame_idx, rec.clk_cnt, f.x_left, f.x_right,
+            f.y_top_seg_0, f.y_top_seg_1, f.y_bottom_seg_0, f.y_bottom_seg_1,
+            static_cast<uint64_t>(f.x2_sum), static_cast<uint64_t>(f.ylow2_sum),
+            static_cast<uint64_t>(f.xylow_sum), static_cast<uint64_t>(f.x_seg0_sum),
+            static_cast<uint64_t>(f.x_seg1_sum), static_cast<uint64_t>(f.ylow_seg0_sum),
+            static_cast<uint64_t>(f.ylow_seg1_sum), static_cast<uint64_t>(f.n_seg0_sum),
+            static_cast<uint64_t>(f.n_seg1_sum),
+        };
+    };
+
+    try {
+        FeatureFile file(fname);
+        const auto descs = FeatureColumns::descs();
+        if (records.size() <= block_records || file.header().num_records != records.size()
+            || file.header().num_columns != descs.size())
+            return fail("header does not match the run");
+        for (size_t c = 0; c < descs.size(); c++)
+            if (std::strcmp(file.columns()[c].name, descs[c].name) != 0 || file.columns()[c].bits != descs[c].bits)
+                return fail("column " + std::to_string(c) + " differs from FeatureColumns");
+
+        size_t n = 0;
+        for (const auto &block : file.blocks()) {
+            for (size_t r = 0; r < block.records; r++, n++) {
+                const auto values = expected(records[n]);
+                for (size_t c = 0; c < values.size(); c++) {
+                    const uint32_t bits = std::min<uint32_t>(file.columns()[c].bits, 64);
+                    const uint64_t mask = bits == 64 ? ~uint64_t(0) : (uint64_t(1) << bits) - 1;
+                    if (file.value(block, c, r) != (values[c] & mask))
+                        return fail("record " + std::to_string(n) + " differs in " + file.columns()[c].name);
+                }
+            }
+        }
+    } catch (const std::exception &e) {
+        return fail(std::string("cannot be read back: ") + e.what());
+    }
+
+    std::filesystem::remove(fname);
+    return true;
+}
@@ -0,0 +1,54 @@
+#include <cstdint>
+#include <iostream>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include "MultiRun.h"
+
+#include "fpga_test.h"
+
+// ------------------------------------------------------------
+// FeatureMerge: several instances merged while they run
+// ------------------------------------------------------------
+// Four producers with more entries than a queue holds, over two frames,
+// with clock counts that collide across instances; one finishes early
+// and one reports nothing. Entries must come out complete and ordered
+// by (frame, clk_cnt, instance).
+FPGA_TEST(feature_merge) {
+    const size_t instances = 4;
+    const size_t per_frame = 3 * FeatureMerge::capacity;
+    const size_t counts[instances] = {2 * per_frame, per_frame / 2, 2 * per_frame, 0};
+
+    FeatureMerge merge(instances);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < instances; i++) {
+        threads.emplace_back([&, i] {
+            for (size_t n = 0; n < counts[i]; n++)
+                merge.push(FeatureMerge::Entry{n / per_frame, 1 + (n % per_frame) * (i + 1), i, Feature_t{}});
+            merge.finish(i);
+        });
+    }
+
+    size_t total = 0;
+    bool ordered = true;
+    FeatureMerge::Entry last{0, 0, 0, Feature_t{}};
+    std::vector<FeatureMerge::Entry> entries;
+    while (merge.pop(entries)) {
+        for (const auto &e : entries) {
+            const auto key = std::tie(e.frame_idx, e.clk_cnt, e.instance);
+            if (total++ && key <= std::tie(last.frame_idx, last.clk_cnt, last.instance))
+                ordered = false;
+            last = e;
+        }
+    }
+    for (auto &thread : threads)
+        thread.join();
+
+    if (!ordered || total != counts[0] + counts[1] + counts[2] + counts[3]) {
+        std::cerr << "Error: FeatureMerge returned " << total << " entries"
+                  << (ordered ? "" : ", out of order") << ".\n";
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,110 @@
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <emulator/hw_access_log.h>
+#include <emulator/hw_access_txn.h>
+
+#include "fpga_test.h"
+
+// ------------------------------------------------------------
+// MMIO log: random accesses read back through mmio_log_reader
+// ------------------------------------------------------------
+// Small and full 64-bit words, bursts and repeated slots, so both
+// short and 10-byte varints and the XOR tables are covered.
+FPGA_TEST(mmio_log) {
+    using hw_t = hw_access_txn<uint64_t, 4>;
+    using record_t = mmio_log_record;
+
+    struct Access {
+        record_t::Kind kind;
+        uint32_t address;
+        std::vector<uint64_t> data;
+    };
+
+    const std::string fname = TempPath(".mlog");
+
+    TestRandom next;
+    auto word = [&]() {
+        const uint64_t w = (uint64_t(next(1u << 31)) << 33) ^ (uint64_t(next(1u << 31)) << 2) ^ next(4);
+        return next(2) ? w : w & 0xff;
+    };
+
+    std::vector<Access> expected;
+    {
+        hw_t hw;
+        hw_access_log<hw_t> log(hw, fname);
+        for (size_t i = 0; i < 20000; i++) {
+            const size_t n = 1 + next(4);
+            const uint32_t offset = static_cast<uint32_t>(n > 1 ? 4 * next(16) : next(64));
+            Access a{static_cast<record_t::Kind>(next(4)), offset, std::vector<uint64_t>(n)};
+            switch (a.kind) {
+            case record_t::WR:
+                for (auto &w : a.data)
+                    w = word();
+                log.wr_burst(offset, a.data.data(), n);
+                break;
+            case record_t::RD:
+                for (size_t k = 0; k < n; k++)
+                    hw.set_rd(offset + k, word());
+                log.rd_burst(offset, a.data.data(), n);
+                break;
+            case record_t::WR_RAW:
+                a.data.resize(1);
+                a.data[0] = word();
+                log.wr_raw(offset, a.data[0]);
+                break;
+            case record_t::RD_RAW:
+                a.data.resize(1);
+                a.data[0] = log.rd_raw(offset);
+                break;
+            }
+            expected.push_back(std::move(a));
+        }
+        log.close();
+        if (log.bytes() != std::filesystem::file_size(fname)) {
+            std::cerr << "Error: hw_access_log::bytes() differs from the file size.\n";
+            return false;
+        }
+    }
+
+    auto fail = [&](const std::string &what) {
+        std::cerr << "Error: MMIO log " << what << ".\n";
+        std::filesystem::remove(fname);
+        return false;
+    };
+
+    try {
+        std::ifstream in(fname, std::ios::binary);
+        mmio_log_header h;
+        if (!in.read(reinterpret_cast<char *>(&h), sizeof(h)) || h.version != mmio_log_header::VERSION
+            || h.num_records != expected.size())
+            return fail("header does not match the accesses");
+
+        mmio_log_reader reader(in, h);
+        record_t r;
+        std::vector<uint64_t> data(record_t::max_words);
+        uint64_t ticks = 0;
+        for (size_t i = 0; i < expected.size(); i++) {
+            const Access &a = expected[i];
+            if (!reader.next(r, data.data()))
+                return fail("ends after " + std::to_string(i) + " records");
+            if (r.kind != a.kind || r.address != a.address || r.words != a.data.size()
+                || !std::equal(a.data.begin(), a.data.end(), data.begin()) || r.ticks < ticks)
+                return fail("record " + std::to_string(i) + " differs from the access");
+            ticks = r.ticks;
+        }
+        if (reader.next(r, data.data()))
+            return fail("has more records than accesses");
+    } catch (const std::exception &e) {
+        return fail(std::string("cannot be read back: ") + e.what());
+    }
+
+    std::filesystem::remove(fname);
+    return true;
+}
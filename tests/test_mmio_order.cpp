@@ -0,0 +1,60 @@
+#include <cstdint>
+#include <iostream>
+
+#include <emulator/hw_access_txn.h>
+
+#include "TestRun.h"
+
+#include "fpga_test.h"
+
+// ------------------------------------------------------------
+// MMIO ordering policies on hw_access_txn
+// ------------------------------------------------------------
+// 4096 pixel clocks with a full feature read (VALID held at 1). The log
+// is checked independently of mmio_fences: with a posted policy a pulse
+// after feed stores must be preceded by FENCE_ST and a read after any
+// store by FENCE, and each clock needs at most one of each. strict
+// issues none.
+template<mmio_order ORDER>
+bool CheckBarriers() {
+    using hw_t = hw_access_txn<uint64_t, 2, 64, ORDER>;
+    using txn_t = typename hw_t::txn_t;
+    const size_t x_size = llcca_gens.X_SIZE;
+    const size_t clocks = 4096;
+
+    hw_t hw;
+    hw.set_rd(0, 1);
+    emulator_fields<hw_t, app_fields_t> emulator(hw);
+    for (uint64_t i = 0; i < clocks; i++) {
+        Collect_t pixel{(i & 7) == 0, i % x_size, i / x_size, false, false, false};
+        WrEmulationData(emulator, pixel);
+        Feature_t feature;
+        RdEmulationData(emulator, feature);
+    }
+
+    bool feed = false, stored = false, ok = true;
+    for (const auto &t : hw.transactions()) {
+        switch (t.kind) {
+        case txn_t::WR:       feed = stored = true; break;
+        case txn_t::WR_RAW:   ok &= !feed; stored = true; break;
+        case txn_t::FENCE_ST: feed = false; break;
+        case txn_t::FENCE:    feed = stored = false; break;
+        case txn_t::RD:
+        case txn_t::RD_RAW:   ok &= !stored; break;
+        }
+    }
+    const size_t fence_st = hw.count(txn_t::FENCE_ST), fence = hw.count(txn_t::FENCE);
+    const bool posted = ORDER != mmio_order::strict;
+    if ((posted && (!ok || fence_st > clocks || fence > clocks)) || (!posted && (fence_st || fence))) {
+        std::cerr << "Error: " << mmio_order_name(ORDER) << " placed " << fence_st << " store and " << fence
+                  << " full barriers in " << clocks << " clocks" << (ok ? "" : ", one missing") << ".\n";
+        return false;
+    }
+    return true;
+}
+
+FPGA_TEST(mmio_order_barriers) {
+    return CheckBarriers<mmio_order::strict>()
+        && CheckBarriers<mmio_order::relaxed>()
+        && CheckBarriers<mmio_order::write_combining>();
+}
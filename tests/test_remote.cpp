@@ -0,0 +1,214 @@
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+
+#include <emulator/batch_regs.h>
+
+#include "TestRun.h"
+#include "ResultCrc.h"
+#include "RemoteClient.h"
+#include "RemoteServer.h"
+
+#include "fpga_test.h"
+
+// ------------------------------------------------------------
+// Remote emulation: RemoteSession on the model
+// ------------------------------------------------------------
+namespace {
+
+using ModelIface = emulator_fields<ModelBackendType, app_fields_t>;
+
+const uint64_t remote_run_clocks = 1000000;
+
+uint32_t RemoteGeometry() {
+    return batch_regs::geometry_id(llcca_gens.X_SIZE, llcca_gens.Y_BITS);
+}
+
+// Every report call, features as their result words.
+struct RemoteRecordReport {
+    struct Record {
+        size_t frame_idx;
+        uint64_t clk_cnt;
+        decltype(CrcResultImage::words) words;
+        bool operator==(const Record &) const = default;
+    };
+
+    std::vector<Record> records;
+    size_t frame_idx = 0;
+
+    void frame(size_t idx) {
+        frame_idx = idx;
+    }
+    void feature(uint64_t clk_cnt, const Feature_t &feature) {
+        CrcResultImage image;
+        WrFeatureFields(image, feature);
+        records.push_back({frame_idx, clk_cnt, image.words});
+    }
+    void speed(uint64_t, std::chrono::steady_clock::time_point) {}
+};
+
+// The hello a client of this build sends.
+RemoteHello ClientHello() {
+    using fields_t = fields<app_fields_t>;
+    RemoteHello hello{};
+    std::memcpy(hello.magic, RemoteHello::MAGIC, sizeof(hello.magic));
+    hello.version = RemoteHello::VERSION;
+    hello.geometry = RemoteGeometry();
+    hello.num_wr_fields = fields_t::num_wr_fields;
+    hello.num_rd_fields = fields_t::num_rd_fields;
+    return hello;
+}
+
+// Runs one frame through a RemoteSession over a socketpair. The client
+// side is written up front, so the session runs on this thread.
+bool RemoteFrame(const std::vector<uint64_t> &payload, uint64_t words,
+                 RemoteReplyHeader &reply, std::vector<uint64_t> &records) {
+    int fds[2];
+    if (::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0)
+        throw std::runtime_error("socketpair failed");
+    RemoteSocket client(fds[0]);
+    RemoteSocket server(fds[1]);
+
+    const RemoteHello hello = ClientHello();
+    const RemoteFrameHeader frame{RemoteFrameHeader::MAGIC, 0, words};
+    client.send_all(&hello, sizeof(hello));
+    client.send_all(&frame, sizeof(frame));
+    client.send_all(payload.data(), payload.size() * sizeof(uint64_t));
+    client.shutdown_write();
+
+    bool ok;
+    {
+        SilenceOutput silence;
+        ModelBackendType hw;
+        ModelIface emulator(hw);
+        RemoteSession<ModelIface> session(emulator, std::move(server), RemoteGeometry());
+        ok = session.run();
+    }
+
+    RemoteHello server_hello;
+    if (!client.recv_all(&server_hello, sizeof(server_hello)) || !client.recv_all(&reply, sizeof(reply)))
+        throw std::runtime_error("no reply from the session");
+    records.resize(reply.words);
+    client.recv_all(records.data(), records.size() * sizeof(uint64_t));
+    return ok;
+}
+
+bool ExpectStatus(const char *what, const std::vector<uint64_t> &payload, uint64_t words,
+                  uint32_t status, const std::vector<uint64_t> &expected_records = {}) {
+    RemoteReplyHeader reply;
+    std::vector<uint64_t> records;
+    const bool ok = RemoteFrame(payload, words, reply, records);
+    if (ok || reply.magic != RemoteReplyHeader::MAGIC || reply.status != status || records != expected_records) {
+        std::cerr << "Error: " << what << " gave status " << RemoteReplyHeader::status_name(reply.status)
+                  << " with " << records.size() << " record words, expected "
+                  << RemoteReplyHeader::status_name(status) << ".\n";
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+// TestRunRemote against a RemoteSession on a unix socket gives the
+// records of a direct TestRun, and the session runs the reset clocks
+// on top of the pixel clocks.
+FPGA_TEST(remote_session) {
+    RemoteRecordReport direct;
+    {
+        SilenceOutput silence;
+        ModelBackendType hw;
+        ModelIface emulator(hw);
+        TestRun(emulator, remote_run_clocks, direct);
+    }
+
+    const std::string path = TempPath(".sock");
+    const std::string address = "unix:" + path;
+    RemoteSocket listener = RemoteSocket::listen(address);
+
+    ModelBackendType hw;
+    ModelIface emulator(hw);
+    bool served = false;
+    uint64_t served_clocks = 0;
+    std::exception_ptr error;
+    std::thread server([&] {
+        try {
+            RemoteSession<ModelIface> session(emulator, listener.accept(), RemoteGeometry());
+            served = session.run();
+            served_clocks = session.clocks();
+        } catch (...) {
+            error = std::current_exception();
+        }
+    });
+
+    RemoteRecordReport remote;
+    uint64_t clocks = 0;
+    try {
+        SilenceOutput silence;
+        clocks = TestRunRemote(address, remote_run_clocks, remote);
+    } catch (...) {
+        listener.shutdown_both();
+        server.join();
+        std::filesystem::remove(path);
+        throw;
+    }
+    server.join();
+    std::filesystem::remove(path);
+    if (error)
+        std::rethrow_exception(error);
+
+    if (direct.records.size() < 2) {
+        std::cerr << "Error: the direct run has " << direct.records.size() << " features, too few to compare.\n";
+        return false;
+    }
+    if (!served || clocks != remote_run_clocks || served_clocks != clocks + 2 * llcca_gens.X_SIZE + 1) {
+        std::cerr << "Error: remote session ran " << served_clocks << " clocks for " << clocks << " pixel clocks"
+                  << (served ? "" : " and failed") << ".\n";
+        return false;
+    }
+    if (remote.records != direct.records) {
+        size_t i = 0;
+        while (i < remote.records.size() && i < direct.records.size() && remote.records[i] == direct.records[i])
+            i++;
+        std::cerr << "Error: feature " << i << " of the remote run differs from the direct run ("
+                  << remote.records.size() << " and " << direct.records.size() << " features).\n";
+        return false;
+    }
+    return true;
+}
+
+// A marker before a bad op is still returned; the session ends after
+// the failing frame.
+FPGA_TEST(remote_bad_op) {
+    const uint64_t mark = RemoteOp::make(RemoteOp::MARK, 0, 7);
+    const uint64_t bad = uint64_t(0xff) << 56;
+    const uint64_t wr = RemoteOp::make(RemoteOp::WR, static_cast<size_t>(wr_add::X), 0);
+    return ExpectStatus("an unknown op", {mark, bad}, 2, RemoteReplyHeader::BAD_OP, {7, RemoteRecord::MARK})
+        && ExpectStatus("a WR without operand", {wr}, 1, RemoteReplyHeader::BAD_OP);
+}
+
+FPGA_TEST(remote_bad_field) {
+    using fields_t = fields<app_fields_t>;
+    const uint64_t wr = RemoteOp::make(RemoteOp::WR, fields_t::num_wr_fields, 0);
+    const uint64_t gate = RemoteOp::make(RemoteOp::SELECT, fields_t::num_rd_fields, 0);
+    const uint64_t select = RemoteOp::make(RemoteOp::SELECT, static_cast<size_t>(rd_add::VALID), 0);
+    return ExpectStatus("a WR past the wr fields", {wr, 1}, 2, RemoteReplyHeader::BAD_FIELD)
+        && ExpectStatus("a SELECT gate past the rd fields", {gate, 1}, 2, RemoteReplyHeader::BAD_FIELD)
+        && ExpectStatus("a SELECT mask past the rd fields", {select, uint64_t(1) << fields_t::num_rd_fields},
+                        2, RemoteReplyHeader::BAD_FIELD);
+}
+
+// The payload of a too large frame is never read.
+FPGA_TEST(remote_too_large) {
+    return ExpectStatus("a frame over MAX_WORDS", {}, RemoteFrameHeader::MAX_WORDS + 1,
+                        RemoteReplyHeader::TOO_LARGE);
+}
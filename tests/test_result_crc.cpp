@@ -0,0 +1,91 @@
+#include <cstdint>
+#include <iostream>
+
+#include "TestRun.h"
+#include "ResultCrc.h"
+
+#include "fpga_test.h"
+
+// ------------------------------------------------------------
+// Result CRC
+// ------------------------------------------------------------
+// RFC 3720 B.4: 32 bytes of 0x00 and of 0xff.
+FPGA_TEST(result_crc_vectors) {
+    const uint64_t zeros[4] = {}, ones[4] = {~0ull, ~0ull, ~0ull, ~0ull};
+    uint32_t crc_zeros = result_crc::init, crc_ones = result_crc::init;
+    for (size_t i = 0; i < 4; i++) {
+        crc_zeros = result_crc::update(crc_zeros, zeros[i]);
+        crc_ones = result_crc::update(crc_ones, ones[i]);
+    }
+    if (~crc_zeros != 0x8a9136aa || ~crc_ones != 0x62a8ab43) {
+        std::cerr << "Error: result_crc does not compute CRC-32C.\n";
+        return false;
+    }
+    return true;
+}
+
+// crc_update() of emulator_top.vhdl, one bit per step.
+FPGA_TEST(result_crc_bitwise) {
+    uint64_t word = 0x9e3779b97f4a7c15ull;
+    uint32_t crc = result_crc::init, bitwise = result_crc::init;
+    for (size_t i = 0; i < 64; i++, word = word * 6364136223846793005ull + 1442695040888963407ull) {
+        crc = result_crc::update(crc, word);
+        for (size_t b = 0; b < 64; b++)
+            bitwise = (bitwise >> 1) ^ ((((bitwise ^ (word >> b)) & 1) != 0) ? result_crc::poly : 0);
+    }
+    if (crc != bitwise) {
+        std::cerr << "Error: result_crc differs from the bitwise CRC of emulator_top.\n";
+        return false;
+    }
+    return true;
+}
+
+using ModelIface = emulator_fields<ModelBackendType, app_fields_t>;
+const uint64_t crc_run_clocks = 200000;
+
+// Reference run (-c) of the model.
+ResultCrcFile CrcReference() {
+    ResultCrcFile reference;
+    SilenceOutput silence;
+    ModelBackendType hw;
+    ModelIface emulator(hw);
+    TestRun(emulator, crc_run_clocks, CrcReport{reference});
+    return reference;
+}
+
+// Verification run (-v) of the model against reference.
+bool CrcVerify(const ResultCrcFile &reference) {
+    SilenceOutput silence;
+    ModelBackendType hw;
+    ModelIface emulator(hw);
+    CrcCheckReport check(emulator, reference);
+    TestRun(emulator, crc_run_clocks, check);
+    return check.ok();
+}
+
+FPGA_TEST(result_crc_match) {
+    const ResultCrcFile reference = CrcReference();
+    if (reference.frames.empty() || reference.frames.front().crc.count == 0) {
+        std::cerr << "Error: the reference run of the model has no results.\n";
+        return false;
+    }
+    if (!CrcVerify(reference)) {
+        std::cerr << "Error: result CRC of the model does not match the reference run.\n";
+        return false;
+    }
+    return true;
+}
+
+FPGA_TEST(result_crc_mismatch) {
+    ResultCrcFile reference = CrcReference();
+    if (reference.frames.empty()) {
+        std::cerr << "Error: the reference run of the model has no frames.\n";
+        return false;
+    }
+    reference.frames.front().crc.crc ^= 1;
+    if (CrcVerify(reference)) {
+        std::cerr << "Error: a corrupted reference CRC was not reported.\n";
+        return false;
+    }
+    return true;
+}
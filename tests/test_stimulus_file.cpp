@@ -0,0 +1,102 @@
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "TestRun.h"
+#include "ResultCrc.h"
+
+#include "fpga_test.h"
+
+// ------------------------------------------------------------
+// Stimulus record / replay
+// ------------------------------------------------------------
+namespace {
+
+using ModelIface = emulator_fields<ModelBackendType, app_fields_t>;
+
+const uint64_t stimulus_run_clocks = 1000000;
+
+} // namespace
+
+// A replay of the recorded TestRun stimulus gives the result CRCs of
+// the TestRun itself, and the header carries the geometry.
+FPGA_TEST(stimulus_replay) {
+    const std::string fname = TempPath(".stim");
+    ResultCrcFile direct, replayed;
+    try {
+        SilenceOutput silence;
+        {
+            StimulusWriter writer(fname, llcca_gens.X_SIZE, llcca_gens.Y_BITS);
+            RecordTestRun(writer, stimulus_run_clocks);
+        }
+        const StimulusFileHeader h = StimulusFile::read_header(fname);
+        if (h.x_size != llcca_gens.X_SIZE || h.y_bits != llcca_gens.Y_BITS) {
+            std::filesystem::remove(fname);
+            std::cerr << "Error: stimulus header has geometry " << h.x_size << "x" << h.y_bits << ".\n";
+            return false;
+        }
+
+        ModelBackendType hw;
+        ModelIface emulator(hw);
+        TestRun(emulator, stimulus_run_clocks, CrcReport{direct});
+
+        StimulusFile file(fname);
+        ModelBackendType replay_hw;
+        ModelIface replay_emulator(replay_hw);
+        TestRunReplay(replay_emulator, file, CrcReport{replayed});
+    } catch (...) {
+        std::filesystem::remove(fname);
+        throw;
+    }
+    std::filesystem::remove(fname);
+
+    if (direct.frames.empty() || direct.frames.front().crc.count == 0) {
+        std::cerr << "Error: the direct run has no results.\n";
+        return false;
+    }
+    if (replayed.frames.size() != direct.frames.size()) {
+        std::cerr << "Error: the replay has " << replayed.frames.size() << " frames, the run "
+                  << direct.frames.size() << ".\n";
+        return false;
+    }
+    for (size_t i = 0; i < direct.frames.size(); i++) {
+        if (replayed.frames[i].crc != direct.frames[i].crc) {
+            std::cerr << "Error: the replay differs from the run in frame " << direct.frames[i].frame_idx << ".\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+// A file recorded for another geometry is refused, not replayed with
+// the wrong row length.
+FPGA_TEST(stimulus_replay_geometry) {
+    const std::string fname = TempPath(".stim");
+    {
+        StimulusWriter writer(fname, llcca_gens.X_SIZE / 2, llcca_gens.Y_BITS);
+        writer.control(true, true, 4);
+        writer.frame(0);
+        writer.pixels(0, 0, StimulusOp::IN_LABEL, 16);
+    }
+
+    bool refused = false;
+    try {
+        StimulusFile file(fname);
+        ModelBackendType hw;
+        ModelIface emulator(hw);
+        SilenceOutput silence;
+        TestRunReplay(emulator, file);
+    } catch (const std::runtime_error &) {
+        refused = true;
+    }
+    std::filesystem::remove(fname);
+
+    if (!refused) {
+        std::cerr << "Error: TestRunReplay ran a stimulus file of another geometry.\n";
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,46 @@
+#include <cstddef>
+#include <iostream>
+
+#include "StressScene.h"
+
+#include "fpga_test.h"
+
+// ------------------------------------------------------------
+// StressScenes worst profile
+// ------------------------------------------------------------
+// Every comb tooth row has x_size / 2 runs, the most of any row, and
+// the row above each comb is blank, so every tooth opens a label.
+FPGA_TEST(stress_worst_comb) {
+    StressScenes::Options options;
+    options.profile = StressScenes::Profile::WORST;
+
+    for (size_t x_size : {1024, 2048}) {
+        for (size_t frame_idx = 0; frame_idx < 4; frame_idx++) {
+            StressScenes::Frame frame;
+            StressScenes::render(options, x_size, frame_idx, frame);
+
+            for (size_t y = 0; y + 24 < frame.rows; y += 64) {
+                size_t above = 0;
+                if (y > 0)
+                    frame.runs(y - 1, [&](size_t, size_t) { above++; });
+                for (size_t r = 0; r < 16; r++) {
+                    size_t runs = 0;
+                    frame.runs(y + r, [&](size_t x_begin, size_t x_end) {
+                        runs += x_begin % 2 == 0 && x_end == x_begin + 1;
+                    });
+                    if (runs != x_size / 2 || above) {
+                        std::cerr << "Error: comb row " << y + r << " of frame " << frame_idx << " at " << x_size
+                                  << " wide has " << runs << " teeth and " << above << " runs above the comb.\n";
+                        return false;
+                    }
+                }
+            }
+            if (frame.max_runs != x_size / 2) {
+                std::cerr << "Error: frame " << frame_idx << " at " << x_size << " wide has at most "
+                          << frame.max_runs << " runs on a row, expected " << x_size / 2 << ".\n";
+                return false;
+            }
+        }
+    }
+    return true;
+}
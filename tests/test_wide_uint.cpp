@@ -0,0 +1,206 @@
+#include <array>
+#include <compare>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <emulator/bit_slicer.h>
+#include <util/WideUint.h>
+
+#include "fpga_test.h"
+
+// ------------------------------------------------------------
+// WideUint against unsigned __int128
+// ------------------------------------------------------------
+namespace {
+
+using u128 = unsigned __int128;
+
+std::string U128String(u128 v) {
+    std::string s;
+    do {
+        s.insert(s.begin(), static_cast<char>('0' + static_cast<int>(v % 10)));
+        v /= 10;
+    } while (v);
+    return s;
+}
+
+// Values around the limb boundaries, then random ones.
+std::vector<u128> U128Values() {
+    const u128 ones = ~u128(0);
+    std::vector<u128> values = {
+        0, 1, 2, UINT64_MAX, u128(UINT64_MAX) + 1, u128(UINT64_MAX) + 2,
+        ones, ones - 1, ones >> 1, u128(1) << 127, (u128(1) << 100) - 1, u128(1) << 99,
+    };
+    TestRandom next;
+    for (size_t i = 0; i < 100; i++) {
+        u128 v = 0;
+        for (size_t k = 0; k < 5; k++)
+            v = v << 31 ^ next(size_t(1) << 31);
+        values.push_back(v);
+    }
+    return values;
+}
+
+// WideUint<BITS> (BITS <= 128) and unsigned __int128 modulo 2^BITS
+// agree on every operation of every pair of values.
+template<size_t BITS>
+bool CompareWithU128() {
+    using W = WideUint<BITS>;
+    const u128 mask = BITS == 128 ? ~u128(0) : (u128(1) << (BITS % 128)) - 1;
+    const auto values = U128Values();
+
+    auto same = [&](const W &w, u128 v, const char *op, u128 a, u128 b) {
+        if (u128(w) == (v & mask) && w.to_string() == U128String(v & mask))
+            return true;
+        std::cerr << "Error: WideUint<" << BITS << "> " << U128String(a & mask) << " " << op << " "
+                  << U128String(b) << " gives " << w << ", expected " << U128String(v & mask) << ".\n";
+        return false;
+    };
+
+    for (u128 a : values) {
+        const W wa(a);
+        if (!same(wa, a, "load", a, 0) || !same(~wa, ~a, "~", a, 0))
+            return false;
+        for (size_t n = 0; n <= BITS + 1; n++) {
+            const u128 shl = n >= BITS ? 0 : (a & mask) << n;
+            const u128 shr = n >= BITS ? 0 : (a & mask) >> n;
+            if (!same(wa << n, shl, "<<", a, n) || !same(wa >> n, shr, ">>", a, n))
+                return false;
+        }
+        for (u128 b : values) {
+            const W wb(b);
+            const u128 ma = a & mask, mb = b & mask;
+            if (!same(wa + wb, a + b, "+", a, b) || !same(wa - wb, a - b, "-", a, b)
+                || !same(wa & wb, a & b, "&", a, b) || !same(wa | wb, a | b, "|", a, b)
+                || !same(wa ^ wb, a ^ b, "^", a, b))
+                return false;
+            if ((wa <=> wb) != (ma <=> mb) || (wa == wb) != (ma == mb)) {
+                std::cerr << "Error: WideUint<" << BITS << "> compares " << U128String(ma) << " and "
+                          << U128String(mb) << " wrongly.\n";
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+FPGA_TEST(wide_uint_128) {
+    return CompareWithU128<128>();
+}
+
+// Trim at a width that is not a multiple of 64.
+FPGA_TEST(wide_uint_100) {
+    return CompareWithU128<100>();
+}
+
+// Carry, borrow and shifts into and out of a third limb, and its text.
+FPGA_TEST(wide_uint_192) {
+    using W = WideUint<192>;
+    const W two_128 = W(1) << 128;
+    const W below = W(~u128(0));
+    const W ones = ~W(0);
+
+    auto check = [](bool ok, const char *what) {
+        if (!ok)
+            std::cerr << "Error: WideUint<192> " << what << ".\n";
+        return ok;
+    };
+
+    return check(below + W(1) == two_128 && two_128.limb(2) == 1 && two_128.limb(1) == 0, "carry into limb 2")
+        && check(two_128 - W(1) == below && (two_128 - W(1)).limb(2) == 0, "borrow from limb 2")
+        && check(ones + W(1) == W(0) && W(0) - W(1) == ones, "wrap modulo 2^192")
+        && check((W(1) << 150).limb(2) == uint64_t(1) << 22 && ((W(1) << 150) >> 150) == W(1), "shift by 150")
+        && check((ones >> 191) == W(1) && (ones << 191) == W(1) << 191, "shift by 191")
+        && check((ones << 192).is_zero() && (ones >> 200).is_zero(), "shift by the width or more")
+        && check(below < two_128 && two_128 > below && (two_128 <=> two_128) == 0, "compare across limbs")
+        && check(two_128.to_string() == "340282366920938463463374607431768211456", "2^128 as text")
+        && check(ones.to_string() == "6277101735386680763835789423207666416102355444464034512895",
+                 "2^192 - 1 as text")
+        && check(two_128.to_double() == 340282366920938463463374607431768211456.0, "2^128 as double");
+}
+
+// ------------------------------------------------------------
+// bit_slicer on a field wider than 128 bits
+// ------------------------------------------------------------
+namespace {
+
+// bit_slicer target and source on eight 64-bit words.
+struct SlicerWords {
+    using wr_word_t = uint64_t;
+    using rd_word_t = uint64_t;
+
+    std::array<uint64_t, 8> words{};
+
+    void write(size_t idx, uint64_t data, uint64_t mask) {
+        words[idx] = (words[idx] & ~mask) | (data & mask);
+    }
+    template<size_t IDX>
+    void write(uint64_t data, uint64_t mask) {
+        write(IDX, data, mask);
+    }
+    uint64_t read(size_t idx) const {
+        return words[idx];
+    }
+    template<size_t IDX>
+    uint64_t read() const {
+        return words[IDX];
+    }
+};
+
+bool Bit(const std::array<uint64_t, 8> &words, size_t bit) {
+    return (words[bit / 64] >> (bit % 64)) & 1;
+}
+
+} // namespace
+
+// A 200-bit field at bit 37 spans four words. Written into words
+// filled with a pattern, it must replace exactly its bits, and read
+// back as written, with the run-time and the compile-time slicer.
+FPGA_TEST(bit_slicer_wide) {
+    constexpr size_t offset = 37, width = 200;
+    using W = WideUint<width>;
+
+    TestRandom next;
+    for (size_t round = 0; round < 64; round++) {
+        W value;
+        for (size_t k = 0; k < 7; k++)
+            value = value << 31 | W(next(size_t(1) << 31));
+
+        for (bool compile_time : {false, true}) {
+            SlicerWords target;
+            for (auto &w : target.words)
+                w = 0xa5a5a5a5a5a5a5a5ull;
+            const auto before = target.words;
+
+            bit_slicer<SlicerWords> slicer(target);
+            W read;
+            if (compile_time) {
+                slicer.write_bits<offset, width>(value);
+                read = slicer.read_bits<offset, width, W>();
+            } else {
+                slicer.write_bits(offset, width, value);
+                read = slicer.read_bits<W>(offset, width);
+            }
+
+            for (size_t bit = 0; bit < 8 * 64; bit++) {
+                const bool in_field = bit >= offset && bit < offset + width;
+                const bool expected = in_field ? !((value >> (bit - offset)) & W(1)).is_zero() : Bit(before, bit);
+                if (Bit(target.words, bit) != expected) {
+                    std::cerr << "Error: bit_slicer (" << (compile_time ? "compile" : "run") << " time) wrote bit "
+                              << bit << " wrongly for " << value << ".\n";
+                    return false;
+                }
+            }
+            if (read != value) {
+                std::cerr << "Error: bit_slicer (" << (compile_time ? "compile" : "run") << " time) read back "
+                          << read << " for " << value << ".\n";
+                return false;
+            }
+        }
+    }
+    return true;
+}